@@ -0,0 +1,170 @@
+﻿#include "pch.h"
+#include "ActionEvents.h"
+#include "ProcessRules.h"
+#include <iomanip>
+#include <iostream>
+#include <system_error>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            // 生产者不持锁通知，可能错过唤醒；分发线程最多等待这么久再检查一次
+            const auto MAX_DISPATCH_DELAY = std::chrono::milliseconds(50);
+        }
+
+        ProcessActionDispatcher::ProcessActionDispatcher(size_t capacity)
+            : m_ring(capacity)
+            , m_published(0)
+            , m_consumed(0)
+            , m_dropped(0)
+            , m_running(false)
+            , m_consoleOutput(true)
+        {
+        }
+
+        ProcessActionDispatcher::~ProcessActionDispatcher() {
+            Stop();
+        }
+
+        void ProcessActionDispatcher::Start() {
+            if (m_running.exchange(true)) {
+                return;
+            }
+
+            try {
+                m_thread = std::thread(&ProcessActionDispatcher::ConsumerLoop, this);
+            }
+            catch (const std::system_error&) {
+                m_running = false;
+                std::cerr << "创建事件分发线程失败，操作事件将被丢弃" << std::endl;
+            }
+        }
+
+        void ProcessActionDispatcher::Stop() {
+            {
+                std::lock_guard<std::mutex> lock(m_wakeupMutex);
+                if (!m_running.exchange(false)) {
+                    return;
+                }
+            }
+            m_wakeup.notify_one();
+
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        bool ProcessActionDispatcher::Publish(ProcessActionEvent&& event) {
+            if (!m_ring.TryPush(std::move(event))) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            m_published.fetch_add(1, std::memory_order_release);
+            m_wakeup.notify_one();
+            return true;
+        }
+
+        void ProcessActionDispatcher::Flush() {
+            uint64_t target = m_published.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> lock(m_wakeupMutex);
+            while (m_running && m_consumed < target) {
+                m_wakeup.notify_one();
+                m_drained.wait_for(lock, MAX_DISPATCH_DELAY);
+            }
+        }
+
+        void ProcessActionDispatcher::AddSink(ProcessActionSink sink) {
+            std::lock_guard<std::mutex> lock(m_sinkMutex);
+            m_sinks.push_back(std::move(sink));
+        }
+
+        void ProcessActionDispatcher::SetConsoleOutput(bool enabled) {
+            m_consoleOutput = enabled;
+        }
+
+        uint64_t ProcessActionDispatcher::GetDroppedCount() const {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+        void ProcessActionDispatcher::ConsumerLoop() {
+            uint64_t seen = 0;
+            while (m_running) {
+                {
+                    std::unique_lock<std::mutex> lock(m_wakeupMutex);
+                    m_wakeup.wait_for(lock, MAX_DISPATCH_DELAY, [this, seen] {
+                        return !m_running || m_published.load(std::memory_order_acquire) != seen;
+                    });
+                }
+                seen = m_published.load(std::memory_order_acquire);
+                Drain();
+                m_drained.notify_all();
+            }
+
+            // 停止前处理完剩余事件
+            Drain();
+        }
+
+        void ProcessActionDispatcher::Drain() {
+            ProcessActionEvent event;
+            bool wroteConsole = false;
+            uint64_t drained = 0;
+
+            std::lock_guard<std::mutex> lock(m_sinkMutex);
+            while (m_ring.TryPop(event)) {
+                drained++;
+                if (m_consoleOutput && event.result == AffinityApplyStatus::Succeeded) {
+                    WriteConsole(event);
+                    wroteConsole = true;
+                }
+
+                for (const ProcessActionSink& sink : m_sinks) {
+                    sink(event);
+                }
+            }
+
+            // 每批事件只刷新一次控制台
+            if (wroteConsole) {
+                std::cout.flush();
+            }
+            m_consumed.fetch_add(drained, std::memory_order_release);
+        }
+
+        void ProcessActionDispatcher::WriteConsole(const ProcessActionEvent& event) {
+            switch (event.type) {
+            case ProcessActionEvent::Type::AffinityExcluded: {
+                CpuSet excluded = event.oldAffinity;
+                excluded.AndNot(event.newAffinity);
+                std::cout << "检测到进程 " << event.processId << " (" << event.name << ") 使用保留核心 "
+                    << excluded.ToString() << "，已自动排除\n";
+                break;
+            }
+            case ProcessActionEvent::Type::ThreadPinned:
+                std::cout << "进程 " << event.processId << " (" << event.name << ") 的热点线程 "
+                    << event.threadId << " 已绑定到核心 " << event.newAffinity.ToString() << "\n";
+                break;
+            case ProcessActionEvent::Type::RuleApplied:
+                std::cout << "进程 " << event.processId << " (" << event.name << ") 已按规则设置亲和性: "
+                    << event.newAffinity.ToString() << "\n";
+                break;
+            case ProcessActionEvent::Type::SchedulingApplied:
+                std::cout << "进程 " << event.processId << " (" << event.name << ") 已按规则设置调度: "
+                    << FormatProcessScheduling(event.scheduling) << "\n";
+                break;
+            case ProcessActionEvent::Type::MemoryPolicyApplied:
+                std::cout << "进程 " << event.processId << " (" << event.name << ") 已按规则设置内存策略: "
+                    << FormatProcessMemoryPolicy(event.memoryPolicy) << "，NUMA 节点 " << event.memoryNodes.ToString();
+                if (event.localMemoryBefore >= 0) {
+                    std::cout << std::fixed << std::setprecision(1) << "，本地内存 " << event.localMemoryBefore << "%";
+                    if (event.localMemoryAfter >= 0) {
+                        std::cout << " -> " << event.localMemoryAfter << "%";
+                    }
+                    std::cout << std::defaultfloat;
+                }
+                std::cout << "\n";
+                break;
+            }
+        }
+    }
+}
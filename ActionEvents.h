@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include "AffinityBatch.h"
+#include "CpuSet.h"
+#include "EventRing.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 操作事件：扫描线程只把结构化事件写入无锁环形队列，
+        // 控制台输出与检测回调都在分发线程上执行，慢速输出不会拖慢保护扫描
+        // =============================================================================
+
+        struct ProcessActionEvent {
+            enum class Type {
+                AffinityExcluded,   // 进程亲和性排除了保留核心
+                ThreadPinned,       // 热点线程绑定到规则核心
+                RuleApplied,        // 按进程规则设置亲和性
+                SchedulingApplied,  // 按调度规则设置优先级、调度策略与 I/O 优先级
+                MemoryPolicyApplied // 按内存策略把进程内存限定到绑定核心所在的 NUMA 节点
+            };
+
+            Type type = Type::AffinityExcluded;
+            DWORD processId = 0;
+            DWORD threadId = 0;                 // 线程级操作时有效；ThreadPinned 为 0 表示扩大进程亲和性失败
+            std::string name;
+            CpuSet oldAffinity;
+            CpuSet newAffinity;
+            ProcessScheduling scheduling;       // 调度规则操作时有效
+            ProcessMemoryPolicy memoryPolicy;   // 内存策略操作时有效
+            CpuSet memoryNodes;                 // 内存策略的目标 NUMA 节点编号
+            double localMemoryBefore = -1.0;    // 目标节点上的常驻内存比例（百分比），无法统计时为 -1
+            double localMemoryAfter = -1.0;     // 迁移后重新统计，未迁移时为 -1
+            AffinityApplyStatus result = AffinityApplyStatus::Succeeded;
+            DWORD errorCode = 0;
+            std::chrono::system_clock::time_point timestamp;
+        };
+
+        // 事件接收者，在分发线程上调用
+        using ProcessActionSink = std::function<void(const ProcessActionEvent& event)>;
+
+        class ProcessActionDispatcher {
+        public:
+            explicit ProcessActionDispatcher(size_t capacity = 4096);
+            ~ProcessActionDispatcher();
+
+            ProcessActionDispatcher(const ProcessActionDispatcher&) = delete;
+            ProcessActionDispatcher& operator=(const ProcessActionDispatcher&) = delete;
+
+            void Start();
+            // 停止分发线程，退出前处理完队列中剩余的事件
+            void Stop();
+
+            // 不加锁、不等待；队列满时丢弃事件并计数
+            bool Publish(ProcessActionEvent&& event);
+
+            // 等待调用前发布的事件全部处理完毕，用于前台命令在输出汇总前对齐控制台
+            void Flush();
+
+            void AddSink(ProcessActionSink sink);
+            // 是否把成功的操作输出到控制台（默认开启）
+            void SetConsoleOutput(bool enabled);
+            uint64_t GetDroppedCount() const;
+
+        private:
+            void ConsumerLoop();
+            void Drain();
+            void WriteConsole(const ProcessActionEvent& event);
+
+            BoundedEventRing<ProcessActionEvent> m_ring;
+            std::atomic<uint64_t> m_published;
+            std::atomic<uint64_t> m_consumed;
+            std::atomic<uint64_t> m_dropped;
+            std::atomic<bool> m_running;
+            std::atomic<bool> m_consoleOutput;
+
+            std::mutex m_wakeupMutex;
+            std::condition_variable m_wakeup;
+            std::condition_variable m_drained;
+            std::thread m_thread;
+
+            // 只在添加接收者与分发时加锁，生产者不接触
+            std::mutex m_sinkMutex;
+            std::vector<ProcessActionSink> m_sinks;
+        };
+    }
+}
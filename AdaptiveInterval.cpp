@@ -0,0 +1,54 @@
+﻿#include "pch.h"
+#include "AdaptiveInterval.h"
+#include <algorithm>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        AdaptiveScanInterval::AdaptiveScanInterval(const AdaptiveIntervalOptions& options)
+            : m_current(0)
+        {
+            Configure(options);
+            Reset();
+        }
+
+        void AdaptiveScanInterval::Configure(const AdaptiveIntervalOptions& options) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_options = options;
+            m_options.minimum = std::max(m_options.minimum, std::chrono::milliseconds(1));
+            m_options.maximum = std::max(m_options.maximum, m_options.minimum);
+            m_options.backoffFactor = std::max(m_options.backoffFactor, 1.0);
+            m_current = std::min(std::max(m_current, m_options.minimum), m_options.maximum);
+        }
+
+        AdaptiveIntervalOptions AdaptiveScanInterval::GetOptions() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_options;
+        }
+
+        std::chrono::milliseconds AdaptiveScanInterval::Update(bool activity) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (activity) {
+                m_current = m_options.minimum;
+            }
+            else {
+                // 先在 double 中比较，避免倍数很大时溢出
+                double next = static_cast<double>(m_current.count()) * m_options.backoffFactor;
+                m_current = next >= static_cast<double>(m_options.maximum.count())
+                    ? m_options.maximum
+                    : std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(next));
+            }
+            return m_current;
+        }
+
+        void AdaptiveScanInterval::Reset() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_current = m_options.minimum;
+        }
+
+        std::chrono::milliseconds AdaptiveScanInterval::Get() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_current;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+
+#include <chrono>
+#include <mutex>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 自适应扫描间隔：每轮扫描结束后根据本轮是否有活动调整下一轮的等待时间
+        //   有活动（新进程、需要排除的进程）：立即回到最小间隔，进程风暴期间快速响应
+        //   无活动：按倍数退避，直到最大间隔，系统空闲时扫描开销趋近于零
+        // =============================================================================
+
+        struct AdaptiveIntervalOptions {
+            std::chrono::milliseconds minimum{500};
+            // 进程自行重置亲和性只能靠扫描发现，最大间隔不宜超过原固定间隔 5 秒
+            std::chrono::milliseconds maximum{5000};
+            double backoffFactor = 2.0;
+        };
+
+        class AdaptiveScanInterval {
+        public:
+            explicit AdaptiveScanInterval(const AdaptiveIntervalOptions& options = AdaptiveIntervalOptions());
+
+            // 最小间隔至少 1ms，最大间隔不小于最小间隔，倍数不小于 1；当前间隔随之限制到新范围内
+            void Configure(const AdaptiveIntervalOptions& options);
+            AdaptiveIntervalOptions GetOptions() const;
+
+            // 一轮结束后调用，返回下一轮的间隔
+            std::chrono::milliseconds Update(bool activity);
+            // 回到最小间隔
+            void Reset();
+            std::chrono::milliseconds Get() const;
+
+        private:
+            mutable std::mutex m_mutex;
+            AdaptiveIntervalOptions m_options;
+            std::chrono::milliseconds m_current;
+        };
+    }
+}
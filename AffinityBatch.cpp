@@ -0,0 +1,237 @@
+﻿#include "pch.h"
+#include "AffinityBatch.h"
+#include <algorithm>
+#include <system_error>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            // 少于该数量的批次直接在调用线程处理，避免唤醒线程池的开销
+            const size_t PARALLEL_THRESHOLD = 32;
+            const size_t MAX_WORKERS = 8;
+        }
+
+        AffinityApplyStatus ClassifyAffinityError(DWORD error) {
+#ifdef _WIN32
+            if (error == ERROR_ACCESS_DENIED) {
+                return AffinityApplyStatus::Denied;
+            }
+            // OpenProcess 对不存在的 PID 返回 ERROR_INVALID_PARAMETER
+            if (error == ERROR_INVALID_PARAMETER) {
+                return AffinityApplyStatus::Exited;
+            }
+#else
+            if (error == EPERM || error == EACCES) {
+                return AffinityApplyStatus::Denied;
+            }
+            if (error == ESRCH || error == ENOENT) {
+                return AffinityApplyStatus::Exited;
+            }
+#endif
+            return AffinityApplyStatus::Failed;
+        }
+
+        const char* GetAffinityApplyStatusText(AffinityApplyStatus status) {
+            switch (status) {
+            case AffinityApplyStatus::Succeeded:
+                return "成功排除";
+            case AffinityApplyStatus::Unchanged:
+                return "无需修改";
+            case AffinityApplyStatus::Denied:
+                return "失败(权限不足)";
+            case AffinityApplyStatus::Exited:
+                return "失败(进程已退出)";
+            case AffinityApplyStatus::Failed:
+                return "失败";
+            }
+            return "失败";
+        }
+
+        AffinityBatchApplier::AffinityBatchApplier(IProcessBackend& backend, ProcessHandleCache& handleCache, size_t workerCount)
+            : m_backend(backend)
+            , m_handleCache(handleCache)
+            , m_workerCount(workerCount)
+            , m_results(nullptr)
+            , m_jobBody(nullptr)
+            , m_jobCount(0)
+            , m_jobNext(0)
+            , m_activeWorkers(0)
+            , m_jobId(0)
+            , m_stopping(false)
+        {
+            if (m_workerCount == 0) {
+                size_t hardwareThreads = std::thread::hardware_concurrency();
+                m_workerCount = std::min(hardwareThreads > 1 ? hardwareThreads - 1 : 0, MAX_WORKERS - 1);
+            }
+        }
+
+        AffinityBatchApplier::~AffinityBatchApplier() {
+            StopWorkers();
+        }
+
+        void AffinityBatchApplier::Run(const std::vector<const ProcessEntry*>& processes, const AffinityPlanner& planner,
+            std::vector<AffinityApplyResult>& results) {
+            std::lock_guard<std::mutex> lock(m_runMutex);
+
+            results.clear();
+            results.resize(processes.size());
+            m_results = &results;
+            m_handles.assign(processes.size(), ProcessHandle());
+
+            // 第一阶段：并行查询当前亲和性并计算目标
+            ParallelFor(processes.size(), [this, &processes, &planner](size_t index) {
+                PlanOne(*processes[index], planner, index);
+            });
+
+            m_pendingChanges.clear();
+            for (size_t i = 0; i < m_handles.size(); i++) {
+                if (m_handles[i].IsValid()) {
+                    m_pendingChanges.push_back(i);
+                }
+            }
+
+            // 第二阶段：并行写入变更
+            ParallelFor(m_pendingChanges.size(), [this](size_t index) {
+                ApplyOne(m_pendingChanges[index]);
+            });
+
+            // 批次结束后释放句柄引用，句柄本身仍由缓存持有
+            m_handles.clear();
+            m_results = nullptr;
+        }
+
+        void AffinityBatchApplier::PlanOne(const ProcessEntry& process, const AffinityPlanner& planner, size_t index) {
+            auto started = std::chrono::steady_clock::now();
+            AffinityApplyResult& result = (*m_results)[index];
+            result.processId = process.processId;
+            result.name = process.name;
+
+            DWORD openError = 0;
+            ProcessHandle handle = m_handleCache.Acquire(process, &openError);
+            CpuSet systemSet;
+            if (!handle.IsValid()) {
+                result.status = ClassifyAffinityError(openError);
+                result.errorCode = openError;
+            }
+            else if (!m_backend.QueryAffinity(handle, result.oldAffinity, systemSet)) {
+                result.errorCode = GetLastError();
+                result.status = ClassifyAffinityError(result.errorCode);
+            }
+            else {
+                CpuSet target;
+                if (planner(process, result.oldAffinity, systemSet, target) && !target.Empty() && target != result.oldAffinity) {
+                    result.newAffinity = std::move(target);
+                    m_handles[index] = handle;
+                }
+                result.status = AffinityApplyStatus::Unchanged;
+            }
+
+            result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        }
+
+        void AffinityBatchApplier::ApplyOne(size_t index) {
+            auto started = std::chrono::steady_clock::now();
+            AffinityApplyResult& result = (*m_results)[index];
+
+            if (m_backend.ApplyAffinity(m_handles[index], result.newAffinity)) {
+                result.status = AffinityApplyStatus::Succeeded;
+            }
+            else {
+                result.errorCode = GetLastError();
+                result.status = ClassifyAffinityError(result.errorCode);
+            }
+
+            result.applyElapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+            result.elapsed += result.applyElapsed;
+        }
+
+        // =============================================================================
+        // 工作线程池
+        // =============================================================================
+
+        void AffinityBatchApplier::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+            if (count < PARALLEL_THRESHOLD || m_workerCount == 0) {
+                for (size_t i = 0; i < count; i++) {
+                    body(i);
+                }
+                return;
+            }
+
+            StartWorkers();
+            {
+                std::lock_guard<std::mutex> lock(m_poolMutex);
+                m_jobBody = &body;
+                m_jobCount = count;
+                m_jobNext = 0;
+                m_activeWorkers = m_workers.size();
+                m_jobId++;
+            }
+            m_poolWakeup.notify_all();
+
+            RunJob();
+
+            std::unique_lock<std::mutex> lock(m_poolMutex);
+            m_poolDone.wait(lock, [this] { return m_activeWorkers == 0; });
+            m_jobBody = nullptr;
+        }
+
+        void AffinityBatchApplier::RunJob() {
+            for (size_t index = m_jobNext.fetch_add(1); index < m_jobCount; index = m_jobNext.fetch_add(1)) {
+                (*m_jobBody)(index);
+            }
+        }
+
+        // finishedJob 为线程创建时已发布的批次编号，线程只处理之后发布的批次
+        void AffinityBatchApplier::WorkerLoop(uint64_t finishedJob) {
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(m_poolMutex);
+                    m_poolWakeup.wait(lock, [this, finishedJob] { return m_stopping || m_jobId != finishedJob; });
+                    if (m_stopping) {
+                        return;
+                    }
+                    finishedJob = m_jobId;
+                }
+
+                RunJob();
+
+                std::lock_guard<std::mutex> lock(m_poolMutex);
+                if (--m_activeWorkers == 0) {
+                    m_poolDone.notify_one();
+                }
+            }
+        }
+
+        // 首次并行批次时才创建线程，只做单次查询的调用方没有额外线程
+        void AffinityBatchApplier::StartWorkers() {
+            if (!m_workers.empty()) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_poolMutex);
+            m_stopping = false;
+            for (size_t i = 0; i < m_workerCount; i++) {
+                try {
+                    m_workers.emplace_back(&AffinityBatchApplier::WorkerLoop, this, m_jobId);
+                }
+                catch (const std::system_error&) {
+                    break;
+                }
+            }
+        }
+
+        void AffinityBatchApplier::StopWorkers() {
+            {
+                std::lock_guard<std::mutex> lock(m_poolMutex);
+                m_stopping = true;
+            }
+            m_poolWakeup.notify_all();
+
+            for (std::thread& worker : m_workers) {
+                worker.join();
+            }
+            m_workers.clear();
+        }
+    }
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include "CpuSet.h"
+#include "ProcessBackend.h"
+#include "ProcessHandleCache.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 批量亲和性应用：先计算全部变更（查询当前亲和性 + 计算目标），再由工作线程池并行写入
+        // 扫描线程不再逐个进程串行调用平台 API，控制台输出也留到整批完成之后
+        // =============================================================================
+
+        enum class AffinityApplyStatus {
+            Succeeded,      // 已修改
+            Unchanged,      // 无需修改
+            Denied,         // 权限不足
+            Exited,         // 进程已退出
+            Failed          // 其他错误
+        };
+
+        // 状态的中文描述，用于控制台输出
+        const char* GetAffinityApplyStatusText(AffinityApplyStatus status);
+        // 按平台错误码区分权限不足、进程已退出与其他错误
+        AffinityApplyStatus ClassifyAffinityError(DWORD error);
+
+        struct AffinityApplyResult {
+            DWORD processId = 0;
+            std::string name;
+            AffinityApplyStatus status = AffinityApplyStatus::Unchanged;
+            CpuSet oldAffinity;
+            CpuSet newAffinity;                 // 仅在需要修改时有值
+            DWORD errorCode = 0;                // 失败时的平台错误码
+            std::chrono::microseconds elapsed{0};   // 查询 + 应用耗时
+            std::chrono::microseconds applyElapsed{0};  // 其中应用耗时，未应用时为 0
+        };
+
+        // 由当前亲和性计算目标亲和性，返回 false 表示无需修改；会在多个工作线程上并发调用
+        using AffinityPlanner = std::function<bool(const ProcessEntry& process,
+            const CpuSet& current, const CpuSet& system, CpuSet& target)>;
+
+        class AffinityBatchApplier {
+        public:
+            // workerCount 为 0 时按硬件线程数选择（最多 8 个，调用线程也参与处理）
+            AffinityBatchApplier(IProcessBackend& backend, ProcessHandleCache& handleCache, size_t workerCount = 0);
+            ~AffinityBatchApplier();
+
+            AffinityBatchApplier(const AffinityBatchApplier&) = delete;
+            AffinityBatchApplier& operator=(const AffinityBatchApplier&) = delete;
+
+            // results 与 processes 一一对应；同一时刻只执行一个批次
+            void Run(const std::vector<const ProcessEntry*>& processes, const AffinityPlanner& planner,
+                std::vector<AffinityApplyResult>& results);
+
+        private:
+            void PlanOne(const ProcessEntry& process, const AffinityPlanner& planner, size_t index);
+            void ApplyOne(size_t index);
+
+            // 在调用线程与工作线程上并行执行 body(0..count-1)，小批次直接在调用线程执行
+            void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+            void RunJob();
+            void WorkerLoop(uint64_t finishedJob);
+            void StartWorkers();
+            void StopWorkers();
+
+            IProcessBackend& m_backend;
+            ProcessHandleCache& m_handleCache;
+            size_t m_workerCount;
+
+            // 当前批次的状态（受 m_runMutex 串行化）
+            std::mutex m_runMutex;
+            std::vector<AffinityApplyResult>* m_results;
+            std::vector<ProcessHandle> m_handles;
+            std::vector<size_t> m_pendingChanges;
+
+            // 工作线程池
+            std::vector<std::thread> m_workers;
+            std::mutex m_poolMutex;
+            std::condition_variable m_poolWakeup;
+            std::condition_variable m_poolDone;
+            const std::function<void(size_t)>* m_jobBody;
+            size_t m_jobCount;
+            std::atomic<size_t> m_jobNext;
+            size_t m_activeWorkers;
+            uint64_t m_jobId;
+            bool m_stopping;
+        };
+    }
+}
@@ -0,0 +1,320 @@
+﻿#include "pch.h"
+#include "CgroupCpuset.h"
+#include <iostream>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const char* const CGROUP_ROOT = "/sys/fs/cgroup";
+
+            // cgroup 接口文件每次写入一个值，失败时 errno 说明原因
+            bool WriteCgroupFile(const std::string& path, const std::string& value) {
+                int fd = open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+                if (fd < 0) {
+                    return false;
+                }
+                ssize_t written = write(fd, value.data(), value.size());
+                int error = errno;
+                close(fd);
+                errno = error;
+                return written == static_cast<ssize_t>(value.size());
+            }
+
+            std::string ReadCgroupFile(const std::string& path) {
+                std::ifstream file(path);
+                std::ostringstream content;
+                content << file.rdbuf();
+                std::string text = content.str();
+                while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+                    text.pop_back();
+                }
+                return text;
+            }
+
+            std::vector<DWORD> ReadCgroupProcesses(const std::string& groupPath) {
+                std::vector<DWORD> processIds;
+                std::ifstream file(groupPath + "/cgroup.procs");
+                DWORD processId = 0;
+                while (file >> processId) {
+                    processIds.push_back(processId);
+                }
+                return processIds;
+            }
+
+            // /proc/<pid>/cgroup 中 cgroup v2 的一行为 "0::/path"
+            std::string ReadProcessCgroup(DWORD processId) {
+                std::ifstream file("/proc/" + std::to_string(processId) + "/cgroup");
+                std::string line;
+                while (std::getline(file, line)) {
+                    if (line.compare(0, 3, "0::") == 0) {
+                        return line.substr(3);
+                    }
+                }
+                return "/";
+            }
+
+            bool MoveProcess(const std::string& groupPath, DWORD processId) {
+                return WriteCgroupFile(groupPath + "/cgroup.procs", std::to_string(processId));
+            }
+
+            bool HasController(const std::string& path, const char* controller) {
+                std::istringstream controllers(ReadCgroupFile(path));
+                std::string name;
+                while (controllers >> name) {
+                    if (name == controller) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+        }
+
+        CgroupCpusetReservation::CgroupCpusetReservation(const std::string& groupName)
+            : m_groupName(groupName)
+            , m_active(false)
+        {
+            SetRoot(CGROUP_ROOT);
+        }
+
+        CgroupCpusetReservation::~CgroupCpusetReservation() {
+            Release();
+        }
+
+        bool CgroupCpusetReservation::IsSupported() {
+            return IsSupported(CGROUP_ROOT);
+        }
+
+        bool CgroupCpusetReservation::IsSupported(const std::string& root) {
+            // cgroup.controllers 只存在于 cgroup v2 层级中，v1 的 cpuset 挂载点没有该文件
+            return HasController(root + "/cgroup.controllers", "cpuset");
+        }
+
+        bool CgroupCpusetReservation::SetRoot(const std::string& root) {
+            if (m_active) {
+                return false;
+            }
+            m_root = root;
+            m_reservedPath = root + "/" + m_groupName + ".reserved";
+            m_generalPath = root + "/" + m_groupName + ".general";
+            return true;
+        }
+
+        std::string CgroupCpusetReservation::GetRoot() const {
+            return m_root;
+        }
+
+        bool CgroupCpusetReservation::Apply(const CpuSet& reservedSet, const CpuSet& systemSet) {
+            CpuSet generalSet = systemSet;
+            generalSet.AndNot(reservedSet);
+            if (reservedSet.Empty() || generalSet.Empty()) {
+                std::cerr << "cgroup 保留需要至少一个保留核心和一个其他核心" << std::endl;
+                return false;
+            }
+
+            const std::string& root = m_root;
+            bool created = !m_active;
+            if (created) {
+                if (!HasController(root + "/cgroup.subtree_control", "cpuset") &&
+                    !WriteCgroupFile(root + "/cgroup.subtree_control", "+cpuset")) {
+                    std::cerr << "启用 cpuset 控制器失败: " << strerror(errno) << std::endl;
+                    return false;
+                }
+                if ((mkdir(m_reservedPath.c_str(), 0755) != 0 && errno != EEXIST) ||
+                    (mkdir(m_generalPath.c_str(), 0755) != 0 && errno != EEXIST)) {
+                    std::cerr << "创建 cgroup 失败: " << strerror(errno) << std::endl;
+                    rmdir(m_reservedPath.c_str());
+                    return false;
+                }
+            }
+            else {
+                // 更新时先退出分区，否则新旧核心集合的独占检查会互相冲突
+                WriteCgroupFile(m_reservedPath + "/cpuset.cpus.partition", "member");
+            }
+
+            // 先收缩普通组，再扩大保留组，两组的核心在任意时刻都不重叠
+            if (!WriteCgroupFile(m_generalPath + "/cpuset.cpus", generalSet.ToString()) ||
+                !WriteCgroupFile(m_reservedPath + "/cpuset.cpus", reservedSet.ToString())) {
+                std::cerr << "写入 cpuset.cpus 失败: " << strerror(errno) << std::endl;
+                if (created) {
+                    rmdir(m_reservedPath.c_str());
+                    rmdir(m_generalPath.c_str());
+                }
+                else {
+                    // 分区已经退出，旧的保留不再独占核心，整体撤销，由调用方退回亲和性排除
+                    Release();
+                }
+                return false;
+            }
+
+            // isolated 需要 Linux 6.2+，旧内核使用 root 分区（仍独占核心，但保留调度负载均衡）
+            if (!WriteCgroupFile(m_reservedPath + "/cpuset.cpus.partition", "isolated") &&
+                !WriteCgroupFile(m_reservedPath + "/cpuset.cpus.partition", "root")) {
+                std::cerr << "设置 cpuset 分区失败: " << strerror(errno) << std::endl;
+            }
+
+            if (!IsPartitionValid()) {
+                std::cerr << "cpuset 分区无效: " << GetPartitionState() << std::endl;
+                m_active = true;
+                Release();
+                return false;
+            }
+
+            if (created) {
+                // 根 cgroup 中的进程移入普通组；内核线程无法移动，写入失败时忽略
+                // 其他顶层 cgroup 由分区保证不再使用保留核心
+                for (DWORD processId : ReadCgroupProcesses(root)) {
+                    MoveProcess(m_generalPath, processId);
+                }
+            }
+
+            m_reservedSet = reservedSet;
+            m_active = true;
+            return true;
+        }
+
+        bool CgroupCpusetReservation::AddProcess(DWORD processId) {
+            if (!m_active) {
+                return false;
+            }
+
+            std::string original = ReadProcessCgroup(processId);
+            if (!MoveProcess(m_reservedPath, processId)) {
+                std::cerr << "移动进程 " << processId << " 到保留组失败: " << strerror(errno) << std::endl;
+                return false;
+            }
+            m_movedProcesses.emplace_back(processId, original);
+            return true;
+        }
+
+        void CgroupCpusetReservation::Release() {
+            if (!m_active) {
+                return;
+            }
+
+            const std::string& root = m_root;
+            for (const auto& moved : m_movedProcesses) {
+                // 原来的 cgroup 已被删除时移回根 cgroup
+                if (!MoveProcess(root + moved.second, moved.first)) {
+                    MoveProcess(root, moved.first);
+                }
+            }
+            m_movedProcesses.clear();
+
+            // 保留组中剩余的进程（包括它们的子进程）与普通组的进程一起回到根 cgroup
+            for (DWORD processId : ReadCgroupProcesses(m_reservedPath)) {
+                MoveProcess(root, processId);
+            }
+            for (DWORD processId : ReadCgroupProcesses(m_generalPath)) {
+                MoveProcess(root, processId);
+            }
+
+            WriteCgroupFile(m_reservedPath + "/cpuset.cpus.partition", "member");
+            if (rmdir(m_reservedPath.c_str()) != 0 || rmdir(m_generalPath.c_str()) != 0) {
+                std::cerr << "删除 cgroup 失败: " << strerror(errno) << std::endl;
+            }
+
+            m_reservedSet.Clear();
+            m_active = false;
+        }
+
+        bool CgroupCpusetReservation::IsActive() const {
+            return m_active;
+        }
+
+        CpuSet CgroupCpusetReservation::GetReservedSet() const {
+            return m_reservedSet;
+        }
+
+        std::string CgroupCpusetReservation::GetPartitionState() const {
+            return ReadCgroupFile(m_reservedPath + "/cpuset.cpus.partition");
+        }
+
+        bool CgroupCpusetReservation::IsPartitionValid() const {
+            // 不支持分区的内核（5.13 之前）没有该文件，其他顶层 cgroup 无法被排除
+            std::string state = GetPartitionState();
+            return !state.empty() && state.find("invalid") == std::string::npos && state.compare(0, 6, "member") != 0;
+        }
+
+        std::string CgroupCpusetReservation::GetReservedPath() const {
+            return m_active ? m_reservedPath : std::string();
+        }
+    }
+}
+
+#else
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // Windows 没有 cgroup，核心保留只能通过修改进程亲和性实现
+
+        CgroupCpusetReservation::CgroupCpusetReservation(const std::string& groupName)
+            : m_groupName(groupName)
+            , m_active(false)
+        {
+        }
+
+        CgroupCpusetReservation::~CgroupCpusetReservation() {
+        }
+
+        bool CgroupCpusetReservation::IsSupported() {
+            return false;
+        }
+
+        bool CgroupCpusetReservation::IsSupported(const std::string&) {
+            return false;
+        }
+
+        bool CgroupCpusetReservation::SetRoot(const std::string& root) {
+            m_root = root;
+            return true;
+        }
+
+        std::string CgroupCpusetReservation::GetRoot() const {
+            return m_root;
+        }
+
+        bool CgroupCpusetReservation::Apply(const CpuSet&, const CpuSet&) {
+            return false;
+        }
+
+        bool CgroupCpusetReservation::AddProcess(DWORD) {
+            return false;
+        }
+
+        void CgroupCpusetReservation::Release() {
+        }
+
+        bool CgroupCpusetReservation::IsActive() const {
+            return false;
+        }
+
+        CpuSet CgroupCpusetReservation::GetReservedSet() const {
+            return CpuSet();
+        }
+
+        std::string CgroupCpusetReservation::GetPartitionState() const {
+            return std::string();
+        }
+
+        bool CgroupCpusetReservation::IsPartitionValid() const {
+            return false;
+        }
+
+        std::string CgroupCpusetReservation::GetReservedPath() const {
+            return std::string();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include "CpuSet.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // cgroup v2 cpuset 核心保留（仅 Linux）：
+        //   <name>.reserved  cpuset.cpus = 保留核心，cpuset.cpus.partition = isolated（旧内核退回 root）
+        //   <name>.general   cpuset.cpus = 其余核心，根 cgroup 中的进程迁入此组
+        // 分区根独占保留核心，内核把它们从其他所有 cgroup 的可用 CPU 中移除，
+        // 之后创建的进程自动继承，保留与更新都只是常数次文件写入，不再逐进程修改亲和性
+        // =============================================================================
+
+        class CgroupCpusetReservation {
+        public:
+            explicit CgroupCpusetReservation(const std::string& groupName = "cpucore");
+            ~CgroupCpusetReservation();
+
+            CgroupCpusetReservation(const CgroupCpusetReservation&) = delete;
+            CgroupCpusetReservation& operator=(const CgroupCpusetReservation&) = delete;
+
+            // 已挂载 cgroup v2 且根 cgroup 提供 cpuset 控制器（需要 root 权限才能实际使用）
+            static bool IsSupported();
+            static bool IsSupported(const std::string& root);
+
+            // 更换 cgroup v2 挂载点（默认 /sys/fs/cgroup，混合层级下通常为 /sys/fs/cgroup/unified）
+            // 保留生效期间不能更换，返回 false
+            bool SetRoot(const std::string& root);
+            std::string GetRoot() const;
+
+            // 创建或更新保留组；首次调用时把根 cgroup 中的进程迁入普通组
+            // 分区无效（例如其他 cgroup 独占了这些核心）或更新时写入失败，撤销保留并返回 false
+            bool Apply(const CpuSet& reservedSet, const CpuSet& systemSet);
+            // 把进程移入保留组，运行在保留核心上；Release 时移回原来的 cgroup
+            bool AddProcess(DWORD processId);
+            // 把两个组中的进程移回原处并删除两个组
+            void Release();
+
+            bool IsActive() const;
+            CpuSet GetReservedSet() const;
+            // 保留组的分区状态（cpuset.cpus.partition 的内容，例如 "isolated" 或 "root invalid (...)"）
+            std::string GetPartitionState() const;
+            // 分区仍独占保留核心；其他 cgroup 之后占用这些核心、CPU 下线等都会让分区变为无效
+            bool IsPartitionValid() const;
+            // 保留组的目录（未应用时为空），用于读取 cpu.pressure 等统计文件
+            std::string GetReservedPath() const;
+
+        private:
+            std::string m_groupName;
+            std::string m_root;
+            std::string m_reservedPath;
+            std::string m_generalPath;
+            CpuSet m_reservedSet;
+            bool m_active;
+            // 由 AddProcess 移入保留组的进程及其原来的 cgroup（相对 cgroup 挂载点）
+            std::vector<std::pair<DWORD, std::string>> m_movedProcesses;
+        };
+    }
+}
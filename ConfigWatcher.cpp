@@ -0,0 +1,99 @@
+﻿#include "pch.h"
+#include "ConfigWatcher.h"
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        ConfigFileWatcher::ConfigFileWatcher()
+            : m_interval(500)
+            , m_running(false)
+        {
+        }
+
+        ConfigFileWatcher::~ConfigFileWatcher() {
+            Stop();
+        }
+
+        bool ConfigFileWatcher::Start(const std::string& path, ChangeCallback callback, std::chrono::milliseconds interval) {
+            Stop();
+
+            m_path = path;
+            m_callback = std::move(callback);
+            m_interval = interval;
+            m_running = true;
+
+            try {
+                m_thread = std::thread(&ConfigFileWatcher::WatchLoop, this);
+            }
+            catch (const std::system_error&) {
+                m_running = false;
+                std::cerr << "创建配置文件监视线程失败" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        void ConfigFileWatcher::Stop() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = false;
+            }
+            m_wakeup.notify_all();
+
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        bool ConfigFileWatcher::IsRunning() const {
+            return m_thread.joinable();
+        }
+
+        ConfigFileWatcher::FileSignature ConfigFileWatcher::ReadSignature(const std::string& path) {
+            FileSignature signature;
+            std::error_code error;
+            auto modified = std::filesystem::last_write_time(path, error);
+            if (error) {
+                return signature;
+            }
+            uintmax_t size = std::filesystem::file_size(path, error);
+            if (error) {
+                return signature;
+            }
+
+            signature.exists = true;
+            signature.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+            signature.size = static_cast<uint64_t>(size);
+            return signature;
+        }
+
+        void ConfigFileWatcher::WatchLoop() {
+            // 启动时的文件内容由调用方自行加载，只报告之后的变化
+            FileSignature applied = ReadSignature(m_path);
+            FileSignature pending = applied;
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_wakeup.wait_for(lock, m_interval, [this] { return !m_running; })) {
+                lock.unlock();
+
+                FileSignature current = ReadSignature(m_path);
+                if (current == applied) {
+                    pending = current;
+                }
+                else if (current != pending) {
+                    // 刚发生变化，等下一次检查确认写入完成
+                    pending = current;
+                }
+                else if (current.exists) {
+                    applied = current;
+                    m_callback(m_path);
+                }
+
+                lock.lock();
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 配置文件监视：按固定间隔比较文件的修改时间与大小，
+        // 连续两次检查结果一致后才回调，避免读到编辑器写了一半的文件
+        // =============================================================================
+
+        class ConfigFileWatcher {
+        public:
+            using ChangeCallback = std::function<void(const std::string& path)>;
+
+            ConfigFileWatcher();
+            ~ConfigFileWatcher();
+
+            ConfigFileWatcher(const ConfigFileWatcher&) = delete;
+            ConfigFileWatcher& operator=(const ConfigFileWatcher&) = delete;
+
+            // 回调在监视线程上执行；已在监视时先停止旧的监视
+            bool Start(const std::string& path, ChangeCallback callback,
+                std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+            void Stop();
+            bool IsRunning() const;
+
+        private:
+            struct FileSignature {
+                bool exists = false;
+                int64_t modified = 0;
+                uint64_t size = 0;
+
+                bool operator==(const FileSignature& other) const {
+                    return exists == other.exists && modified == other.modified && size == other.size;
+                }
+                bool operator!=(const FileSignature& other) const { return !(*this == other); }
+            };
+
+            static FileSignature ReadSignature(const std::string& path);
+            void WatchLoop();
+
+            std::string m_path;
+            ChangeCallback m_callback;
+            std::chrono::milliseconds m_interval;
+
+            std::thread m_thread;
+            std::mutex m_mutex;
+            std::condition_variable m_wakeup;
+            bool m_running;
+        };
+    }
+}
@@ -0,0 +1,90 @@
+﻿#include "pch.h"
+#include "CoreUtilization.h"
+#include <thread>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        CoreUtilizationSampler::CoreUtilizationSampler(IProcessBackend& backend)
+            : m_backend(backend)
+            , m_window(std::chrono::seconds(1))
+        {
+        }
+
+        void CoreUtilizationSampler::SetWindow(std::chrono::milliseconds window) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_window = window.count() > 0 ? window : std::chrono::milliseconds(1);
+        }
+
+        std::chrono::milliseconds CoreUtilizationSampler::GetWindow() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_window;
+        }
+
+        bool CoreUtilizationSampler::Sample() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return SampleLocked();
+        }
+
+        bool CoreUtilizationSampler::EnsureWindow() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!SampleLocked()) {
+                return false;
+            }
+
+            auto span = m_snapshots.back().time - m_snapshots.front().time;
+            if (span < m_window) {
+                auto remaining = m_window - span;
+                lock.unlock();
+                std::this_thread::sleep_for(remaining);
+                lock.lock();
+                return SampleLocked();
+            }
+            return true;
+        }
+
+        bool CoreUtilizationSampler::GetUtilization(std::vector<double>& utilization) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            utilization.clear();
+            if (m_snapshots.size() < 2) {
+                return false;
+            }
+
+            // 以窗口起点之前最近的一次采样为基准（SampleLocked 保证它是 front）
+            const std::vector<CpuTimes>& oldest = m_snapshots.front().times;
+            const std::vector<CpuTimes>& newest = m_snapshots.back().times;
+
+            utilization.assign(newest.size(), -1.0);
+            for (size_t cpu = 0; cpu < newest.size() && cpu < oldest.size(); cpu++) {
+                if (newest[cpu].total <= oldest[cpu].total) {
+                    continue;
+                }
+                uint64_t total = newest[cpu].total - oldest[cpu].total;
+                uint64_t busy = newest[cpu].busy >= oldest[cpu].busy ? newest[cpu].busy - oldest[cpu].busy : 0;
+                utilization[cpu] = busy >= total ? 100.0 : 100.0 * static_cast<double>(busy) / static_cast<double>(total);
+            }
+            return true;
+        }
+
+        void CoreUtilizationSampler::Reset() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_snapshots.clear();
+        }
+
+        bool CoreUtilizationSampler::SampleLocked() {
+            Snapshot snapshot;
+            if (!m_backend.QueryCpuTimes(snapshot.times)) {
+                return false;
+            }
+            snapshot.time = std::chrono::steady_clock::now();
+            m_snapshots.push_back(std::move(snapshot));
+
+            // 只保留窗口起点之前最近的一次采样及之后的采样
+            auto windowStart = m_snapshots.back().time - m_window;
+            while (m_snapshots.size() > 2 && m_snapshots[1].time <= windowStart) {
+                m_snapshots.pop_front();
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include "ProcessBackend.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 每核心使用率采样：按时间窗口比较两次累计 CPU 时间（Linux /proc/stat，
+        // Windows 每处理器性能计数），得到各核心在窗口内的实际忙碌比例
+        // =============================================================================
+
+        class CoreUtilizationSampler {
+        public:
+            explicit CoreUtilizationSampler(IProcessBackend& backend);
+
+            // 平均窗口，默认 1 秒
+            void SetWindow(std::chrono::milliseconds window);
+            std::chrono::milliseconds GetWindow();
+
+            // 采样一次，平台不支持时返回 false
+            bool Sample();
+
+            // 保证最近的采样覆盖一个完整窗口：不足时补采样并等待到窗口结束
+            bool EnsureWindow();
+
+            // 各 CPU 在窗口内的使用率（0~100），下标为 CPU 编号，无数据时为 -1
+            bool GetUtilization(std::vector<double>& utilization);
+
+            void Reset();
+
+        private:
+            struct Snapshot {
+                std::chrono::steady_clock::time_point time;
+                std::vector<CpuTimes> times;
+            };
+
+            bool SampleLocked();
+
+            IProcessBackend& m_backend;
+            std::mutex m_mutex;
+            std::chrono::milliseconds m_window;
+            std::deque<Snapshot> m_snapshots;
+        };
+    }
+}
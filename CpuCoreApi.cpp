@@ -0,0 +1,305 @@
+﻿#include "pch.h"
+#define CPUCORE_EXPORTS
+#include "CpuCoreApi.h"
+#include "CpuCoreManager.h"
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+
+using namespace SamsunIoCardC::CpuManager;
+
+// 不透明句柄背后的实例；共享进程表的打开、关闭与刷新由 tableMutex 串行化（表只允许一个写者）
+struct CpuCoreContext {
+    CpuCoreManager manager;
+    SharedProcessTable table;
+    std::mutex tableMutex;
+};
+
+struct CpuCoreHistory {
+    TimeSeriesStore store;
+};
+
+namespace {
+    void FillBindingResult(const AffinityApplyResult& result, CpuCoreBindingResult& output) {
+        output.processId = result.processId;
+        output.status = static_cast<int32_t>(result.status);
+        output.errorCode = result.errorCode;
+        output.reserved = 0;
+        CpuSetToMask(result.oldAffinity, output.oldMask);
+        CpuSetToMask(result.newAffinity, output.newMask);
+    }
+
+    // 异常不能跨越 C 接口，统一转换为错误码
+    template <typename Function>
+    int32_t Guarded(const char* name, Function function) {
+        try {
+            return function();
+        }
+        catch (const std::bad_alloc&) {
+            std::cerr << name << " 内存不足" << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cerr << name << " 异常: " << e.what() << std::endl;
+        }
+        catch (...) {
+            std::cerr << name << " 未知异常" << std::endl;
+        }
+        return CPUCORE_ERROR_FAILED;
+    }
+}
+
+extern "C" {
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_GetApiVersion(void) {
+    return CPUCORE_API_VERSION;
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_RaiseFileDescriptorLimit(void) {
+    return RaiseFileDescriptorLimit() ? CPUCORE_OK : CPUCORE_ERROR_FAILED;
+}
+
+CPUCORE_API CpuCoreContext* CPUCORE_CALL CpuCore_Create(void) {
+    try {
+        CpuCoreContext* context = new CpuCoreContext();
+        // 作为库使用时结果由调用方处理，只保留失败输出
+        context->manager.SetActionConsoleOutput(false);
+        return context;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "CpuCore_Create 失败: " << e.what() << std::endl;
+    }
+    catch (...) {
+        std::cerr << "CpuCore_Create 失败" << std::endl;
+    }
+    return nullptr;
+}
+
+CPUCORE_API void CPUCORE_CALL CpuCore_Destroy(CpuCoreContext* context) {
+    try {
+        delete context;
+    }
+    catch (...) {
+        std::cerr << "CpuCore_Destroy 未知异常" << std::endl;
+    }
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_LoadConfig(CpuCoreContext* context, const char* iniPath) {
+    if (context == nullptr || iniPath == nullptr) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_LoadConfig", [&]() {
+        return context->manager.LoadConfigFile(iniPath) ? CPUCORE_OK : CPUCORE_ERROR_FAILED;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_ApplyBindings(CpuCoreContext* context,
+    const CpuCoreBinding* bindings, uint32_t count, CpuCoreBindingResult* results) {
+    if (context == nullptr || (count != 0 && (bindings == nullptr || results == nullptr))) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_ApplyBindings", [&]() {
+        std::vector<AffinityRequest> requests(count);
+        for (uint32_t i = 0; i < count; i++) {
+            requests[i].processId = bindings[i].processId;
+            requests[i].coreCount = bindings[i].coreCount;
+            if (bindings[i].coreCount == 0) {
+                requests[i].cores = MaskToCpuSet(bindings[i].mask);
+            }
+        }
+
+        std::vector<AffinityApplyResult> applied = context->manager.ApplyAffinityBatch(requests);
+        for (uint32_t i = 0; i < count; i++) {
+            FillBindingResult(applied[i], results[i]);
+        }
+        return CPUCORE_OK;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_ApplyProcessRules(CpuCoreContext* context,
+    CpuCoreBindingResult* results, uint32_t capacity, uint32_t* count) {
+    if (context == nullptr || count == nullptr || (capacity != 0 && results == nullptr)) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_ApplyProcessRules", [&]() {
+        uint32_t reported = 0;
+        for (const AffinityApplyResult& result : context->manager.ApplyProcessRules()) {
+            if (result.status == AffinityApplyStatus::Unchanged) {
+                continue;
+            }
+            if (reported < capacity) {
+                FillBindingResult(result, results[reported]);
+            }
+            reported++;
+        }
+        *count = reported;
+        return reported > capacity ? CPUCORE_ERROR_BUFFER_TOO_SMALL : CPUCORE_OK;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_OpenProcessTable(CpuCoreContext* context, const char* name,
+    uint32_t capacity, const CpuCoreProcessTable** table) {
+    if (context == nullptr || capacity == 0 || table == nullptr) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    *table = nullptr;
+    return Guarded("CpuCore_OpenProcessTable", [&]() {
+        std::lock_guard<std::mutex> lock(context->tableMutex);
+        if (!context->table.Open(name == nullptr ? std::string() : std::string(name), capacity)) {
+            return CPUCORE_ERROR_FAILED;
+        }
+        *table = context->table.GetTable();
+        return CPUCORE_OK;
+    });
+}
+
+CPUCORE_API void CPUCORE_CALL CpuCore_CloseProcessTable(CpuCoreContext* context) {
+    if (context == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(context->tableMutex);
+    context->table.Close();
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_RefreshProcessTable(CpuCoreContext* context, uint32_t flags) {
+    if (context == nullptr) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_RefreshProcessTable", [&]() {
+        std::lock_guard<std::mutex> lock(context->tableMutex);
+        if (!context->table.IsOpen()) {
+            return CPUCORE_ERROR_INVALID_ARGUMENT;
+        }
+        bool includeAffinity = (flags & CPUCORE_REFRESH_AFFINITY) != 0;
+        return context->manager.PublishProcessTable(context->table, includeAffinity) ? CPUCORE_OK : CPUCORE_ERROR_FAILED;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_StartProtection(CpuCoreContext* context, const uint32_t* cores, uint32_t count) {
+    if (context == nullptr || cores == nullptr || count == 0) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_StartProtection", [&]() {
+        // 先校验并发布保留核心，编号超出处理器数时不启动保护
+        std::vector<DWORD> reservedCores(cores, cores + count);
+        if (!context->manager.UpdateReservedCores(reservedCores)) {
+            return CPUCORE_ERROR_INVALID_ARGUMENT;
+        }
+        context->manager.StartMultiCoreProtection(reservedCores);
+        return CPUCORE_OK;
+    });
+}
+
+CPUCORE_API void CPUCORE_CALL CpuCore_StopProtection(CpuCoreContext* context) {
+    if (context == nullptr) {
+        return;
+    }
+    Guarded("CpuCore_StopProtection", [&]() {
+        context->manager.StopCoreProtection();
+        return CPUCORE_OK;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_StartHistoryRecording(CpuCoreContext* context, const char* directory,
+    uint32_t intervalMilliseconds) {
+    if (context == nullptr || directory == nullptr || intervalMilliseconds == 0) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_StartHistoryRecording", [&]() {
+        return context->manager.StartHistoryRecording(directory, intervalMilliseconds) ? CPUCORE_OK : CPUCORE_ERROR_FAILED;
+    });
+}
+
+CPUCORE_API void CPUCORE_CALL CpuCore_StopHistoryRecording(CpuCoreContext* context) {
+    if (context == nullptr) {
+        return;
+    }
+    Guarded("CpuCore_StopHistoryRecording", [&]() {
+        context->manager.StopHistoryRecording();
+        return CPUCORE_OK;
+    });
+}
+
+CPUCORE_API CpuCoreHistory* CPUCORE_CALL CpuCore_OpenHistory(const char* directory, int32_t readOnly) {
+    if (directory == nullptr) {
+        return nullptr;
+    }
+    CpuCoreHistory* history = nullptr;
+    Guarded("CpuCore_OpenHistory", [&]() {
+        std::unique_ptr<CpuCoreHistory> opened(new CpuCoreHistory());
+        if (!opened->store.Open(directory, readOnly != 0)) {
+            return CPUCORE_ERROR_FAILED;
+        }
+        history = opened.release();
+        return CPUCORE_OK;
+    });
+    return history;
+}
+
+CPUCORE_API void CPUCORE_CALL CpuCore_CloseHistory(CpuCoreHistory* history) {
+    try {
+        delete history;
+    }
+    catch (...) {
+        std::cerr << "CpuCore_CloseHistory 未知异常" << std::endl;
+    }
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_AppendHistory(CpuCoreHistory* history, const char* key, int64_t time, double value) {
+    if (history == nullptr || key == nullptr) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_AppendHistory", [&]() {
+        return history->store.Append(key, time, value) ? CPUCORE_OK : CPUCORE_ERROR_FAILED;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_QueryHistory(CpuCoreHistory* history, const char* key, int64_t from, int64_t to,
+    int64_t step, int32_t aggregation, CpuCoreHistoryPoint* points, uint32_t capacity, uint32_t* count) {
+    if (history == nullptr || key == nullptr || count == nullptr || (capacity != 0 && points == nullptr) || step < 0 ||
+        aggregation < CPUCORE_AGGREGATE_AVERAGE || aggregation > CPUCORE_AGGREGATE_LAST) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_QueryHistory", [&]() {
+        std::vector<TimeSeriesPoint> result;
+        if (!history->store.Query(key, from, to, step, static_cast<TimeSeriesAggregation>(aggregation), result)) {
+            return CPUCORE_ERROR_FAILED;
+        }
+
+        uint32_t total = static_cast<uint32_t>(result.size());
+        for (uint32_t i = 0; i < total && i < capacity; i++) {
+            points[i].time = result[i].time;
+            points[i].value = result[i].value;
+            points[i].raw = result[i].raw;
+        }
+        *count = total;
+        return total > capacity ? CPUCORE_ERROR_BUFFER_TOO_SMALL : CPUCORE_OK;
+    });
+}
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_ListHistorySeries(CpuCoreHistory* history, const char* prefix,
+    char* buffer, uint32_t capacity, uint32_t* length) {
+    if (history == nullptr || length == nullptr || (capacity != 0 && buffer == nullptr)) {
+        return CPUCORE_ERROR_INVALID_ARGUMENT;
+    }
+    return Guarded("CpuCore_ListHistorySeries", [&]() {
+        std::string names;
+        for (const std::string& key : history->store.ListSeries(prefix == nullptr ? std::string() : std::string(prefix))) {
+            if (!names.empty()) {
+                names += '\n';
+            }
+            names += key;
+        }
+
+        *length = static_cast<uint32_t>(names.size() + 1);
+        if (*length > capacity) {
+            return CPUCORE_ERROR_BUFFER_TOO_SMALL;
+        }
+        memcpy(buffer, names.c_str(), names.size() + 1);
+        return CPUCORE_OK;
+    });
+}
+
+}
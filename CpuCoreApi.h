@@ -0,0 +1,176 @@
+﻿#pragma once
+
+#include <stdint.h>
+
+// =============================================================================
+// CpuCoreManager 的 C 接口，供 C# 服务通过 P/Invoke 调用（Windows: CpuCore.dll，Linux: libcpucore.so）
+//   批量调用：一次调用应用 N 个绑定或整套进程规则，托管端不再逐个 PID 往返
+//   共享进程表：固定布局的进程快照写入共享内存，托管端直接读取映射内存，不分配 Process 对象
+//   历史时序存储：管理器记录每核心使用率与亲和性变化，Web 服务只读打开同一目录做范围查询与降采样
+// 所有结构体只含定长字段、按自然对齐排列，可直接声明为 C# 的 blittable struct（fixed 缓冲区）
+// 编译库时定义 CPUCORE_EXPORTS
+// =============================================================================
+
+#ifdef _WIN32
+#ifdef CPUCORE_EXPORTS
+#define CPUCORE_API __declspec(dllexport)
+#else
+#define CPUCORE_API __declspec(dllimport)
+#endif
+#define CPUCORE_CALL __cdecl
+#else
+#define CPUCORE_API __attribute__((visibility("default")))
+#define CPUCORE_CALL
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CPUCORE_API_VERSION 1
+
+// 掩码字数与进程名长度，决定结构体大小，修改时必须提高 CPUCORE_API_VERSION
+#define CPUCORE_MASK_WORDS 16           // 1024 个 CPU，第 i 个字对应 CPU i*64 ~ i*64+63
+#define CPUCORE_NAME_LENGTH 64          // UTF-8，含结尾 0，过长时截断
+
+// 函数返回值
+#define CPUCORE_OK 0
+#define CPUCORE_ERROR_INVALID_ARGUMENT -1
+#define CPUCORE_ERROR_FAILED -2
+#define CPUCORE_ERROR_NOT_SUPPORTED -3
+#define CPUCORE_ERROR_BUFFER_TOO_SMALL -4
+
+// 单个进程的应用结果，与 AffinityApplyStatus 一致
+#define CPUCORE_APPLY_SUCCEEDED 0
+#define CPUCORE_APPLY_UNCHANGED 1
+#define CPUCORE_APPLY_DENIED 2
+#define CPUCORE_APPLY_EXITED 3
+#define CPUCORE_APPLY_FAILED 4
+
+// 进程表记录标志
+#define CPUCORE_PROCESS_SYSTEM 0x1          // 系统伪进程或内核线程
+#define CPUCORE_PROCESS_CRITICAL 0x2        // 匹配 [Critical] 列表
+#define CPUCORE_PROCESS_AFFINITY 0x4        // affinity 有效
+#define CPUCORE_PROCESS_RULE 0x8            // 匹配亲和性规则
+
+// 进程表刷新选项
+#define CPUCORE_REFRESH_AFFINITY 0x1        // 同时查询每个进程的亲和性（使用缓存句柄）
+
+#define CPUCORE_TABLE_MAGIC 0x54555043u     // "CPUT"
+
+// 历史查询的降采样方式，与 TimeSeriesAggregation 一致
+#define CPUCORE_AGGREGATE_AVERAGE 0
+#define CPUCORE_AGGREGATE_MIN 1
+#define CPUCORE_AGGREGATE_MAX 2
+#define CPUCORE_AGGREGATE_LAST 3
+
+typedef struct CpuCoreContext CpuCoreContext;
+typedef struct CpuCoreHistory CpuCoreHistory;
+
+// 一个绑定请求：coreCount 为 0 时使用 mask，否则使用编号最低的 coreCount 个可用核心（与核心数规则相同）
+// 保护运行中时保留核心不会分配给请求的进程
+typedef struct CpuCoreBinding {
+    uint32_t processId;
+    uint32_t coreCount;
+    uint64_t mask[CPUCORE_MASK_WORDS];
+} CpuCoreBinding;
+
+typedef struct CpuCoreBindingResult {
+    uint32_t processId;
+    int32_t status;                     // CPUCORE_APPLY_*
+    uint32_t errorCode;                 // 失败时的平台错误码（Windows GetLastError / Linux errno）
+    uint32_t reserved;
+    uint64_t oldMask[CPUCORE_MASK_WORDS];
+    uint64_t newMask[CPUCORE_MASK_WORDS];   // 仅在需要修改时有值
+} CpuCoreBindingResult;
+
+typedef struct CpuCoreProcessRecord {
+    uint32_t processId;
+    uint32_t parentProcessId;
+    uint64_t startTime;                 // 与 PID 组合唯一标识进程实例
+    uint32_t flags;                     // CPUCORE_PROCESS_*
+    uint32_t reserved;
+    uint64_t affinity[CPUCORE_MASK_WORDS];
+    char name[CPUCORE_NAME_LENGTH];
+} CpuCoreProcessRecord;
+
+// 共享进程表头，records 紧随其后，共 capacity 项
+// 读取方式（序号锁）：读 sequence，为奇数表示正在写入需重试；读取 count 与记录后再读 sequence，
+// 两次相同则数据一致。写入方只有刷新调用的线程
+typedef struct CpuCoreProcessTable {
+    uint32_t magic;                     // CPUCORE_TABLE_MAGIC
+    uint32_t version;                   // CPUCORE_API_VERSION
+    uint32_t recordSize;                // sizeof(CpuCoreProcessRecord)
+    uint32_t capacity;
+    volatile uint64_t sequence;
+    uint32_t count;                     // 有效记录数，不超过 capacity
+    uint32_t totalProcesses;            // 快照中的进程总数，大于 count 表示容量不足被截断
+    uint64_t updateTime;                // 刷新时间（Unix 毫秒）
+    CpuCoreProcessRecord records[1];
+} CpuCoreProcessTable;
+
+typedef struct CpuCoreHistoryPoint {
+    int64_t time;                       // Unix 毫秒；降采样时为桶的起点
+    double value;
+    uint64_t raw;                       // 原始 64 位值（亲和性等整数序列），平均值降采样时为 0
+} CpuCoreHistoryPoint;
+
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_GetApiVersion(void);
+
+// 可选：把宿主进程的文件描述符软上限提升到硬上限（仅 Linux 有效），进程很多时在创建实例前调用
+// 库不会自行修改宿主的资源限制；不调用时超出上限的进程退化为按 PID 访问
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_RaiseFileDescriptorLimit(void);
+
+// 创建 / 销毁管理器实例；销毁时停止保护并关闭共享进程表
+CPUCORE_API CpuCoreContext* CPUCORE_CALL CpuCore_Create(void);
+CPUCORE_API void CPUCORE_CALL CpuCore_Destroy(CpuCoreContext* context);
+
+// 读取 INI 中的进程规则、热点线程规则与保留核心（UTF-8 路径）
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_LoadConfig(CpuCoreContext* context, const char* iniPath);
+
+// 批量应用绑定：一次进程快照，句柄缓存与线程池并行写入；results 与 bindings 一一对应
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_ApplyBindings(CpuCoreContext* context,
+    const CpuCoreBinding* bindings, uint32_t count, CpuCoreBindingResult* results);
+
+// 按已加载的规则扫描全部进程（对应服务的 ScanAndApplyConfigurations），只返回发生变化或失败的进程
+// 结果多于 capacity 时填满 results、*count 为实际数量并返回 CPUCORE_ERROR_BUFFER_TOO_SMALL（规则已全部应用）
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_ApplyProcessRules(CpuCoreContext* context,
+    CpuCoreBindingResult* results, uint32_t capacity, uint32_t* count);
+
+// 创建共享进程表：name 为 NULL 时只在本进程内映射；否则创建命名共享内存
+// （Windows: Local\<name>，Linux: /dev/shm/<name>），其他进程也可以只读映射
+// 返回的表在 CpuCore_CloseProcessTable / CpuCore_Destroy 之前有效；重复调用会先关闭旧表
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_OpenProcessTable(CpuCoreContext* context, const char* name,
+    uint32_t capacity, const CpuCoreProcessTable** table);
+CPUCORE_API void CPUCORE_CALL CpuCore_CloseProcessTable(CpuCoreContext* context);
+// 重新枚举进程并写入共享进程表，flags 为 CPUCORE_REFRESH_*
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_RefreshProcessTable(CpuCoreContext* context, uint32_t flags);
+
+// 后台保护：保留 cores 中的核心，已在运行时只替换保留核心；编号不小于处理器数时返回 CPUCORE_ERROR_INVALID_ARGUMENT
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_StartProtection(CpuCoreContext* context, const uint32_t* cores, uint32_t count);
+CPUCORE_API void CPUCORE_CALL CpuCore_StopProtection(CpuCoreContext* context);
+
+// 管理器把每核心使用率（cpu.<n>.utilization）、扫描指标（scan.*）与进程亲和性（process.<名称>.affinity）
+// 记录到 directory；同一目录只能有一个写入方，目录已被其他写入方打开时返回 CPUCORE_ERROR_FAILED
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_StartHistoryRecording(CpuCoreContext* context, const char* directory,
+    uint32_t intervalMilliseconds);
+CPUCORE_API void CPUCORE_CALL CpuCore_StopHistoryRecording(CpuCoreContext* context);
+
+// 独立打开历史目录（UTF-8 路径）；readOnly 为 0 时作为写入方，可以追加自定义序列
+// 作为写入方打开时，目录已被其他写入方（包括正在记录的管理器）占用则返回 NULL
+CPUCORE_API CpuCoreHistory* CPUCORE_CALL CpuCore_OpenHistory(const char* directory, int32_t readOnly);
+CPUCORE_API void CPUCORE_CALL CpuCore_CloseHistory(CpuCoreHistory* history);
+// 追加一个点，time 早于该序列的上一个点时返回 CPUCORE_ERROR_FAILED
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_AppendHistory(CpuCoreHistory* history, const char* key, int64_t time, double value);
+// 查询 [from, to) 内的点；step 为 0 时返回原始点，否则按 step 毫秒与 aggregation（CPUCORE_AGGREGATE_*）降采样
+// 结果多于 capacity 时填满 points、*count 为实际数量并返回 CPUCORE_ERROR_BUFFER_TOO_SMALL
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_QueryHistory(CpuCoreHistory* history, const char* key, int64_t from, int64_t to,
+    int64_t step, int32_t aggregation, CpuCoreHistoryPoint* points, uint32_t capacity, uint32_t* count);
+// 以 prefix（可为 NULL）开头的序列名，以换行分隔写入 buffer 并以 0 结尾；*length 为所需字节数（含结尾 0）
+// 容量不足时返回 CPUCORE_ERROR_BUFFER_TOO_SMALL
+CPUCORE_API int32_t CPUCORE_CALL CpuCore_ListHistorySeries(CpuCoreHistory* history, const char* prefix,
+    char* buffer, uint32_t capacity, uint32_t* length);
+
+#ifdef __cplusplus
+}
+#endif
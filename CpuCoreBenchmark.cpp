@@ -0,0 +1,551 @@
+﻿#include "pch.h"
+#include "CpuCoreManager.h"
+#include "Metrics.h"
+#include "SimulatedBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
+// =============================================================================
+// CpuCoreManager 基准测试：在模拟进程表上测量扫描与排除路径的开销
+//
+//   initial    保护启动后的首次全量扫描（全部进程都需要排除保留核心）
+//   sweep      进程变动后的稳态全量扫描（只处理新建与轮到复检的进程）
+//   events     事件驱动路径：新进程经事件源送达到排除完成
+//   replay     回放录制的进程变动轨迹，每个时间片一个样本
+//   reserve    ReserveCoreForCurrentProcess（每次先恢复全部进程的亲和性）
+//   available  GetAvailableCores（1ms 采样窗口）
+//
+// 随机数种子固定时进程表与变动序列完全相同，结果可与 --baseline 比较作为变更门禁
+// =============================================================================
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const std::chrono::seconds PASS_WAIT_TIMEOUT(30);
+            // 事件路径的待处理队列上限为 4096，超过后退化为全量扫描
+            const size_t MAX_EVENTS_PER_STEP = 4000;
+
+            struct BenchmarkOptions {
+                std::vector<size_t> processCounts = { 1000, 10000, 50000 };
+                DWORD coreCount = 64;
+                double churnRatio = 0.01;       // 每轮替换的进程比例
+                double deniedRatio = 0.05;
+                size_t iterations = 20;
+                uint32_t seed = 1;
+                std::set<std::string> scenarios = { "initial", "sweep", "events", "replay", "reserve", "available" };
+                std::string tracePath;
+                double traceStepMilliseconds = 100.0;
+                std::string csvPath;
+                std::string baselinePath;
+                double tolerance = 0.15;
+                std::string recordPath;
+                int recordSeconds = 60;
+            };
+
+            struct BenchmarkResult {
+                std::string scenario;
+                size_t processCount = 0;
+                DWORD coreCount = 0;
+                double churnRatio = 0;
+                double deniedRatio = 0;
+                uint64_t samples = 0;
+                double mean = 0;            // 微秒
+                uint64_t p50 = 0;
+                uint64_t p99 = 0;
+                uint64_t max = 0;
+
+                std::string Key() const {
+                    std::ostringstream key;
+                    key << scenario << "|" << processCount << "|" << coreCount << "|" << churnRatio << "|" << deniedRatio;
+                    return key.str();
+                }
+            };
+
+            // 被测函数的控制台输出不计入结果，也不刷屏
+            class NullBuffer : public std::streambuf {
+            protected:
+                int overflow(int c) override {
+                    return traits_type::not_eof(c);
+                }
+            };
+
+            class ScopedSilence {
+            public:
+                ScopedSilence()
+                    : m_previous(std::cout.rdbuf(&m_null))
+                {
+                }
+
+                ~ScopedSilence() {
+                    std::cout.rdbuf(m_previous);
+                    std::cout.clear();
+                }
+
+            private:
+                NullBuffer m_null;
+                std::streambuf* m_previous;
+            };
+
+            BenchmarkResult Summarize(const std::string& scenario, const BenchmarkOptions& options, size_t processCount,
+                const LatencyHistogram& histogram) {
+                BenchmarkResult result;
+                result.scenario = scenario;
+                result.processCount = processCount;
+                result.coreCount = options.coreCount;
+                result.churnRatio = options.churnRatio;
+                result.deniedRatio = options.deniedRatio;
+                result.samples = histogram.GetCount();
+                result.mean = result.samples ? static_cast<double>(histogram.GetSum()) / result.samples : 0.0;
+                result.p50 = histogram.GetQuantile(0.5);
+                result.p99 = histogram.GetQuantile(0.99);
+                result.max = histogram.GetMax();
+                return result;
+            }
+
+            std::chrono::microseconds ElapsedSince(std::chrono::steady_clock::time_point started) {
+                return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+            }
+
+            // 保护线程完成至少 minimumPasses 轮、且当前没有正在进行的一轮
+            bool WaitForPasses(const CpuCoreManager& manager, uint64_t minimumPasses) {
+                const ManagerMetrics& metrics = manager.GetMetrics();
+                auto deadline = std::chrono::steady_clock::now() + PASS_WAIT_TIMEOUT;
+                for (;;) {
+                    uint64_t finished = metrics.passTime.GetCount();
+                    if (finished >= minimumPasses && finished == metrics.passes.load(std::memory_order_relaxed)) {
+                        return true;
+                    }
+                    if (std::chrono::steady_clock::now() >= deadline) {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+
+            // 事件路径已查询 targetQueries 个进程并处理完毕
+            bool WaitForQueries(const CpuCoreManager& manager, const SimulatedProcessBackend& backend, uint64_t targetQueries) {
+                auto deadline = std::chrono::steady_clock::now() + PASS_WAIT_TIMEOUT;
+                while (backend.GetQueryProcessCount() < targetQueries) {
+                    if (std::chrono::steady_clock::now() >= deadline) {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                }
+                return WaitForPasses(manager, 0);
+            }
+
+            size_t ChurnPerStep(const BenchmarkOptions& options, size_t processCount) {
+                double churn = std::round(static_cast<double>(processCount) * options.churnRatio);
+                return std::max<size_t>(1, static_cast<size_t>(churn));
+            }
+
+            void RunConfiguration(const BenchmarkOptions& options, size_t processCount,
+                const std::vector<ProcessTraceRecord>& trace, std::vector<BenchmarkResult>& results) {
+                SimulatedSystemOptions system;
+                system.processCount = processCount;
+                system.coreCount = options.coreCount;
+                system.deniedRatio = options.deniedRatio;
+                system.seed = options.seed;
+
+                auto backendOwner = std::make_unique<SimulatedProcessBackend>(system);
+                SimulatedProcessBackend& backend = *backendOwner;
+                CpuCoreManager manager(std::move(backendOwner));
+                manager.SetActionConsoleOutput(false);
+
+                DWORD reservedCore = options.coreCount - 1;
+                size_t churn = ChurnPerStep(options, processCount);
+                auto enabled = [&options](const char* scenario) { return options.scenarios.count(scenario) != 0; };
+
+                if (enabled("reserve")) {
+                    LatencyHistogram histogram;
+                    for (size_t i = 0; i < options.iterations; i++) {
+                        backend.ResetAffinities();
+                        ScopedSilence silence;
+                        auto started = std::chrono::steady_clock::now();
+                        manager.ReserveCoreForCurrentProcess(reservedCore);
+                        histogram.Record(ElapsedSince(started));
+                    }
+                    results.push_back(Summarize("reserve", options, processCount, histogram));
+                    backend.ResetAffinities();
+                }
+
+                if (enabled("available")) {
+                    LatencyHistogram histogram;
+                    manager.SetIdleCoreCriteria(20.0, 1);
+                    for (size_t i = 0; i < options.iterations; i++) {
+                        ScopedSilence silence;
+                        auto started = std::chrono::steady_clock::now();
+                        manager.GetAvailableCores();
+                        histogram.Record(ElapsedSince(started));
+                    }
+                    results.push_back(Summarize("available", options, processCount, histogram));
+                }
+
+                bool needsProtection = enabled("initial") || enabled("sweep") || enabled("events") ||
+                    (enabled("replay") && !trace.empty());
+                if (!needsProtection) {
+                    return;
+                }
+
+                {
+                    ScopedSilence silence;
+                    auto started = std::chrono::steady_clock::now();
+                    manager.StartMultiCoreProtection(std::vector<DWORD>(1, reservedCore));
+                    if (!WaitForPasses(manager, 1)) {
+                        std::cerr << "等待首次全量扫描超时" << std::endl;
+                        manager.StopCoreProtection();
+                        return;
+                    }
+                    if (enabled("initial")) {
+                        LatencyHistogram histogram;
+                        histogram.Record(ElapsedSince(started));
+                        results.push_back(Summarize("initial", options, processCount, histogram));
+                    }
+                }
+
+                if (enabled("sweep")) {
+                    LatencyHistogram histogram;
+                    for (size_t i = 0; i < options.iterations; i++) {
+                        backend.Churn(churn, churn, false);
+                        uint64_t finished = manager.GetMetrics().passTime.GetCount();
+                        auto started = std::chrono::steady_clock::now();
+                        backend.RequestResync();
+                        if (!WaitForPasses(manager, finished + 1)) {
+                            std::cerr << "等待全量扫描超时" << std::endl;
+                            break;
+                        }
+                        histogram.Record(ElapsedSince(started));
+                    }
+                    results.push_back(Summarize("sweep", options, processCount, histogram));
+                }
+
+                if (enabled("events")) {
+                    LatencyHistogram histogram;
+                    size_t created = std::min(churn, MAX_EVENTS_PER_STEP);
+                    for (size_t i = 0; i < options.iterations; i++) {
+                        uint64_t target = backend.GetQueryProcessCount() + created;
+                        auto started = std::chrono::steady_clock::now();
+                        backend.Churn(created, created, true);
+                        if (!WaitForQueries(manager, backend, target)) {
+                            std::cerr << "等待事件处理超时" << std::endl;
+                            break;
+                        }
+                        histogram.Record(ElapsedSince(started));
+                    }
+                    results.push_back(Summarize("events", options, processCount, histogram));
+                }
+
+                if (enabled("replay") && !trace.empty()) {
+                    LatencyHistogram histogram;
+                    auto step = std::chrono::microseconds(static_cast<int64_t>(options.traceStepMilliseconds * 1000.0));
+                    size_t next = 0;
+                    while (next < trace.size()) {
+                        // 一个时间片内的记录一次送达，模拟事件突发
+                        auto sliceEnd = trace[next].offset + step;
+                        std::set<DWORD> queried;
+                        bool overflow = false;
+                        uint64_t finished = manager.GetMetrics().passTime.GetCount();
+                        uint64_t queries = backend.GetQueryProcessCount();
+
+                        auto started = std::chrono::steady_clock::now();
+                        for (; next < trace.size() && trace[next].offset < sliceEnd; next++) {
+                            const ProcessTraceRecord& record = trace[next];
+                            if (record.type == ProcessEvent::Type::Overflow) {
+                                backend.RequestResync();
+                                overflow = true;
+                                continue;
+                            }
+                            if (record.type != ProcessEvent::Type::Exited) {
+                                queried.insert(record.processId);
+                            }
+                            backend.Apply(record, true);
+                        }
+
+                        // 事件丢失时待处理队列被全量扫描取代，只等待扫描完成
+                        bool completed = overflow || queried.size() > MAX_EVENTS_PER_STEP
+                            ? WaitForPasses(manager, finished + 1)
+                            : WaitForQueries(manager, backend, queries + queried.size());
+                        if (!completed) {
+                            std::cerr << "等待轨迹回放处理超时" << std::endl;
+                            break;
+                        }
+                        histogram.Record(ElapsedSince(started));
+                    }
+                    results.push_back(Summarize("replay", options, processCount, histogram));
+                }
+
+                ScopedSilence silence;
+                manager.StopCoreProtection();
+            }
+
+            void PrintResults(const std::vector<BenchmarkResult>& results) {
+                // 列名与 CSV 表头一致（中文字符宽度不定，无法用 setw 对齐）
+                std::cout << std::left << std::setw(12) << "scenario" << std::right
+                    << std::setw(10) << "processes" << std::setw(8) << "cores" << std::setw(8) << "samples"
+                    << std::setw(12) << "mean_us" << std::setw(12) << "p50_us" << std::setw(12) << "p99_us"
+                    << std::setw(12) << "max_us" << std::endl;
+                for (const BenchmarkResult& result : results) {
+                    std::cout << std::left << std::setw(12) << result.scenario << std::right
+                        << std::setw(10) << result.processCount << std::setw(8) << result.coreCount
+                        << std::setw(8) << result.samples << std::setw(12) << std::fixed << std::setprecision(1) << result.mean
+                        << std::setw(12) << result.p50 << std::setw(12) << result.p99 << std::setw(12) << result.max << std::endl;
+                }
+            }
+
+            bool WriteCsv(const std::string& path, const std::vector<BenchmarkResult>& results) {
+                std::ofstream file(path, std::ios::trunc);
+                if (!file.is_open()) {
+                    return false;
+                }
+
+                file << "scenario,processes,cores,churn,denied,samples,mean_us,p50_us,p99_us,max_us\n";
+                for (const BenchmarkResult& result : results) {
+                    file << result.scenario << "," << result.processCount << "," << result.coreCount << ","
+                        << result.churnRatio << "," << result.deniedRatio << "," << result.samples << ","
+                        << result.mean << "," << result.p50 << "," << result.p99 << "," << result.max << "\n";
+                }
+                return file.good();
+            }
+
+            bool ReadCsv(const std::string& path, std::map<std::string, BenchmarkResult>& results) {
+                std::ifstream file(path);
+                if (!file.is_open()) {
+                    return false;
+                }
+
+                std::string line;
+                std::getline(file, line);   // 表头
+                while (std::getline(file, line)) {
+                    std::istringstream fields(line);
+                    BenchmarkResult result;
+                    char comma;
+                    if (!std::getline(fields, result.scenario, ',') ||
+                        !(fields >> result.processCount >> comma >> result.coreCount >> comma >> result.churnRatio >> comma
+                            >> result.deniedRatio >> comma >> result.samples >> comma >> result.mean >> comma
+                            >> result.p50 >> comma >> result.p99 >> comma >> result.max)) {
+                        continue;
+                    }
+                    results[result.Key()] = result;
+                }
+                return true;
+            }
+
+            // 按 p50 比较，p99 受调度抖动影响过大，不作为门禁
+            int CompareWithBaseline(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results) {
+                std::map<std::string, BenchmarkResult> baseline;
+                if (!ReadCsv(options.baselinePath, baseline)) {
+                    std::cerr << "无法读取基线文件: " << options.baselinePath << std::endl;
+                    return 2;
+                }
+
+                int regressions = 0;
+                std::cout << "\n=== 与基线比较（容差 " << options.tolerance * 100 << "%） ===" << std::endl;
+                for (const BenchmarkResult& result : results) {
+                    auto it = baseline.find(result.Key());
+                    if (it == baseline.end() || it->second.p50 == 0) {
+                        continue;
+                    }
+
+                    double ratio = static_cast<double>(result.p50) / static_cast<double>(it->second.p50);
+                    bool regressed = ratio > 1.0 + options.tolerance;
+                    std::cout << std::left << std::setw(12) << result.scenario << std::right << std::setw(10) << result.processCount
+                        << "  p50 " << it->second.p50 << " -> " << result.p50 << " us ("
+                        << std::fixed << std::setprecision(2) << ratio << "x)" << (regressed ? "  退化" : "") << std::endl;
+                    if (regressed) {
+                        regressions++;
+                    }
+                }
+                return regressions > 0 ? 1 : 0;
+            }
+
+            // 用当前平台的事件源录制进程变动，供之后回放
+            int RecordTrace(const BenchmarkOptions& options) {
+                RaiseFileDescriptorLimit();
+                std::unique_ptr<IProcessEventSource> source = CreatePlatformEventSource();
+                std::unique_ptr<IProcessBackend> backend = CreatePlatformBackend();
+
+                std::mutex mutex;
+                std::vector<ProcessTraceRecord> records;
+                auto started = std::chrono::steady_clock::now();
+                bool listening = source && source->Start([&](const ProcessEvent& event) {
+                    ProcessTraceRecord record;
+                    record.offset = ElapsedSince(started);
+                    record.type = event.type;
+                    record.processId = event.processId;
+                    record.parentProcessId = event.parentProcessId;
+
+                    // 新进程可能很快退出，在事件线程上立即取进程名
+                    ProcessEntry entry;
+                    if (event.type != ProcessEvent::Type::Exited && event.type != ProcessEvent::Type::Overflow &&
+                        backend->QueryProcess(event.processId, entry)) {
+                        record.name = entry.name;
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    records.push_back(std::move(record));
+                });
+                if (!listening) {
+                    std::cerr << "进程事件监听不可用（需要管理员权限）" << std::endl;
+                    return 2;
+                }
+
+                std::cout << "正在录制进程变动 " << options.recordSeconds << " 秒..." << std::endl;
+                std::this_thread::sleep_for(std::chrono::seconds(options.recordSeconds));
+                source->Stop();
+
+                if (!SaveProcessTrace(options.recordPath, records)) {
+                    std::cerr << "写入轨迹文件失败: " << options.recordPath << std::endl;
+                    return 2;
+                }
+                std::cout << "已录制 " << records.size() << " 条记录: " << options.recordPath << std::endl;
+                return 0;
+            }
+
+            std::vector<std::string> SplitList(const std::string& text) {
+                std::vector<std::string> items;
+                std::istringstream stream(text);
+                std::string item;
+                while (std::getline(stream, item, ',')) {
+                    if (!item.empty()) {
+                        items.push_back(item);
+                    }
+                }
+                return items;
+            }
+
+            void PrintUsage() {
+                std::cout <<
+                    "用法: CpuCoreBenchmark [选项]\n"
+                    "  --processes 1000,10000,50000   进程数（可多个）\n"
+                    "  --cores 64                     逻辑处理器数（1~1024）\n"
+                    "  --churn 0.01                   每轮替换的进程比例\n"
+                    "  --denied 0.05                  无权修改亲和性的进程比例\n"
+                    "  --iterations 20                每个场景的样本数\n"
+                    "  --seed 1                       随机数种子\n"
+                    "  --scenarios initial,sweep,events,replay,reserve,available\n"
+                    "  --trace <文件>                 回放进程变动轨迹\n"
+                    "  --trace-step 100               回放时每个样本覆盖的轨迹时间（毫秒）\n"
+                    "  --csv <文件>                   结果写入 CSV\n"
+                    "  --baseline <文件>              与基线 CSV 比较 p50，退化超过容差时返回 1\n"
+                    "  --tolerance 0.15               基线比较容差\n"
+                    "  --record-trace <文件>          用当前平台事件源录制轨迹后退出\n"
+                    "  --duration 60                  录制时长（秒）\n";
+            }
+
+            bool ParseArguments(int argc, char* argv[], BenchmarkOptions& options) {
+                for (int i = 1; i < argc; i++) {
+                    std::string name = argv[i];
+                    if (name == "--help" || name == "-h") {
+                        return false;
+                    }
+                    if (i + 1 >= argc) {
+                        std::cerr << "缺少参数值: " << name << std::endl;
+                        return false;
+                    }
+
+                    std::string value = argv[++i];
+                    if (name == "--processes") {
+                        options.processCounts.clear();
+                        for (const std::string& item : SplitList(value)) {
+                            options.processCounts.push_back(std::strtoul(item.c_str(), nullptr, 10));
+                        }
+                    }
+                    else if (name == "--cores") {
+                        options.coreCount = std::min<DWORD>(std::max<DWORD>(std::strtoul(value.c_str(), nullptr, 10), 2), 1024);
+                    }
+                    else if (name == "--churn") {
+                        options.churnRatio = std::atof(value.c_str());
+                    }
+                    else if (name == "--denied") {
+                        options.deniedRatio = std::atof(value.c_str());
+                    }
+                    else if (name == "--iterations") {
+                        options.iterations = std::max<size_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+                    }
+                    else if (name == "--seed") {
+                        options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+                    }
+                    else if (name == "--scenarios") {
+                        std::vector<std::string> scenarios = SplitList(value);
+                        options.scenarios = std::set<std::string>(scenarios.begin(), scenarios.end());
+                    }
+                    else if (name == "--trace") {
+                        options.tracePath = value;
+                    }
+                    else if (name == "--trace-step") {
+                        options.traceStepMilliseconds = std::max(0.001, std::atof(value.c_str()));
+                    }
+                    else if (name == "--csv") {
+                        options.csvPath = value;
+                    }
+                    else if (name == "--baseline") {
+                        options.baselinePath = value;
+                    }
+                    else if (name == "--tolerance") {
+                        options.tolerance = std::atof(value.c_str());
+                    }
+                    else if (name == "--record-trace") {
+                        options.recordPath = value;
+                    }
+                    else if (name == "--duration") {
+                        options.recordSeconds = std::max(1, std::atoi(value.c_str()));
+                    }
+                    else {
+                        std::cerr << "未知参数: " << name << std::endl;
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+
+        int RunBenchmark(int argc, char* argv[]) {
+            BenchmarkOptions options;
+            if (!ParseArguments(argc, argv, options)) {
+                PrintUsage();
+                return 2;
+            }
+
+            if (!options.recordPath.empty()) {
+                return RecordTrace(options);
+            }
+
+            std::vector<ProcessTraceRecord> trace;
+            if (!options.tracePath.empty() && !LoadProcessTrace(options.tracePath, trace)) {
+                std::cerr << "无法读取轨迹文件: " << options.tracePath << std::endl;
+                return 2;
+            }
+
+            std::vector<BenchmarkResult> results;
+            for (size_t processCount : options.processCounts) {
+                std::cout << "正在测试 " << processCount << " 个进程、" << options.coreCount << " 个核心..." << std::endl;
+                RunConfiguration(options, processCount, trace, results);
+            }
+
+            std::cout << std::endl;
+            PrintResults(results);
+
+            if (!options.csvPath.empty() && !WriteCsv(options.csvPath, results)) {
+                std::cerr << "写入 CSV 失败: " << options.csvPath << std::endl;
+            }
+            if (!options.baselinePath.empty()) {
+                return CompareWithBaseline(options, results);
+            }
+            return 0;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return SamsunIoCardC::CpuManager::RunBenchmark(argc, argv);
+}
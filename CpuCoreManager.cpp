@@ -2,56 +2,151 @@
 #include "CpuCoreManager.h"
 #include <iostream>
 #include <thread>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
 #include <chrono>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
+
+#ifdef _WIN32
 #include <shellapi.h>
+#else
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
 
 namespace SamsunIoCardC {
     namespace CpuManager {
 
+        namespace {
+            // 待处理队列上限，超过后改为立即全量扫描，避免进程风暴时无限增长
+            const size_t MAX_PENDING_PROCESSES = 4096;
+            // 一次抖动测量最多记录的扫描发现
+            const size_t MAX_JITTER_OCCUPANTS = 65536;
+            // 进程名索引的最长有效期，超过后按需查询会先刷新一次快照
+            const auto NAME_INDEX_MAX_AGE = std::chrono::seconds(2);
+
+            // 本轮是否有活动：出现了新进程，或有进程（例如自行重置了亲和性）被重新排除
+            // 无权限修改的进程每次复检都会失败，不计为活动，否则间隔永远无法退避
+            bool HasScanActivity(size_t newProcesses, const std::vector<AffinityApplyResult>& results) {
+                if (newProcesses > 0) {
+                    return true;
+                }
+                return std::any_of(results.begin(), results.end(), [](const AffinityApplyResult& result) {
+                    return result.status == AffinityApplyStatus::Succeeded;
+                });
+            }
+
+            // 与 C# 服务一致，核心数规则使用编号最低的若干个可用核心
+            CpuSet SelectLowestCores(const CpuSet& allowed, DWORD coreCount) {
+                CpuSet cores;
+                DWORD count = 0;
+                for (size_t cpu = allowed.First(); cpu != CpuSet::npos && count < coreCount; cpu = allowed.Next(cpu)) {
+                    cores.Set(cpu);
+                    count++;
+                }
+                return cores;
+            }
+
+            // 规则的目标亲和性：可用核心为 system 去掉 avoided（去掉后为空时使用全部核心）
+            bool PlanRuleAffinity(const ProcessRuleMatch& match, const CpuSet& system, const CpuSet& avoided, CpuSet& target) {
+                CpuSet allowed = system;
+                allowed.AndNot(avoided);
+                if (allowed.Empty()) {
+                    allowed = system;
+                }
+
+                target = match.cores ? *match.cores & allowed : SelectLowestCores(allowed, match.coreCount);
+                return !target.Empty();
+            }
+
+            // nodes 上的常驻内存占比（百分比），没有常驻内存或无法统计时返回 -1
+            double LocalMemoryPercent(const std::vector<uint64_t>& kilobytesPerNode, const CpuSet& nodes) {
+                uint64_t total = 0;
+                uint64_t local = 0;
+                for (size_t node = 0; node < kilobytesPerNode.size(); node++) {
+                    total += kilobytesPerNode[node];
+                    if (nodes.Test(node)) {
+                        local += kilobytesPerNode[node];
+                    }
+                }
+                return total > 0 ? 100.0 * static_cast<double>(local) / static_cast<double>(total) : -1.0;
+            }
+        }
+
         // =============================================================================
         // CpuCoreManager 类实现
         // =============================================================================
 
         CpuCoreManager::CpuCoreManager()
-            : m_isProtectionActive(false)
-            , m_protectedCore(0)
-            , m_protectionThread(nullptr)
+            : CpuCoreManager(CreatePlatformBackend())
+        {
+        }
+
+        CpuCoreManager::CpuCoreManager(std::unique_ptr<IProcessBackend> backend)
+            : m_backend(std::move(backend))
+            , m_handleCache(*m_backend)
+            , m_batchApplier(*m_backend, m_handleCache)
+            , m_utilizationSampler(*m_backend)
+            , m_idleThresholdPercent(20.0)
+            , m_reservationMode(ReservationMode::Affinity)
+            , m_irqSteeringEnabled(false)
+            , m_isProtectionActive(false)
+            , m_reservationControlRunning(false)
+            , m_resyncRequested(false)
+            , m_historyRecording(false)
         {
+            auto config = std::make_shared<ProtectionConfig>();
+            config->processRules = std::make_shared<ProcessRuleSet>();
+            m_config = std::move(config);
+
+            m_actionDispatcher.AddSink([this](const ProcessActionEvent& event) {
+                OnActionEvent(event);
+            });
+            m_actionDispatcher.Start();
         }
 
         CpuCoreManager::~CpuCoreManager() {
+            m_configWatcher.Stop();
+            m_metricsExporter.Stop();
+            StopReservationController();
             StopCoreProtection();
+            // 处理完剩余事件后才能释放回调
+            m_actionDispatcher.Stop();
+            StopHistoryRecording();
         }
 
-        bool CpuCoreManager::SetProcessAffinity(DWORD_PTR affinityMask) {
-            HANDLE hProcess = GetCurrentProcess();
+        bool CpuCoreManager::SetProcessAffinity(const CpuSet& affinity) {
+            ProcessHandle self = m_backend->OpenSelf();
 
-            if (!SetProcessAffinityMask(hProcess, affinityMask)) {
+            if (!m_backend->ApplyAffinity(self, affinity)) {
                 std::cerr << "设置CPU亲和性失败，错误码: " << GetLastError() << std::endl;
                 return false;
             }
 
-            std::cout << "成功设置进程CPU亲和性掩码: 0x" << std::hex << affinityMask << std::dec << std::endl;
+            std::cout << "成功设置进程CPU亲和性: " << affinity.ToString() << std::endl;
             return true;
         }
 
-        DWORD_PTR CpuCoreManager::GetProcessAffinity() {
-            HANDLE hProcess = GetCurrentProcess();
-            DWORD_PTR processAffinityMask = 0;
-            DWORD_PTR systemAffinityMask = 0;
+        CpuSet CpuCoreManager::GetProcessAffinity() {
+            ProcessHandle self = m_backend->OpenSelf();
+            CpuSet processAffinity;
+            CpuSet systemAffinity;
 
-            if (!GetProcessAffinityMask(hProcess, &processAffinityMask, &systemAffinityMask)) {
+            if (!m_backend->QueryAffinity(self, processAffinity, systemAffinity)) {
                 std::cerr << "获取CPU亲和性失败，错误码: " << GetLastError() << std::endl;
-                return 0;
+                return CpuSet();
             }
 
-            return processAffinityMask;
+            return processAffinity;
         }
 
         bool CpuCoreManager::SetProcessPriorityLevel(DWORD priorityClass) {
-            HANDLE hProcess = GetCurrentProcess();
+            ProcessHandle self = m_backend->OpenSelf();
 
-            if (!SetPriorityClass(hProcess, priorityClass)) {
+            if (!m_backend->SetPriority(self, priorityClass)) {
                 std::cerr << "设置进程优先级失败，错误码: " << GetLastError() << std::endl;
                 return false;
             }
@@ -61,23 +156,21 @@ namespace SamsunIoCardC {
         }
 
         void CpuCoreManager::DisplayCpuCoreInfo() {
-            SYSTEM_INFO sysInfo = GetSystemInfo();
+            ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
 
             std::cout << "=== CPU系统信息 ===" << std::endl;
             std::cout << "CPU核心数: " << sysInfo.dwNumberOfProcessors << std::endl;
-            std::cout << "活动处理器掩码: 0x" << std::hex << sysInfo.dwActiveProcessorMask << std::dec << std::endl;
+            std::cout << "活动处理器: " << sysInfo.activeProcessors.ToString() << std::endl;
 
             std::cout << "可用CPU核心: ";
-            for (DWORD i = 0; i < sysInfo.dwNumberOfProcessors; i++) {
-                if (sysInfo.dwActiveProcessorMask & (1ULL << i)) {
-                    std::cout << i << " ";
-                }
+            for (size_t cpu = sysInfo.activeProcessors.First(); cpu != CpuSet::npos; cpu = sysInfo.activeProcessors.Next(cpu)) {
+                std::cout << cpu << " ";
             }
             std::cout << std::endl;
         }
 
         bool CpuCoreManager::BindToSingleCore(DWORD coreIndex) {
-            SYSTEM_INFO sysInfo = GetSystemInfo();
+            ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
 
             if (coreIndex >= sysInfo.dwNumberOfProcessors) {
                 std::cerr << "错误: 核心索引 " << coreIndex << " 超出范围 (0-"
@@ -85,19 +178,17 @@ namespace SamsunIoCardC {
                 return false;
             }
 
-            DWORD_PTR affinityMask = 1ULL << coreIndex;
-
-            if (!(sysInfo.dwActiveProcessorMask & affinityMask)) {
+            if (!sysInfo.activeProcessors.Test(coreIndex)) {
                 std::cerr << "错误: CPU核心 " << coreIndex << " 不可用" << std::endl;
                 return false;
             }
 
-            return SetProcessAffinity(affinityMask);
+            return SetProcessAffinity(CpuSet::Single(coreIndex));
         }
 
-        bool CpuCoreManager::BindToMultipleCores(const std::vector<DWORD>& coreIndices) {
-            SYSTEM_INFO sysInfo = GetSystemInfo();
-            DWORD_PTR affinityMask = 0;
+        bool CpuCoreManager::BindToMultipleCores(const std::vector<DWORD>& coreIndices, const ProcessMemoryPolicy& memoryPolicy) {
+            ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
+            CpuSet affinity;
 
             for (DWORD coreIndex : coreIndices) {
                 if (coreIndex >= sysInfo.dwNumberOfProcessors) {
@@ -105,125 +196,194 @@ namespace SamsunIoCardC {
                     return false;
                 }
 
-                DWORD_PTR coreMask = 1ULL << coreIndex;
-                if (!(sysInfo.dwActiveProcessorMask & coreMask)) {
+                if (!sysInfo.activeProcessors.Test(coreIndex)) {
                     std::cerr << "错误: CPU核心 " << coreIndex << " 不可用" << std::endl;
                     return false;
                 }
 
-                affinityMask |= coreMask;
+                affinity.Set(coreIndex);
+            }
+
+            if (!SetProcessAffinity(affinity)) {
+                return false;
+            }
+            if (memoryPolicy.IsEmpty()) {
+                return true;
             }
 
-            return SetProcessAffinity(affinityMask);
+            ProcessEntry self;
+            self.processId = m_backend->GetCurrentPid();
+            m_backend->QueryProcess(self.processId, self);
+            bool applied = ApplyMemoryPolicy(self, m_backend->OpenSelf(), memoryPolicy, affinity, m_backend->GetCpuTopology());
+            // 结果由事件分发线程输出，等待输出完成再返回
+            m_actionDispatcher.Flush();
+            return applied;
         }
 
-        DWORD_PTR CpuCoreManager::GetProcessAffinityByPID(DWORD processId) {
-            HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, processId);
-            if (hProcess == NULL) {
-                return 0;
+        CpuSet CpuCoreManager::GetProcessAffinityByPID(DWORD processId) {
+            ProcessHandle handle = m_backend->Open(processId, ProcessAccess::Query);
+            if (!handle.IsValid()) {
+                return CpuSet();
             }
 
-            DWORD_PTR processAffinityMask = 0;
-            DWORD_PTR systemAffinityMask = 0;
+            CpuSet processAffinity;
+            CpuSet systemAffinity;
 
-            if (!GetProcessAffinityMask(hProcess, &processAffinityMask, &systemAffinityMask)) {
-                CloseHandle(hProcess);
-                return 0;
+            if (!m_backend->QueryAffinity(handle, processAffinity, systemAffinity)) {
+                return CpuSet();
             }
 
-            CloseHandle(hProcess);
-            return processAffinityMask;
+            return processAffinity;
         }
 
-        std::map<DWORD, DWORD_PTR> CpuCoreManager::GetAllProcessesAffinity() {
-            std::map<DWORD, DWORD_PTR> processAffinityMap;
+        std::map<DWORD, CpuSet> CpuCoreManager::GetAllProcessesAffinity() {
+            std::map<DWORD, CpuSet> processAffinityMap;
 
-            HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-            if (hSnapshot == INVALID_HANDLE_VALUE) {
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
                 std::cerr << "创建进程快照失败，错误码: " << GetLastError() << std::endl;
                 return processAffinityMap;
             }
 
-            PROCESSENTRY32 pe32;
-            pe32.dwSize = sizeof(PROCESSENTRY32);
-
-            if (!Process32First(hSnapshot, &pe32)) {
-                std::cerr << "遍历进程失败，错误码: " << GetLastError() << std::endl;
-                CloseHandle(hSnapshot);
-                return processAffinityMap;
-            }
-
-            do {
-                if (pe32.th32ProcessID == 0 || pe32.th32ProcessID == 4 ||
-                    pe32.th32ProcessID == GetCurrentProcessId()) {
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            for (const ProcessEntry& process : processes) {
+                if (IsSkippedProcess(process, *config)) {
                     continue;
                 }
 
-                DWORD_PTR affinity = GetProcessAffinityByPID(pe32.th32ProcessID);
-                if (affinity != 0) {
-                    processAffinityMap[pe32.th32ProcessID] = affinity;
+                CpuSet affinity = GetProcessAffinityByPID(process.processId);
+                if (!affinity.Empty()) {
+                    processAffinityMap[process.processId] = std::move(affinity);
                 }
-            } while (Process32Next(hSnapshot, &pe32));
+            }
 
-            CloseHandle(hSnapshot);
             return processAffinityMap;
         }
 
         std::string CpuCoreManager::GetProcessName(DWORD processId) {
-            HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-            if (hSnapshot == INVALID_HANDLE_VALUE) {
-                return "Unknown";
+            ProcessName name = FindProcessName(processId);
+            return name ? *name : std::string("Unknown");
+        }
+
+        ProcessName CpuCoreManager::FindProcessName(DWORD processId) {
+            // 保护线程运行时索引每轮扫描都会刷新；否则一批查询共用一次快照
+            if (m_nameIndex.Age() > NAME_INDEX_MAX_AGE) {
+                std::vector<ProcessEntry> processes;
+                SnapshotProcesses(processes);
             }
 
-            PROCESSENTRY32 pe32;
-            pe32.dwSize = sizeof(PROCESSENTRY32);
+            ProcessName name = m_nameIndex.Find(processId);
+            if (name) {
+                return name;
+            }
 
-            if (Process32First(hSnapshot, &pe32)) {
-                do {
-                    if (pe32.th32ProcessID == processId) {
-                        CloseHandle(hSnapshot);
-                        return Utils::WideStringToString(pe32.szExeFile);
-                    }
-                } while (Process32Next(hSnapshot, &pe32));
+            // 上次刷新之后创建的进程只查询这一个 PID
+            ProcessEntry process;
+            if (!m_backend->QueryProcess(processId, process)) {
+                return ProcessName();
             }
+            m_nameIndex.Insert(process);
+            return m_nameIndex.Find(processId);
+        }
 
-            CloseHandle(hSnapshot);
-            return "Unknown";
+        std::vector<DWORD> CpuCoreManager::GetProcessDescendants(DWORD processId) {
+            // 进程树与名称索引由同一次快照刷新
+            if (m_nameIndex.Age() > NAME_INDEX_MAX_AGE) {
+                std::vector<ProcessEntry> processes;
+                SnapshotProcesses(processes);
+            }
+            return m_processTree.GetDescendants(processId);
         }
 
         bool CpuCoreManager::ExcludeCoreFromProcess(DWORD processId, DWORD coreToExclude) {
-            HANDLE hProcess = OpenProcess(PROCESS_SET_INFORMATION | PROCESS_QUERY_INFORMATION, FALSE, processId);
-            if (hProcess == NULL) {
+            ProcessHandle handle = m_backend->Open(processId, ProcessAccess::QueryAndSet);
+            if (!handle.IsValid()) {
                 return false;
             }
 
-            DWORD_PTR processAffinityMask = 0;
-            DWORD_PTR systemAffinityMask = 0;
+            CpuSet processAffinity;
+            CpuSet systemAffinity;
 
-            if (!GetProcessAffinityMask(hProcess, &processAffinityMask, &systemAffinityMask)) {
-                CloseHandle(hProcess);
+            if (!m_backend->QueryAffinity(handle, processAffinity, systemAffinity)) {
                 return false;
             }
 
-            DWORD_PTR newAffinityMask = processAffinityMask & ~(1ULL << coreToExclude);
+            return m_backend->ApplyAffinity(handle, ComputeExcludedSet(processAffinity, systemAffinity, CpuSet::Single(coreToExclude)));
+        }
 
-            if (newAffinityMask == 0) {
-                for (int i = 0; i < 64; i++) {
-                    if (systemAffinityMask & (1ULL << i) && i != coreToExclude) {
-                        newAffinityMask = 1ULL << i;
-                        break;
-                    }
-                }
+        std::vector<ThreadUsage> CpuCoreManager::GetBusiestThreads(DWORD processId, DWORD intervalMilliseconds) {
+            std::vector<ThreadUsage> ranked;
+            ProcessEntry process;
+            if (!m_backend->QueryProcess(processId, process)) {
+                return ranked;
+            }
+
+            // 独立的统计记录：第一次只建立基准，间隔后的第二次得到区间消耗
+            ThreadActivityTracker tracker;
+            if (!tracker.Rank(*m_backend, process, ranked)) {
+                return ranked;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMilliseconds));
+            tracker.Rank(*m_backend, process, ranked);
+            return ranked;
+        }
+
+        bool CpuCoreManager::PinThread(DWORD threadId, const CpuSet& cores) {
+            if (!m_backend->ApplyThreadAffinity(threadId, cores)) {
+                std::cerr << "设置线程 " << threadId << " 亲和性失败，错误码: " << GetLastError() << std::endl;
+                return false;
+            }
+
+            std::cout << "线程 " << threadId << " 已绑定到核心: " << cores.ToString() << std::endl;
+            return true;
+        }
+
+        bool CpuCoreManager::ExcludeCoresFromThread(DWORD threadId, const CpuSet& cores) {
+            CpuSet affinity;
+            if (!m_backend->QueryThreadAffinity(threadId, affinity)) {
+                return false;
+            }
+
+            if (!affinity.Intersects(cores)) {
+                return true;
+            }
+            return m_backend->ApplyThreadAffinity(threadId,
+                ComputeExcludedSet(affinity, m_backend->GetProcessorInfo().activeProcessors, cores));
+        }
+
+        void CpuCoreManager::SetHotThreadRules(const std::vector<HotThreadRule>& rules) {
+            PublishConfig([&rules](ProtectionConfig& config) {
+                config.hotThreadRules = rules;
+            });
+
+            std::lock_guard<std::mutex> lock(m_hotThreadMutex);
+            m_threadTracker.Clear();
+        }
+
+        bool CpuCoreManager::LoadHotThreadRules(const std::string& iniPath) {
+            std::vector<HotThreadRule> rules;
+            if (!CpuManager::LoadHotThreadRules(iniPath, rules)) {
+                std::cerr << "无法读取配置文件: " << iniPath << std::endl;
+                return false;
             }
 
-            bool success = SetProcessAffinityMask(hProcess, newAffinityMask);
-            CloseHandle(hProcess);
+            std::cout << "已加载热点线程规则 " << rules.size() << " 条" << std::endl;
+            SetHotThreadRules(rules);
+            return true;
+        }
+
+        void CpuCoreManager::ApplyHotThreadRules() {
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
+                std::cerr << "创建进程快照失败，错误码: " << GetLastError() << std::endl;
+                return;
+            }
 
-            return success;
+            ApplyHotThreadRules(processes, *GetConfig());
         }
 
         bool CpuCoreManager::ReserveCoreForCurrentProcess(DWORD reservedCore) {
-            SYSTEM_INFO sysInfo = GetSystemInfo();
+            ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
 
             if (reservedCore >= sysInfo.dwNumberOfProcessors) {
                 std::cerr << "错误: 核心索引 " << reservedCore << " 超出范围" << std::endl;
@@ -231,135 +391,402 @@ namespace SamsunIoCardC {
             }
 
             std::cout << "\n=== 为当前进程保留CPU核心 " << reservedCore << " ===" << std::endl;
+            CpuSet reservedSet = CpuSet::Single(reservedCore);
+
+            // cgroup 方式只需常数次文件写入，之后创建的进程也不会使用保留核心
+            // 保留记录在配置快照中，之后的 RefreshReservation 不会把它释放
+            if (m_reservationMode == ReservationMode::Cgroup) {
+                bool reserved = false;
+                PublishConfig([&](ProtectionConfig& config) {
+                    config.reservedCores.assign(1, reservedCore);
+                    config.reservedSet = reservedSet;
+                    config.reservationHeld = true;
+                    config.reservedByCgroup = ApplyCgroupReservation(config);
+                    reserved = config.reservedByCgroup &&
+                        std::find(m_cgroupMembers.begin(), m_cgroupMembers.end(), m_backend->GetCurrentPid()) != m_cgroupMembers.end();
+                    if (config.reservedByCgroup && !reserved) {
+                        m_cgroupReservation.Release();
+                        config.reservedByCgroup = false;
+                    }
+                    config.reservationHeld = reserved;
+                });
+                if (reserved) {
+                    std::cout << "已通过 cgroup cpuset 分区保留核心 " << reservedCore << "，当前进程已移入保留组" << std::endl;
+                    return true;
+                }
+                std::cout << "cgroup 保留失败，改为修改其他进程的CPU亲和性" << std::endl;
+            }
 
-            HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-            if (hSnapshot == INVALID_HANDLE_VALUE) {
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
                 std::cerr << "创建进程快照失败" << std::endl;
                 return false;
             }
+            m_handleCache.Prune(processes);
+
+            std::vector<const ProcessEntry*> targets;
+            size_t skippedCount = 0;
+            targets.reserve(processes.size());
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            for (const ProcessEntry& process : processes) {
+                if (IsSkippedProcess(process, *config) || config->processRules->IsCritical(process.name)) {
+                    skippedCount++;
+                }
+                else {
+                    targets.push_back(&process);
+                }
+            }
+
+            std::cout << "正在修改其他进程的CPU亲和性..." << std::endl;
+            auto started = std::chrono::steady_clock::now();
+            std::vector<AffinityApplyResult> results;
+            ExcludeFromProcesses(targets, reservedSet, results);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
 
-            PROCESSENTRY32 pe32;
-            pe32.dwSize = sizeof(PROCESSENTRY32);
+            // 逐进程的结果由事件分发线程输出，等它输出完再打印统计
+            m_actionDispatcher.Flush();
 
-            int processedCount = 0;
             int successCount = 0;
-            int skipCount = 0;
+            int deniedCount = 0;
+            int exitedCount = 0;
+            int failedCount = 0;
+            for (const AffinityApplyResult& result : results) {
+                switch (result.status) {
+                case AffinityApplyStatus::Succeeded:
+                    successCount++;
+                    break;
+                case AffinityApplyStatus::Denied:
+                    deniedCount++;
+                    break;
+                case AffinityApplyStatus::Exited:
+                    exitedCount++;
+                    break;
+                case AffinityApplyStatus::Failed:
+                    failedCount++;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            std::cout << "\n=== 处理结果统计 ===" << std::endl;
+            std::cout << "总进程数: " << processes.size() << std::endl;
+            std::cout << "跳过系统进程: " << skippedCount << std::endl;
+            std::cout << "处理的进程: " << results.size() << std::endl;
+            std::cout << "成功修改: " << successCount << std::endl;
+            std::cout << "权限不足: " << deniedCount << std::endl;
+            std::cout << "进程已退出: " << exitedCount << std::endl;
+            std::cout << "其他失败: " << failedCount << std::endl;
+            std::cout << "耗时: " << elapsed.count() << " ms" << std::endl;
+
+            return true;
+        }
+
+        std::vector<AffinityApplyResult> CpuCoreManager::ExcludeCoresFromAllProcesses(const CpuSet& excluded) {
+            std::vector<AffinityApplyResult> results;
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
+                return results;
+            }
+            m_handleCache.Prune(processes);
+
+            std::vector<const ProcessEntry*> targets;
+            targets.reserve(processes.size());
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            for (const ProcessEntry& process : processes) {
+                if (!IsSkippedProcess(process, *config) && !config->processRules->IsCritical(process.name)) {
+                    targets.push_back(&process);
+                }
+            }
+
+            ExcludeFromProcesses(targets, excluded, results);
+            return results;
+        }
 
-            if (!Process32First(hSnapshot, &pe32)) {
-                CloseHandle(hSnapshot);
+        bool CpuCoreManager::LoadProcessRules(const std::string& iniPath) {
+            auto rules = std::make_shared<ProcessRuleSet>();
+            if (!rules->Load(iniPath)) {
+                std::cerr << "无法读取配置文件: " << iniPath << std::endl;
                 return false;
             }
 
-            std::cout << "正在修改其他进程的CPU亲和性..." << std::endl;
-            std::cout << "进程ID\t\t进程名\t\t\t\t状态" << std::endl;
-            std::cout << "-------\t\t--------\t\t\t--------" << std::endl;
-
-            do {
-                if (pe32.th32ProcessID == 0 ||
-                    pe32.th32ProcessID == 4 ||
-                    pe32.th32ProcessID == GetCurrentProcessId() ||
-                    IsSystemCriticalProcess(pe32.szExeFile)) {
-
-                    std::string processName = Utils::WideStringToString(pe32.szExeFile);
-                    std::cout << pe32.th32ProcessID << "\t\t" << processName << "\t\t\t跳过(系统进程)" << std::endl;
-                    skipCount++;
+            size_t ruleCount = rules->GetRuleCount();
+            PublishConfig([&rules](ProtectionConfig& config) {
+                config.processRules = std::move(rules);
+            });
+            std::cout << "已加载进程规则 " << ruleCount << " 条" << std::endl;
+            return true;
+        }
+
+        std::vector<AffinityApplyResult> CpuCoreManager::ApplyProcessRules() {
+            std::vector<AffinityApplyResult> results;
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
+                return results;
+            }
+            m_handleCache.Prune(processes);
+
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            const ProcessRuleSet& rules = *config->processRules;
+            std::vector<const ProcessEntry*> targets;
+            // 规则在批次开始前解析完毕，工作线程只读
+            std::unordered_map<DWORD, ResolvedProcessRules> resolved;
+            for (const ProcessEntry& process : processes) {
+                if (IsSkippedProcess(process, *config) || rules.IsCritical(process.name)) {
                     continue;
                 }
+                ResolvedProcessRules processRules = ResolveProcessRules(rules, m_processTree, process);
+                if (!processRules.IsEmpty()) {
+                    resolved.emplace(process.processId, processRules);
+                    targets.push_back(&process);
+                }
+            }
 
-                processedCount++;
+            CpuSet avoided;
+            if (m_isProtectionActive) {
+                avoided = config->reservedSet;
+            }
 
-                DWORD_PTR currentAffinity = GetProcessAffinityByPID(pe32.th32ProcessID);
-                if (currentAffinity & (1ULL << reservedCore)) {
-                    std::string processName = Utils::WideStringToString(pe32.szExeFile);
+            m_batchApplier.Run(targets, [&resolved, &avoided](const ProcessEntry& process, const CpuSet&, const CpuSet& system, CpuSet& target) {
+                const ProcessRuleMatch& match = resolved.at(process.processId).match;
+                return match.kind != ProcessRuleKind::None && PlanRuleAffinity(match, system, avoided, target);
+            }, results);
 
-                    if (ExcludeCoreFromProcess(pe32.th32ProcessID, reservedCore)) {
-                        std::cout << pe32.th32ProcessID << "\t\t" << processName << "\t\t\t成功排除" << std::endl;
-                        successCount++;
+            RecordApplyResults(results, std::chrono::steady_clock::time_point());
 
-                        if (m_processDetectedCallback) {
-                            m_processDetectedCallback(pe32.th32ProcessID, processName);
-                        }
-                    }
-                    else {
-                        std::cout << pe32.th32ProcessID << "\t\t" << processName << "\t\t\t失败(权限不足)" << std::endl;
-                    }
+            // 调度设置使用亲和性批次已打开的缓存句柄
+            for (const ProcessEntry* process : targets) {
+                ApplySchedulingRule(*process, resolved.at(process->processId).scheduling);
+            }
+
+            // 内存策略按亲和性批次之后的实际亲和性推导节点
+            CpuTopology topology;
+            for (const ProcessEntry* process : targets) {
+                const ProcessMemoryPolicy* memoryPolicy = resolved.at(process->processId).memoryPolicy;
+                if (memoryPolicy == nullptr) {
+                    continue;
                 }
-                else {
-                    std::string processName = Utils::WideStringToString(pe32.szExeFile);
-                    std::cout << pe32.th32ProcessID << "\t\t" << processName << "\t\t\t无需修改" << std::endl;
+                if (topology.numaNodes.empty()) {
+                    topology = m_backend->GetCpuTopology();
+                }
+
+                ProcessHandle handle;
+                CpuSet processSet;
+                CpuSet systemSet;
+                if (QueryCachedAffinity(*process, handle, processSet, systemSet)) {
+                    ApplyMemoryPolicy(*process, handle, *memoryPolicy, processSet, topology);
+                }
+            }
+
+            for (const AffinityApplyResult& result : results) {
+                if (result.status != AffinityApplyStatus::Unchanged) {
+                    PublishAction(ProcessActionEvent::Type::RuleApplied, AffinityApplyResult(result));
                 }
+            }
+            return results;
+        }
 
-            } while (Process32Next(hSnapshot, &pe32));
+        std::vector<AffinityApplyResult> CpuCoreManager::ApplyAffinityBatch(const std::vector<AffinityRequest>& requests) {
+            std::vector<AffinityApplyResult> results(requests.size());
+            for (size_t i = 0; i < requests.size(); i++) {
+                results[i].processId = requests[i].processId;
+                results[i].status = AffinityApplyStatus::Exited;
+            }
 
-            CloseHandle(hSnapshot);
+            std::vector<ProcessEntry> processes;
+            if (requests.empty() || !SnapshotProcesses(processes)) {
+                return results;
+            }
+            m_handleCache.Prune(processes);
 
-            std::cout << "\n=== 处理结果统计 ===" << std::endl;
-            std::cout << "总进程数: " << (processedCount + skipCount) << std::endl;
-            std::cout << "跳过系统进程: " << skipCount << std::endl;
-            std::cout << "处理的进程: " << processedCount << std::endl;
-            std::cout << "成功修改: " << successCount << std::endl;
+            // 同一 PID 出现多次时以最后一项为准
+            std::unordered_map<DWORD, size_t> requestIndex;
+            for (size_t i = 0; i < requests.size(); i++) {
+                requestIndex[requests[i].processId] = i;
+            }
+            std::vector<const ProcessEntry*> targets;
+            for (const ProcessEntry& process : processes) {
+                if (requestIndex.count(process.processId) != 0) {
+                    targets.push_back(&process);
+                }
+            }
+
+            CpuSet avoided;
+            if (m_isProtectionActive) {
+                avoided = GetConfig()->reservedSet;
+            }
+
+            std::vector<AffinityApplyResult> applied;
+            m_batchApplier.Run(targets, [&](const ProcessEntry& process, const CpuSet&, const CpuSet& system, CpuSet& target) {
+                const AffinityRequest& request = requests[requestIndex.at(process.processId)];
+                ProcessRuleMatch match;
+                match.coreCount = request.coreCount;
+                match.cores = request.coreCount == 0 ? &request.cores : nullptr;
+                return PlanRuleAffinity(match, system, avoided, target);
+            }, applied);
+            RecordApplyResults(applied, std::chrono::steady_clock::time_point());
+
+            std::unordered_map<DWORD, const AffinityApplyResult*> appliedIndex;
+            for (const AffinityApplyResult& result : applied) {
+                appliedIndex[result.processId] = &result;
+            }
+            for (AffinityApplyResult& result : results) {
+                auto it = appliedIndex.find(result.processId);
+                if (it != appliedIndex.end()) {
+                    result = *it->second;
+                }
+            }
+            return results;
+        }
+
+        bool CpuCoreManager::PublishProcessTable(SharedProcessTable& table, bool includeAffinity) {
+            if (!table.IsOpen()) {
+                return false;
+            }
+
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
+                return false;
+            }
+            if (includeAffinity) {
+                m_handleCache.Prune(processes);
+            }
+
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            const ProcessRuleSet& rules = *config->processRules;
+            uint32_t capacity = table.GetTable()->capacity;
+            uint32_t count = static_cast<uint32_t>(std::min<size_t>(processes.size(), capacity));
+
+            CpuCoreProcessRecord* records = table.BeginUpdate();
+            for (uint32_t i = 0; i < count; i++) {
+                const ProcessEntry& process = processes[i];
+                CpuCoreProcessRecord& record = records[i];
+                record.processId = process.processId;
+                record.parentProcessId = process.parentProcessId;
+                record.startTime = process.startTime;
+                record.flags = 0;
+                record.reserved = 0;
+                if (process.isSystem) {
+                    record.flags |= CPUCORE_PROCESS_SYSTEM;
+                }
+                if (rules.IsCritical(process.name)) {
+                    record.flags |= CPUCORE_PROCESS_CRITICAL;
+                }
+                if (ResolveProcessRules(rules, m_processTree, process).match.kind != ProcessRuleKind::None) {
+                    record.flags |= CPUCORE_PROCESS_RULE;
+                }
+
+                ProcessHandle handle;
+                CpuSet processSet;
+                CpuSet systemSet;
+                if (includeAffinity && !process.isSystem && QueryCachedAffinity(process, handle, processSet, systemSet)) {
+                    record.flags |= CPUCORE_PROCESS_AFFINITY;
+                }
+                CpuSetToMask(processSet, record.affinity);
 
+                size_t nameLength = std::min<size_t>(process.name.size(), CPUCORE_NAME_LENGTH - 1);
+                // 截断时不拆开 UTF-8 多字节字符
+                while (nameLength > 0 && nameLength < process.name.size() &&
+                    (static_cast<unsigned char>(process.name[nameLength]) & 0xC0) == 0x80) {
+                    nameLength--;
+                }
+                memcpy(record.name, process.name.data(), nameLength);
+                memset(record.name + nameLength, 0, CPUCORE_NAME_LENGTH - nameLength);
+            }
+            table.EndUpdate(count, static_cast<uint32_t>(processes.size()));
             return true;
         }
 
-        DWORD_PTR CpuCoreManager::AnalyzeOtherProcessesCPUUsage() {
-            DWORD_PTR occupiedCores = 0;
+        CpuSet CpuCoreManager::AnalyzeOtherProcessesCPUUsage() {
+            CpuSet occupiedCores;
             auto processAffinityMap = GetAllProcessesAffinity();
 
             std::cout << "\n=== 系统进程CPU亲和性分析 ===" << std::endl;
-            std::cout << "进程ID\t\t亲和性掩码\t\t占用核心" << std::endl;
-            std::cout << "-------\t\t----------\t\t--------" << std::endl;
+            std::cout << "进程ID\t\t占用核心" << std::endl;
+            std::cout << "-------\t\t--------" << std::endl;
 
             for (const auto& pair : processAffinityMap) {
-                DWORD processId = pair.first;
-                DWORD_PTR affinity = pair.second;
+                occupiedCores |= pair.second;
+                std::cout << pair.first << "\t\t" << pair.second.ToString() << std::endl;
+            }
+
+            return occupiedCores;
+        }
 
-                occupiedCores |= affinity;
+        CpuSet CpuCoreManager::GetAvailableCores() {
+            // 几乎所有进程的亲和性都覆盖全部核心，只有实测使用率才能区分真正空闲的核心
+            if (!m_utilizationSampler.EnsureWindow() || !m_utilizationSampler.GetUtilization(m_lastUtilization)) {
+                std::cout << "无法采样核心使用率，改用亲和性分析" << std::endl;
+                m_lastUtilization.clear();
+                return ReportAvailableCores(AnalyzeOtherProcessesCPUUsage());
+            }
 
-                std::cout << processId << "\t\t0x" << std::hex << affinity << std::dec << "\t\t\t";
+            ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
+            CpuSet busyCores;
 
-                for (int i = 0; i < 64; i++) {
-                    if (affinity & (1ULL << i)) {
-                        std::cout << i << " ";
-                    }
+            std::cout << "\n=== 核心使用率（" << m_utilizationSampler.GetWindow().count()
+                << "ms 平均，空闲阈值 " << m_idleThresholdPercent << "%） ===" << std::endl;
+            std::cout << "核心\t\t使用率" << std::endl;
+            std::cout << "----\t\t------" << std::endl;
+
+            for (size_t cpu = sysInfo.activeProcessors.First(); cpu != CpuSet::npos; cpu = sysInfo.activeProcessors.Next(cpu)) {
+                double utilization = cpu < m_lastUtilization.size() ? m_lastUtilization[cpu] : -1.0;
+                if (utilization < 0) {
+                    // 没有数据的核心不冒险当作空闲
+                    busyCores.Set(cpu);
+                    std::cout << cpu << "\t\t未知" << std::endl;
+                    continue;
                 }
-                std::cout << std::endl;
+
+                if (utilization >= m_idleThresholdPercent) {
+                    busyCores.Set(cpu);
+                }
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(1) << utilization << "%";
+                std::cout << cpu << "\t\t" << text.str() << std::endl;
             }
 
-            return occupiedCores;
+            return ReportAvailableCores(busyCores);
         }
 
-        DWORD_PTR CpuCoreManager::GetAvailableCores() {
-            SYSTEM_INFO sysInfo = GetSystemInfo();
-            DWORD_PTR occupiedCores = AnalyzeOtherProcessesCPUUsage();
-            DWORD_PTR availableCores = sysInfo.dwActiveProcessorMask & ~occupiedCores;
+        void CpuCoreManager::SetIdleCoreCriteria(double thresholdPercent, DWORD windowMilliseconds) {
+            m_idleThresholdPercent = thresholdPercent;
+            m_utilizationSampler.SetWindow(std::chrono::milliseconds(windowMilliseconds));
+        }
 
-            std::cout << "\n=== CPU核心分配分析 ===" << std::endl;
-            std::cout << "系统总核心掩码: 0x" << std::hex << sysInfo.dwActiveProcessorMask << std::dec << std::endl;
-            std::cout << "其他进程占用: 0x" << std::hex << occupiedCores << std::dec << std::endl;
-            std::cout << "可用核心掩码: 0x" << std::hex << availableCores << std::dec << std::endl;
+        CpuSet CpuCoreManager::ReportAvailableCores(const CpuSet& occupiedCores) {
+            ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
+            CpuSet availableCores = sysInfo.activeProcessors;
+            availableCores.AndNot(occupiedCores);
 
-            std::cout << "可用核心编号: ";
-            for (int i = 0; i < sysInfo.dwNumberOfProcessors; i++) {
-                if (availableCores & (1ULL << i)) {
-                    std::cout << i << " ";
-                }
-            }
-            std::cout << std::endl;
+            std::cout << "\n=== CPU核心分配分析 ===" << std::endl;
+            std::cout << "系统总核心: " << sysInfo.activeProcessors.ToString()
+                << " (" << sysInfo.activeProcessors.Count() << "个)" << std::endl;
+            std::cout << "其他进程占用: " << occupiedCores.ToString() << std::endl;
+            std::cout << "可用核心: " << availableCores.ToString()
+                << " (" << availableCores.Count() << "个)" << std::endl;
 
             return availableCores;
         }
 
         bool CpuCoreManager::SetIntelligentCPUAffinity() {
-            DWORD_PTR availableCores = GetAvailableCores();
-
-            if (availableCores == 0) {
-                std::cout << "警告: 没有完全空闲的CPU核心，将使用最后一个核心" << std::endl;
-                SYSTEM_INFO sysInfo = GetSystemInfo();
-                availableCores = 1ULL << (sysInfo.dwNumberOfProcessors - 1);
+            CpuSet availableCores = GetAvailableCores();
+
+            if (availableCores.Empty()) {
+                ProcessorInfo sysInfo = m_backend->GetProcessorInfo();
+                size_t leastBusy = sysInfo.activeProcessors.Last();
+                for (size_t cpu = sysInfo.activeProcessors.First(); cpu != CpuSet::npos; cpu = sysInfo.activeProcessors.Next(cpu)) {
+                    if (cpu < m_lastUtilization.size() && m_lastUtilization[cpu] >= 0 &&
+                        (leastBusy >= m_lastUtilization.size() || m_lastUtilization[leastBusy] < 0 ||
+                         m_lastUtilization[cpu] < m_lastUtilization[leastBusy])) {
+                        leastBusy = cpu;
+                    }
+                }
+                std::cout << "警告: 没有空闲的CPU核心，将使用负载最低的核心 " << leastBusy << std::endl;
+                availableCores = CpuSet::Single(leastBusy);
             }
 
-            std::cout << "\n设置当前进程使用CPU核心: 0x" << std::hex << availableCores << std::dec << std::endl;
+            std::cout << "\n设置当前进程使用CPU核心: " << availableCores.ToString() << std::endl;
 
             if (SetProcessAffinity(availableCores)) {
                 std::cout << "成功设置当前进程使用剩余CPU核心" << std::endl;
@@ -372,58 +799,52 @@ namespace SamsunIoCardC {
         }
 
         void CpuCoreManager::StartCoreProtection(DWORD reservedCore) {
-            if (m_isProtectionActive) {
-                StopCoreProtection();
+            // 保护已在运行时只替换保留核心，不停止线程，切换期间不存在未保护的窗口
+            if (!UpdateReservedCores(std::vector<DWORD>(1, reservedCore)) || m_isProtectionActive) {
+                return;
             }
-
-            m_protectedCore = reservedCore;
-            m_protectedCores.clear();
-            m_protectedCores.push_back(reservedCore);
             m_isProtectionActive = true;
+            RefreshReservation();
 
-            m_protectionThread = CreateThread(
-                nullptr,
-                0,
-                ProtectionThreadProc,
-                this,
-                0,
-                nullptr
-            );
+            // 先订阅事件再启动线程，首轮全量扫描之后创建的进程不会遗漏
+            StartProcessEventSource();
+
+            try {
+                m_protectionThread = std::thread(&CpuCoreManager::ProtectionThreadFunction, this);
+            }
+            catch (const std::system_error&) {
+            }
 
-            if (m_protectionThread == nullptr) {
+            if (!m_protectionThread.joinable()) {
                 std::cerr << "创建保护线程失败" << std::endl;
                 m_isProtectionActive = false;
+                StopProcessEventSource();
+                RefreshReservation();
             } else {
                 std::cout << "CPU核心保护线程已启动，保护核心: " << reservedCore << std::endl;
             }
         }
 
         void CpuCoreManager::StartMultiCoreProtection(const std::vector<DWORD>& reservedCores) {
-            if (m_isProtectionActive) {
-                StopCoreProtection();
-            }
-
-            if (reservedCores.empty()) {
-                std::cerr << "没有指定要保护的核心" << std::endl;
+            if (!UpdateReservedCores(reservedCores) || m_isProtectionActive) {
                 return;
             }
-
-            m_protectedCores = reservedCores;
-            m_protectedCore = reservedCores[0]; // 主保护核心
             m_isProtectionActive = true;
+            RefreshReservation();
+
+            StartProcessEventSource();
 
-            m_protectionThread = CreateThread(
-                nullptr,
-                0,
-                ProtectionThreadProc,
-                this,
-                0,
-                nullptr
-            );
+            try {
+                m_protectionThread = std::thread(&CpuCoreManager::ProtectionThreadFunction, this);
+            }
+            catch (const std::system_error&) {
+            }
 
-            if (m_protectionThread == nullptr) {
+            if (!m_protectionThread.joinable()) {
                 std::cerr << "创建多核心保护线程失败" << std::endl;
                 m_isProtectionActive = false;
+                StopProcessEventSource();
+                RefreshReservation();
             } else {
                 std::cout << "多核心保护线程已启动，保护核心: ";
                 for (DWORD core : reservedCores) {
@@ -435,231 +856,1465 @@ namespace SamsunIoCardC {
 
         void CpuCoreManager::StopCoreProtection() {
             if (m_isProtectionActive) {
-                m_isProtectionActive = false;
+                StopProcessEventSource();
+
+                {
+                    std::lock_guard<std::mutex> lock(m_protectionMutex);
+                    m_isProtectionActive = false;
+                }
+                m_protectionWakeup.notify_all();
 
-                if (m_protectionThread != nullptr) {
-                    WaitForSingleObject(m_protectionThread, 5000); // 等待5秒
-                    CloseHandle(m_protectionThread);
-                    m_protectionThread = nullptr;
+                if (m_protectionThread.joinable()) {
+                    m_protectionThread.join();
                 }
+                m_handleCache.Clear();
+                RefreshReservation();
+                m_irqSteering.Restore();
 
                 std::cout << "CPU核心保护线程已停止" << std::endl;
             }
         }
 
-        void CpuCoreManager::ProtectReservedCore(DWORD reservedCore, int durationSeconds) {
-            std::cout << "\n开始保护CPU核心 " << reservedCore << " (" << durationSeconds << "秒)..." << std::endl;
+        bool CpuCoreManager::UpdateReservedCores(const std::vector<DWORD>& reservedCores) {
+            CpuSet reservedSet;
+            if (!BuildReservedSet(reservedCores, reservedSet)) {
+                return false;
+            }
 
-            for (int i = 0; i < durationSeconds && m_isProtectionActive; i++) {
-                HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-                if (hSnapshot != INVALID_HANDLE_VALUE) {
-                    PROCESSENTRY32 pe32;
-                    pe32.dwSize = sizeof(PROCESSENTRY32);
-
-                    if (Process32First(hSnapshot, &pe32)) {
-                        do {
-                            if (pe32.th32ProcessID != GetCurrentProcessId() &&
-                                pe32.th32ProcessID != 0 &&
-                                pe32.th32ProcessID != 4) {
-
-                                DWORD_PTR affinity = GetProcessAffinityByPID(pe32.th32ProcessID);
-                                if (affinity & (1ULL << reservedCore)) {
-                                    ExcludeCoreFromProcess(pe32.th32ProcessID, reservedCore);
-                                    std::string processName = Utils::WideStringToString(pe32.szExeFile);
-                                    std::cout << "检测到进程 " << pe32.th32ProcessID
-                                        << " (" << processName << ") 使用保留核心，已自动排除" << std::endl;
-
-                                    if (m_processDetectedCallback) {
-                                        m_processDetectedCallback(pe32.th32ProcessID, processName);
-                                    }
-                                }
-                            }
-                        } while (Process32Next(hSnapshot, &pe32));
-                    }
-                    CloseHandle(hSnapshot);
-                }
+            bool changed = false;
+            PublishConfig([&](ProtectionConfig& config) {
+                changed = ReplaceReservedCores(config, reservedCores, std::move(reservedSet));
+            });
 
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (changed && m_isProtectionActive) {
+                std::cout << "保护核心已更新: " << GetConfig()->reservedSet.ToString() << std::endl;
             }
+            return true;
         }
 
-        void CpuCoreManager::ProtectMultipleReservedCores(const std::vector<DWORD>& reservedCores, int durationSeconds) {
-            std::cout << "\n开始保护多个CPU核心 (";
-            for (size_t i = 0; i < reservedCores.size(); i++) {
-                std::cout << reservedCores[i];
-                if (i < reservedCores.size() - 1) std::cout << ", ";
+        bool CpuCoreManager::ReplaceReservedCores(ProtectionConfig& config, std::vector<DWORD> reservedCores, CpuSet reservedSet) {
+            bool changed = config.reservedSet != reservedSet;
+            config.reservedCores = std::move(reservedCores);
+            config.reservedSet = std::move(reservedSet);
+            // 不同的保留核心取代 ReserveCoreForCurrentProcess 的保留；保护未运行时不创建 cgroup，启动保护时再应用
+            // 核心不变时保留（以及已移入保留组的当前进程）继续有效，启动保护不会重建保留组
+            config.reservationHeld = config.reservationHeld && !changed;
+            config.reservedByCgroup = ApplyCgroupReservation(config);
+            return changed;
+        }
+
+        bool CpuCoreManager::BuildReservedSet(const std::vector<DWORD>& reservedCores, CpuSet& reservedSet) {
+            if (reservedCores.empty()) {
+                std::cerr << "没有指定要保护的核心" << std::endl;
+                return false;
             }
-            std::cout << ") (" << durationSeconds << "秒)..." << std::endl;
-            
-            for (int i = 0; i < durationSeconds && m_isProtectionActive; i++) {
-                HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-                if (hSnapshot != INVALID_HANDLE_VALUE) {
-                    PROCESSENTRY32 pe32;
-                    pe32.dwSize = sizeof(PROCESSENTRY32);
-                    
-                    if (Process32First(hSnapshot, &pe32)) {
-                        do {
-                            if (pe32.th32ProcessID != GetCurrentProcessId() && 
-                                pe32.th32ProcessID != 0 && 
-                                pe32.th32ProcessID != 4) {
-                                
-                                DWORD_PTR affinity = GetProcessAffinityByPID(pe32.th32ProcessID);
-                                
-                                // 检查是否占用了任何保留的核心
-                                bool usingReservedCore = false;
-                                DWORD conflictCore = 0;
-                                
-                                for (DWORD reservedCore : reservedCores) {
-                                    if (affinity & (1ULL << reservedCore)) {
-                                        usingReservedCore = true;
-                                        conflictCore = reservedCore;
-                                        break;
-                                    }
-                                }
-                                
-                                if (usingReservedCore) {
-                                    ExcludeCoreFromProcess(pe32.th32ProcessID, conflictCore);
-                                    std::string processName = Utils::WideStringToString(pe32.szExeFile);
-                                    std::cout << "检测到进程 " << pe32.th32ProcessID 
-                                             << " (" << processName << ") 使用保留核心 " << conflictCore << "，已自动排除" << std::endl;
-                                    
-                                    if (m_processDetectedCallback) {
-                                        m_processDetectedCallback(pe32.th32ProcessID, processName);
-                                    }
-                                }
-                            }
-                        } while (Process32Next(hSnapshot, &pe32));
-                    }
-                    CloseHandle(hSnapshot);
+
+            // CpuSet 按最大编号分配位图，超出范围的编号（例如来自 C 接口）不能直接写入
+            DWORD processorCount = m_backend->GetProcessorInfo().dwNumberOfProcessors;
+            reservedSet.Clear();
+            for (DWORD core : reservedCores) {
+                if (core >= processorCount) {
+                    std::cerr << "错误: 核心索引 " << core << " 超出范围（处理器数 " << processorCount << "）" << std::endl;
+                    reservedSet.Clear();
+                    return false;
                 }
-                
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+                reservedSet.Set(core);
             }
+            return true;
         }
 
-        std::vector<DWORD> CpuCoreManager::GetRecommendedCores(DWORD coreCount, DWORD desiredCores) {
-            std::vector<DWORD> recommendedCores;
-            
-            // 推荐策略：从最后的核心开始分配（通常系统负载较低）
-            for (DWORD i = 0; i < desiredCores && i < coreCount; i++) {
-                recommendedCores.push_back(coreCount - 1 - i);
+        bool CpuCoreManager::SetReservationMode(ReservationMode mode) {
+            std::string root;
+            {
+                std::lock_guard<std::mutex> lock(m_configMutex);
+                root = m_cgroupReservation.GetRoot();
             }
-            
-            return recommendedCores;
+            if (mode == ReservationMode::Cgroup && !CgroupCpusetReservation::IsSupported(root)) {
+                std::cerr << "当前系统不支持 cgroup v2 cpuset，继续使用亲和性排除" << std::endl;
+                return false;
+            }
+
+            m_reservationMode = mode;
+            RefreshReservation();
+            return true;
         }
 
-        void CpuCoreManager::DisplayCoreAllocationStrategy(DWORD totalCores, DWORD desiredCores) {
-            std::cout << "\n=== 核心分配策略 ===" << std::endl;
-            std::cout << "系统总核心数: " << totalCores << std::endl;
-            std::cout << "请求核心数: " << desiredCores << std::endl;
-            
-            auto recommendedCores = GetRecommendedCores(totalCores, desiredCores);
-            
-            std::cout << "推荐分配核心: ";
-            for (DWORD core : recommendedCores) {
-                std::cout << core << " ";
-            }
-            std::cout << std::endl;
-            
-            std::cout << "分配原则:" << std::endl;
-            std::cout << "- 优先使用高编号核心（系统负载通常较低）" << std::endl;
-            std::cout << "- 为系统保留低编号核心（0, 1 等）" << std::endl;
-            std::cout << "- 确保系统关键进程有足够资源" << std::endl;
+        ReservationMode CpuCoreManager::GetReservationMode() const {
+            return m_reservationMode;
         }
 
-        void CpuCoreManager::MonitorCPUUsage(int durationSeconds) {
-            std::cout << "\n开始监控CPU使用情况（" << durationSeconds << "秒）..." << std::endl;
-            
-            for (int i = 0; i < durationSeconds; i++) {
-                std::cout << "\n--- 第" << (i+1) << "秒监控结果 ---" << std::endl;
-                GetAvailableCores();
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+        bool CpuCoreManager::SetCgroupRoot(const std::string& root) {
+            std::lock_guard<std::mutex> lock(m_configMutex);
+            if (!m_cgroupReservation.SetRoot(root)) {
+                std::cerr << "cgroup 保留生效期间不能更换挂载点" << std::endl;
+                return false;
             }
+            return true;
         }
 
-        void CpuCoreManager::SetProcessDetectedCallback(ProcessDetectedCallback callback) {
-            m_processDetectedCallback = callback;
+        bool CpuCoreManager::AddProcessToReservation(DWORD processId) {
+            std::lock_guard<std::mutex> lock(m_configMutex);
+            return m_cgroupReservation.AddProcess(processId);
         }
 
-        // 私有方法实现
-        DWORD WINAPI CpuCoreManager::ProtectionThreadProc(LPVOID lpParam) {
-            CpuCoreManager* pThis = static_cast<CpuCoreManager*>(lpParam);
-            pThis->ProtectionThreadFunction();
-            return 0;
-        }
+        bool CpuCoreManager::SetIrqSteering(bool enabled) {
+            if (enabled && !IrqAffinitySteering::IsSupported()) {
+                std::cerr << "当前系统不支持修改中断亲和性（需要 Linux 与 root 权限）" << std::endl;
+                return false;
+            }
 
-        void CpuCoreManager::ProtectionThreadFunction() {
-            while (m_isProtectionActive) {
-                HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-                if (hSnapshot != INVALID_HANDLE_VALUE) {
-                    PROCESSENTRY32 pe32;
-                    pe32.dwSize = sizeof(PROCESSENTRY32);
-                    
-                    if (Process32First(hSnapshot, &pe32)) {
-                        do {
-                            if (pe32.th32ProcessID != GetCurrentProcessId() && 
-                                pe32.th32ProcessID != 0 && 
-                                pe32.th32ProcessID != 4 &&
-                                !IsSystemCriticalProcess(pe32.szExeFile)) {
-                                
-                                DWORD_PTR affinity = GetProcessAffinityByPID(pe32.th32ProcessID);
-                                
-                                // 检查是否使用了任何保护的核心
-                                bool needExclusion = false;
-                                DWORD conflictCore = 0;
-                                
-                                for (DWORD protectedCore : m_protectedCores) {
-                                    if (affinity & (1ULL << protectedCore)) {
-                                        needExclusion = true;
-                                        conflictCore = protectedCore;
-                                        break;
-                                    }
-                                }
-                                
-                                if (needExclusion) {
-                                    ExcludeCoreFromProcess(pe32.th32ProcessID, conflictCore);
-                                    
-                                    if (m_processDetectedCallback) {
-                                        std::string processName = Utils::WideStringToString(pe32.szExeFile);
-                                        m_processDetectedCallback(pe32.th32ProcessID, processName);
-                                    }
-                                }
-                            }
-                        } while (Process32Next(hSnapshot, &pe32));
-                    }
-                    CloseHandle(hSnapshot);
-                }
-                
-                Sleep(5000); // 每5秒检查一次
+            m_irqSteeringEnabled = enabled;
+            {
+                // 由保护线程在下一轮全量扫描中应用或恢复
+                std::lock_guard<std::mutex> lock(m_protectionMutex);
+                m_resyncRequested = true;
             }
+            m_protectionWakeup.notify_all();
+            return true;
         }
 
-        bool CpuCoreManager::IsSystemCriticalProcess(const wchar_t* processName) {
-            const wchar_t* criticalProcesses[] = {
-                L"System", L"Registry", L"csrss.exe", L"winlogon.exe",
-                L"services.exe", L"lsass.exe", L"wininit.exe", L"smss.exe"
-            };
+        void CpuCoreManager::SetScanIntervalLimits(DWORD minimumMilliseconds, DWORD maximumMilliseconds) {
+            AdaptiveIntervalOptions options = m_scanInterval.GetOptions();
+            options.minimum = std::chrono::milliseconds(minimumMilliseconds);
+            options.maximum = std::chrono::milliseconds(maximumMilliseconds);
+            m_scanInterval.Configure(options);
 
-            for (const auto& critical : criticalProcesses) {
-                if (wcscmp(processName, critical) == 0) {
-                    return true;
-                }
+            {
+                // 缩短最大间隔后不必等完按旧间隔安排的下一轮
+                std::lock_guard<std::mutex> lock(m_protectionMutex);
+                m_resyncRequested = true;
             }
-            return false;
+            m_protectionWakeup.notify_all();
         }
 
-        SYSTEM_INFO CpuCoreManager::GetSystemInfo() {
-            SYSTEM_INFO sysInfo;
-            ::GetSystemInfo(&sysInfo);
-            return sysInfo;
+        DWORD CpuCoreManager::GetCurrentScanInterval() const {
+            return static_cast<DWORD>(m_scanInterval.Get().count());
         }
 
-        // =============================================================================
-        // Utils 命名空间实现
+        bool CpuCoreManager::StartReservationController(const ReservationControllerOptions& options) {
+            StopReservationController();
+
+            m_reservationControlRunning = true;
+            try {
+                m_reservationThread = std::thread(&CpuCoreManager::ReservationControlThreadFunction, this, options);
+            }
+            catch (const std::system_error&) {
+                m_reservationControlRunning = false;
+                std::cerr << "创建保留核心调整线程失败" << std::endl;
+                return false;
+            }
+
+            std::cout << "保留核心闭环调整已启动，范围: " << std::max<DWORD>(options.minCores, 1) << " ~ "
+                << std::max(options.maxCores, options.minCores) << " 个物理核心" << std::endl;
+            return true;
+        }
+
+        void CpuCoreManager::StopReservationController() {
+            {
+                std::lock_guard<std::mutex> lock(m_reservationMutex);
+                m_reservationControlRunning = false;
+            }
+            m_reservationWakeup.notify_all();
+
+            if (m_reservationThread.joinable()) {
+                m_reservationThread.join();
+            }
+        }
+
+        void CpuCoreManager::ReservationControlThreadFunction(ReservationControllerOptions options) {
+            if (options.processId == 0) {
+                options.processId = m_backend->GetCurrentPid();
+            }
+            // 保护线程跳过被保护进程，不与本线程争夺它的亲和性
+            PublishConfig([&options, this](ProtectionConfig& config) {
+                config.controlledProcessId = options.processId;
+                config.reservedByCgroup = ApplyCgroupReservation(config);
+            });
+            ReservationController controller(options);
+            ReservationPressureSampler sampler(*m_backend);
+            // 拓扑在运行期间基本不变，只在启动时读取一次
+            CpuTopology topology = m_backend->GetCpuTopology();
+
+            {
+                std::unique_lock<std::mutex> lock(m_reservationMutex);
+                while (!m_reservationWakeup.wait_for(lock, options.interval, [this] { return !m_reservationControlRunning; })) {
+                    lock.unlock();
+                    AdjustReservation(options, controller, sampler, topology);
+                    lock.lock();
+                }
+            }
+
+            PublishConfig([](ProtectionConfig& config) {
+                config.controlledProcessId = 0;
+            });
+        }
+
+        void CpuCoreManager::AdjustReservation(const ReservationControllerOptions& options, ReservationController& controller,
+            ReservationPressureSampler& sampler, const CpuTopology& topology) {
+            auto config = GetConfig();
+            if (!m_isProtectionActive || config->reservedSet.Empty()) {
+                // 保护停止期间不累计计数，重新启动后从新的基准开始
+                sampler.Reset();
+                controller.Reset();
+                return;
+            }
+
+            std::string cgroupPath;
+            if (config->reservedByCgroup) {
+                std::lock_guard<std::mutex> lock(m_configMutex);
+                cgroupPath = m_cgroupReservation.GetReservedPath();
+            }
+
+            ReservationPressure sample = sampler.Sample(options.processId, config->reservedSet, cgroupPath);
+            ReservationAdjustment adjustment = controller.Evaluate(sample,
+                CountReservedCores(topology, config->reservedSet), std::chrono::steady_clock::now());
+
+            CpuSet reservedSet = config->reservedSet;
+            CpuSet changedCpus;
+            if (adjustment == ReservationAdjustment::Grow) {
+                // CPU 0 所在的物理核心处理系统任务与中断，不参与保留
+                CpuSet eligible = topology.onlineProcessors;
+                eligible.Reset(0);
+                for (const CpuSet& core : topology.physicalCores) {
+                    if (core.Test(0)) {
+                        eligible.AndNot(core);
+                    }
+                }
+                changedCpus = PlanReservationGrowth(topology, reservedSet, eligible);
+                reservedSet |= changedCpus;
+            }
+            else if (adjustment == ReservationAdjustment::Shrink) {
+                changedCpus = PlanReservationShrink(topology, reservedSet);
+                reservedSet.AndNot(changedCpus);
+            }
+            if (changedCpus.Empty() || reservedSet.Empty()) {
+                return;
+            }
+
+            std::ostringstream reason;
+            reason << std::fixed << std::setprecision(1);
+            if (sample.utilization >= 0) {
+                reason << "使用率 " << sample.utilization << "%";
+            }
+            if (sample.pressure >= 0) {
+                reason << (sample.utilization >= 0 ? "，" : "") << "等待 " << sample.pressure << "%";
+            }
+            std::cout << (adjustment == ReservationAdjustment::Grow ? "扩大保留核心，加入 " : "缩小保留核心，移出 ")
+                << changedCpus.ToString() << "（" << reason.str() << "）" << std::endl;
+
+            std::vector<DWORD> reservedCores;
+            for (size_t cpu = reservedSet.First(); cpu != CpuSet::npos; cpu = reservedSet.Next(cpu)) {
+                reservedCores.push_back(static_cast<DWORD>(cpu));
+            }
+            if (!UpdateReservedCores(reservedCores)) {
+                return;
+            }
+
+            // cgroup 方式下保留组中的进程自动跟随新的核心，亲和性方式需要直接修改被保护进程
+            if (!GetConfig()->reservedByCgroup) {
+                ProcessHandle handle = options.processId == m_backend->GetCurrentPid()
+                    ? m_backend->OpenSelf()
+                    : m_backend->Open(options.processId, ProcessAccess::QueryAndSet);
+                if (!handle.IsValid() || !m_backend->ApplyAffinity(handle, reservedSet)) {
+                    std::cerr << "设置被保护进程 " << options.processId << " 的亲和性失败，错误码: " << GetLastError() << std::endl;
+                }
+                // 保护线程只排除保留核心，不会把移出的核心还给其他进程
+                if (adjustment == ReservationAdjustment::Shrink) {
+                    ReturnReleasedCores(config->reservedSet, changedCpus);
+                }
+            }
+        }
+
+        void CpuCoreManager::ReturnReleasedCores(const CpuSet& previousReserved, const CpuSet& released) {
+            std::vector<ProcessEntry> processes;
+            if (!SnapshotProcesses(processes)) {
+                return;
+            }
+
+            // 规则进程由保护线程按新的保留核心重新计算，热点线程规则进程在线程级管理
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            std::vector<const ProcessEntry*> targets;
+            targets.reserve(processes.size());
+            for (const ProcessEntry& process : processes) {
+                if (IsSkippedProcess(process, *config) || config->processRules->IsCritical(process.name) ||
+                    HasHotThreadRule(*config, process.name) ||
+                    ResolveProcessRules(*config->processRules, m_processTree, process).match.kind != ProcessRuleKind::None) {
+                    continue;
+                }
+                targets.push_back(&process);
+            }
+
+            // 只归还给亲和性仍是排除结果的进程，自行缩小过亲和性的进程保持不变
+            std::vector<AffinityApplyResult> results;
+            m_batchApplier.Run(targets, [&previousReserved, &released](const ProcessEntry&, const CpuSet& current,
+                const CpuSet& system, CpuSet& target) {
+                CpuSet excluded = system;
+                excluded.AndNot(previousReserved);
+                if (current != excluded) {
+                    return false;
+                }
+                target = current | (released & system);
+                return target != current;
+            }, results);
+
+            size_t returned = 0;
+            for (const AffinityApplyResult& result : results) {
+                if (result.status == AffinityApplyStatus::Succeeded) {
+                    returned++;
+                }
+            }
+            if (returned > 0) {
+                std::cout << "已把核心 " << released.ToString() << " 归还给 " << returned << " 个进程" << std::endl;
+            }
+        }
+
+        bool CpuCoreManager::ApplyCgroupReservation(const ProtectionConfig& config) {
+            const CpuSet& reservedSet = config.reservedSet;
+            if (m_reservationMode != ReservationMode::Cgroup || (!m_isProtectionActive && !config.reservationHeld) ||
+                reservedSet.Empty()) {
+                m_cgroupReservation.Release();
+                return false;
+            }
+
+            if (!m_cgroupReservation.IsActive() || m_cgroupReservation.GetReservedSet() != reservedSet) {
+                // 新建的保留组中还没有任何进程
+                if (!m_cgroupReservation.IsActive()) {
+                    m_cgroupMembers.clear();
+                }
+                if (!m_cgroupReservation.Apply(reservedSet, m_backend->GetProcessorInfo().activeProcessors)) {
+                    std::cerr << "cgroup 保留失败，改用亲和性排除" << std::endl;
+                    return false;
+                }
+
+                std::cout << "已通过 cgroup cpuset 分区保留核心: " << reservedSet.ToString()
+                    << "（" << m_cgroupReservation.GetPartitionState() << "）" << std::endl;
+            }
+
+            // 为当前进程建立的保留以及闭环调整的被保护进程都不做排除，需要移入保留组才能运行在保留核心上
+            // 保留组重建后重新移入；每个进程在同一个保留组中只移动一次
+            auto addMember = [this](DWORD processId) {
+                if (std::find(m_cgroupMembers.begin(), m_cgroupMembers.end(), processId) == m_cgroupMembers.end() &&
+                    m_cgroupReservation.AddProcess(processId)) {
+                    m_cgroupMembers.push_back(processId);
+                }
+            };
+            if (config.reservationHeld) {
+                addMember(m_backend->GetCurrentPid());
+            }
+            if (config.controlledProcessId != 0) {
+                addMember(config.controlledProcessId);
+            }
+            return true;
+        }
+
+        void CpuCoreManager::RefreshReservation() {
+            // 切回亲和性排除时版本变化，保护线程随即对全部进程重新检查
+            PublishConfig([this](ProtectionConfig& config) {
+                config.reservedByCgroup = ApplyCgroupReservation(config);
+            });
+        }
+
+        std::vector<DWORD> CpuCoreManager::GetProtectedCores() {
+            return GetConfig()->reservedCores;
+        }
+
+        bool CpuCoreManager::LoadConfigFile(const std::string& iniPath) {
+            std::vector<IniEntry> entries;
+            if (!ReadIniFile(iniPath, entries)) {
+                std::cerr << "无法读取配置文件: " << iniPath << std::endl;
+                return false;
+            }
+
+            auto rules = std::make_shared<ProcessRuleSet>();
+            rules->Load(entries);
+            std::vector<HotThreadRule> hotThreadRules;
+            CpuManager::LoadHotThreadRules(entries, hotThreadRules);
+
+            std::vector<DWORD> reservedCores;
+            CpuSet reservedSet;
+            for (const IniEntry& entry : entries) {
+                if (entry.section != "protection" || ToLowerAscii(entry.key) != "reservedcores") {
+                    continue;
+                }
+
+                CpuSet cores;
+                if (!CpuSet::Parse(entry.value, cores) || cores.Empty()) {
+                    std::cerr << "忽略格式错误的保留核心（第 " << entry.line << " 行）: " << entry.value << std::endl;
+                    continue;
+                }
+                std::vector<DWORD> lineCores;
+                for (size_t cpu = cores.First(); cpu != CpuSet::npos; cpu = cores.Next(cpu)) {
+                    lineCores.push_back(static_cast<DWORD>(cpu));
+                }
+                if (!BuildReservedSet(lineCores, cores)) {
+                    std::cerr << "忽略超出范围的保留核心（第 " << entry.line << " 行）: " << entry.value << std::endl;
+                    continue;
+                }
+                reservedCores = std::move(lineCores);
+                reservedSet = std::move(cores);
+            }
+
+            size_t ruleCount = rules->GetRuleCount();
+            PublishConfig([&](ProtectionConfig& config) {
+                config.processRules = std::move(rules);
+                config.hotThreadRules = std::move(hotThreadRules);
+                // 与 UpdateReservedCores 相同：保留核心变化时同步更新 cgroup 保留组
+                if (!reservedCores.empty()) {
+                    ReplaceReservedCores(config, std::move(reservedCores), std::move(reservedSet));
+                }
+            });
+            {
+                std::lock_guard<std::mutex> lock(m_hotThreadMutex);
+                m_threadTracker.Clear();
+            }
+
+            std::shared_ptr<const ProtectionConfig> config = GetConfig();
+            std::cout << "已加载配置 " << iniPath << "：进程规则 " << ruleCount << " 条，热点线程规则 "
+                << config->hotThreadRules.size() << " 条，保留核心 " << config->reservedSet.ToString() << std::endl;
+            return true;
+        }
+
+        bool CpuCoreManager::WatchConfigFile(const std::string& iniPath) {
+            return m_configWatcher.Start(iniPath, [this](const std::string& path) {
+                std::cout << "检测到配置文件变化，重新加载" << std::endl;
+                LoadConfigFile(path);
+            });
+        }
+
+        void CpuCoreManager::StopWatchingConfigFile() {
+            m_configWatcher.Stop();
+        }
+
+        void CpuCoreManager::ProtectReservedCore(DWORD reservedCore, int durationSeconds) {
+            CpuSet reservedSet;
+            if (!BuildReservedSet(std::vector<DWORD>(1, reservedCore), reservedSet)) {
+                return;
+            }
+            std::cout << "\n开始保护CPU核心 " << reservedCore << " (" << durationSeconds << "秒)..." << std::endl;
+
+            RunForegroundProtection(reservedSet, durationSeconds);
+        }
+
+        void CpuCoreManager::ProtectMultipleReservedCores(const std::vector<DWORD>& reservedCores, int durationSeconds) {
+            CpuSet reservedSet;
+            if (!BuildReservedSet(reservedCores, reservedSet)) {
+                return;
+            }
+            std::cout << "\n开始保护多个CPU核心 (";
+            for (size_t i = 0; i < reservedCores.size(); i++) {
+                std::cout << reservedCores[i];
+                if (i < reservedCores.size() - 1) std::cout << ", ";
+            }
+            std::cout << ") (" << durationSeconds << "秒)..." << std::endl;
+
+            // 一次排除全部冲突核心
+            RunForegroundProtection(reservedSet, durationSeconds);
+        }
+
+        void CpuCoreManager::RunForegroundProtection(const CpuSet& reservedSet, int durationSeconds) {
+            std::vector<ProcessEntry> processes;
+            std::vector<const ProcessEntry*> changed;
+            std::vector<const ProcessEntry*> targets;
+            std::vector<AffinityApplyResult> results;
+            IncrementalProcessScanner scanner;
+            // 与保护线程使用相同的间隔范围，但各自独立退避
+            AdaptiveScanInterval interval(m_scanInterval.GetOptions());
+
+            auto end = std::chrono::steady_clock::now() + std::chrono::seconds(durationSeconds);
+            while (m_isProtectionActive) {
+                bool activity = false;
+                if (SnapshotProcesses(processes)) {
+                    m_handleCache.Prune(processes);
+                    scanner.Update(processes, changed);
+
+                    targets.clear();
+                    std::shared_ptr<const ProtectionConfig> config = GetConfig();
+                    for (const ProcessEntry* process : changed) {
+                        if (!IsSkippedProcess(*process, *config)) {
+                            targets.push_back(process);
+                        }
+                    }
+                    ExcludeFromProcesses(targets, reservedSet, results);
+                    activity = HasScanActivity(scanner.GetNewCount(), results);
+                }
+
+                auto now = std::chrono::steady_clock::now();
+                if (now >= end) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(interval.Update(activity), end - now));
+            }
+        }
+
+        std::vector<DWORD> CpuCoreManager::GetRecommendedCores(DWORD coreCount, DWORD desiredCores) {
+            std::vector<DWORD> recommendedCores;
+            CoreReservation reservation = GetRecommendedReservation(coreCount, desiredCores);
+
+            for (const CpuSet& core : reservation.cores) {
+                for (size_t cpu = core.First(); cpu != CpuSet::npos; cpu = core.Next(cpu)) {
+                    recommendedCores.push_back(static_cast<DWORD>(cpu));
+                }
+            }
+
+            return recommendedCores;
+        }
+
+        CoreReservation CpuCoreManager::GetRecommendedReservation(DWORD coreCount, DWORD desiredCores) {
+            CpuTopology topology = m_backend->GetCpuTopology();
+            CpuSet eligible = topology.onlineProcessors & CpuSet::Range(0, coreCount);
+            return PlanCoreReservation(topology, desiredCores, eligible);
+        }
+
+        void CpuCoreManager::DisplayCoreAllocationStrategy(DWORD totalCores, DWORD desiredCores) {
+            std::cout << "\n=== 核心分配策略 ===" << std::endl;
+            std::cout << "系统总核心数: " << totalCores << std::endl;
+            std::cout << "请求核心数: " << desiredCores << std::endl;
+
+            CpuTopology topology = m_backend->GetCpuTopology();
+            std::cout << "物理核心: " << topology.physicalCores.size()
+                << "，L3 域: " << topology.l3Domains.size()
+                << "，NUMA 节点: " << topology.numaNodes.size() << std::endl;
+
+            CpuSet eligible = topology.onlineProcessors & CpuSet::Range(0, totalCores);
+            CoreReservation reservation = PlanCoreReservation(topology, desiredCores, eligible);
+
+            std::cout << "推荐分配核心: ";
+            for (const CpuSet& core : reservation.cores) {
+                std::cout << "[" << core.ToString() << "] ";
+            }
+            std::cout << std::endl;
+            std::cout << "保留逻辑处理器: " << reservation.cpus.ToString() << std::endl;
+
+            if (reservation.cores.size() < desiredCores) {
+                std::cout << "警告: 只有 " << reservation.cores.size() << " 个物理核心的兄弟线程全部可用" << std::endl;
+            }
+            if (reservation.l3Domain >= 0) {
+                std::cout << "L3 域: " << topology.l3Domains[reservation.l3Domain].ToString() << std::endl;
+            }
+            else if (!reservation.cores.empty()) {
+                std::cout << "警告: 保留核心跨越多个 L3 域" << std::endl;
+            }
+            if (reservation.numaNode >= 0) {
+                std::cout << "NUMA 节点: " << reservation.numaNode << std::endl;
+            }
+
+            std::cout << "分配原则:" << std::endl;
+            std::cout << "- 以物理核心为单位保留，SMT 兄弟线程一并保留，避免与其他进程共享执行单元" << std::endl;
+            std::cout << "- 保留核心放在同一个 L3 域（CCX）内，放不下时放在同一个 NUMA 节点内" << std::endl;
+            std::cout << "- 避开 CPU 0 所在的 L3 域，域内优先使用高编号核心" << std::endl;
+        }
+
+        void CpuCoreManager::MonitorCPUUsage(int durationSeconds) {
+            std::cout << "\n开始监控CPU使用情况（" << durationSeconds << "秒）..." << std::endl;
+
+            // 增量维护各进程亲和性及每个核心的占用进程数，每秒只查询新建/复检的进程
+            IncrementalProcessScanner scanner;
+            std::vector<ProcessEntry> processes;
+            std::vector<const ProcessEntry*> changed;
+            std::vector<DWORD> exited;
+            std::unordered_map<DWORD, CpuSet> processAffinity;
+            std::vector<int> coreUsers;
+
+            auto updateCoreUsers = [&coreUsers](const CpuSet& affinity, int delta) {
+                if (affinity.Empty()) {
+                    return;
+                }
+                if (coreUsers.size() <= affinity.Last()) {
+                    coreUsers.resize(affinity.Last() + 1, 0);
+                }
+                for (size_t core = affinity.First(); core != CpuSet::npos; core = affinity.Next(core)) {
+                    coreUsers[core] += delta;
+                }
+            };
+
+            for (int i = 0; i < durationSeconds; i++) {
+                std::cout << "\n--- 第" << (i+1) << "秒监控结果 ---" << std::endl;
+
+                if (SnapshotProcesses(processes)) {
+                    scanner.Update(processes, changed, &exited);
+
+                    for (DWORD processId : exited) {
+                        auto it = processAffinity.find(processId);
+                        if (it != processAffinity.end()) {
+                            updateCoreUsers(it->second, -1);
+                            processAffinity.erase(it);
+                        }
+                    }
+
+                    std::shared_ptr<const ProtectionConfig> config = GetConfig();
+                    for (const ProcessEntry* process : changed) {
+                        if (IsSkippedProcess(*process, *config)) {
+                            continue;
+                        }
+
+                        CpuSet affinity = GetProcessAffinityByPID(process->processId);
+                        auto it = processAffinity.find(process->processId);
+                        if (it != processAffinity.end()) {
+                            updateCoreUsers(it->second, -1);
+                            processAffinity.erase(it);
+                        }
+                        if (!affinity.Empty()) {
+                            updateCoreUsers(affinity, 1);
+                            processAffinity.emplace(process->processId, std::move(affinity));
+                        }
+                    }
+
+                    CpuSet occupiedCores;
+                    for (size_t core = 0; core < coreUsers.size(); core++) {
+                        if (coreUsers[core] > 0) {
+                            occupiedCores.Set(core);
+                        }
+                    }
+
+                    std::cout << "进程总数: " << processes.size() << "，本轮查询: " << changed.size() << std::endl;
+                    ReportAvailableCores(occupiedCores);
+                }
+
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+        }
+
+        void CpuCoreManager::SetProcessDetectedCallback(ProcessDetectedCallback callback) {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            m_processDetectedCallback = callback;
+        }
+
+        void CpuCoreManager::AddActionSink(ProcessActionSink sink) {
+            m_actionDispatcher.AddSink(std::move(sink));
+        }
+
+        void CpuCoreManager::SetActionConsoleOutput(bool enabled) {
+            m_actionDispatcher.SetConsoleOutput(enabled);
+        }
+
+        uint64_t CpuCoreManager::GetDroppedActionCount() const {
+            return m_actionDispatcher.GetDroppedCount();
+        }
+
+        std::vector<CoreJitterReport> CpuCoreManager::MeasureCoreJitter(const JitterProbeOptions& options) {
+            return MeasureCoreJitter(GetConfig()->reservedSet, options);
+        }
+
+        std::vector<CoreJitterReport> CpuCoreManager::MeasureCoreJitter(const CpuSet& cores, const JitterProbeOptions& options) {
+            if (cores.Empty()) {
+                std::cerr << "没有要测量的核心，请先设置保留核心" << std::endl;
+                return std::vector<CoreJitterReport>();
+            }
+
+            // 测量前扫描一次亲和性仍包含被测核心的进程（无权限修改、关键进程等）
+            // cgroup 分区生效时亲和性不代表实际可用的核心，不做这项检查
+            std::vector<JitterSuspect> residents;
+            if (!GetConfig()->reservedByCgroup) {
+                auto now = std::chrono::system_clock::now();
+                for (const auto& entry : GetAllProcessesAffinity()) {
+                    if (!entry.second.Intersects(cores)) {
+                        continue;
+                    }
+                    JitterSuspect resident;
+                    resident.processId = entry.first;
+                    resident.name = GetProcessName(entry.first);
+                    resident.cores = entry.second & cores;
+                    resident.seen = now;
+                    residents.push_back(std::move(resident));
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_jitterMutex);
+                m_jitterCores = cores;
+                m_jitterOccupants.clear();
+            }
+
+            std::cout << "正在测量核心 " << cores.ToString() << " 的抖动（" << options.duration.count() << " ms）..." << std::endl;
+            JitterProbe probe(*m_backend);
+            std::vector<CoreJitterReport> reports = probe.Run(cores, options);
+
+            // 等分发线程处理完测量期间的事件
+            m_actionDispatcher.Flush();
+            std::vector<JitterSuspect> occupants;
+            {
+                std::lock_guard<std::mutex> lock(m_jitterMutex);
+                occupants.swap(m_jitterOccupants);
+                m_jitterCores.Clear();
+            }
+
+            CorrelateJitterSpikes(reports, residents, occupants, options.correlationWindow);
+            PrintJitterReport(reports);
+            return reports;
+        }
+
+        const ManagerMetrics& CpuCoreManager::GetMetrics() const {
+            return m_metrics;
+        }
+
+        std::string CpuCoreManager::FormatMetrics() {
+            MetricsExtras extras;
+            extras.droppedEvents = m_actionDispatcher.GetDroppedCount();
+            extras.protectedCoreCount = m_isProtectionActive ? GetConfig()->reservedSet.Count() : 0;
+            extras.scanIntervalSeconds = m_isProtectionActive ? m_scanInterval.Get().count() / 1000.0 : 0.0;
+            return FormatPrometheusMetrics(m_metrics, extras);
+        }
+
+        bool CpuCoreManager::WriteMetricsFile(const std::string& path) {
+            return CpuManager::WriteMetricsFile(path, FormatMetrics());
+        }
+
+        bool CpuCoreManager::StartMetricsExport(const std::string& path, DWORD intervalMilliseconds) {
+            return m_metricsExporter.Start(path, std::chrono::milliseconds(intervalMilliseconds), [this] {
+                return FormatMetrics();
+            });
+        }
+
+        void CpuCoreManager::StopMetricsExport() {
+            m_metricsExporter.Stop();
+        }
+
+        bool CpuCoreManager::StartHistoryRecording(const std::string& directory, DWORD intervalMilliseconds,
+            const TimeSeriesStoreOptions& options) {
+            StopHistoryRecording();
+
+            auto history = std::make_shared<TimeSeriesStore>();
+            if (!history->Open(directory, false, options)) {
+                return false;
+            }
+
+            std::chrono::milliseconds interval(std::max<DWORD>(intervalMilliseconds, 100));
+            m_historyRecording = true;
+            try {
+                m_historyThread = std::thread(&CpuCoreManager::HistoryThreadFunction, this, history, interval);
+            }
+            catch (const std::system_error&) {
+                m_historyRecording = false;
+                std::cerr << "创建历史记录线程失败" << std::endl;
+                return false;
+            }
+
+            std::atomic_store(&m_history, history);
+            std::cout << "历史记录已启动: " << directory << "（间隔 " << interval.count() << " ms）" << std::endl;
+            return true;
+        }
+
+        void CpuCoreManager::StopHistoryRecording() {
+            {
+                std::lock_guard<std::mutex> lock(m_historyMutex);
+                m_historyRecording = false;
+            }
+            m_historyWakeup.notify_all();
+
+            if (m_historyThread.joinable()) {
+                m_historyThread.join();
+            }
+            // 分发线程可能仍持有存储，由最后一个引用关闭
+            std::atomic_store(&m_history, std::shared_ptr<TimeSeriesStore>());
+        }
+
+        void CpuCoreManager::HistoryThreadFunction(std::shared_ptr<TimeSeriesStore> history, std::chrono::milliseconds interval) {
+            // 独立的采样器，窗口与记录间隔一致，不影响 GetAvailableCores 的采样
+            CoreUtilizationSampler sampler(*m_backend);
+            sampler.SetWindow(interval);
+            sampler.Sample();
+            std::vector<double> utilization;
+
+            std::unique_lock<std::mutex> lock(m_historyMutex);
+            while (!m_historyWakeup.wait_for(lock, interval, [this] { return !m_historyRecording; })) {
+                lock.unlock();
+
+                // 时间对齐到间隔的整数倍，规整序列的时间戳二阶差分为 0，每点只占 1 位
+                int64_t now = TimeSeriesStore::Now();
+                now -= now % interval.count();
+
+                if (sampler.Sample() && sampler.GetUtilization(utilization)) {
+                    for (size_t cpu = 0; cpu < utilization.size(); cpu++) {
+                        if (utilization[cpu] >= 0) {
+                            history->Append("cpu." + std::to_string(cpu) + ".utilization", now, utilization[cpu]);
+                        }
+                    }
+                }
+
+                // 计数器记录累计值，查询方按相邻两点求差得到速率
+                history->Append("scan.interval_ms", now, m_isProtectionActive ? static_cast<double>(GetCurrentScanInterval()) : 0.0);
+                history->AppendRaw("scan.passes", now, m_metrics.passes.load(std::memory_order_relaxed));
+                history->AppendRaw("scan.processes_scanned", now, m_metrics.processesScanned.load(std::memory_order_relaxed));
+                history->AppendRaw("scan.exclusions_applied", now, m_metrics.exclusionsApplied.load(std::memory_order_relaxed));
+                history->AppendRaw("scan.exclusions_denied", now, m_metrics.exclusionsDenied.load(std::memory_order_relaxed));
+                history->AppendRaw("scan.exclusions_failed", now, m_metrics.exclusionsFailed.load(std::memory_order_relaxed));
+                history->AppendRaw("scan.dropped_events", now, m_actionDispatcher.GetDroppedCount());
+
+                lock.lock();
+            }
+            history->Flush();
+        }
+
+        // 私有方法实现
+        bool CpuCoreManager::SnapshotProcesses(std::vector<ProcessEntry>& processes) {
+            auto started = std::chrono::steady_clock::now();
+            if (!m_backend->EnumerateProcesses(processes)) {
+                return false;
+            }
+            m_metrics.snapshotTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started));
+            m_metrics.processesScanned.fetch_add(processes.size(), std::memory_order_relaxed);
+
+            m_nameIndex.Update(processes);
+            m_processTree.Update(processes);
+            return true;
+        }
+
+        void CpuCoreManager::ProtectionThreadFunction() {
+            std::vector<ProcessEntry> processes;
+            std::vector<const ProcessEntry*> changed;
+            std::vector<const ProcessEntry*> targets;
+            std::vector<const ProcessEntry*> treeTargets;
+            std::unordered_map<DWORD, ProcessRuleMatch> treeMatches;
+            std::vector<AffinityApplyResult> results;
+            std::vector<PendingProcess> pendingProcesses;
+            auto nextSweep = std::chrono::steady_clock::now();
+            m_protectionScanner.Reset();
+            m_scanInterval.Reset();
+            uint64_t configVersion = GetConfig()->version;
+
+            while (m_isProtectionActive) {
+                bool sweepDue = false;
+                {
+                    // 新进程事件、事件丢失、停止请求均立即唤醒；否则等到下一轮全量扫描（间隔自适应）
+                    std::unique_lock<std::mutex> lock(m_protectionMutex);
+                    m_protectionWakeup.wait_until(lock, nextSweep, [this] {
+                        return !m_isProtectionActive || !m_pendingProcesses.empty() || m_resyncRequested;
+                    });
+                    if (!m_isProtectionActive) {
+                        break;
+                    }
+
+                    pendingProcesses.swap(m_pendingProcesses);
+                    sweepDue = m_resyncRequested || std::chrono::steady_clock::now() >= nextSweep;
+                    m_resyncRequested = false;
+                }
+
+                // 本轮使用同一份配置；配置变化后所有进程都需要按新配置重新检查
+                std::shared_ptr<const ProtectionConfig> config = GetConfig();
+                if (config->version != configVersion) {
+                    configVersion = config->version;
+                    m_protectionScanner.Reset();
+                    sweepDue = true;
+                }
+
+                auto passStarted = std::chrono::steady_clock::now();
+                m_metrics.passes.fetch_add(1, std::memory_order_relaxed);
+
+                if (sweepDue) {
+                    SteerInterrupts(*config);
+                }
+
+                // 其他 cgroup 占用保留核心、CPU 下线等都会让分区在运行中失效，此后改用亲和性排除
+                if (sweepDue && config->reservedByCgroup && !m_cgroupReservation.IsPartitionValid()) {
+                    PublishConfig([this](ProtectionConfig& current) {
+                        if (current.reservedByCgroup && !m_cgroupReservation.IsPartitionValid()) {
+                            std::cerr << "cpuset 分区已失效（" << m_cgroupReservation.GetPartitionState()
+                                << "），改用亲和性排除" << std::endl;
+                            m_cgroupReservation.Release();
+                            current.reservedByCgroup = false;
+                        }
+                    });
+                    config = GetConfig();
+                    configVersion = config->version;
+                    m_protectionScanner.Reset();
+                }
+
+                if (!sweepDue) {
+                    ProtectPendingProcesses(pendingProcesses, *config);
+                    // 有新进程时系统可能正处于进程风暴，提前下一轮全量扫描以补偿丢失的事件
+                    if (!pendingProcesses.empty()) {
+                        nextSweep = std::min(nextSweep, std::chrono::steady_clock::now() + m_scanInterval.Update(true));
+                    }
+                    pendingProcesses.clear();
+                    m_metrics.passTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - passStarted));
+                    continue;
+                }
+
+                // 一致性扫描同时覆盖了本轮的待处理进程；只处理新建、PID 复用和轮到复检的进程
+                pendingProcesses.clear();
+                bool activity = false;
+                if (SnapshotProcesses(processes)) {
+                    auto detected = std::chrono::steady_clock::now();
+                    m_handleCache.Prune(processes);
+                    m_protectionScanner.Update(processes, changed);
+
+                    targets.clear();
+                    treeTargets.clear();
+                    treeMatches.clear();
+                    for (const ProcessEntry* process : changed) {
+                        if (IsSkippedProcess(*process, *config) || config->processRules->IsCritical(process->name)) {
+                            continue;
+                        }
+                        ResolvedProcessRules resolved = ResolveProcessRules(*config->processRules, m_processTree, *process);
+                        ApplySchedulingRule(*process, resolved.scheduling);
+                        if (HasHotThreadRule(*config, process->name)) {
+                            continue;
+                        }
+
+                        if (resolved.treeRule) {
+                            treeMatches.emplace(process->processId, resolved.match);
+                            treeTargets.push_back(process);
+                        }
+                        else if (!config->reservedByCgroup) {
+                            // 保留核心由 cgroup 分区独占时无需逐进程排除，规则与调度仍照常应用
+                            targets.push_back(process);
+                        }
+                    }
+                    ExcludeFromProcesses(targets, config->reservedSet, results, detected);
+                    activity = HasScanActivity(m_protectionScanner.GetNewCount(), results);
+                    if (!treeTargets.empty()) {
+                        ApplyTreeRules(treeTargets, treeMatches, config->reservedSet, results, detected);
+                        activity = activity || HasScanActivity(0, results);
+                    }
+
+                    // 线程排名随负载变化，规则进程每轮都重新评估
+                    ApplyHotThreadRules(processes, *config);
+                }
+                m_metrics.passTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - passStarted));
+
+                nextSweep = std::chrono::steady_clock::now() + m_scanInterval.Update(activity);
+            }
+        }
+
+        void CpuCoreManager::SteerInterrupts(const ProtectionConfig& config) {
+            if (!m_irqSteeringEnabled) {
+                m_irqSteering.Restore();
+                return;
+            }
+
+            size_t steered = m_irqSteering.Apply(config.reservedSet, m_backend->GetProcessorInfo().activeProcessors);
+            if (steered > 0) {
+                std::cout << "已将 " << steered << " 个中断移出保留核心（内核托管、无法移动: "
+                    << m_irqSteering.GetUnmanagedCount() << "）" << std::endl;
+            }
+        }
+
+        void CpuCoreManager::ExcludeFromProcesses(const std::vector<const ProcessEntry*>& processes, const CpuSet& excluded,
+            std::vector<AffinityApplyResult>& results, std::chrono::steady_clock::time_point detected) {
+            m_batchApplier.Run(processes, [&excluded](const ProcessEntry&, const CpuSet& current, const CpuSet& system, CpuSet& target) {
+                if (!current.Intersects(excluded)) {
+                    return false;
+                }
+                target = ComputeExcludedSet(current, system, excluded);
+                return true;
+            }, results);
+
+            RecordApplyResults(results, detected);
+            for (const AffinityApplyResult& result : results) {
+                if (result.status != AffinityApplyStatus::Unchanged) {
+                    PublishAction(ProcessActionEvent::Type::AffinityExcluded, AffinityApplyResult(result));
+                }
+            }
+        }
+
+        void CpuCoreManager::ApplyTreeRules(const std::vector<const ProcessEntry*>& processes,
+            const std::unordered_map<DWORD, ProcessRuleMatch>& matches, const CpuSet& avoided,
+            std::vector<AffinityApplyResult>& results, std::chrono::steady_clock::time_point detected) {
+            m_batchApplier.Run(processes, [&matches, &avoided](const ProcessEntry& process, const CpuSet&, const CpuSet& system, CpuSet& target) {
+                return PlanRuleAffinity(matches.at(process.processId), system, avoided, target);
+            }, results);
+
+            RecordApplyResults(results, detected);
+            for (const AffinityApplyResult& result : results) {
+                if (result.status != AffinityApplyStatus::Unchanged) {
+                    PublishAction(ProcessActionEvent::Type::RuleApplied, AffinityApplyResult(result));
+                }
+            }
+        }
+
+        void CpuCoreManager::RecordApplyResults(const std::vector<AffinityApplyResult>& results,
+            std::chrono::steady_clock::time_point detected) {
+            auto finished = std::chrono::steady_clock::now();
+            for (const AffinityApplyResult& result : results) {
+                m_metrics.processQueryTime.Record(result.elapsed - result.applyElapsed);
+                if (result.status == AffinityApplyStatus::Unchanged) {
+                    continue;
+                }
+
+                if (result.applyElapsed.count() > 0 || result.status == AffinityApplyStatus::Succeeded) {
+                    m_metrics.applyTime.Record(result.applyElapsed);
+                }
+                RecordApplyStatus(result.status);
+                if (result.status == AffinityApplyStatus::Succeeded && detected != std::chrono::steady_clock::time_point()) {
+                    // 批次整体完成的时间，是单个进程延迟的上界
+                    m_metrics.detectionLatency.Record(std::chrono::duration_cast<std::chrono::microseconds>(finished - detected));
+                }
+            }
+        }
+
+        void CpuCoreManager::RecordApplyStatus(AffinityApplyStatus status) {
+            switch (status) {
+            case AffinityApplyStatus::Succeeded:
+                m_metrics.exclusionsApplied.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case AffinityApplyStatus::Denied:
+                m_metrics.exclusionsDenied.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case AffinityApplyStatus::Exited:
+            case AffinityApplyStatus::Failed:
+                m_metrics.exclusionsFailed.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case AffinityApplyStatus::Unchanged:
+                break;
+            }
+        }
+
+        void CpuCoreManager::ApplySchedulingRule(const ProcessEntry& process, const ProcessScheduling* scheduling) {
+            if (scheduling == nullptr) {
+                return;
+            }
+
+            ProcessActionEvent event;
+            event.type = ProcessActionEvent::Type::SchedulingApplied;
+            event.processId = process.processId;
+            event.name = process.name;
+            event.scheduling = *scheduling;
+
+            DWORD openError = 0;
+            bool changed = false;
+            ProcessHandle handle = m_handleCache.Acquire(process, &openError);
+            if (!handle.IsValid()) {
+                event.errorCode = openError;
+                event.result = ClassifyAffinityError(openError);
+            }
+            else if (!m_backend->ApplyScheduling(handle, *scheduling, changed)) {
+                event.errorCode = GetLastError();
+                event.result = ClassifyAffinityError(event.errorCode);
+            }
+            else {
+                event.result = changed ? AffinityApplyStatus::Succeeded : AffinityApplyStatus::Unchanged;
+            }
+
+            // 复检时设置仍是目标值，不产生事件
+            if (event.result != AffinityApplyStatus::Unchanged) {
+                event.timestamp = std::chrono::system_clock::now();
+                m_actionDispatcher.Publish(std::move(event));
+            }
+        }
+
+        bool CpuCoreManager::ApplyMemoryPolicy(const ProcessEntry& process, const ProcessHandle& handle,
+            const ProcessMemoryPolicy& policy, const CpuSet& affinity, const CpuTopology& topology) {
+            CpuSet nodes = FindNumaNodes(topology, affinity);
+            if (nodes.Empty() || nodes.Count() >= topology.numaNodes.size()) {
+                return true;
+            }
+
+            ProcessActionEvent event;
+            event.type = ProcessActionEvent::Type::MemoryPolicyApplied;
+            event.processId = process.processId;
+            event.name = process.name;
+            event.memoryPolicy = policy;
+            event.memoryNodes = nodes;
+
+            std::vector<uint64_t> kilobytesPerNode;
+            if (m_backend->QueryMemoryNodes(process.processId, kilobytesPerNode)) {
+                event.localMemoryBefore = LocalMemoryPercent(kilobytesPerNode, nodes);
+            }
+
+            if (!m_backend->ApplyMemoryPolicy(handle, policy, nodes)) {
+                event.errorCode = GetLastError();
+                event.result = ClassifyAffinityError(event.errorCode);
+            }
+            else {
+                // 其他进程的分配策略无法设置，后端只迁移了已有页面，事件只报告迁移
+                if (process.processId != m_backend->GetCurrentPid()) {
+                    event.memoryPolicy.mode = ProcessMemoryPolicy::Mode::None;
+                }
+                if (policy.migrate && m_backend->QueryMemoryNodes(process.processId, kilobytesPerNode)) {
+                    event.localMemoryAfter = LocalMemoryPercent(kilobytesPerNode, nodes);
+                }
+            }
+
+            bool succeeded = event.result == AffinityApplyStatus::Succeeded;
+            event.timestamp = std::chrono::system_clock::now();
+            m_actionDispatcher.Publish(std::move(event));
+            return succeeded;
+        }
+
+        void CpuCoreManager::PublishAction(ProcessActionEvent::Type type, AffinityApplyResult&& result) {
+            ProcessActionEvent event;
+            event.type = type;
+            event.processId = result.processId;
+            event.name = std::move(result.name);
+            event.oldAffinity = std::move(result.oldAffinity);
+            event.newAffinity = std::move(result.newAffinity);
+            event.result = result.status;
+            event.errorCode = result.errorCode;
+            event.timestamp = std::chrono::system_clock::now();
+            m_actionDispatcher.Publish(std::move(event));
+        }
+
+        void CpuCoreManager::OnActionEvent(const ProcessActionEvent& event) {
+            // 亲和性变化按进程名记录（PID 会复用且数量不受控），每 64 个 CPU 一个序列
+            if ((event.type == ProcessActionEvent::Type::AffinityExcluded || event.type == ProcessActionEvent::Type::RuleApplied) &&
+                event.result == AffinityApplyStatus::Succeeded && !event.newAffinity.Empty()) {
+                std::shared_ptr<TimeSeriesStore> history = std::atomic_load(&m_history);
+                if (history) {
+                    int64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        event.timestamp.time_since_epoch()).count();
+                    std::string key = "process." + event.name + ".affinity";
+                    // 原亲和性中的高位 CPU 被移除时同样写入该字（值为 0）
+                    size_t last = event.newAffinity.Last();
+                    if (!event.oldAffinity.Empty()) {
+                        last = std::max(last, event.oldAffinity.Last());
+                    }
+                    size_t words = last / 64 + 1;
+                    for (size_t word = 0; word < words; word++) {
+                        history->AppendRaw(word == 0 ? key : key + "." + std::to_string(word), time, event.newAffinity.Word(word));
+                    }
+                }
+            }
+
+            if (event.type != ProcessActionEvent::Type::AffinityExcluded) {
+                return;
+            }
+
+            // 无论排除是否成功，扫描时该进程都可以在被测核心上运行
+            {
+                std::lock_guard<std::mutex> lock(m_jitterMutex);
+                if (event.oldAffinity.Intersects(m_jitterCores) && m_jitterOccupants.size() < MAX_JITTER_OCCUPANTS) {
+                    JitterSuspect occupant;
+                    occupant.processId = event.processId;
+                    occupant.name = event.name;
+                    occupant.cores = event.oldAffinity & m_jitterCores;
+                    occupant.seen = event.timestamp;
+                    m_jitterOccupants.push_back(std::move(occupant));
+                }
+            }
+
+            if (event.result != AffinityApplyStatus::Succeeded) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            if (m_processDetectedCallback) {
+                m_processDetectedCallback(event.processId, event.name);
+            }
+        }
+
+        void CpuCoreManager::ProtectProcess(const ProcessEntry& process, const CpuSet& reservedSet, const ProcessRuleMatch& treeRule,
+            std::chrono::steady_clock::time_point detected) {
+            // 稳态下每个存活进程只有一次亲和性查询，不再重复打开/关闭句柄
+            ProcessHandle handle;
+            CpuSet affinity;
+            CpuSet systemAffinity;
+            auto started = std::chrono::steady_clock::now();
+            bool queried = QueryCachedAffinity(process, handle, affinity, systemAffinity);
+            auto queriedAt = std::chrono::steady_clock::now();
+            m_metrics.processQueryTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(queriedAt - started));
+            if (!queried) {
+                return;
+            }
+
+            // 规则进程设为规则核心，其他进程检查是否使用了任何保护的核心
+            CpuSet target;
+            bool hasRule = treeRule.kind != ProcessRuleKind::None;
+            if (hasRule ? PlanRuleAffinity(treeRule, systemAffinity, reservedSet, target) && target != affinity
+                : affinity.Intersects(reservedSet)) {
+                AffinityApplyResult result;
+                result.processId = process.processId;
+                result.name = process.name;
+                result.newAffinity = hasRule ? std::move(target) : ComputeExcludedSet(affinity, systemAffinity, reservedSet);
+                if (m_backend->ApplyAffinity(handle, result.newAffinity)) {
+                    result.status = AffinityApplyStatus::Succeeded;
+                }
+                else {
+                    result.errorCode = GetLastError();
+                    result.status = ClassifyAffinityError(result.errorCode);
+                }
+
+                auto appliedAt = std::chrono::steady_clock::now();
+                m_metrics.applyTime.Record(std::chrono::duration_cast<std::chrono::microseconds>(appliedAt - queriedAt));
+                RecordApplyStatus(result.status);
+                if (result.status == AffinityApplyStatus::Succeeded) {
+                    m_metrics.detectionLatency.Record(std::chrono::duration_cast<std::chrono::microseconds>(appliedAt - detected));
+                }
+
+                result.oldAffinity = std::move(affinity);
+                PublishAction(hasRule ? ProcessActionEvent::Type::RuleApplied : ProcessActionEvent::Type::AffinityExcluded,
+                    std::move(result));
+            }
+        }
+
+        void CpuCoreManager::ProtectPendingProcesses(std::vector<PendingProcess>& pending, const ProtectionConfig& config) {
+            // fork 与 exec 会对同一进程各报告一次，保留最早的送达时间
+            std::sort(pending.begin(), pending.end(), [](const PendingProcess& a, const PendingProcess& b) {
+                return a.processId != b.processId ? a.processId < b.processId : a.detected < b.detected;
+            });
+            pending.erase(std::unique(pending.begin(), pending.end(), [](const PendingProcess& a, const PendingProcess& b) {
+                return a.processId == b.processId;
+            }), pending.end());
+
+            // 先登记本批的全部进程，同一批中先处理子进程时也能找到父进程
+            std::vector<std::pair<ProcessEntry, std::chrono::steady_clock::time_point>> processes;
+            processes.reserve(pending.size());
+            for (const PendingProcess& entry : pending) {
+                // 进程可能在事件送达前已经退出
+                ProcessEntry process;
+                if (!m_backend->QueryProcess(entry.processId, process)) {
+                    continue;
+                }
+                // Windows 的单进程查询不提供父进程，使用事件中的父进程
+                if (process.parentProcessId == 0) {
+                    process.parentProcessId = entry.parentProcessId;
+                }
+                m_protectionScanner.MarkProcessed(process);
+                m_nameIndex.Insert(process);
+                m_processTree.Insert(process);
+                processes.emplace_back(std::move(process), entry.detected);
+            }
+
+            for (const auto& entry : processes) {
+                if (!m_isProtectionActive) {
+                    return;
+                }
+
+                const ProcessEntry& process = entry.first;
+                if (IsSkippedProcess(process, config) || config.processRules->IsCritical(process.name)) {
+                    continue;
+                }
+                // 子进程在出现时即按 [ProcessTree] 祖先的规则处理
+                ResolvedProcessRules resolved = ResolveProcessRules(*config.processRules, m_processTree, process);
+                ApplySchedulingRule(process, resolved.scheduling);
+                // 规则进程的线程没有运行历史，留到下一轮全量扫描按排名绑定
+                if (HasHotThreadRule(config, process.name)) {
+                    continue;
+                }
+
+                if (resolved.treeRule) {
+                    ProtectProcess(process, config.reservedSet, resolved.match, entry.second);
+                }
+                else if (!config.reservedByCgroup) {
+                    ProtectProcess(process, config.reservedSet, ProcessRuleMatch(), entry.second);
+                }
+            }
+        }
+
+        void CpuCoreManager::ApplyHotThreadRules(const std::vector<ProcessEntry>& processes, const ProtectionConfig& config) {
+            if (config.hotThreadRules.empty()) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_hotThreadMutex);
+
+            m_threadTracker.Prune(processes);
+            CpuSet systemSet = m_backend->GetProcessorInfo().activeProcessors;
+
+            for (const ProcessEntry& process : processes) {
+                if (IsSkippedProcess(process, config)) {
+                    continue;
+                }
+
+                for (const HotThreadRule& rule : config.hotThreadRules) {
+                    if (MatchesHotThreadRule(rule, process.name)) {
+                        ApplyHotThreadRule(rule, process, systemSet, config.reservedSet);
+                        break;
+                    }
+                }
+            }
+        }
+
+        void CpuCoreManager::ApplyHotThreadRule(const HotThreadRule& rule, const ProcessEntry& process, const CpuSet& systemSet,
+            const CpuSet& reservedSet) {
+            // Windows 下线程亲和性必须是进程亲和性的子集，先保证进程允许使用规则核心
+            ProcessHandle handle;
+            CpuSet processSet;
+            CpuSet processSystemSet;
+            if (QueryCachedAffinity(process, handle, processSet, processSystemSet) && !rule.cores.IsSubsetOf(processSet)) {
+                CpuSet widened = processSet | rule.cores;
+                if (!m_backend->ApplyAffinity(handle, widened)) {
+                    // 进程亲和性不包含规则核心时每个线程的绑定都会失败，以进程级事件（线程 ID 为 0）报告一次
+                    ProcessActionEvent event;
+                    event.type = ProcessActionEvent::Type::ThreadPinned;
+                    event.processId = process.processId;
+                    event.name = process.name;
+                    event.oldAffinity = std::move(processSet);
+                    event.newAffinity = std::move(widened);
+                    event.errorCode = GetLastError();
+                    event.result = AffinityApplyStatus::Failed;
+                    event.timestamp = std::chrono::system_clock::now();
+                    m_actionDispatcher.Publish(std::move(event));
+                    return;
+                }
+            }
+
+            if (!m_threadTracker.Rank(*m_backend, process, m_rankedThreads)) {
+                return;
+            }
+
+            // 辅助线程同时避开规则核心与保留核心
+            CpuSet avoided = rule.cores;
+            if (m_isProtectionActive) {
+                avoided |= reservedSet;
+            }
+
+            for (size_t i = 0; i < m_rankedThreads.size(); i++) {
+                const ThreadUsage& thread = m_rankedThreads[i];
+                CpuSet current;
+                if (!m_backend->QueryThreadAffinity(thread.threadId, current)) {
+                    continue;   // 线程已退出或权限不足
+                }
+
+                bool isHot = i < rule.topK;
+                CpuSet target = rule.cores;
+                if (!isHot) {
+                    // 上一轮的热点线程只在规则核心上，降级后放回其余全部核心
+                    target = current;
+                    target.AndNot(avoided);
+                    if (target.Empty()) {
+                        target = systemSet;
+                        target.AndNot(avoided);
+                    }
+                }
+
+                if (target.Empty() || target == current) {
+                    continue;
+                }
+
+                if (isHot) {
+                    ProcessActionEvent event;
+                    event.type = ProcessActionEvent::Type::ThreadPinned;
+                    event.processId = process.processId;
+                    event.threadId = thread.threadId;
+                    event.name = process.name;
+                    event.oldAffinity = std::move(current);
+                    event.newAffinity = target;
+                    if (m_backend->ApplyThreadAffinity(thread.threadId, target)) {
+                        event.result = AffinityApplyStatus::Succeeded;
+                    }
+                    else {
+                        event.errorCode = GetLastError();
+                        event.result = AffinityApplyStatus::Failed;
+                    }
+                    event.timestamp = std::chrono::system_clock::now();
+                    m_actionDispatcher.Publish(std::move(event));
+                }
+                else {
+                    m_backend->ApplyThreadAffinity(thread.threadId, target);
+                }
+            }
+        }
+
+        bool CpuCoreManager::HasHotThreadRule(const ProtectionConfig& config, const std::string& processName) {
+            for (const HotThreadRule& rule : config.hotThreadRules) {
+                if (MatchesHotThreadRule(rule, processName)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void CpuCoreManager::StartProcessEventSource() {
+            {
+                std::lock_guard<std::mutex> lock(m_protectionMutex);
+                m_pendingProcesses.clear();
+                m_resyncRequested = false;
+            }
+
+            m_eventSource = m_backend->CreateEventSource();
+            if (m_eventSource &&
+                m_eventSource->Start([this](const ProcessEvent& event) { OnProcessEvent(event); })) {
+                std::cout << "进程事件监听已启动，新进程将被立即处理" << std::endl;
+                return;
+            }
+
+            m_eventSource.reset();
+            std::cout << "进程事件监听不可用（需要管理员权限），仅使用周期扫描" << std::endl;
+        }
+
+        void CpuCoreManager::StopProcessEventSource() {
+            if (m_eventSource) {
+                m_eventSource->Stop();
+                m_eventSource.reset();
+            }
+        }
+
+        // 在事件源线程上执行，只入队并唤醒保护线程
+        void CpuCoreManager::OnProcessEvent(const ProcessEvent& event) {
+            {
+                std::lock_guard<std::mutex> lock(m_protectionMutex);
+
+                switch (event.type) {
+                case ProcessEvent::Type::Created:
+                case ProcessEvent::Type::Exec:
+                    if (m_pendingProcesses.size() < MAX_PENDING_PROCESSES) {
+                        m_pendingProcesses.push_back(PendingProcess{ event.processId, event.parentProcessId, std::chrono::steady_clock::now() });
+                    }
+                    else {
+                        m_resyncRequested = true;
+                    }
+                    break;
+                case ProcessEvent::Type::Overflow:
+                    m_resyncRequested = true;
+                    break;
+                case ProcessEvent::Type::Exited:
+                    // 已退出进程的句柄由下一轮全量扫描淘汰
+                    return;
+                }
+            }
+            m_protectionWakeup.notify_one();
+        }
+
+        std::shared_ptr<const ProtectionConfig> CpuCoreManager::GetConfig() const {
+            return std::atomic_load(&m_config);
+        }
+
+        void CpuCoreManager::PublishConfig(const std::function<void(ProtectionConfig& config)>& update) {
+            {
+                std::lock_guard<std::mutex> lock(m_configMutex);
+                auto config = std::make_shared<ProtectionConfig>(*std::atomic_load(&m_config));
+                update(*config);
+                config->version++;
+                std::atomic_store(&m_config, std::shared_ptr<const ProtectionConfig>(std::move(config)));
+            }
+
+            // 保护线程在下一轮开始时取到新快照
+            {
+                std::lock_guard<std::mutex> lock(m_protectionMutex);
+                m_resyncRequested = true;
+            }
+            m_protectionWakeup.notify_all();
+        }
+
+        bool CpuCoreManager::IsSkippedProcess(const ProcessEntry& entry, const ProtectionConfig& config) {
+            return entry.isSystem || entry.processId == m_backend->GetCurrentPid() ||
+                (config.controlledProcessId != 0 && entry.processId == config.controlledProcessId);
+        }
+
+        bool CpuCoreManager::QueryCachedAffinity(const ProcessEntry& process, ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet) {
+            handle = m_handleCache.Acquire(process);
+            if (!handle.IsValid()) {
+                return false;
+            }
+
+            return m_backend->QueryAffinity(handle, processSet, systemSet);
+        }
+
+        CpuSet CpuCoreManager::ComputeExcludedSet(const CpuSet& processSet, const CpuSet& systemSet, const CpuSet& excluded) {
+            CpuSet newAffinity = processSet;
+            newAffinity.AndNot(excluded);
+
+            if (newAffinity.Empty()) {
+                CpuSet candidates = systemSet;
+                candidates.AndNot(excluded);
+                if (!candidates.Empty()) {
+                    newAffinity = CpuSet::Single(candidates.First());
+                }
+            }
+
+            return newAffinity;
+        }
+
+        // =============================================================================
+        // Utils 命名空间实现
         // =============================================================================
 
         namespace Utils {
 
+#ifdef _WIN32
             bool IsRunningAsAdmin() {
                 BOOL fIsElevated = FALSE;
                 HANDLE hToken = NULL;
@@ -760,18 +2415,48 @@ namespace SamsunIoCardC {
                 }
             }
 
+#else
+            bool IsRunningAsAdmin() {
+                return geteuid() == 0;
+            }
+
+            bool RestartAsAdmin() {
+                // Linux 下无法交互式提权，需由调用方以 root 或 CAP_SYS_NICE 启动
+                std::cerr << "请使用 root 权限（例如 sudo）重新启动程序" << std::endl;
+                return false;
+            }
+
+            bool EnablePrivilege(const TCHAR*, bool) {
+                // Linux 没有可按需启用的特权，修改其他进程亲和性需要 root 或 CAP_SYS_NICE
+                return IsRunningAsAdmin();
+            }
+
+            void DisplaySystemInfo() {
+                struct utsname systemName;
+
+                std::cout << "=== 系统信息 ===" << std::endl;
+                std::cout << "CPU核心数: " << GetCpuCoreCount() << std::endl;
+                std::cout << "页面大小: " << sysconf(_SC_PAGESIZE) << " bytes" << std::endl;
+                std::cout << "处理器架构: ";
+
+                if (uname(&systemName) == 0) {
+                    std::cout << systemName.machine << std::endl;
+                }
+                else {
+                    std::cout << "Unknown" << std::endl;
+                }
+            }
+#endif
+
             DWORD GetCpuCoreCount() {
-                SYSTEM_INFO sysInfo;
-                GetSystemInfo(&sysInfo);
-                return sysInfo.dwNumberOfProcessors;
+                return QueryProcessorInfo().dwNumberOfProcessors;
             }
 
-            DWORD_PTR GetSystemAffinityMask() {
-                SYSTEM_INFO sysInfo;
-                GetSystemInfo(&sysInfo);
-                return sysInfo.dwActiveProcessorMask;
+            CpuSet GetSystemAffinityMask() {
+                return QueryProcessorInfo().activeProcessors;
             }
 
+#ifdef _WIN32
             std::string WideStringToString(const wchar_t* wideStr) {
                 if (wideStr == nullptr) return "";
 
@@ -793,6 +2478,55 @@ namespace SamsunIoCardC {
                 MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &result[0], sizeNeeded);
                 return result;
             }
+#else
+            // Linux 下 wchar_t 为 UTF-32
+            std::string WideStringToString(const wchar_t* wideStr) {
+                if (wideStr == nullptr) return "";
+
+                std::string result;
+                for (; *wideStr != L'\0'; wideStr++) {
+                    uint32_t code = static_cast<uint32_t>(*wideStr);
+                    if (code < 0x80) {
+                        result += static_cast<char>(code);
+                    }
+                    else if (code < 0x800) {
+                        result += static_cast<char>(0xC0 | (code >> 6));
+                        result += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    else if (code < 0x10000) {
+                        result += static_cast<char>(0xE0 | (code >> 12));
+                        result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        result += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    else {
+                        result += static_cast<char>(0xF0 | (code >> 18));
+                        result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                        result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        result += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                }
+                return result;
+            }
+
+            std::wstring StringToWideString(const std::string& str) {
+                if (str.empty()) return L"";
+
+                std::wstring result;
+                for (size_t i = 0; i < str.size();) {
+                    unsigned char lead = static_cast<unsigned char>(str[i]);
+                    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+                    uint32_t code = extra == 0 ? lead : (lead & (0x3F >> extra));
+
+                    for (int k = 1; k <= extra && i + k < str.size(); k++) {
+                        code = (code << 6) | (static_cast<unsigned char>(str[i + k]) & 0x3F);
+                    }
+
+                    result += static_cast<wchar_t>(code);
+                    i += static_cast<size_t>(extra) + 1;
+                }
+                return result;
+            }
+#endif
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,385 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include "ActionEvents.h"
+#include "AdaptiveInterval.h"
+#include "AffinityBatch.h"
+#include "CgroupCpuset.h"
+#include "ConfigWatcher.h"
+#include "CoreUtilization.h"
+#include "CpuSet.h"
+#include "HotThreads.h"
+#include "IrqAffinity.h"
+#include "JitterProbe.h"
+#include "Metrics.h"
+#include "ProcessBackend.h"
+#include "ProcessHandleCache.h"
+#include "ProcessNameIndex.h"
+#include "ProcessRules.h"
+#include "ProcessScanner.h"
+#include "ProcessTree.h"
+#include "ReservationController.h"
+#include "SharedProcessTable.h"
+#include "TimeSeriesStore.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // 检测到进程占用保留核心并已处理时的回调
+        using ProcessDetectedCallback = std::function<void(DWORD processId, const std::string& processName)>;
+
+        // 核心保留方式
+        enum class ReservationMode {
+            Affinity,   // 修改其他进程的亲和性，保护线程持续检查新进程
+            Cgroup      // Linux cgroup v2 cpuset 分区，新进程自动继承，保护线程不再逐进程排除
+        };
+
+        // 扫描读取的配置快照：发布后不再修改；更新时复制当前快照、修改后整体替换（RCU）
+        // 保护线程每轮开始时取一次快照，版本变化时对全部进程重新检查
+        struct ProtectionConfig {
+            std::vector<DWORD> reservedCores;
+            CpuSet reservedSet;
+            std::shared_ptr<const ProcessRuleSet> processRules;
+            std::vector<HotThreadRule> hotThreadRules;
+            bool reservedByCgroup = false;      // 保留核心已由 cgroup 分区独占
+            bool reservationHeld = false;       // ReserveCoreForCurrentProcess 建立的保留，保护未运行时也保持；当前进程属于保留组
+            DWORD controlledProcessId = 0;      // 保留核心闭环调整的被保护进程，与当前进程一样不做排除
+            uint64_t version = 0;
+        };
+
+        // 批量绑定中的一项：coreCount 为 0 时绑定到 cores，否则使用编号最低的 coreCount 个可用核心
+        struct AffinityRequest {
+            DWORD processId = 0;
+            CpuSet cores;
+            DWORD coreCount = 0;
+        };
+
+        // =============================================================================
+        // CpuCoreManager：CPU 亲和性管理与核心保留
+        // =============================================================================
+
+        class CpuCoreManager {
+        public:
+            CpuCoreManager();
+            // 使用指定的进程后端（默认使用当前平台后端）
+            explicit CpuCoreManager(std::unique_ptr<IProcessBackend> backend);
+            ~CpuCoreManager();
+
+            CpuCoreManager(const CpuCoreManager&) = delete;
+            CpuCoreManager& operator=(const CpuCoreManager&) = delete;
+
+            // 当前进程亲和性与优先级
+            bool SetProcessAffinity(const CpuSet& affinity);
+            CpuSet GetProcessAffinity();
+            bool SetProcessPriorityLevel(DWORD priorityClass);
+
+            void DisplayCpuCoreInfo();
+            bool BindToSingleCore(DWORD coreIndex);
+            // memoryPolicy 非空时同时把当前进程的内存限定到这些核心所在的 NUMA 节点
+            // Linux 的分配策略只作用于调用线程及其之后创建的线程，需要在创建工作线程之前调用
+            bool BindToMultipleCores(const std::vector<DWORD>& coreIndices,
+                const ProcessMemoryPolicy& memoryPolicy = ProcessMemoryPolicy());
+
+            // 其他进程亲和性
+            CpuSet GetProcessAffinityByPID(DWORD processId);
+            std::map<DWORD, CpuSet> GetAllProcessesAffinity();
+            // 通过 PID 索引查询进程名，索引过期（超过 2 秒未刷新）时先刷新一次
+            std::string GetProcessName(DWORD processId);
+            // 与 GetProcessName 相同，但返回驻留的名称，索引命中时不分配内存；未找到返回空指针
+            ProcessName FindProcessName(DWORD processId);
+            // 进程的全部后代 PID（按进程树，广度优先）；进程树过期时先刷新一次
+            std::vector<DWORD> GetProcessDescendants(DWORD processId);
+            bool ExcludeCoreFromProcess(DWORD processId, DWORD coreToExclude);
+
+            // 线程级亲和性：按 intervalMilliseconds 内消耗的 CPU 时间降序返回进程的线程
+            std::vector<ThreadUsage> GetBusiestThreads(DWORD processId, DWORD intervalMilliseconds);
+            bool PinThread(DWORD threadId, const CpuSet& cores);
+            bool ExcludeCoresFromThread(DWORD threadId, const CpuSet& cores);
+
+            // 热点线程规则：匹配进程的最忙 K 个线程绑定到规则核心，其余线程排除规则核心与保留核心
+            // 保护线程每轮全量扫描时按最新排名重新应用，匹配的进程不再做进程级排除
+            void SetHotThreadRules(const std::vector<HotThreadRule>& rules);
+            bool LoadHotThreadRules(const std::string& iniPath);
+            void ApplyHotThreadRules();
+
+            // 进程规则（[ProcessName] / [PID] / [ProcessCoreBinding] / [PidCoreBinding] / [Critical]
+            // / [ProcessScheduling] / [PidScheduling] / [ProcessMemoryPolicy] / [PidMemoryPolicy] / [ProcessTree]）
+            // 加载后编译为索引，系统关键进程判断与规则匹配均为常数时间；未加载时只有内置关键进程列表
+            bool LoadProcessRules(const std::string& iniPath);
+            // 按规则设置所有匹配进程的亲和性（保护生效时避开保留核心）、调度设置与内存策略，不匹配任何规则的进程保持不变
+            // 返回亲和性结果；调度设置与内存策略的结果以 SchedulingApplied / MemoryPolicyApplied 事件发布
+            // 保护运行中时调度规则还会在每轮扫描时应用到新进程与轮到复检的进程；内存迁移开销大，只在这里执行
+            // [ProcessTree] 进程的规则同时适用于其后代；保护运行中时这些亲和性规则也由保护线程在进程出现时立即应用
+            std::vector<AffinityApplyResult> ApplyProcessRules();
+            // 批量设置指定进程的亲和性：一次进程快照，句柄缓存与线程池并行应用，结果与 requests 一一对应
+            // 保护运行中时不分配保留核心；快照中不存在的进程结果为 Exited
+            std::vector<AffinityApplyResult> ApplyAffinityBatch(const std::vector<AffinityRequest>& requests);
+            // 枚举进程写入共享进程表（CpuCoreApi.h 的固定布局），includeAffinity 时同时查询亲和性
+            bool PublishProcessTable(SharedProcessTable& table, bool includeAffinity);
+
+            // 核心保留
+            bool ReserveCoreForCurrentProcess(DWORD reservedCore);
+            // 从所有其他进程的亲和性中排除指定核心：先计算全部变更，再由线程池并行应用
+            // 返回每个进程的结果（跳过的系统进程与当前进程不在其中）
+            std::vector<AffinityApplyResult> ExcludeCoresFromAllProcesses(const CpuSet& excluded);
+            CpuSet AnalyzeOtherProcessesCPUUsage();
+            // 按实测使用率判断空闲核心：窗口内使用率低于阈值的核心视为可用
+            CpuSet GetAvailableCores();
+            bool SetIntelligentCPUAffinity();
+            // 空闲判定阈值（百分比）与平均窗口，默认 20% / 1000ms
+            void SetIdleCoreCriteria(double thresholdPercent, DWORD windowMilliseconds);
+
+            // 后台保护线程
+            void StartCoreProtection(DWORD reservedCore);
+            // 保护已在运行时不重启线程，只发布新的保留核心，下一轮扫描即生效
+            void StartMultiCoreProtection(const std::vector<DWORD>& reservedCores);
+            void StopCoreProtection();
+            // 替换保留核心；保护运行中时立即唤醒保护线程重新检查全部进程，期间不存在未保护的窗口
+            // 列表为空或含有不小于处理器数的编号时返回 false，不做任何修改
+            bool UpdateReservedCores(const std::vector<DWORD>& reservedCores);
+            std::vector<DWORD> GetProtectedCores();
+
+            // 一次读取配置文件中的进程规则、热点线程规则与 [Protection] ReservedCores，整体发布
+            bool LoadConfigFile(const std::string& iniPath);
+            // 监视配置文件，修改后自动调用 LoadConfigFile（约 1 秒内生效）
+            bool WatchConfigFile(const std::string& iniPath);
+            void StopWatchingConfigFile();
+
+            // 选择核心保留方式，系统不支持 cgroup v2 cpuset 时返回 false；保护运行中立即切换
+            // cgroup 方式在保护启动时创建保留组与普通组，停止保护或切回亲和性方式时删除
+            bool SetReservationMode(ReservationMode mode);
+            ReservationMode GetReservationMode() const;
+            // cgroup v2 挂载点，默认 /sys/fs/cgroup；需要在选择 cgroup 方式之前设置，保留生效期间返回 false
+            bool SetCgroupRoot(const std::string& root);
+            // cgroup 方式下把进程移入保留组，使其运行在保留核心上
+            bool AddProcessToReservation(DWORD processId);
+            // 保护运行期间把硬件中断移出保留核心（仅 Linux），停止保护时恢复原亲和性
+            // 新注册的中断与被改回的中断在每轮全量扫描时重新处理；系统不支持时返回 false
+            bool SetIrqSteering(bool enabled);
+
+            // 全量扫描间隔范围：发现新进程或需要排除的进程时回到最小间隔，否则每轮加倍直到最大间隔
+            // 默认 500ms / 5000ms，同时用于前台保护循环
+            void SetScanIntervalLimits(DWORD minimumMilliseconds, DWORD maximumMilliseconds);
+            // 保护线程当前的全量扫描间隔（毫秒）
+            DWORD GetCurrentScanInterval() const;
+
+            // 按被保护进程的负载在 [minCores, maxCores] 个物理核心之间自动扩大或缩小保留（保护运行期间生效）
+            // 扩大优先选择与现有保留核心同一 L3 域的核心，CPU 0 所在的物理核心始终留给系统
+            // 亲和性方式下同时把被保护进程的亲和性设为新的保留核心；再次调用时替换选项
+            bool StartReservationController(const ReservationControllerOptions& options = ReservationControllerOptions());
+            void StopReservationController();
+
+            // 前台保护循环，扫描间隔与保护线程一样自适应
+            void ProtectReservedCore(DWORD reservedCore, int durationSeconds);
+            void ProtectMultipleReservedCores(const std::vector<DWORD>& reservedCores, int durationSeconds);
+
+            // 按拓扑推荐保留 desiredCores 个物理核心，返回这些核心的全部逻辑处理器（含 SMT 兄弟线程）
+            // 只考虑编号小于 coreCount 的处理器
+            std::vector<DWORD> GetRecommendedCores(DWORD coreCount, DWORD desiredCores);
+            CoreReservation GetRecommendedReservation(DWORD coreCount, DWORD desiredCores);
+            void DisplayCoreAllocationStrategy(DWORD totalCores, DWORD desiredCores);
+            void MonitorCPUUsage(int durationSeconds);
+
+            // 回调在事件分发线程上异步执行，不会阻塞保护扫描
+            void SetProcessDetectedCallback(ProcessDetectedCallback callback);
+            // 接收全部操作事件（含失败结果），同样在事件分发线程上执行
+            void AddActionSink(ProcessActionSink sink);
+            // 关闭后成功的操作不再输出到控制台，只分发给回调与接收者
+            void SetActionConsoleOutput(bool enabled);
+            // 事件队列满时丢弃的事件数
+            uint64_t GetDroppedActionCount() const;
+
+            // 在保留核心上运行抖动探测，突发与同期扫描在该核心上发现的进程关联；结果同时输出到控制台
+            std::vector<CoreJitterReport> MeasureCoreJitter(const JitterProbeOptions& options = JitterProbeOptions());
+            std::vector<CoreJitterReport> MeasureCoreJitter(const CpuSet& cores, const JitterProbeOptions& options);
+
+            // 自身开销统计：快照 / 单进程查询 / 应用耗时、发现到排除的延迟与各类计数
+            const ManagerMetrics& GetMetrics() const;
+            std::string FormatMetrics();
+            bool WriteMetricsFile(const std::string& path);
+            // 定期把 Prometheus 文本写入文件（node_exporter textfile collector 目录）
+            bool StartMetricsExport(const std::string& path, DWORD intervalMilliseconds = 5000);
+            void StopMetricsExport();
+
+            // 把每核心使用率、扫描指标与进程亲和性变化记录到 directory 下的时序存储（见 TimeSeriesStore.h）
+            // 使用率与扫描指标每 intervalMilliseconds 记录一次，亲和性按进程名记录每次成功的修改
+            // 其他进程（例如 Web 服务）可以只读打开同一目录查询；再次调用时先停止旧的记录
+            bool StartHistoryRecording(const std::string& directory, DWORD intervalMilliseconds = 1000,
+                const TimeSeriesStoreOptions& options = TimeSeriesStoreOptions());
+            void StopHistoryRecording();
+
+        private:
+            void ProtectionThreadFunction();
+            // 枚举进程并刷新 PID -> 进程名索引，所有扫描都经由这里取快照
+            bool SnapshotProcesses(std::vector<ProcessEntry>& processes);
+            // 对单个进程执行保留核心排除（调用方已完成跳过判断）；treeRule 非空时改为按该规则设置亲和性（同样避开保留核心）
+            void ProtectProcess(const ProcessEntry& process, const CpuSet& reservedSet, const ProcessRuleMatch& treeRule,
+                std::chrono::steady_clock::time_point detected);
+            // 批量排除 excluded 中的核心，每个有变更或失败的进程发布一个操作事件
+            // detected 非空时记录从发现进程到排除完成的延迟
+            void ExcludeFromProcesses(const std::vector<const ProcessEntry*>& processes, const CpuSet& excluded,
+                std::vector<AffinityApplyResult>& results,
+                std::chrono::steady_clock::time_point detected = std::chrono::steady_clock::time_point());
+            // 批量按 [ProcessTree] 规则设置亲和性（避开 avoided），matches 为每个进程的规则
+            void ApplyTreeRules(const std::vector<const ProcessEntry*>& processes,
+                const std::unordered_map<DWORD, ProcessRuleMatch>& matches, const CpuSet& avoided,
+                std::vector<AffinityApplyResult>& results, std::chrono::steady_clock::time_point detected);
+            // 把批量应用结果计入统计
+            void RecordApplyResults(const std::vector<AffinityApplyResult>& results,
+                std::chrono::steady_clock::time_point detected);
+            void RecordApplyStatus(AffinityApplyStatus status);
+            // 事件驱动路径：立即处理事件源报告的新进程
+            struct PendingProcess {
+                DWORD processId;
+                DWORD parentProcessId;                              // 事件报告的父进程，未知时为 0
+                std::chrono::steady_clock::time_point detected;     // 事件送达时间
+            };
+            void ProtectPendingProcesses(std::vector<PendingProcess>& pending, const ProtectionConfig& config);
+            // 校验核心编号（不小于处理器数时输出错误并返回 false）并转换为集合
+            bool BuildReservedSet(const std::vector<DWORD>& reservedCores, CpuSet& reservedSet);
+            // 打印核心分配分析并返回可用核心
+            CpuSet ReportAvailableCores(const CpuSet& occupiedCores);
+            void StartProcessEventSource();
+            void StopProcessEventSource();
+            void OnProcessEvent(const ProcessEvent& event);
+            // 按当前方式应用 config 中的 cgroup 保留，返回保留核心是否已由 cgroup 独占；调用方已持有 m_configMutex
+            bool ApplyCgroupReservation(const ProtectionConfig& config);
+            // 替换 config 中的保留核心并重新应用 cgroup 保留，返回核心是否变化；调用方已持有 m_configMutex
+            bool ReplaceReservedCores(ProtectionConfig& config, std::vector<DWORD> reservedCores, CpuSet reservedSet);
+            // 重新发布配置，使保留方式或保护状态的变化生效
+            void RefreshReservation();
+            // 按开关与当前保留核心应用或恢复中断引导，在保护线程的全量扫描时调用
+            void SteerInterrupts(const ProtectionConfig& config);
+            // 前台保护循环的共同实现
+            void RunForegroundProtection(const CpuSet& reservedSet, int durationSeconds);
+            // 保留核心闭环调整线程，每个采样周期调用一次 AdjustReservation
+            void ReservationControlThreadFunction(ReservationControllerOptions options);
+            void AdjustReservation(const ReservationControllerOptions& options, ReservationController& controller,
+                ReservationPressureSampler& sampler, const CpuTopology& topology);
+            // 亲和性方式缩小保留后，把移出的核心归还给此前被排除的进程（亲和性恰为 全部核心 - 原保留核心）
+            void ReturnReleasedCores(const CpuSet& previousReserved, const CpuSet& released);
+            // 当前配置快照，调用方在一轮扫描内持有
+            std::shared_ptr<const ProtectionConfig> GetConfig() const;
+            // 串行化的读-复制-更新：update 修改副本后原子发布，并唤醒保护线程
+            void PublishConfig(const std::function<void(ProtectionConfig& config)>& update);
+            // 是否跳过该进程（系统伪进程、内核线程、当前进程、闭环调整的被保护进程）
+            bool IsSkippedProcess(const ProcessEntry& entry, const ProtectionConfig& config);
+            // 通过句柄缓存查询进程亲和性，失败时 handle 为无效句柄
+            bool QueryCachedAffinity(const ProcessEntry& process, ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet);
+            // 计算排除指定核心后的亲和性，结果为空时退回到第一个可用的其他核心
+            static CpuSet ComputeExcludedSet(const CpuSet& processSet, const CpuSet& systemSet, const CpuSet& excluded);
+            // 对快照中匹配热点线程规则的进程执行线程级绑定
+            void ApplyHotThreadRules(const std::vector<ProcessEntry>& processes, const ProtectionConfig& config);
+            void ApplyHotThreadRule(const HotThreadRule& rule, const ProcessEntry& process, const CpuSet& systemSet,
+                const CpuSet& reservedSet);
+            // 进程是否由热点线程规则在线程级管理
+            static bool HasHotThreadRule(const ProtectionConfig& config, const std::string& processName);
+            // 按调度规则（已由 ResolveProcessRules 解析，可能继承自祖先）设置进程的优先级、调度策略与 I/O 优先级
+            // scheduling 为空时不做任何事
+            void ApplySchedulingRule(const ProcessEntry& process, const ProcessScheduling* scheduling);
+            // 按进程当前亲和性所在的 NUMA 节点应用内存策略，发布带有本地内存比例的事件
+            // 亲和性覆盖全部节点时没有可限定的节点，不做任何事
+            bool ApplyMemoryPolicy(const ProcessEntry& process, const ProcessHandle& handle, const ProcessMemoryPolicy& policy,
+                const CpuSet& affinity, const CpuTopology& topology);
+            // 把亲和性应用结果写入事件队列，不等待控制台与回调
+            void PublishAction(ProcessActionEvent::Type type, AffinityApplyResult&& result);
+            void OnActionEvent(const ProcessActionEvent& event);
+            // 历史记录线程：按间隔写入使用率与扫描指标
+            void HistoryThreadFunction(std::shared_ptr<TimeSeriesStore> history, std::chrono::milliseconds interval);
+
+            std::unique_ptr<IProcessBackend> m_backend;
+            ProcessHandleCache m_handleCache;
+            ProcessNameIndex m_nameIndex;
+            // 与 m_nameIndex 同时刷新，用于 [ProcessTree] 规则的继承
+            ProcessTree m_processTree;
+            AffinityBatchApplier m_batchApplier;
+            CoreUtilizationSampler m_utilizationSampler;
+            double m_idleThresholdPercent;
+            // 最近一次 GetAvailableCores 测得的各核心使用率，采样不可用时为空
+            std::vector<double> m_lastUtilization;
+
+            // 当前配置快照，通过 std::atomic_load / std::atomic_store 读取与发布
+            std::shared_ptr<const ProtectionConfig> m_config;
+            std::mutex m_configMutex;
+            ConfigFileWatcher m_configWatcher;
+
+            // cgroup 保留状态，在 m_configMutex 下修改
+            std::atomic<ReservationMode> m_reservationMode;
+            CgroupCpusetReservation m_cgroupReservation;
+            std::vector<DWORD> m_cgroupMembers; // 已移入当前保留组的进程（当前进程、闭环调整的被保护进程）
+
+            // 中断引导状态，只在保护线程内（以及线程结束后的 StopCoreProtection 中）访问
+            std::atomic<bool> m_irqSteeringEnabled;
+            IrqAffinitySteering m_irqSteering;
+
+            std::atomic<bool> m_isProtectionActive;
+            std::thread m_protectionThread;
+            std::mutex m_protectionMutex;
+            std::condition_variable m_protectionWakeup;
+            // 保护线程的增量扫描状态，只在保护线程内访问
+            IncrementalProcessScanner m_protectionScanner;
+            AdaptiveScanInterval m_scanInterval;
+
+            // 保留核心闭环调整线程
+            std::thread m_reservationThread;
+            std::mutex m_reservationMutex;
+            std::condition_variable m_reservationWakeup;
+            bool m_reservationControlRunning;
+
+            // 进程事件源与待处理队列（受 m_protectionMutex 保护）
+            std::unique_ptr<IProcessEventSource> m_eventSource;
+            std::vector<PendingProcess> m_pendingProcesses;
+            bool m_resyncRequested;
+
+            // 热点线程的 CPU 时间记录（规则在配置快照中）
+            std::mutex m_hotThreadMutex;
+            ThreadActivityTracker m_threadTracker;
+            std::vector<ThreadUsage> m_rankedThreads;
+
+            // 操作事件队列；回调由分发线程调用，设置回调时需持有 m_callbackMutex
+            ProcessActionDispatcher m_actionDispatcher;
+            std::mutex m_callbackMutex;
+            ProcessDetectedCallback m_processDetectedCallback;
+
+            ManagerMetrics m_metrics;
+            MetricsFileExporter m_metricsExporter;
+
+            // 历史记录；存储通过 std::atomic_load / std::atomic_store 读取，事件分发线程也写入亲和性变化
+            std::shared_ptr<TimeSeriesStore> m_history;
+            std::thread m_historyThread;
+            std::mutex m_historyMutex;
+            std::condition_variable m_historyWakeup;
+            bool m_historyRecording;
+
+            // 抖动测量期间由事件分发线程记录扫描在被测核心上发现的进程
+            std::mutex m_jitterMutex;
+            CpuSet m_jitterCores;
+            std::vector<JitterSuspect> m_jitterOccupants;
+        };
+
+        // =============================================================================
+        // 工具函数
+        // =============================================================================
+
+        namespace Utils {
+            bool IsRunningAsAdmin();
+            bool RestartAsAdmin();
+            bool EnablePrivilege(const TCHAR* privilegeName, bool enable);
+            void DisplaySystemInfo();
+            DWORD GetCpuCoreCount();
+            CpuSet GetSystemAffinityMask();
+            std::string WideStringToString(const wchar_t* wideStr);
+            std::wstring StringToWideString(const std::string& str);
+        }
+    }
+}
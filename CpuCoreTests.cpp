@@ -0,0 +1,818 @@
+﻿#include "pch.h"
+#include "CpuCoreManager.h"
+#include "CpuSet.h"
+#include "ProcessRules.h"
+#include "ProcessTree.h"
+#include "ReservationController.h"
+#include "SimulatedBackend.h"
+#include "TimeSeriesStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+// =============================================================================
+// CpuCoreManager 单元测试：只覆盖不依赖真实进程的逻辑，管理器用例使用模拟后端与临时目录
+//
+// 没有测试框架，每个用例是一个函数，CHECK 失败时输出位置并继续；
+// 命令行参数为用例名的子串时只运行匹配的用例。全部通过返回 0，否则返回 1
+// =============================================================================
+
+namespace {
+    int g_checks = 0;
+    int g_failures = 0;
+
+    void ReportFailure(const char* file, int line, const std::string& message) {
+        g_failures++;
+        std::cerr << "  失败: " << file << ":" << line << ": " << message << std::endl;
+    }
+}
+
+#define CHECK(condition) \
+    do { \
+        g_checks++; \
+        if (!(condition)) { \
+            ReportFailure(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        g_checks++; \
+        if (!((expected) == (actual))) { \
+            ReportFailure(__FILE__, __LINE__, std::string(#actual " 不等于 " #expected)); \
+        } \
+    } while (0)
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+
+            // =========================================================================
+            // CpuSet
+            // =========================================================================
+
+            CpuSet ParseOrEmpty(const std::string& text) {
+                CpuSet cpus;
+                CpuSet::Parse(text, cpus);
+                return cpus;
+            }
+
+            void TestCpuSetParse() {
+                CpuSet cpus;
+                CHECK(CpuSet::Parse("0-3,8,10-11", cpus));
+                CHECK_EQUAL(size_t(7), cpus.Count());
+                CHECK(cpus.Test(3) && cpus.Test(8) && !cpus.Test(9) && cpus.Test(11));
+
+                // sysfs 列表以换行结尾，逗号两侧允许空白
+                CHECK(CpuSet::Parse("  0-1 , 64\n", cpus));
+                CHECK_EQUAL(std::string("0-1,64"), cpus.ToString());
+
+                CHECK(CpuSet::Parse("", cpus));
+                CHECK(cpus.Empty());
+
+                CHECK(CpuSet::Parse("8191", cpus));
+                CHECK_EQUAL(size_t(8191), cpus.First());
+
+                CHECK(!CpuSet::Parse("3-1", cpus));
+                CHECK(!CpuSet::Parse("a", cpus));
+                CHECK(!CpuSet::Parse("1,,2", cpus));
+                CHECK(!CpuSet::Parse("1-", cpus));
+                CHECK(!CpuSet::Parse("1 2", cpus));
+                // 超出解析上限的编号不分配位图
+                CHECK(!CpuSet::Parse("8192", cpus));
+                CHECK(!CpuSet::Parse("0-4000000000", cpus));
+            }
+
+            void TestCpuSetFormat() {
+                CHECK_EQUAL(std::string("(空)"), CpuSet().ToString());
+                CHECK_EQUAL(std::string("5"), CpuSet::Single(5).ToString());
+                CHECK_EQUAL(std::string("62-65"), CpuSet::Range(62, 4).ToString());
+                CHECK_EQUAL(std::string("0,2,4-6,127"), ParseOrEmpty("6,5,4,2,0,127").ToString());
+
+                // 格式化结果可以重新解析为相同的集合
+                CpuSet cpus = ParseOrEmpty("1-3,63-64,100,1000-1023");
+                CHECK(cpus == ParseOrEmpty(cpus.ToString()));
+            }
+
+            void TestCpuSetWords() {
+                CpuSet cpus = CpuSet::FromMask(0xF0, 64);
+                CHECK_EQUAL(std::string("68-71"), cpus.ToString());
+                CHECK_EQUAL(uint64_t(0), cpus.Word(0));
+                CHECK_EQUAL(uint64_t(0xF0), cpus.Word(1));
+                CHECK_EQUAL(uint64_t(0), cpus.Word(5));
+                CHECK_EQUAL(uint64_t(0xF00), cpus.ExtractMask(60));
+
+                // 去掉末尾全零字后与空集合相等
+                CpuSet trimmed = CpuSet::Single(200);
+                trimmed.Reset(200);
+                CHECK(trimmed == CpuSet());
+                CHECK_EQUAL(size_t(0), trimmed.WordCount());
+                CHECK_EQUAL(CpuSet::npos, trimmed.First());
+                CHECK_EQUAL(CpuSet::npos, trimmed.Last());
+            }
+
+            void TestCpuSetIteration() {
+                CpuSet cpus = ParseOrEmpty("63,64,130");
+                CHECK_EQUAL(size_t(63), cpus.First());
+                CHECK_EQUAL(size_t(64), cpus.Next(63));
+                CHECK_EQUAL(size_t(130), cpus.Next(64));
+                CHECK_EQUAL(CpuSet::npos, cpus.Next(130));
+                CHECK_EQUAL(size_t(130), cpus.Last());
+                CHECK_EQUAL(CpuSet::npos, cpus.Next(CpuSet::npos));
+            }
+
+            void TestCpuSetOperators() {
+                CpuSet left = ParseOrEmpty("0-7");
+                CpuSet right = ParseOrEmpty("4-11");
+                CHECK_EQUAL(std::string("0-11"), (left | right).ToString());
+                CHECK_EQUAL(std::string("4-7"), (left & right).ToString());
+                CHECK(left.Intersects(right));
+                CHECK(!left.Intersects(ParseOrEmpty("64")));
+                CHECK(ParseOrEmpty("2-3").IsSubsetOf(left));
+                CHECK(!right.IsSubsetOf(left));
+                CHECK(CpuSet().IsSubsetOf(left));
+
+                CpuSet remaining = left;
+                remaining.AndNot(right);
+                CHECK_EQUAL(std::string("0-3"), remaining.ToString());
+                // 移除高位后与较短的集合相等
+                CpuSet wide = ParseOrEmpty("1,200");
+                wide.AndNot(ParseOrEmpty("200"));
+                CHECK(wide == CpuSet::Single(1));
+            }
+
+            // =========================================================================
+            // ProcessRuleSet
+            // =========================================================================
+
+            IniEntry MakeEntry(const char* section, const char* key, const char* value) {
+                IniEntry entry;
+                entry.section = section;
+                entry.key = key;
+                entry.value = value;
+                return entry;
+            }
+
+            void TestRuleNamePrecedence() {
+                ProcessRuleSet rules;
+                rules.Load({
+                    MakeEntry("processname", "w*r?er", "1"),
+                    MakeEntry("processname", "work*", "2"),
+                    MakeEntry("processname", "worker*", "3"),
+                    MakeEntry("processname", "worker", "4"),
+                    MakeEntry("processname", "*er", "5"),
+                });
+
+                // 精确 > 最长前缀 > 通配符
+                ProcessRuleMatch match = rules.Resolve(100, "worker");
+                CHECK(match.kind == ProcessRuleKind::NameCoreCount);
+                CHECK_EQUAL(DWORD(4), match.coreCount);
+                CHECK_EQUAL(DWORD(3), rules.Resolve(100, "worker2").coreCount);
+                CHECK_EQUAL(DWORD(2), rules.Resolve(100, "workbench").coreCount);
+                // 前缀树没有命中时按文件顺序匹配通配符
+                CHECK_EQUAL(DWORD(1), rules.Resolve(100, "wirker").coreCount);
+                CHECK_EQUAL(DWORD(5), rules.Resolve(100, "other").coreCount);
+
+                // 不区分大小写并忽略 .exe 后缀
+                CHECK_EQUAL(DWORD(4), rules.Resolve(100, "Worker.EXE").coreCount);
+                CHECK_EQUAL(DWORD(3), rules.Resolve(100, "WORKER2.exe").coreCount);
+            }
+
+            void TestRuleKindPrecedence() {
+                ProcessRuleSet rules;
+                rules.Load({
+                    MakeEntry("processname", "app", "2"),
+                    MakeEntry("processcorebinding", "app*", "4-5"),
+                    MakeEntry("pid", "200", "3"),
+                    MakeEntry("pidcorebinding", "300", "6"),
+                    MakeEntry("pid", "300", "1"),
+                    MakeEntry("pidscheduling", "400", "nice:5"),
+                });
+
+                // 进程名核心绑定优先于更精确的进程名核心数规则
+                ProcessRuleMatch match = rules.Resolve(100, "app");
+                CHECK(match.kind == ProcessRuleKind::NameBinding);
+                CHECK(match.cores != nullptr && match.cores->ToString() == "4-5");
+
+                // PID 规则优先于进程名规则，PID 核心绑定优先于 PID 核心数
+                match = rules.Resolve(200, "app");
+                CHECK(match.kind == ProcessRuleKind::PidCoreCount);
+                CHECK_EQUAL(DWORD(3), match.coreCount);
+                match = rules.Resolve(300, "app");
+                CHECK(match.kind == ProcessRuleKind::PidBinding);
+                CHECK(match.cores != nullptr && match.cores->ToString() == "6");
+
+                // 只有调度规则的 PID 继续按进程名匹配亲和性规则
+                CHECK(rules.Resolve(400, "app").kind == ProcessRuleKind::NameBinding);
+                CHECK(rules.ResolveScheduling(400, "other") != nullptr);
+                CHECK(rules.ResolveScheduling(401, "other") == nullptr);
+
+                CHECK(rules.Resolve(100, "other").kind == ProcessRuleKind::None);
+            }
+
+            void TestRuleInvalidEntries() {
+                ProcessRuleSet rules;
+                rules.Load({
+                    MakeEntry("processname", "bad", "x"),
+                    MakeEntry("pid", "abc", "2"),
+                    MakeEntry("processcorebinding", "empty", ""),
+                    MakeEntry("processcorebinding", "reversed", "3-1"),
+                    MakeEntry("processname", "good", "2"),
+                });
+
+                CHECK(rules.Resolve(1, "bad").kind == ProcessRuleKind::None);
+                CHECK(rules.Resolve(1, "empty").kind == ProcessRuleKind::None);
+                CHECK(rules.Resolve(1, "reversed").kind == ProcessRuleKind::None);
+                CHECK_EQUAL(DWORD(2), rules.Resolve(1, "good").coreCount);
+            }
+
+            // =========================================================================
+            // ProcessTree 与规则继承
+            // =========================================================================
+
+            ProcessEntry MakeProcess(DWORD processId, DWORD parentProcessId, uint64_t startTime, const char* name) {
+                ProcessEntry process;
+                process.processId = processId;
+                process.parentProcessId = parentProcessId;
+                process.startTime = startTime;
+                process.name = name;
+                return process;
+            }
+
+            // launcher(10) -> shell(20) -> helper(30) -> app(40)，shell(20) -> worker(50)
+            std::vector<ProcessEntry> MakeProcessChain() {
+                return {
+                    MakeProcess(10, 1, 100, "launcher"),
+                    MakeProcess(20, 10, 200, "shell"),
+                    MakeProcess(30, 20, 300, "helper"),
+                    MakeProcess(40, 30, 400, "app"),
+                    MakeProcess(50, 20, 500, "worker"),
+                };
+            }
+
+            void TestTreeRuleInheritance() {
+                ProcessRuleSet rules;
+                rules.Load({
+                    MakeEntry("processtree", "processes", "launcher, shell"),
+                    MakeEntry("processcorebinding", "launcher", "4-5"),
+                    MakeEntry("processscheduling", "launcher", "nice:10"),
+                    MakeEntry("processmemorypolicy", "launcher", "bind"),
+                    MakeEntry("processscheduling", "shell", "nice:5"),
+                    // helper 不在 [ProcessTree] 中，它的规则不传给后代
+                    MakeEntry("processcorebinding", "helper", "6"),
+                    MakeEntry("processscheduling", "helper", "nice:1"),
+                    MakeEntry("processname", "worker", "2"),
+                });
+                ProcessTree tree;
+                std::vector<ProcessEntry> processes = MakeProcessChain();
+                tree.Update(processes);
+
+                // 三类规则分别取最近的带有该类规则的 [ProcessTree] 祖先
+                ResolvedProcessRules resolved = ResolveProcessRules(rules, tree, processes[3]);
+                CHECK(resolved.match.kind == ProcessRuleKind::NameBinding);
+                CHECK(resolved.match.cores != nullptr && resolved.match.cores->ToString() == "4-5");
+                CHECK_EQUAL(DWORD(10), resolved.inheritedFrom);
+                CHECK(resolved.treeRule);
+                CHECK(resolved.scheduling != nullptr && resolved.scheduling == rules.ResolveScheduling(20, "shell"));
+                CHECK(resolved.memoryPolicy != nullptr && resolved.memoryPolicy->mode == ProcessMemoryPolicy::Mode::Bind);
+
+                // 后代自身的亲和性规则优先，其余两类仍然继承
+                resolved = ResolveProcessRules(rules, tree, processes[4]);
+                CHECK(resolved.match.kind == ProcessRuleKind::NameCoreCount);
+                CHECK_EQUAL(DWORD(2), resolved.match.coreCount);
+                CHECK_EQUAL(DWORD(0), resolved.inheritedFrom);
+                CHECK(!resolved.treeRule);
+                CHECK(resolved.scheduling == rules.ResolveScheduling(20, "shell"));
+                CHECK(resolved.memoryPolicy == rules.ResolveMemoryPolicy(10, "launcher"));
+
+                // 非 [ProcessTree] 进程自身的规则不受影响
+                resolved = ResolveProcessRules(rules, tree, processes[2]);
+                CHECK(resolved.match.cores != nullptr && resolved.match.cores->ToString() == "6");
+                CHECK(resolved.scheduling == rules.ResolveScheduling(30, "helper"));
+                CHECK(resolved.memoryPolicy == rules.ResolveMemoryPolicy(10, "launcher"));
+
+                // [ProcessTree] 进程自身的规则会被保护线程持续应用
+                resolved = ResolveProcessRules(rules, tree, processes[0]);
+                CHECK(resolved.treeRule);
+                CHECK_EQUAL(DWORD(0), resolved.inheritedFrom);
+            }
+
+            void TestTreeRootGate() {
+                // 没有 [ProcessTree] 时祖先的规则不会传给后代
+                ProcessRuleSet rules;
+                rules.Load({
+                    MakeEntry("processcorebinding", "launcher", "4-5"),
+                    MakeEntry("processscheduling", "shell", "nice:5"),
+                });
+                ProcessTree tree;
+                std::vector<ProcessEntry> processes = MakeProcessChain();
+                tree.Update(processes);
+                CHECK(ResolveProcessRules(rules, tree, processes[3]).IsEmpty());
+                CHECK(!ResolveProcessRules(rules, tree, processes[0]).treeRule);
+
+                // 只把 launcher 列为根：shell 的调度规则不继承，launcher 的亲和性规则继承
+                ProcessRuleSet gated;
+                gated.Load({
+                    MakeEntry("processtree", "pids", "10"),
+                    MakeEntry("processcorebinding", "launcher", "4-5"),
+                    MakeEntry("processscheduling", "shell", "nice:5"),
+                });
+                ResolvedProcessRules resolved = ResolveProcessRules(gated, tree, processes[3]);
+                CHECK_EQUAL(DWORD(10), resolved.inheritedFrom);
+                CHECK(resolved.scheduling == nullptr);
+            }
+
+            void TestTreeReusedParentPid() {
+                ProcessRuleSet rules;
+                rules.Load({
+                    MakeEntry("processtree", "processes", "launcher"),
+                    MakeEntry("processcorebinding", "launcher", "4-5"),
+                });
+
+                // PID 10 已被一个晚于子进程创建的 launcher 复用，父子关系不再成立
+                ProcessTree tree;
+                ProcessEntry orphan = MakeProcess(40, 10, 400, "app");
+                tree.Update({ MakeProcess(10, 1, 900, "launcher"), orphan });
+                CHECK(ResolveProcessRules(rules, tree, orphan).IsEmpty());
+                size_t visited = 0;
+                CHECK(!tree.VisitAncestors(orphan, [&visited](const ProcessEntry&) { visited++; return false; }));
+                CHECK_EQUAL(size_t(0), visited);
+                CHECK(tree.GetDescendants(10).empty());
+
+                // 链中间断开时，更远的祖先同样不可见
+                std::vector<ProcessEntry> processes = MakeProcessChain();
+                processes[2].startTime = 450;
+                tree.Update(processes);
+                CHECK(ResolveProcessRules(rules, tree, processes[3]).IsEmpty());
+                CHECK_EQUAL(size_t(3), tree.GetDescendants(10).size());
+
+                // 创建时间未知时只能信任 PID
+                processes[2].startTime = 0;
+                tree.Update(processes);
+                CHECK_EQUAL(DWORD(10), ResolveProcessRules(rules, tree, processes[3]).inheritedFrom);
+            }
+
+            void TestTreeUpdateRemovesVanished() {
+                ProcessTree tree;
+                tree.Update(MakeProcessChain());
+                CHECK_EQUAL(size_t(5), tree.Size());
+                CHECK_EQUAL(size_t(4), tree.GetDescendants(10).size());
+
+                // worker(50) 退出后从父进程的子进程列表中移除
+                std::vector<ProcessEntry> processes = MakeProcessChain();
+                processes.pop_back();
+                tree.Update(processes);
+                CHECK_EQUAL(size_t(4), tree.Size());
+                ProcessEntry found;
+                CHECK(!tree.Find(50, found));
+                CHECK_EQUAL(size_t(2), tree.GetDescendants(20).size());
+
+                // PID 50 被 launcher 之下的新进程复用，不能再出现在 shell 的后代中
+                processes.push_back(MakeProcess(50, 10, 600, "worker"));
+                tree.Update(processes);
+                std::vector<DWORD> descendants = tree.GetDescendants(20);
+                CHECK_EQUAL(size_t(2), descendants.size());
+                CHECK(std::find(descendants.begin(), descendants.end(), DWORD(50)) == descendants.end());
+                CHECK_EQUAL(size_t(4), tree.GetDescendants(10).size());
+            }
+
+            // =========================================================================
+            // ReservationController
+            // =========================================================================
+
+            ReservationPressure MakePressure(double utilization, double pressure) {
+                ReservationPressure sample;
+                sample.utilization = utilization;
+                sample.pressure = pressure;
+                return sample;
+            }
+
+            ReservationControllerOptions MakeControllerOptions() {
+                ReservationControllerOptions options;
+                options.minCores = 1;
+                options.maxCores = 3;
+                options.growAfter = 3;
+                options.shrinkAfter = 5;
+                options.cooldown = std::chrono::milliseconds(10000);
+                return options;
+            }
+
+            void TestControllerGrowHysteresis() {
+                ReservationController controller(MakeControllerOptions());
+                auto now = std::chrono::steady_clock::now();
+                const auto step = std::chrono::seconds(1);
+
+                // 过载需要连续 growAfter 个周期，中间一个正常周期清零计数
+                CHECK(controller.Evaluate(MakePressure(95, 0), 1, now) == ReservationAdjustment::None);
+                CHECK(controller.Evaluate(MakePressure(95, 0), 1, now += step) == ReservationAdjustment::None);
+                CHECK(controller.Evaluate(MakePressure(60, 0), 1, now += step) == ReservationAdjustment::None);
+                CHECK(controller.Evaluate(MakePressure(95, 0), 1, now += step) == ReservationAdjustment::None);
+                CHECK(controller.Evaluate(MakePressure(95, 0), 1, now += step) == ReservationAdjustment::None);
+                // 只有等待超过阈值同样计为过载
+                CHECK(controller.Evaluate(MakePressure(50, 20), 1, now += step) == ReservationAdjustment::Grow);
+
+                // 冷却期间继续计数但不调整，冷却结束后立即按计数调整
+                for (int i = 0; i < 5; i++) {
+                    CHECK(controller.Evaluate(MakePressure(95, 0), 2, now += step) == ReservationAdjustment::None);
+                }
+                CHECK(controller.Evaluate(MakePressure(95, 0), 2, now += std::chrono::seconds(5)) == ReservationAdjustment::Grow);
+
+                // 已达到 maxCores 时不再扩大
+                now += std::chrono::seconds(20);
+                for (int i = 0; i < 5; i++) {
+                    CHECK(controller.Evaluate(MakePressure(95, 50), 3, now += step) == ReservationAdjustment::None);
+                }
+            }
+
+            void TestControllerShrinkHysteresis() {
+                ReservationController controller(MakeControllerOptions());
+                auto now = std::chrono::steady_clock::now();
+                const auto step = std::chrono::seconds(1);
+
+                // 空闲要求使用率与等待都低于阈值；介于两组阈值之间的周期既不扩大也不缩小
+                for (int i = 0; i < 4; i++) {
+                    CHECK(controller.Evaluate(MakePressure(10, 0.5), 2, now += step) == ReservationAdjustment::None);
+                }
+                CHECK(controller.Evaluate(MakePressure(10, 5), 2, now += step) == ReservationAdjustment::None);
+                for (int i = 0; i < 4; i++) {
+                    CHECK(controller.Evaluate(MakePressure(10, -1), 2, now += step) == ReservationAdjustment::None);
+                }
+                // 缺少的信号（-1）不参与判断
+                CHECK(controller.Evaluate(MakePressure(-1, 0), 2, now += step) == ReservationAdjustment::Shrink);
+
+                // 已达到 minCores 时不再缩小；没有任何信号的周期不改变计数
+                now += std::chrono::seconds(20);
+                for (int i = 0; i < 10; i++) {
+                    CHECK(controller.Evaluate(MakePressure(0, 0), 1, now += step) == ReservationAdjustment::None);
+                }
+                CHECK(controller.Evaluate(MakePressure(-1, -1), 2, now += step) == ReservationAdjustment::Shrink);
+            }
+
+            void TestControllerRange() {
+                ReservationController controller(MakeControllerOptions());
+                auto now = std::chrono::steady_clock::now();
+
+                // 超出范围时不等待计数，但同样受冷却时间限制
+                CHECK(controller.Evaluate(ReservationPressure(), 0, now) == ReservationAdjustment::Grow);
+                CHECK(controller.Evaluate(ReservationPressure(), 5, now + std::chrono::seconds(1)) == ReservationAdjustment::None);
+                CHECK(controller.Evaluate(ReservationPressure(), 5, now + std::chrono::seconds(10)) == ReservationAdjustment::Shrink);
+
+                // Reset 清除冷却时间
+                controller.Reset();
+                CHECK(controller.Evaluate(ReservationPressure(), 0, now + std::chrono::seconds(11)) == ReservationAdjustment::Grow);
+            }
+
+            // =========================================================================
+            // TimeSeriesStore
+            // =========================================================================
+
+            // 每个用例使用独立的临时目录，结束时删除
+            class TemporaryDirectory {
+            public:
+                explicit TemporaryDirectory(const char* name)
+                    : m_path(std::filesystem::temp_directory_path() /
+                        (std::string("cpucore-tests-") + name + "-" + std::to_string(TimeSeriesStore::Now())))
+                {
+                    std::error_code error;
+                    std::filesystem::remove_all(m_path, error);
+                }
+
+                ~TemporaryDirectory() {
+                    std::error_code error;
+                    std::filesystem::remove_all(m_path, error);
+                }
+
+                std::string Path() const { return m_path.string(); }
+
+            private:
+                std::filesystem::path m_path;
+            };
+
+            uint64_t DoubleBits(double value) {
+                uint64_t bits = 0;
+                memcpy(&bits, &value, sizeof(bits));
+                return bits;
+            }
+
+            TimeSeriesPoint MakePoint(int64_t time, double value) {
+                TimeSeriesPoint point;
+                point.time = time;
+                point.value = value;
+                point.raw = DoubleBits(value);
+                return point;
+            }
+
+            void TestTimeSeriesRoundTrip() {
+                TemporaryDirectory directory("roundtrip");
+                TimeSeriesStoreOptions options;
+                options.chunksPerSegment = 4;   // 小段，数据跨越多个块与段
+
+                // 时间覆盖相等、规整、抖动与大跨度的间隔，二阶差分落在每个编码区间；
+                // 值覆盖不变、符号变化、NaN、无穷、非规格化数与随机位模式
+                const double specials[] = {
+                    0.0, -0.0, 1.0, -1.0, 0.1, 1e300, -1e-300, 4.9e-324,
+                    std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                    std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::max()
+                };
+                const int64_t gaps[] = { 1000, 1000, 0, 1, 1003, 997, 64, 300, 5000, 70000, 1000, 600000, 1000, 1 };
+                std::mt19937_64 random(7);
+                std::vector<int64_t> times;
+                std::vector<uint64_t> doubles;
+                std::vector<uint64_t> raws;
+                // 约覆盖 5 天，早于当前时间且在保留时间内
+                int64_t time = TimeSeriesStore::Now() - 7 * 24 * 3600000LL;
+                for (size_t i = 0; i < 6000; i++) {
+                    time += gaps[i % (sizeof(gaps) / sizeof(gaps[0]))];
+                    times.push_back(time);
+                    doubles.push_back(i % 3 == 0 ? DoubleBits(specials[(i / 3) % (sizeof(specials) / sizeof(specials[0]))])
+                        : i % 3 == 1 ? DoubleBits(50.0 + static_cast<double>(i % 7)) : random());
+                    raws.push_back(i % 5 == 0 ? std::numeric_limits<uint64_t>::max() : i % 5 == 1 ? 0 : random());
+                }
+
+                {
+                    TimeSeriesStore writer;
+                    CHECK(writer.Open(directory.Path(), false, options));
+                    bool appended = true;
+                    for (size_t i = 0; i < times.size(); i++) {
+                        double value = 0.0;
+                        memcpy(&value, &doubles[i], sizeof(value));
+                        appended = writer.Append("test.double", times[i], value) && appended;
+                        appended = writer.AppendRaw("test.raw", times[i], raws[i]) && appended;
+                    }
+                    CHECK(appended);
+                    // 时间倒退的点被拒绝
+                    CHECK(!writer.Append("test.double", times.back() - 1, 1.0));
+                }
+
+                // 在另一个实例中只读打开，按位比较
+                TimeSeriesStore reader;
+                CHECK(reader.Open(directory.Path(), true, options));
+                std::vector<TimeSeriesPoint> points;
+                CHECK(reader.Query("test.double", times.front(), times.back() + 1, points));
+                CHECK_EQUAL(times.size(), points.size());
+                size_t mismatched = 0;
+                for (size_t i = 0; i < points.size() && i < times.size(); i++) {
+                    if (points[i].time != times[i] || points[i].raw != doubles[i]) {
+                        mismatched++;
+                    }
+                }
+                CHECK_EQUAL(size_t(0), mismatched);
+
+                CHECK(reader.Query("test.raw", times.front(), times.back() + 1, points));
+                CHECK_EQUAL(times.size(), points.size());
+                mismatched = 0;
+                for (size_t i = 0; i < points.size() && i < times.size(); i++) {
+                    if (points[i].time != times[i] || points[i].raw != raws[i]) {
+                        mismatched++;
+                    }
+                }
+                CHECK_EQUAL(size_t(0), mismatched);
+
+                // 查询区间为 [from, to)
+                CHECK(reader.Query("test.raw", times[100], times[200], points));
+                CHECK(!points.empty() && points.front().time == times[100] && points.back().time < times[200]);
+                CHECK(reader.Query("missing", times.front(), times.back(), points));
+                CHECK(points.empty());
+
+                std::vector<std::string> series = reader.ListSeries("test.");
+                CHECK(series.size() == 2 && series[0] == "test.double" && series[1] == "test.raw");
+            }
+
+            void TestTimeSeriesSingleWriter() {
+                TemporaryDirectory directory("writer");
+                TimeSeriesStore first;
+                TimeSeriesStore second;
+                TimeSeriesStore reader;
+                CHECK(first.Open(directory.Path(), false));
+                CHECK(!second.Open(directory.Path(), false));
+                CHECK(reader.Open(directory.Path(), true));
+
+                // 第一个写入方关闭后锁被释放，序列编号从序列表继续
+                CHECK(first.Append("a", TimeSeriesStore::Now(), 1.0));
+                first.Close();
+                CHECK(second.Open(directory.Path(), false));
+                CHECK(second.Append("b", TimeSeriesStore::Now(), 2.0));
+                std::vector<std::string> series = second.ListSeries();
+                CHECK(series.size() == 2 && series[0] == "a" && series[1] == "b");
+            }
+
+            void TestDownsampleTimeSeries() {
+                std::vector<TimeSeriesPoint> points = {
+                    MakePoint(-5, 7.0),         // from 之前的点按向下取整落入前一个桶
+                    MakePoint(0, 1.0), MakePoint(3, 5.0), MakePoint(9, 3.0),
+                    MakePoint(25, 2.0), MakePoint(29, 8.0),
+                };
+                std::vector<TimeSeriesPoint> result;
+
+                DownsampleTimeSeries(points, 0, 10, TimeSeriesAggregation::Average, result);
+                CHECK_EQUAL(size_t(3), result.size());
+                if (result.size() == 3) {
+                    // 空桶 [10, 20) 不输出；平均值没有原始值
+                    CHECK_EQUAL(int64_t(-10), result[0].time);
+                    CHECK_EQUAL(int64_t(0), result[1].time);
+                    CHECK_EQUAL(int64_t(20), result[2].time);
+                    CHECK_EQUAL(3.0, result[1].value);
+                    CHECK_EQUAL(uint64_t(0), result[1].raw);
+                    CHECK_EQUAL(5.0, result[2].value);
+                }
+
+                DownsampleTimeSeries(points, 0, 10, TimeSeriesAggregation::Min, result);
+                CHECK(result.size() == 3 && result[1].value == 1.0 && result[1].raw == DoubleBits(1.0));
+                DownsampleTimeSeries(points, 0, 10, TimeSeriesAggregation::Max, result);
+                CHECK(result.size() == 3 && result[1].value == 5.0 && result[2].value == 8.0);
+                DownsampleTimeSeries(points, 0, 10, TimeSeriesAggregation::Last, result);
+                CHECK(result.size() == 3 && result[1].value == 3.0 && result[2].raw == DoubleBits(8.0));
+
+                // 桶按 from 对齐
+                DownsampleTimeSeries(points, 5, 10, TimeSeriesAggregation::Last, result);
+                CHECK(result.size() == 3 && result[0].time == -5 && result[1].time == 5 && result[2].time == 25);
+                CHECK(result.size() == 3 && result[0].value == 5.0 && result[1].value == 3.0);
+
+                // step 不大于 0 时返回原始点
+                DownsampleTimeSeries(points, 0, 0, TimeSeriesAggregation::Average, result);
+                CHECK_EQUAL(points.size(), result.size());
+            }
+
+#ifndef _WIN32
+            // =========================================================================
+            // CpuCoreManager 的 cgroup 保留
+            // =========================================================================
+
+            void WriteTextFile(const std::filesystem::path& path, const std::string& text) {
+                std::ofstream file(path);
+                file << text;
+            }
+
+            std::string ReadTextFile(const std::filesystem::path& path) {
+                std::ifstream file(path);
+                std::string text;
+                std::getline(file, text);
+                return text;
+            }
+
+            // 普通目录中的模拟 cgroup v2 挂载点：mkdir 不会生成接口文件，预先创建两个组及其接口文件
+            void CreateCgroupRoot(const std::filesystem::path& root) {
+                std::filesystem::create_directories(root);
+                WriteTextFile(root / "cgroup.controllers", "cpuset cpu memory\n");
+                WriteTextFile(root / "cgroup.subtree_control", "cpuset\n");
+                WriteTextFile(root / "cgroup.procs", "");
+                for (const char* group : { "cpucore.reserved", "cpucore.general" }) {
+                    std::filesystem::create_directories(root / group);
+                    WriteTextFile(root / group / "cpuset.cpus", "");
+                    WriteTextFile(root / group / "cpuset.cpus.partition", "member\n");
+                    WriteTextFile(root / group / "cgroup.procs", "");
+                }
+            }
+
+            void TestCgroupReloadReservedCores() {
+                TemporaryDirectory directory("cgroup");
+                std::filesystem::path root = directory.Path();
+                CreateCgroupRoot(root);
+
+                SimulatedSystemOptions system;
+                system.processCount = 20;
+                system.coreCount = 8;
+                CpuCoreManager manager(std::make_unique<SimulatedProcessBackend>(system));
+                manager.SetActionConsoleOutput(false);
+                CHECK(manager.SetCgroupRoot(root.string()));
+                CHECK(manager.SetReservationMode(ReservationMode::Cgroup));
+
+                manager.StartMultiCoreProtection({ 6, 7 });
+                CHECK_EQUAL(std::string("6-7"), ReadTextFile(root / "cpucore.reserved" / "cpuset.cpus"));
+                CHECK_EQUAL(std::string("0-5"), ReadTextFile(root / "cpucore.general" / "cpuset.cpus"));
+                CHECK_EQUAL(std::string("isolated"), ReadTextFile(root / "cpucore.reserved" / "cpuset.cpus.partition"));
+                // 保留生效期间不能更换挂载点
+                CHECK(!manager.SetCgroupRoot("/sys/fs/cgroup"));
+
+                // 重新加载的保留核心与 UpdateReservedCores 一样同步到保留组
+                std::filesystem::path iniPath = root / "reload.ini";
+                WriteTextFile(iniPath, "[Protection]\nReservedCores=4-5\n");
+                CHECK(manager.LoadConfigFile(iniPath.string()));
+                CHECK(manager.GetProtectedCores() == std::vector<DWORD>({ 4, 5 }));
+                CHECK_EQUAL(std::string("4-5"), ReadTextFile(root / "cpucore.reserved" / "cpuset.cpus"));
+                CHECK_EQUAL(std::string("0-3,6-7"), ReadTextFile(root / "cpucore.general" / "cpuset.cpus"));
+                CHECK_EQUAL(std::string("isolated"), ReadTextFile(root / "cpucore.reserved" / "cpuset.cpus.partition"));
+
+                // 保留核心不变时不重写保留组
+                WriteTextFile(root / "cpucore.reserved" / "cpuset.cpus", "unchanged");
+                CHECK(manager.LoadConfigFile(iniPath.string()));
+                CHECK_EQUAL(std::string("unchanged"), ReadTextFile(root / "cpucore.reserved" / "cpuset.cpus"));
+
+                manager.StopCoreProtection();
+                CHECK_EQUAL(std::string("member"), ReadTextFile(root / "cpucore.reserved" / "cpuset.cpus.partition"));
+            }
+
+            void TestCgroupHeldReservation() {
+                TemporaryDirectory directory("cgroup-held");
+                std::filesystem::path root = directory.Path();
+                CreateCgroupRoot(root);
+                std::filesystem::path reservedProcs = root / "cpucore.reserved" / "cgroup.procs";
+                std::filesystem::path partition = root / "cpucore.reserved" / "cpuset.cpus.partition";
+
+                SimulatedSystemOptions system;
+                system.processCount = 20;
+                system.coreCount = 8;
+                auto backendOwner = std::make_unique<SimulatedProcessBackend>(system);
+                std::string currentPid = std::to_string(backendOwner->GetCurrentPid());
+                CpuCoreManager manager(std::move(backendOwner));
+                manager.SetActionConsoleOutput(false);
+                manager.SetScanIntervalLimits(10, 20);
+                CHECK(manager.SetCgroupRoot(root.string()));
+                CHECK(manager.SetReservationMode(ReservationMode::Cgroup));
+
+                CHECK(manager.ReserveCoreForCurrentProcess(7));
+                CHECK_EQUAL(currentPid, ReadTextFile(reservedProcs));
+
+                // 以相同核心启动保护沿用保留组，当前进程仍在其中
+                WriteTextFile(reservedProcs, "");
+                manager.StartCoreProtection(7);
+                CHECK_EQUAL(std::string("isolated"), ReadTextFile(partition));
+                CHECK_EQUAL(std::string(""), ReadTextFile(reservedProcs));
+
+                // 分区在运行中失效：保护线程下一轮全量扫描撤销保留组
+                WriteTextFile(partition, "isolated invalid (Cpu list in cpuset.cpus not exclusive)\n");
+                bool released = false;
+                for (int i = 0; i < 100 && !released; i++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    released = ReadTextFile(partition) == "member";
+                }
+                CHECK(released);
+
+                // 切回 cgroup 方式时重建保留组，当前进程再次移入
+                WriteTextFile(partition, "member\n");
+                WriteTextFile(reservedProcs, "");
+                CHECK(manager.SetReservationMode(ReservationMode::Cgroup));
+                CHECK_EQUAL(std::string("isolated"), ReadTextFile(partition));
+                CHECK_EQUAL(currentPid, ReadTextFile(reservedProcs));
+
+                manager.StopCoreProtection();
+            }
+#endif
+
+            struct TestCase {
+                const char* name;
+                void (*function)();
+            };
+
+            const TestCase TEST_CASES[] = {
+                { "CpuSet.Parse", TestCpuSetParse },
+                { "CpuSet.Format", TestCpuSetFormat },
+                { "CpuSet.Words", TestCpuSetWords },
+                { "CpuSet.Iteration", TestCpuSetIteration },
+                { "CpuSet.Operators", TestCpuSetOperators },
+                { "ProcessRules.NamePrecedence", TestRuleNamePrecedence },
+                { "ProcessRules.KindPrecedence", TestRuleKindPrecedence },
+                { "ProcessRules.InvalidEntries", TestRuleInvalidEntries },
+                { "ProcessTree.Inheritance", TestTreeRuleInheritance },
+                { "ProcessTree.RootGate", TestTreeRootGate },
+                { "ProcessTree.ReusedParentPid", TestTreeReusedParentPid },
+                { "ProcessTree.UpdateRemovesVanished", TestTreeUpdateRemovesVanished },
+                { "ReservationController.Grow", TestControllerGrowHysteresis },
+                { "ReservationController.Shrink", TestControllerShrinkHysteresis },
+                { "ReservationController.Range", TestControllerRange },
+                { "TimeSeriesStore.RoundTrip", TestTimeSeriesRoundTrip },
+                { "TimeSeriesStore.SingleWriter", TestTimeSeriesSingleWriter },
+                { "TimeSeriesStore.Downsample", TestDownsampleTimeSeries },
+#ifndef _WIN32
+                { "CgroupReservation.ReloadReservedCores", TestCgroupReloadReservedCores },
+                { "CgroupReservation.HeldReservation", TestCgroupHeldReservation },
+#endif
+            };
+        }
+
+        int RunTests(int argc, char* argv[]) {
+            const char* filter = argc > 1 ? argv[1] : nullptr;
+            int run = 0;
+            int failed = 0;
+            for (const TestCase& test : TEST_CASES) {
+                if (filter != nullptr && strstr(test.name, filter) == nullptr) {
+                    continue;
+                }
+
+                int failuresBefore = g_failures;
+                std::cout << test.name << std::endl;
+                test.function();
+                run++;
+                if (g_failures != failuresBefore) {
+                    failed++;
+                }
+            }
+
+            std::cout << "用例 " << run << " 个，检查 " << g_checks << " 项，失败用例 " << failed << " 个" << std::endl;
+            return g_failures == 0 && run > 0 ? 0 : 1;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return SamsunIoCardC::CpuManager::RunTests(argc, argv);
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+
+// =============================================================================
+// 平台相关头文件与 Win32 类型兼容定义
+// Windows 下直接使用 SDK 类型；Linux 下提供同名别名，使公共接口在两个平台上保持一致
+// =============================================================================
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <tlhelp32.h>
+
+#else
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+typedef uint32_t DWORD;
+typedef uintptr_t DWORD_PTR;
+typedef int BOOL;
+typedef char TCHAR;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+// 优先级类别：取值与 Windows 一致，Linux 后端映射为 nice 值
+#define IDLE_PRIORITY_CLASS          0x00000040
+#define BELOW_NORMAL_PRIORITY_CLASS  0x00004000
+#define NORMAL_PRIORITY_CLASS        0x00000020
+#define ABOVE_NORMAL_PRIORITY_CLASS  0x00008000
+#define HIGH_PRIORITY_CLASS          0x00000080
+#define REALTIME_PRIORITY_CLASS      0x00000100
+
+#define SE_DEBUG_NAME "SeDebugPrivilege"
+
+// 与 Win32 同名，返回最近一次系统调用的 errno，便于沿用现有错误输出
+inline DWORD GetLastError() {
+    return static_cast<DWORD>(errno);
+}
+
+#endif
@@ -0,0 +1,302 @@
+﻿#include "pch.h"
+#include "CpuSet.h"
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const size_t BITS_PER_WORD = 64;
+            // 解析时允许的最大 CPU 编号（Linux NR_CPUS 上限），防止错误输入导致超大分配
+            const unsigned long MAX_PARSED_CPU = 8192;
+
+            size_t PopCount(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+                return static_cast<size_t>(__popcnt64(value));
+#elif defined(__GNUC__) || defined(__clang__)
+                return static_cast<size_t>(__builtin_popcountll(value));
+#else
+                size_t count = 0;
+                for (; value != 0; value &= value - 1) {
+                    count++;
+                }
+                return count;
+#endif
+            }
+
+            // value 不能为 0
+            size_t LowestBit(uint64_t value) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+                unsigned long index;
+                _BitScanForward64(&index, value);
+                return index;
+#elif defined(__GNUC__) || defined(__clang__)
+                return static_cast<size_t>(__builtin_ctzll(value));
+#else
+                size_t index = 0;
+                while ((value & 1) == 0) {
+                    value >>= 1;
+                    index++;
+                }
+                return index;
+#endif
+            }
+
+            // value 不能为 0
+            size_t HighestBit(uint64_t value) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+                unsigned long index;
+                _BitScanReverse64(&index, value);
+                return index;
+#elif defined(__GNUC__) || defined(__clang__)
+                return BITS_PER_WORD - 1 - static_cast<size_t>(__builtin_clzll(value));
+#else
+                size_t index = 0;
+                while (value >>= 1) {
+                    index++;
+                }
+                return index;
+#endif
+            }
+        }
+
+        CpuSet CpuSet::FromMask(uint64_t mask, size_t firstCpu) {
+            CpuSet result;
+            for (; mask != 0; mask &= mask - 1) {
+                result.Set(firstCpu + LowestBit(mask));
+            }
+            return result;
+        }
+
+        CpuSet CpuSet::Range(size_t first, size_t count) {
+            CpuSet result;
+            if (count == 0) {
+                return result;
+            }
+
+            size_t last = first + count - 1;
+            result.m_words.assign(last / BITS_PER_WORD + 1, 0);
+            for (size_t word = first / BITS_PER_WORD; word <= last / BITS_PER_WORD; word++) {
+                size_t low = word == first / BITS_PER_WORD ? first % BITS_PER_WORD : 0;
+                size_t high = word == last / BITS_PER_WORD ? last % BITS_PER_WORD : BITS_PER_WORD - 1;
+                uint64_t highMask = high == BITS_PER_WORD - 1 ? ~0ULL : ((1ULL << (high + 1)) - 1);
+                result.m_words[word] = highMask & ~((1ULL << low) - 1);
+            }
+            return result;
+        }
+
+        CpuSet CpuSet::Single(size_t cpu) {
+            CpuSet result;
+            result.Set(cpu);
+            return result;
+        }
+
+        bool CpuSet::Parse(const std::string& text, CpuSet& result) {
+            result.Clear();
+
+            const char* p = text.c_str();
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+
+            while (*p != '\0' && *p != '\n' && *p != '\r') {
+                char* end = nullptr;
+                unsigned long first = strtoul(p, &end, 10);
+                if (end == p) {
+                    return false;
+                }
+
+                unsigned long last = first;
+                p = end;
+                if (*p == '-') {
+                    last = strtoul(p + 1, &end, 10);
+                    if (end == p + 1 || last < first) {
+                        return false;
+                    }
+                    p = end;
+                }
+                if (last >= MAX_PARSED_CPU) {
+                    return false;
+                }
+
+                CpuSet range = Range(first, last - first + 1);
+                result |= range;
+
+                while (*p == ' ' || *p == '\t') {
+                    p++;
+                }
+                if (*p == ',') {
+                    p++;
+                }
+                else if (*p != '\0' && *p != '\n' && *p != '\r') {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void CpuSet::Set(size_t cpu) {
+            size_t word = cpu / BITS_PER_WORD;
+            if (word >= m_words.size()) {
+                m_words.resize(word + 1, 0);
+            }
+            m_words[word] |= 1ULL << (cpu % BITS_PER_WORD);
+        }
+
+        void CpuSet::Reset(size_t cpu) {
+            size_t word = cpu / BITS_PER_WORD;
+            if (word < m_words.size()) {
+                m_words[word] &= ~(1ULL << (cpu % BITS_PER_WORD));
+                Trim();
+            }
+        }
+
+        bool CpuSet::Test(size_t cpu) const {
+            size_t word = cpu / BITS_PER_WORD;
+            return word < m_words.size() && (m_words[word] & (1ULL << (cpu % BITS_PER_WORD))) != 0;
+        }
+
+        size_t CpuSet::Count() const {
+            size_t count = 0;
+            for (uint64_t word : m_words) {
+                count += PopCount(word);
+            }
+            return count;
+        }
+
+        size_t CpuSet::First() const {
+            for (size_t word = 0; word < m_words.size(); word++) {
+                if (m_words[word] != 0) {
+                    return word * BITS_PER_WORD + LowestBit(m_words[word]);
+                }
+            }
+            return npos;
+        }
+
+        size_t CpuSet::Last() const {
+            // Trim 保证最后一个字非零
+            if (m_words.empty()) {
+                return npos;
+            }
+            return (m_words.size() - 1) * BITS_PER_WORD + HighestBit(m_words.back());
+        }
+
+        size_t CpuSet::Next(size_t cpu) const {
+            if (cpu == npos) {
+                return npos;
+            }
+
+            size_t start = cpu + 1;
+            size_t word = start / BITS_PER_WORD;
+            if (word >= m_words.size()) {
+                return npos;
+            }
+
+            uint64_t bits = m_words[word] & (~0ULL << (start % BITS_PER_WORD));
+            while (bits == 0) {
+                if (++word >= m_words.size()) {
+                    return npos;
+                }
+                bits = m_words[word];
+            }
+            return word * BITS_PER_WORD + LowestBit(bits);
+        }
+
+        uint64_t CpuSet::ExtractMask(size_t firstCpu) const {
+            size_t word = firstCpu / BITS_PER_WORD;
+            size_t shift = firstCpu % BITS_PER_WORD;
+            if (shift == 0) {
+                return Word(word);
+            }
+            return (Word(word) >> shift) | (Word(word + 1) << (BITS_PER_WORD - shift));
+        }
+
+        bool CpuSet::Intersects(const CpuSet& other) const {
+            size_t common = std::min(m_words.size(), other.m_words.size());
+            for (size_t word = 0; word < common; word++) {
+                if ((m_words[word] & other.m_words[word]) != 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool CpuSet::IsSubsetOf(const CpuSet& other) const {
+            for (size_t word = 0; word < m_words.size(); word++) {
+                if ((m_words[word] & ~other.Word(word)) != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        CpuSet& CpuSet::operator|=(const CpuSet& other) {
+            if (other.m_words.size() > m_words.size()) {
+                m_words.resize(other.m_words.size(), 0);
+            }
+            for (size_t word = 0; word < other.m_words.size(); word++) {
+                m_words[word] |= other.m_words[word];
+            }
+            return *this;
+        }
+
+        CpuSet& CpuSet::operator&=(const CpuSet& other) {
+            if (m_words.size() > other.m_words.size()) {
+                m_words.resize(other.m_words.size());
+            }
+            for (size_t word = 0; word < m_words.size(); word++) {
+                m_words[word] &= other.m_words[word];
+            }
+            Trim();
+            return *this;
+        }
+
+        CpuSet& CpuSet::AndNot(const CpuSet& other) {
+            size_t common = std::min(m_words.size(), other.m_words.size());
+            for (size_t word = 0; word < common; word++) {
+                m_words[word] &= ~other.m_words[word];
+            }
+            Trim();
+            return *this;
+        }
+
+        std::string CpuSet::ToString() const {
+            if (Empty()) {
+                return "(空)";
+            }
+
+            std::string result;
+            size_t cpu = First();
+            while (cpu != npos) {
+                size_t last = cpu;
+                size_t next = Next(cpu);
+                while (next != npos && next == last + 1) {
+                    last = next;
+                    next = Next(next);
+                }
+
+                if (!result.empty()) {
+                    result += ',';
+                }
+                result += std::to_string(cpu);
+                if (last != cpu) {
+                    result += '-';
+                    result += std::to_string(last);
+                }
+                cpu = next;
+            }
+            return result;
+        }
+
+        void CpuSet::Trim() {
+            while (!m_words.empty() && m_words.back() == 0) {
+                m_words.pop_back();
+            }
+        }
+    }
+}
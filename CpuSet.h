@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // CpuSet：任意宽度的逻辑处理器集合，替代 64 位 DWORD_PTR 掩码
+        //
+        // CPU 编号为全局逻辑处理器编号：Linux 下即内核 CPU 编号；
+        // Windows 下按处理器组顺序连续编号（组 0 的处理器在前，依次类推）。
+        // 内部按 64 位字存储并去掉末尾的全零字，相等比较可直接比较字数组。
+        // =============================================================================
+
+        class CpuSet {
+        public:
+            static const size_t npos = static_cast<size_t>(-1);
+
+            CpuSet() = default;
+
+            // 由 64 位掩码构造，firstCpu 为第 0 位对应的 CPU 编号
+            static CpuSet FromMask(uint64_t mask, size_t firstCpu = 0);
+            // 编号 [first, first + count) 的连续集合
+            static CpuSet Range(size_t first, size_t count);
+            static CpuSet Single(size_t cpu);
+            // 解析 "0-3,8,10-11" 格式的 CPU 列表，格式错误时返回 false
+            static bool Parse(const std::string& text, CpuSet& result);
+
+            void Set(size_t cpu);
+            void Reset(size_t cpu);
+            bool Test(size_t cpu) const;
+            void Clear() { m_words.clear(); }
+
+            bool Empty() const { return m_words.empty(); }
+            // 集合中的 CPU 数量
+            size_t Count() const;
+            // 最小/最大 CPU 编号，空集合返回 npos
+            size_t First() const;
+            size_t Last() const;
+            // 大于 cpu 的下一个 CPU 编号，不存在时返回 npos
+            // 遍历: for (size_t cpu = set.First(); cpu != CpuSet::npos; cpu = set.Next(cpu))
+            size_t Next(size_t cpu) const;
+
+            // 第 index 个 64 位字（CPU index*64 ~ index*64+63），超出范围返回 0
+            uint64_t Word(size_t index) const { return index < m_words.size() ? m_words[index] : 0; }
+            size_t WordCount() const { return m_words.size(); }
+            // 取 CPU firstCpu ~ firstCpu+63 组成的 64 位掩码（用于 Windows 处理器组）
+            uint64_t ExtractMask(size_t firstCpu) const;
+
+            bool Intersects(const CpuSet& other) const;
+            bool IsSubsetOf(const CpuSet& other) const;
+
+            CpuSet& operator|=(const CpuSet& other);
+            CpuSet& operator&=(const CpuSet& other);
+            // 从集合中移除 other 中的 CPU
+            CpuSet& AndNot(const CpuSet& other);
+
+            friend CpuSet operator|(CpuSet left, const CpuSet& right) { return left |= right; }
+            friend CpuSet operator&(CpuSet left, const CpuSet& right) { return left &= right; }
+            bool operator==(const CpuSet& other) const { return m_words == other.m_words; }
+            bool operator!=(const CpuSet& other) const { return m_words != other.m_words; }
+
+            // 输出 "0-3,8" 格式，空集合输出 "(空)"
+            std::string ToString() const;
+
+        private:
+            void Trim();
+
+            std::vector<uint64_t> m_words;
+        };
+    }
+}
@@ -0,0 +1,217 @@
+﻿#include "pch.h"
+#include "CpuTopology.h"
+#include <algorithm>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+
+            // 某个域内可用的物理核心
+            struct DomainCandidate {
+                int index = -1;
+                bool containsCpu0 = false;
+                std::vector<const CpuSet*> cores;   // 按编号从高到低
+            };
+
+            bool IsHigherCore(const CpuSet* left, const CpuSet* right) {
+                return left->First() > right->First();
+            }
+
+            std::vector<DomainCandidate> GroupByDomain(const std::vector<CpuSet>& domains, const std::vector<const CpuSet*>& cores) {
+                std::vector<DomainCandidate> candidates(domains.size());
+                for (size_t i = 0; i < domains.size(); i++) {
+                    candidates[i].index = static_cast<int>(i);
+                    candidates[i].containsCpu0 = domains[i].Test(0);
+                }
+
+                for (const CpuSet* core : cores) {
+                    int domain = CpuTopology::FindDomain(domains, core->First());
+                    if (domain >= 0 && core->IsSubsetOf(domains[domain])) {
+                        candidates[domain].cores.push_back(core);
+                    }
+                }
+                return candidates;
+            }
+
+            // 选择能容纳 desiredCores 个核心的域：避开 CPU 0（系统中断与常驻服务），
+            // 其次选最小可容纳的域，把大域留给其他保留，最后选高编号
+            const DomainCandidate* ChooseDomain(const std::vector<DomainCandidate>& candidates, size_t desiredCores) {
+                const DomainCandidate* best = nullptr;
+                for (const DomainCandidate& candidate : candidates) {
+                    if (candidate.cores.size() < desiredCores) {
+                        continue;
+                    }
+                    if (best == nullptr) {
+                        best = &candidate;
+                        continue;
+                    }
+
+                    if (candidate.containsCpu0 != best->containsCpu0) {
+                        if (!candidate.containsCpu0) {
+                            best = &candidate;
+                        }
+                    }
+                    else if (candidate.cores.size() != best->cores.size()) {
+                        if (candidate.cores.size() < best->cores.size()) {
+                            best = &candidate;
+                        }
+                    }
+                    else if (candidate.cores.front()->First() > best->cores.front()->First()) {
+                        best = &candidate;
+                    }
+                }
+                return best;
+            }
+
+            // 按可用核心数从多到少依次填充各域，尽量减少跨域数量；数量相同时同样避开 CPU 0、优先高编号
+            void SortFillOrder(std::vector<DomainCandidate>& candidates) {
+                std::stable_sort(candidates.begin(), candidates.end(),
+                    [](const DomainCandidate& left, const DomainCandidate& right) {
+                        if (left.cores.size() != right.cores.size()) {
+                            return left.cores.size() > right.cores.size();
+                        }
+                        if (left.containsCpu0 != right.containsCpu0) {
+                            return !left.containsCpu0;
+                        }
+                        return !left.cores.empty() && left.cores.front()->First() > right.cores.front()->First();
+                    });
+            }
+
+            // cpus 全部位于同一个域时返回该域下标，否则返回 -1
+            int ContainingDomain(const std::vector<CpuSet>& domains, const CpuSet& cpus) {
+                int domain = CpuTopology::FindDomain(domains, cpus.First());
+                return domain >= 0 && cpus.IsSubsetOf(domains[domain]) ? domain : -1;
+            }
+        }
+
+        int CpuTopology::FindDomain(const std::vector<CpuSet>& domains, size_t cpu) {
+            for (size_t i = 0; i < domains.size(); i++) {
+                if (domains[i].Test(cpu)) {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1;
+        }
+
+        CoreReservation PlanCoreReservation(const CpuTopology& topology, DWORD desiredCores, const CpuSet& eligible) {
+            CoreReservation plan;
+            if (desiredCores == 0) {
+                return plan;
+            }
+
+            // 兄弟线程中有任何一个不可用的物理核心不参与保留，否则保留核心会与其他工作共享执行单元
+            std::vector<const CpuSet*> eligibleCores;
+            for (const CpuSet& core : topology.physicalCores) {
+                if (!core.Empty() && core.IsSubsetOf(eligible)) {
+                    eligibleCores.push_back(&core);
+                }
+            }
+            std::sort(eligibleCores.begin(), eligibleCores.end(), IsHigherCore);
+
+            auto take = [&plan, desiredCores](const std::vector<const CpuSet*>& cores) {
+                for (const CpuSet* core : cores) {
+                    if (plan.cores.size() >= desiredCores) {
+                        return;
+                    }
+                    if (!plan.cpus.Intersects(*core)) {
+                        plan.cores.push_back(*core);
+                        plan.cpus |= *core;
+                    }
+                }
+            };
+
+            std::vector<DomainCandidate> l3Candidates = GroupByDomain(topology.l3Domains, eligibleCores);
+            const DomainCandidate* l3Domain = ChooseDomain(l3Candidates, desiredCores);
+            if (l3Domain != nullptr) {
+                take(l3Domain->cores);
+            }
+            else {
+                // 单个 L3 域放不下：先尝试同一 NUMA 节点，再退回整机；均按 L3 域从大到小填充
+                std::vector<DomainCandidate> nodeCandidates = GroupByDomain(topology.numaNodes, eligibleCores);
+                const DomainCandidate* node = ChooseDomain(nodeCandidates, desiredCores);
+
+                std::vector<DomainCandidate> fillOrder = node != nullptr
+                    ? GroupByDomain(topology.l3Domains, node->cores)
+                    : l3Candidates;
+                SortFillOrder(fillOrder);
+                for (const DomainCandidate& candidate : fillOrder) {
+                    take(candidate.cores);
+                }
+                take(node != nullptr ? node->cores : eligibleCores);
+            }
+
+            if (!plan.cpus.Empty()) {
+                plan.l3Domain = ContainingDomain(topology.l3Domains, plan.cpus);
+                plan.numaNode = ContainingDomain(topology.numaNodes, plan.cpus);
+            }
+            return plan;
+        }
+
+        CpuSet PlanReservationGrowth(const CpuTopology& topology, const CpuSet& reserved, const CpuSet& eligible) {
+            const CpuSet* best = nullptr;
+            int bestRank = -1;
+            for (const CpuSet& core : topology.physicalCores) {
+                if (core.Empty() || !core.IsSubsetOf(eligible) || core.Intersects(reserved)) {
+                    continue;
+                }
+
+                int rank = 0;
+                int l3Domain = CpuTopology::FindDomain(topology.l3Domains, core.First());
+                int numaNode = CpuTopology::FindDomain(topology.numaNodes, core.First());
+                if (l3Domain >= 0 && topology.l3Domains[l3Domain].Intersects(reserved)) {
+                    rank = 2;
+                }
+                else if (numaNode >= 0 && topology.numaNodes[numaNode].Intersects(reserved)) {
+                    rank = 1;
+                }
+
+                if (best == nullptr || rank > bestRank || (rank == bestRank && core.First() > best->First())) {
+                    best = &core;
+                    bestRank = rank;
+                }
+            }
+            return best != nullptr ? *best : CpuSet();
+        }
+
+        CpuSet PlanReservationShrink(const CpuTopology& topology, const CpuSet& reserved) {
+            CpuSet best;
+            size_t bestDomainCount = 0;
+            for (const CpuSet& core : topology.physicalCores) {
+                CpuSet cpus = core & reserved;
+                if (cpus.Empty()) {
+                    continue;
+                }
+
+                int l3Domain = CpuTopology::FindDomain(topology.l3Domains, core.First());
+                size_t domainCount = l3Domain >= 0 ? (topology.l3Domains[l3Domain] & reserved).Count() : 0;
+                if (best.Empty() || domainCount < bestDomainCount ||
+                    (domainCount == bestDomainCount && cpus.First() < best.First())) {
+                    best = std::move(cpus);
+                    bestDomainCount = domainCount;
+                }
+            }
+            return best;
+        }
+
+        size_t CountReservedCores(const CpuTopology& topology, const CpuSet& reserved) {
+            size_t count = 0;
+            for (const CpuSet& core : topology.physicalCores) {
+                if (core.Intersects(reserved)) {
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        CpuSet FindNumaNodes(const CpuTopology& topology, const CpuSet& cpus) {
+            CpuSet nodes;
+            for (size_t index = 0; index < topology.numaNodes.size(); index++) {
+                if (topology.numaNodes[index].Intersects(cpus)) {
+                    nodes.Set(index < topology.numaNodeIds.size() ? topology.numaNodeIds[index] : index);
+                }
+            }
+            return nodes;
+        }
+    }
+}
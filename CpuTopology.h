@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include "CpuSet.h"
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // CPU 拓扑：SMT 兄弟线程、共享 L3 的核心组（CCX）、NUMA 节点
+        // Linux:   /sys/devices/system/cpu/cpu*/topology、cache/index*、/sys/devices/system/node
+        // Windows: GetLogicalProcessorInformationEx
+        // =============================================================================
+
+        struct CpuTopology {
+            CpuSet onlineProcessors;
+            std::vector<CpuSet> physicalCores;  // 每个物理核心包含的逻辑处理器（SMT 兄弟线程）
+            std::vector<CpuSet> l3Domains;      // 共享同一 L3 的逻辑处理器；无 L3 信息时按物理封装划分
+            std::vector<CpuSet> numaNodes;      // 各 NUMA 节点的逻辑处理器；无 NUMA 信息时为单一节点
+            std::vector<DWORD> numaNodeIds;     // 与 numaNodes 对应的系统节点编号
+
+            // 包含 cpu 的域下标，不存在时返回 -1
+            static int FindDomain(const std::vector<CpuSet>& domains, size_t cpu);
+        };
+
+        // 核心保留方案
+        struct CoreReservation {
+            std::vector<CpuSet> cores;  // 选中的物理核心
+            CpuSet cpus;                // 需要保留的全部逻辑处理器（含 SMT 兄弟线程）
+            int l3Domain = -1;          // 全部核心所在的 L3 域，跨域时为 -1
+            int numaNode = -1;          // 全部核心所在的 NUMA 节点，跨节点时为 -1
+        };
+
+        // 读取当前系统拓扑，由各平台实现
+        CpuTopology QueryCpuTopology();
+
+        // 规划保留 desiredCores 个物理核心：
+        //   以整个物理核心为单位，保证保留核心的 SMT 兄弟线程不被其他进程使用；
+        //   优先放在同一个 L3 域内（最小可容纳的域，避开 CPU 0 所在的域），其次同一个 NUMA 节点；
+        //   域内优先选择高编号核心。只考虑全部兄弟线程都在 eligible 中的物理核心。
+        CoreReservation PlanCoreReservation(const CpuTopology& topology, DWORD desiredCores, const CpuSet& eligible);
+
+        // 逐个物理核心调整已有的保留，不打乱其余核心：
+        //   扩大：在 eligible 中选一个与保留核心不相交的完整物理核心，优先同一 L3 域，其次同一 NUMA 节点，再其次高编号
+        //   缩小：选一个保留的物理核心移出，优先所在 L3 域中保留核心最少的（离群核心），其次低编号
+        // 返回需要加入或移出的逻辑处理器，没有可选核心时为空
+        CpuSet PlanReservationGrowth(const CpuTopology& topology, const CpuSet& reserved, const CpuSet& eligible);
+        CpuSet PlanReservationShrink(const CpuTopology& topology, const CpuSet& reserved);
+        // 保留集合涉及的物理核心数
+        size_t CountReservedCores(const CpuTopology& topology, const CpuSet& reserved);
+        // cpus 所在 NUMA 节点的编号集合（按位表示节点编号），用于内存策略
+        CpuSet FindNumaNodes(const CpuTopology& topology, const CpuSet& cpus);
+    }
+}
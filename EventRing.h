@@ -0,0 +1,107 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 有界无锁环形队列（按槽位序号同步，Vyukov 算法）
+        //
+        // 生产者与消费者都不加锁、不等待：队列满时 TryPush 立即返回 false，由调用方计数丢弃。
+        // 扫描线程是主要生产者，但 ReserveCoreForCurrentProcess 等调用方线程也会写入，
+        // 因此入队同样按多生产者实现；多个消费者可以并发 TryPop。
+        // =============================================================================
+
+        template <typename T>
+        class BoundedEventRing {
+        public:
+            // 容量向上取整为 2 的幂
+            explicit BoundedEventRing(size_t capacity)
+                : m_mask(RoundUpToPowerOfTwo(capacity) - 1)
+                , m_slots(new Slot[m_mask + 1])
+                , m_enqueuePosition(0)
+                , m_dequeuePosition(0)
+            {
+                for (size_t i = 0; i <= m_mask; i++) {
+                    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            BoundedEventRing(const BoundedEventRing&) = delete;
+            BoundedEventRing& operator=(const BoundedEventRing&) = delete;
+
+            bool TryPush(T&& value) {
+                size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+                for (;;) {
+                    Slot& slot = m_slots[position & m_mask];
+                    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+                    if (difference == 0) {
+                        if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            slot.value = std::move(value);
+                            slot.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (difference < 0) {
+                        return false;   // 队列已满
+                    }
+                    else {
+                        position = m_enqueuePosition.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool TryPop(T& value) {
+                size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+                for (;;) {
+                    Slot& slot = m_slots[position & m_mask];
+                    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+                    if (difference == 0) {
+                        if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            value = std::move(slot.value);
+                            slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (difference < 0) {
+                        return false;   // 队列为空
+                    }
+                    else {
+                        position = m_dequeuePosition.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            size_t Capacity() const { return m_mask + 1; }
+
+        private:
+            struct Slot {
+                std::atomic<size_t> sequence;
+                T value;
+            };
+
+            static size_t RoundUpToPowerOfTwo(size_t value) {
+                size_t result = 2;
+                while (result < value) {
+                    result <<= 1;
+                }
+                return result;
+            }
+
+            const size_t m_mask;
+            std::unique_ptr<Slot[]> m_slots;
+            // 生产者与消费者的位置放在不同缓存行，避免伪共享
+            alignas(64) std::atomic<size_t> m_enqueuePosition;
+            alignas(64) std::atomic<size_t> m_dequeuePosition;
+        };
+    }
+}
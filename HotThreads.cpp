@@ -0,0 +1,141 @@
+﻿#include "pch.h"
+#include "HotThreads.h"
+#include "ProcessRules.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_set>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 规则解析
+        // =============================================================================
+
+        bool ParseHotThreadRule(const std::string& processName, const std::string& value, HotThreadRule& rule) {
+            std::string name = TrimIniText(processName);
+            std::string text = TrimIniText(value);
+            size_t separator = text.find(':');
+            if (name.empty() || separator == std::string::npos) {
+                return false;
+            }
+
+            std::string countText = TrimIniText(text.substr(0, separator));
+            char* end = nullptr;
+            unsigned long topK = strtoul(countText.c_str(), &end, 10);
+            if (countText.empty() || *end != '\0' || topK == 0) {
+                return false;
+            }
+
+            CpuSet cores;
+            if (!CpuSet::Parse(TrimIniText(text.substr(separator + 1)), cores) || cores.Empty()) {
+                return false;
+            }
+
+            rule.processName = NormalizeProcessName(name);
+            rule.topK = static_cast<DWORD>(topK);
+            rule.cores = std::move(cores);
+            return true;
+        }
+
+        bool LoadHotThreadRules(const std::string& iniPath, std::vector<HotThreadRule>& rules) {
+            std::vector<IniEntry> entries;
+            if (!ReadIniFile(iniPath, entries)) {
+                rules.clear();
+                return false;
+            }
+
+            LoadHotThreadRules(entries, rules);
+            return true;
+        }
+
+        void LoadHotThreadRules(const std::vector<IniEntry>& entries, std::vector<HotThreadRule>& rules) {
+            rules.clear();
+            for (const IniEntry& entry : entries) {
+                if (entry.section != "hotthreadbinding") {
+                    continue;
+                }
+
+                HotThreadRule rule;
+                if (ParseHotThreadRule(entry.key, entry.value, rule)) {
+                    rules.push_back(std::move(rule));
+                }
+                else {
+                    std::cerr << "忽略格式错误的热点线程规则（第 " << entry.line << " 行）: "
+                        << entry.key << "=" << entry.value << std::endl;
+                }
+            }
+        }
+
+        bool MatchesHotThreadRule(const HotThreadRule& rule, const std::string& processName) {
+            return ProcessNameEquals(rule.processName, processName);
+        }
+
+        // =============================================================================
+        // ThreadActivityTracker
+        // =============================================================================
+
+        bool ThreadActivityTracker::Rank(IProcessBackend& backend, const ProcessEntry& process, std::vector<ThreadUsage>& ranked) {
+            ranked.clear();
+            if (!backend.EnumerateThreads(process.processId, m_threads)) {
+                m_processes.erase(process.processId);
+                return false;
+            }
+
+            ProcessThreads& history = m_processes[process.processId];
+            if (history.startTime != process.startTime) {
+                // PID 被复用，旧进程的线程记录作废
+                history.lastCpuTime.clear();
+                history.startTime = process.startTime;
+            }
+
+            std::unordered_map<DWORD, uint64_t> current;
+            current.reserve(m_threads.size());
+            ranked.reserve(m_threads.size());
+
+            for (ThreadEntry& thread : m_threads) {
+                ThreadUsage usage;
+                usage.threadId = thread.threadId;
+                usage.name = std::move(thread.name);
+                usage.cpuTime = thread.cpuTime;
+
+                auto it = history.lastCpuTime.find(thread.threadId);
+                uint64_t previous = it != history.lastCpuTime.end() && it->second <= thread.cpuTime ? it->second : 0;
+                usage.intervalCpuTime = thread.cpuTime - previous;
+
+                current.emplace(thread.threadId, thread.cpuTime);
+                ranked.push_back(std::move(usage));
+            }
+
+            // 只保留仍存在的线程，已退出线程的记录随之淘汰
+            history.lastCpuTime.swap(current);
+
+            std::stable_sort(ranked.begin(), ranked.end(), [](const ThreadUsage& a, const ThreadUsage& b) {
+                return a.intervalCpuTime > b.intervalCpuTime;
+            });
+            return true;
+        }
+
+        void ThreadActivityTracker::Prune(const std::vector<ProcessEntry>& processes) {
+            std::unordered_set<DWORD> alive;
+            alive.reserve(processes.size());
+            for (const ProcessEntry& process : processes) {
+                alive.insert(process.processId);
+            }
+
+            for (auto it = m_processes.begin(); it != m_processes.end();) {
+                if (alive.count(it->first) == 0) {
+                    it = m_processes.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        void ThreadActivityTracker::Clear() {
+            m_processes.clear();
+        }
+    }
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include "CpuSet.h"
+#include "IniFile.h"
+#include "ProcessBackend.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 热点线程：按区间 CPU 时间给进程内线程排序，只把最忙的 K 个线程绑定到保留核心，
+        // 其余辅助线程排除这些核心、在剩余核心上自由调度
+        // =============================================================================
+
+        // 线程在一个统计区间内的 CPU 消耗
+        struct ThreadUsage {
+            DWORD threadId = 0;
+            std::string name;
+            uint64_t cpuTime = 0;           // 累计 CPU 时间（100ns）
+            uint64_t intervalCpuTime = 0;   // 距上次统计消耗的 CPU 时间（100ns）
+        };
+
+        // 热点线程规则，INI 格式（[HotThreadBinding] 节）：进程名=K:核心列表
+        // 例：gateway=1:6-7 表示 gateway 最忙的 1 个线程绑定到核心 6、7
+        struct HotThreadRule {
+            std::string processName;    // 不区分大小写，可省略 .exe
+            DWORD topK = 1;
+            CpuSet cores;
+        };
+
+        // 解析单条规则，格式错误返回 false
+        bool ParseHotThreadRule(const std::string& processName, const std::string& value, HotThreadRule& rule);
+
+        // 读取 INI 文件中的 [HotThreadBinding] 节，文件无法打开时返回 false
+        bool LoadHotThreadRules(const std::string& iniPath, std::vector<HotThreadRule>& rules);
+        // 从已读取的 INI 内容中取出 [HotThreadBinding] 节
+        void LoadHotThreadRules(const std::vector<IniEntry>& entries, std::vector<HotThreadRule>& rules);
+
+        // 进程名是否匹配规则
+        bool MatchesHotThreadRule(const HotThreadRule& rule, const std::string& processName);
+
+        class ThreadActivityTracker {
+        public:
+            // 枚举进程线程并按距上次统计消耗的 CPU 时间降序排列；首次出现的线程按累计时间计
+            bool Rank(IProcessBackend& backend, const ProcessEntry& process, std::vector<ThreadUsage>& ranked);
+
+            // 淘汰已不在快照中的进程
+            void Prune(const std::vector<ProcessEntry>& processes);
+            void Clear();
+
+        private:
+            struct ProcessThreads {
+                uint64_t startTime = 0;
+                std::unordered_map<DWORD, uint64_t> lastCpuTime;   // 线程 ID -> 上次统计时的累计 CPU 时间
+            };
+
+            std::unordered_map<DWORD, ProcessThreads> m_processes;
+            std::vector<ThreadEntry> m_threads;
+        };
+    }
+}
@@ -0,0 +1,67 @@
+﻿#include "pch.h"
+#include "IniFile.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        std::string TrimIniText(const std::string& text) {
+            size_t begin = text.find_first_not_of(" \t\r\n");
+            if (begin == std::string::npos) {
+                return std::string();
+            }
+            size_t end = text.find_last_not_of(" \t\r\n");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        std::string ToLowerAscii(std::string text) {
+            std::transform(text.begin(), text.end(), text.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return text;
+        }
+
+        bool ReadIniFile(const std::string& iniPath, std::vector<IniEntry>& entries) {
+            entries.clear();
+
+            std::ifstream file(iniPath);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            std::string section;
+            std::string line;
+            size_t lineNumber = 0;
+            while (std::getline(file, line)) {
+                lineNumber++;
+                // 兼容带 BOM 的 UTF-8 文件
+                if (lineNumber == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+                    line.erase(0, 3);
+                }
+                line = TrimIniText(line);
+                if (line.empty() || line[0] == '#' || line[0] == ';') {
+                    continue;
+                }
+
+                if (line.front() == '[' && line.back() == ']') {
+                    section = ToLowerAscii(TrimIniText(line.substr(1, line.size() - 2)));
+                    continue;
+                }
+
+                size_t equals = line.find('=');
+                if (equals == std::string::npos) {
+                    continue;
+                }
+
+                IniEntry entry;
+                entry.section = section;
+                entry.key = TrimIniText(line.substr(0, equals));
+                entry.value = TrimIniText(line.substr(equals + 1));
+                entry.line = lineNumber;
+                entries.push_back(std::move(entry));
+            }
+            return true;
+        }
+    }
+}
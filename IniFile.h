@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // INI 文件读取：与 CpuCoreConfigManager.cs 的解析规则一致
+        // （# 与 ; 开头为注释，[节名] 切换节，键=值 以第一个等号分隔，前后空白忽略）
+        // =============================================================================
+
+        struct IniEntry {
+            std::string section;    // 小写节名
+            std::string key;
+            std::string value;
+            size_t line = 0;        // 行号，用于错误提示
+        };
+
+        // 按文件顺序读取全部键值，文件无法打开时返回 false
+        bool ReadIniFile(const std::string& iniPath, std::vector<IniEntry>& entries);
+
+        std::string TrimIniText(const std::string& text);
+        std::string ToLowerAscii(std::string text);
+    }
+}
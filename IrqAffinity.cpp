@@ -0,0 +1,240 @@
+﻿#include "pch.h"
+#include "IrqAffinity.h"
+#include <iostream>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const char* const IRQ_ROOT = "/proc/irq";
+            const char* const DEFAULT_AFFINITY_PATH = "/proc/irq/default_smp_affinity";
+
+            bool WriteProcFile(const std::string& path, const std::string& value) {
+                int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return false;
+                }
+                ssize_t written = write(fd, value.data(), value.size());
+                int error = errno;
+                close(fd);
+                errno = error;
+                return written == static_cast<ssize_t>(value.size());
+            }
+
+            std::string ReadProcLine(const std::string& path) {
+                std::ifstream file(path);
+                std::string line;
+                std::getline(file, line);
+                return line;
+            }
+
+            std::string IrqAffinityPath(unsigned int irq) {
+                return std::string(IRQ_ROOT) + "/" + std::to_string(irq) + "/smp_affinity_list";
+            }
+
+            // 当前系统注册的全部中断号
+            std::vector<unsigned int> ListIrqs() {
+                std::vector<unsigned int> irqs;
+                std::error_code error;
+                for (std::filesystem::directory_iterator it(IRQ_ROOT, error), end; !error && it != end; it.increment(error)) {
+                    const std::string name = it->path().filename().string();
+                    if (!name.empty() && name.find_first_not_of("0123456789") == std::string::npos) {
+                        irqs.push_back(static_cast<unsigned int>(std::stoul(name)));
+                    }
+                }
+                return irqs;
+            }
+
+            // default_smp_affinity 使用十六进制掩码，每 32 位一组，高位在前，以逗号分隔
+            std::string FormatHexMask(const CpuSet& cpus, size_t cpuCount) {
+                size_t groups = (std::max<size_t>(cpuCount, 1) + 31) / 32;
+                std::string text;
+                for (size_t group = groups; group-- > 0;) {
+                    uint32_t bits = 0;
+                    for (size_t bit = 0; bit < 32; bit++) {
+                        if (cpus.Test(group * 32 + bit)) {
+                            bits |= 1u << bit;
+                        }
+                    }
+                    char buffer[16];
+                    snprintf(buffer, sizeof(buffer), "%08x", bits);
+                    if (!text.empty()) {
+                        text += ',';
+                    }
+                    text += buffer;
+                }
+                return text;
+            }
+
+            // 保留核心之外的目标：原亲和性去掉保留核心，全部落在保留核心上时改用其余全部核心
+            CpuSet ComputeIrqAffinity(const CpuSet& base, const CpuSet& reservedSet, const CpuSet& systemSet) {
+                CpuSet target = base & systemSet;
+                target.AndNot(reservedSet);
+                if (target.Empty()) {
+                    target = systemSet;
+                    target.AndNot(reservedSet);
+                }
+                return target;
+            }
+        }
+
+        IrqAffinitySteering::IrqAffinitySteering()
+            : m_active(false)
+        {
+        }
+
+        IrqAffinitySteering::~IrqAffinitySteering() {
+            Restore();
+        }
+
+        bool IrqAffinitySteering::IsSupported() {
+            return access(DEFAULT_AFFINITY_PATH, W_OK) == 0;
+        }
+
+        size_t IrqAffinitySteering::Apply(const CpuSet& reservedSet, const CpuSet& systemSet) {
+            CpuSet available = systemSet;
+            available.AndNot(reservedSet);
+            if (reservedSet.Empty() || available.Empty()) {
+                // 不再保留任何核心时恢复原值
+                Restore();
+                return 0;
+            }
+
+            // 之后注册的中断默认不使用保留核心
+            if (m_originalDefault.empty()) {
+                m_originalDefault = ReadProcLine(DEFAULT_AFFINITY_PATH);
+            }
+            WriteProcFile(DEFAULT_AFFINITY_PATH, FormatHexMask(available, systemSet.Last() + 1));
+            m_active = true;
+
+            size_t steered = 0;
+            for (unsigned int irq : ListIrqs()) {
+                if (m_unmanaged.count(irq) != 0) {
+                    continue;
+                }
+
+                std::string path = IrqAffinityPath(irq);
+                std::string currentText = ReadProcLine(path);
+                CpuSet current;
+                if (!CpuSet::Parse(currentText, current)) {
+                    continue;
+                }
+
+                // 保留核心变化后以原值为基准，之前被移走的中断可以回到不再保留的核心
+                auto original = m_original.find(irq);
+                CpuSet base = current;
+                if (original != m_original.end()) {
+                    CpuSet::Parse(original->second, base);
+                }
+
+                CpuSet target = ComputeIrqAffinity(base, reservedSet, systemSet);
+                if (target == current) {
+                    continue;
+                }
+
+                if (!WriteProcFile(path, target.ToString())) {
+                    // 内核托管的中断返回 EIO，每核心的中断（定时器等）返回 EINVAL
+                    m_unmanaged.insert(irq);
+                    continue;
+                }
+                if (original == m_original.end()) {
+                    m_original.emplace(irq, currentText);
+                }
+                steered++;
+            }
+            return steered;
+        }
+
+        void IrqAffinitySteering::Restore() {
+            if (!m_active) {
+                return;
+            }
+
+            size_t failed = 0;
+            for (const auto& entry : m_original) {
+                // 中断可能已随设备移除
+                if (!WriteProcFile(IrqAffinityPath(entry.first), entry.second) && errno != ENOENT) {
+                    failed++;
+                }
+            }
+            if (!m_originalDefault.empty()) {
+                WriteProcFile(DEFAULT_AFFINITY_PATH, m_originalDefault);
+            }
+            if (failed > 0) {
+                std::cerr << failed << " 个中断的亲和性恢复失败" << std::endl;
+            }
+
+            m_original.clear();
+            m_unmanaged.clear();
+            m_originalDefault.clear();
+            m_active = false;
+        }
+
+        bool IrqAffinitySteering::IsActive() const {
+            return m_active;
+        }
+
+        size_t IrqAffinitySteering::GetSteeredCount() const {
+            return m_original.size();
+        }
+
+        size_t IrqAffinitySteering::GetUnmanagedCount() const {
+            return m_unmanaged.size();
+        }
+    }
+}
+
+#else
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // Windows 的中断亲和性由驱动与注册表（Interrupt Management\Affinity Policy）决定，
+        // 修改后需要重启设备，无法在运行时引导
+
+        IrqAffinitySteering::IrqAffinitySteering()
+            : m_active(false)
+        {
+        }
+
+        IrqAffinitySteering::~IrqAffinitySteering() {
+        }
+
+        bool IrqAffinitySteering::IsSupported() {
+            return false;
+        }
+
+        size_t IrqAffinitySteering::Apply(const CpuSet&, const CpuSet&) {
+            return 0;
+        }
+
+        void IrqAffinitySteering::Restore() {
+        }
+
+        bool IrqAffinitySteering::IsActive() const {
+            return false;
+        }
+
+        size_t IrqAffinitySteering::GetSteeredCount() const {
+            return 0;
+        }
+
+        size_t IrqAffinitySteering::GetUnmanagedCount() const {
+            return 0;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include "CpuSet.h"
+#include <map>
+#include <set>
+#include <string>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 中断亲和性引导（仅 Linux）：把硬件中断移出保留核心
+        //   通过 /proc/irq/<n>/smp_affinity_list 修改每个中断，/proc/irq/default_smp_affinity 覆盖之后注册的中断
+        //   首次修改时保存原值，Restore 时写回；保留核心变化时以原值为基准重新计算
+        // 内核托管的中断（例如 NVMe 按队列分配的中断）拒绝修改，记录后不再重试
+        // =============================================================================
+
+        class IrqAffinitySteering {
+        public:
+            IrqAffinitySteering();
+            ~IrqAffinitySteering();
+
+            IrqAffinitySteering(const IrqAffinitySteering&) = delete;
+            IrqAffinitySteering& operator=(const IrqAffinitySteering&) = delete;
+
+            static bool IsSupported();
+
+            // 让所有中断避开 reservedSet；可重复调用，只改写当前仍落在保留核心上的中断
+            // （包括新出现的中断与被 irqbalance 等改回的中断），返回本次改写的中断数
+            // 没有保留核心时恢复原值
+            size_t Apply(const CpuSet& reservedSet, const CpuSet& systemSet);
+            // 写回所有改写过的中断的原值
+            void Restore();
+
+            bool IsActive() const;
+            // 改写过的中断数与拒绝修改的中断数
+            size_t GetSteeredCount() const;
+            size_t GetUnmanagedCount() const;
+
+        private:
+            std::map<unsigned int, std::string> m_original;    // 中断号 -> 原 smp_affinity_list
+            std::set<unsigned int> m_unmanaged;
+            std::string m_originalDefault;                      // 原 default_smp_affinity（十六进制掩码）
+            bool m_active;
+        };
+    }
+}
@@ -0,0 +1,289 @@
+﻿#include "pch.h"
+#include "JitterProbe.h"
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const size_t MAX_SPIKES_PER_CORE = 1000;
+            const size_t MAX_SUSPECTS_PER_SPIKE = 8;
+            const size_t PRINTED_SPIKES_PER_CORE = 10;
+
+            DWORD CurrentThreadId() {
+#ifdef _WIN32
+                return GetCurrentThreadId();
+#else
+                return static_cast<DWORD>(syscall(SYS_gettid));
+#endif
+            }
+
+            // 需要管理员权限（Linux CAP_SYS_NICE），失败时以普通优先级继续测量
+            bool RaiseCurrentThreadPriority() {
+#ifdef _WIN32
+                return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != FALSE;
+#else
+                sched_param param;
+                param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+                return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+            }
+
+            // 睡眠到绝对时间点，避免相对睡眠的误差累积
+            class PeriodicSleeper {
+            public:
+                PeriodicSleeper()
+#ifdef _WIN32
+                    // 高精度可等待定时器（Windows 10 1803+），不支持时退回 sleep_until
+                    : m_timer(CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS))
+#endif
+                {
+                }
+
+                ~PeriodicSleeper() {
+#ifdef _WIN32
+                    if (m_timer != NULL) {
+                        CloseHandle(m_timer);
+                    }
+#endif
+                }
+
+                void SleepUntil(std::chrono::steady_clock::time_point deadline) {
+#ifdef _WIN32
+                    auto remaining = deadline - std::chrono::steady_clock::now();
+                    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+                        return;
+                    }
+                    LARGE_INTEGER due;
+                    due.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() / 100);
+                    if (m_timer != NULL && SetWaitableTimer(m_timer, &due, 0, NULL, NULL, FALSE)) {
+                        WaitForSingleObject(m_timer, INFINITE);
+                        return;
+                    }
+                    std::this_thread::sleep_until(deadline);
+#else
+                    // libstdc++ 的 steady_clock 即 CLOCK_MONOTONIC
+                    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+                    timespec target;
+                    target.tv_sec = static_cast<time_t>(sinceEpoch / 1000000000);
+                    target.tv_nsec = static_cast<long>(sinceEpoch % 1000000000);
+                    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR) {
+                    }
+#endif
+                }
+
+            private:
+#ifdef _WIN32
+                HANDLE m_timer;
+#endif
+            };
+
+            uint64_t ToMicroseconds(std::chrono::steady_clock::duration value) {
+                auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+                return microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0;
+            }
+
+            void AddSpike(CoreJitterReport& report, JitterSpike::Kind kind, uint64_t microseconds) {
+                report.spikeCount++;
+                if (report.spikes.size() >= MAX_SPIKES_PER_CORE) {
+                    return;
+                }
+
+                JitterSpike spike;
+                spike.kind = kind;
+                spike.microseconds = microseconds;
+                spike.time = std::chrono::system_clock::now();
+                report.spikes.push_back(std::move(spike));
+            }
+
+            std::string FormatTime(std::chrono::system_clock::time_point time) {
+                std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+                auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+                std::tm local;
+#ifdef _WIN32
+                localtime_s(&local, &seconds);
+#else
+                localtime_r(&seconds, &local);
+#endif
+                std::ostringstream text;
+                text << std::put_time(&local, "%H:%M:%S") << "." << std::setw(3) << std::setfill('0') << milliseconds;
+                return text.str();
+            }
+        }
+
+        JitterProbe::JitterProbe(IProcessBackend& backend)
+            : m_backend(backend)
+        {
+        }
+
+        std::vector<CoreJitterReport> JitterProbe::Run(const CpuSet& cpus, const JitterProbeOptions& options) {
+            std::vector<CoreJitterReport> reports;
+            for (size_t cpu = cpus.First(); cpu != CpuSet::npos; cpu = cpus.Next(cpu)) {
+                CoreJitterReport report;
+                report.cpu = static_cast<DWORD>(cpu);
+                reports.push_back(std::move(report));
+            }
+
+            // 所有探测线程使用同一个结束时间，结果覆盖同一段时间
+            auto end = std::chrono::steady_clock::now() + options.duration;
+            std::vector<std::thread> threads;
+            threads.reserve(reports.size());
+            for (CoreJitterReport& report : reports) {
+                try {
+                    threads.emplace_back(&JitterProbe::ProbeCore, this, std::cref(options), end, std::ref(report));
+                }
+                catch (const std::system_error&) {
+                    std::cerr << "创建核心 " << report.cpu << " 的探测线程失败" << std::endl;
+                }
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            return reports;
+        }
+
+        void JitterProbe::ProbeCore(const JitterProbeOptions& options, std::chrono::steady_clock::time_point end,
+            CoreJitterReport& report) {
+            report.pinned = m_backend.ApplyThreadAffinity(CurrentThreadId(), CpuSet::Single(report.cpu));
+            if (!report.pinned) {
+                // 未绑定时测到的是其他核心，结果没有意义
+                return;
+            }
+            report.realtime = options.realtimePriority && RaiseCurrentThreadPriority();
+
+            LatencyHistogram wakeupLatency;
+            LatencyHistogram interruptions;
+            PeriodicSleeper sleeper;
+            uint64_t spikeThreshold = static_cast<uint64_t>(options.spikeThreshold.count());
+            auto interruptionThreshold = std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.interruptionThreshold);
+
+            auto next = std::chrono::steady_clock::now() + options.interval;
+            while (next < end) {
+                sleeper.SleepUntil(next);
+                auto woke = std::chrono::steady_clock::now();
+                uint64_t latency = ToMicroseconds(woke - next);
+                wakeupLatency.Record(latency);
+                if (latency >= spikeThreshold) {
+                    AddSpike(report, JitterSpike::Kind::Wakeup, latency);
+                }
+
+                // 忙循环期间线程一直可运行，读数间隔即为被打断的时长
+                auto busyEnd = woke + options.busyWindow;
+                auto last = woke;
+                for (;;) {
+                    auto now = std::chrono::steady_clock::now();
+                    auto gap = now - last;
+                    if (gap >= interruptionThreshold) {
+                        uint64_t microseconds = ToMicroseconds(gap);
+                        interruptions.Record(microseconds);
+                        if (microseconds >= spikeThreshold) {
+                            AddSpike(report, JitterSpike::Kind::Interruption, microseconds);
+                        }
+                    }
+                    last = now;
+                    if (now >= busyEnd) {
+                        break;
+                    }
+                }
+
+                // 超时的周期直接跳过，与 cyclictest 相同，不补偿
+                next += options.interval;
+                auto now = std::chrono::steady_clock::now();
+                while (next <= now) {
+                    next += options.interval;
+                }
+            }
+
+            report.wakeupLatency = SummarizeLatency(wakeupLatency);
+            report.interruptions = SummarizeLatency(interruptions);
+        }
+
+        void CorrelateJitterSpikes(std::vector<CoreJitterReport>& reports, const std::vector<JitterSuspect>& residents,
+            const std::vector<JitterSuspect>& occupants, std::chrono::milliseconds window) {
+            for (CoreJitterReport& report : reports) {
+                for (const JitterSuspect& resident : residents) {
+                    if (resident.cores.Test(report.cpu)) {
+                        report.residents.push_back(resident);
+                    }
+                }
+
+                for (JitterSpike& spike : report.spikes) {
+                    for (const JitterSuspect& occupant : occupants) {
+                        if (spike.suspects.size() >= MAX_SUSPECTS_PER_SPIKE) {
+                            break;
+                        }
+                        if (!occupant.cores.Test(report.cpu)) {
+                            continue;
+                        }
+                        auto distance = occupant.seen > spike.time ? occupant.seen - spike.time : spike.time - occupant.seen;
+                        if (distance <= window) {
+                            spike.suspects.push_back(occupant);
+                        }
+                    }
+                }
+            }
+        }
+
+        void PrintJitterReport(const std::vector<CoreJitterReport>& reports) {
+            std::cout << "\n=== 保留核心抖动测量（微秒） ===" << std::endl;
+            for (const CoreJitterReport& report : reports) {
+                std::cout << "\n核心 " << report.cpu;
+                if (!report.pinned) {
+                    std::cout << ": 探测线程无法绑定到该核心（cgroup 方式下需先把当前进程移入保留组）" << std::endl;
+                    continue;
+                }
+                std::cout << (report.realtime ? "（实时优先级）" : "（普通优先级，结果包含调度延迟）") << std::endl;
+
+                const LatencySummary& wakeup = report.wakeupLatency;
+                const LatencySummary& interruptions = report.interruptions;
+                std::cout << "  唤醒延迟: 次数 " << wakeup.count << "  p50 " << wakeup.p50 << "  p99 " << wakeup.p99
+                    << "  p99.9 " << wakeup.p999 << "  最大 " << wakeup.max << std::endl;
+                std::cout << "  忙循环打断: 次数 " << interruptions.count << "  累计 " << interruptions.sum
+                    << "  p99 " << interruptions.p99 << "  最大 " << interruptions.max << std::endl;
+                std::cout << "  突发: " << report.spikeCount << " 次" << std::endl;
+
+                if (!report.residents.empty()) {
+                    std::cout << "  测量开始时仍可使用该核心的进程:";
+                    for (const JitterSuspect& resident : report.residents) {
+                        std::cout << " " << resident.name << "(" << resident.processId << ")";
+                    }
+                    std::cout << std::endl;
+                }
+
+                // 只列出最大的几次突发
+                std::vector<const JitterSpike*> largest;
+                for (const JitterSpike& spike : report.spikes) {
+                    largest.push_back(&spike);
+                }
+                size_t printed = std::min(largest.size(), PRINTED_SPIKES_PER_CORE);
+                std::partial_sort(largest.begin(), largest.begin() + printed, largest.end(),
+                    [](const JitterSpike* a, const JitterSpike* b) { return a->microseconds > b->microseconds; });
+
+                for (size_t i = 0; i < printed; i++) {
+                    const JitterSpike& spike = *largest[i];
+                    std::cout << "    " << FormatTime(spike.time) << "  "
+                        << (spike.kind == JitterSpike::Kind::Wakeup ? "唤醒延迟 " : "忙循环打断 ") << spike.microseconds;
+                    if (!spike.suspects.empty()) {
+                        std::cout << "  同期扫描发现:";
+                        for (const JitterSuspect& suspect : spike.suspects) {
+                            std::cout << " " << suspect.name << "(" << suspect.processId << ")";
+                        }
+                    }
+                    std::cout << std::endl;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include "CpuSet.h"
+#include "Metrics.h"
+#include "ProcessBackend.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 抖动探测（类似 cyclictest）：在每个被测核心上绑定一个探测线程，
+        //   定时唤醒：按固定周期睡眠到绝对时间点，记录实际唤醒的延迟
+        //   忙循环：唤醒后连续读时钟一小段时间，相邻两次读数的间隔超过阈值即视为被打断（中断、抢占）
+        // 超过突发阈值的样本记录时间点，之后与扫描在该核心上发现的进程关联
+        // =============================================================================
+
+        struct JitterProbeOptions {
+            std::chrono::milliseconds duration{10000};
+            std::chrono::microseconds interval{1000};               // 唤醒周期
+            std::chrono::microseconds busyWindow{200};              // 每个周期的忙循环时长
+            std::chrono::microseconds interruptionThreshold{5};     // 忙循环读数间隔超过该值计为一次打断
+            std::chrono::microseconds spikeThreshold{100};          // 超过该值的样本记录为突发
+            std::chrono::milliseconds correlationWindow{1000};      // 突发前后多长时间内发现的进程视为嫌疑
+            bool realtimePriority = true;                           // 尝试以实时优先级运行探测线程
+        };
+
+        // 扫描发现的、可能在被测核心上运行的进程
+        struct JitterSuspect {
+            DWORD processId = 0;
+            std::string name;
+            CpuSet cores;                                   // 该进程可运行的被测核心
+            std::chrono::system_clock::time_point seen;     // 扫描发现的时间
+        };
+
+        struct JitterSpike {
+            enum class Kind {
+                Wakeup,         // 定时唤醒延迟
+                Interruption    // 忙循环被打断
+            };
+
+            Kind kind = Kind::Wakeup;
+            uint64_t microseconds = 0;
+            std::chrono::system_clock::time_point time;
+            std::vector<JitterSuspect> suspects;    // 时间窗口内扫描在该核心上发现的进程
+        };
+
+        struct CoreJitterReport {
+            DWORD cpu = 0;
+            bool pinned = false;        // 探测线程是否成功绑定到该核心
+            bool realtime = false;      // 是否以实时优先级运行
+            LatencySummary wakeupLatency;
+            LatencySummary interruptions;
+            uint64_t spikeCount = 0;                // 含超出记录上限未保存的突发
+            std::vector<JitterSpike> spikes;
+            std::vector<JitterSuspect> residents;   // 测量开始时亲和性仍包含该核心的进程
+        };
+
+        class JitterProbe {
+        public:
+            explicit JitterProbe(IProcessBackend& backend);
+
+            // 每个核心一个探测线程，阻塞到测量结束
+            std::vector<CoreJitterReport> Run(const CpuSet& cpus, const JitterProbeOptions& options);
+
+        private:
+            void ProbeCore(const JitterProbeOptions& options, std::chrono::steady_clock::time_point end,
+                CoreJitterReport& report);
+
+            IProcessBackend& m_backend;
+        };
+
+        // 把突发与扫描发现的进程关联：residents 按核心归入报告，occupants 按时间窗口归入各突发
+        void CorrelateJitterSpikes(std::vector<CoreJitterReport>& reports, const std::vector<JitterSuspect>& residents,
+            const std::vector<JitterSuspect>& occupants, std::chrono::milliseconds window);
+
+        void PrintJitterReport(const std::vector<CoreJitterReport>& reports);
+    }
+}
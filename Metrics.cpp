@@ -0,0 +1,289 @@
+﻿#include "pch.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const double EXPORTED_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+            void WriteCounter(std::ostringstream& out, const char* name, const char* help, uint64_t value) {
+                out << "# HELP " << name << " " << help << "\n";
+                out << "# TYPE " << name << " counter\n";
+                out << name << " " << value << "\n";
+            }
+
+            void WriteGauge(std::ostringstream& out, const char* name, const char* help, double value) {
+                out << "# HELP " << name << " " << help << "\n";
+                out << "# TYPE " << name << " gauge\n";
+                out << name << " " << value << "\n";
+            }
+
+            // 以秒为单位导出，符合 Prometheus 的命名约定
+            void WriteSummary(std::ostringstream& out, const char* name, const char* help, const LatencyHistogram& histogram) {
+                out << "# HELP " << name << " " << help << "\n";
+                out << "# TYPE " << name << " summary\n";
+                for (double quantile : EXPORTED_QUANTILES) {
+                    out << name << "{quantile=\"" << quantile << "\"} " << histogram.GetQuantile(quantile) / 1e6 << "\n";
+                }
+                out << name << "_sum " << histogram.GetSum() / 1e6 << "\n";
+                out << name << "_count " << histogram.GetCount() << "\n";
+            }
+        }
+
+        // =============================================================================
+        // LatencyHistogram
+        // =============================================================================
+
+        LatencyHistogram::LatencyHistogram()
+            : m_count(0)
+            , m_sum(0)
+            , m_max(0)
+        {
+            for (std::atomic<uint64_t>& bucket : m_buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        size_t LatencyHistogram::BucketIndex(uint64_t value) {
+            if (value < LINEAR_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+
+            size_t magnitude = 63;
+            while ((value >> magnitude) == 0) {
+                magnitude--;
+            }
+            // 最高位之后保留 3 位，子桶编号 8~15
+            size_t shift = magnitude - 3;
+            size_t sub = static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+            return LINEAR_BUCKETS + (magnitude - 4) * SUB_BUCKETS + sub;
+        }
+
+        uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+            if (index < LINEAR_BUCKETS) {
+                return index;
+            }
+
+            size_t magnitude = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+            uint64_t sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+            size_t shift = magnitude - 3;
+            if (magnitude == 63 && sub == 15) {
+                return UINT64_MAX;
+            }
+            return ((sub + 1) << shift) - 1;
+        }
+
+        void LatencyHistogram::Record(std::chrono::microseconds value) {
+            Record(value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0);
+        }
+
+        void LatencyHistogram::Record(uint64_t microseconds) {
+            m_buckets[BucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(microseconds, std::memory_order_relaxed);
+
+            uint64_t max = m_max.load(std::memory_order_relaxed);
+            while (microseconds > max && !m_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed)) {
+            }
+        }
+
+        uint64_t LatencyHistogram::GetCount() const {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+        uint64_t LatencyHistogram::GetSum() const {
+            return m_sum.load(std::memory_order_relaxed);
+        }
+
+        uint64_t LatencyHistogram::GetMax() const {
+            return m_max.load(std::memory_order_relaxed);
+        }
+
+        uint64_t LatencyHistogram::GetQuantile(double quantile) const {
+            // 各桶计数与总数分别读取，并发记录时以桶计数之和为准
+            uint64_t total = 0;
+            for (const std::atomic<uint64_t>& bucket : m_buckets) {
+                total += bucket.load(std::memory_order_relaxed);
+            }
+            if (total == 0) {
+                return 0;
+            }
+
+            uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total));
+            if (rank >= total) {
+                rank = total - 1;
+            }
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; i++) {
+                seen += m_buckets[i].load(std::memory_order_relaxed);
+                if (seen > rank) {
+                    // 桶上界不超过实际观测到的最大值
+                    return std::min(BucketUpperBound(i), GetMax());
+                }
+            }
+            return GetMax();
+        }
+
+        LatencySummary SummarizeLatency(const LatencyHistogram& histogram) {
+            LatencySummary summary;
+            summary.count = histogram.GetCount();
+            summary.sum = histogram.GetSum();
+            summary.p50 = histogram.GetQuantile(0.5);
+            summary.p99 = histogram.GetQuantile(0.99);
+            summary.p999 = histogram.GetQuantile(0.999);
+            summary.max = histogram.GetMax();
+            return summary;
+        }
+
+        // =============================================================================
+        // 导出
+        // =============================================================================
+
+        std::string FormatPrometheusMetrics(const ManagerMetrics& metrics, const MetricsExtras& extras) {
+            std::ostringstream out;
+            WriteSummary(out, "cpucore_snapshot_seconds", "Time to enumerate one process snapshot", metrics.snapshotTime);
+            WriteSummary(out, "cpucore_process_query_seconds", "Time to open and query affinity of one process", metrics.processQueryTime);
+            WriteSummary(out, "cpucore_apply_seconds", "Time to apply affinity to one process", metrics.applyTime);
+            WriteSummary(out, "cpucore_detection_to_exclusion_seconds", "Time from detecting a process to excluding reserved cores", metrics.detectionLatency);
+            WriteSummary(out, "cpucore_protection_pass_seconds", "Time of one protection thread pass", metrics.passTime);
+
+            WriteCounter(out, "cpucore_protection_passes_total", "Protection thread passes", metrics.passes.load(std::memory_order_relaxed));
+            WriteCounter(out, "cpucore_processes_scanned_total", "Processes enumerated by snapshots", metrics.processesScanned.load(std::memory_order_relaxed));
+            WriteCounter(out, "cpucore_exclusions_applied_total", "Affinity changes applied", metrics.exclusionsApplied.load(std::memory_order_relaxed));
+            WriteCounter(out, "cpucore_exclusions_denied_total", "Affinity changes denied by permissions", metrics.exclusionsDenied.load(std::memory_order_relaxed));
+            WriteCounter(out, "cpucore_exclusions_failed_total", "Affinity changes failed for other reasons", metrics.exclusionsFailed.load(std::memory_order_relaxed));
+            WriteCounter(out, "cpucore_action_events_dropped_total", "Action events dropped because the queue was full", extras.droppedEvents);
+
+            WriteGauge(out, "cpucore_protected_cores", "Number of reserved logical processors", static_cast<double>(extras.protectedCoreCount));
+            WriteGauge(out, "cpucore_scan_interval_seconds", "Current interval between full protection sweeps", extras.scanIntervalSeconds);
+            WriteGauge(out, "cpucore_self_cpu_seconds", "CPU time consumed by this process", GetSelfCpuSeconds());
+            return out.str();
+        }
+
+        bool WriteMetricsFile(const std::string& path, const std::string& content) {
+            std::string temporaryPath = path + ".tmp";
+            {
+                std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) {
+                    return false;
+                }
+                file << content;
+                if (!file.good()) {
+                    return false;
+                }
+            }
+
+#ifdef _WIN32
+            if (!MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                return false;
+            }
+#else
+            if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+                return false;
+            }
+#endif
+            return true;
+        }
+
+        double GetSelfCpuSeconds() {
+#ifdef _WIN32
+            FILETIME creationTime, exitTime, kernelTime, userTime;
+            if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+                return 0.0;
+            }
+            auto toTicks = [](const FILETIME& time) {
+                return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+            };
+            return static_cast<double>(toTicks(kernelTime) + toTicks(userTime)) / 1e7;
+#else
+            struct rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0) {
+                return 0.0;
+            }
+            return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+        }
+
+        // =============================================================================
+        // MetricsFileExporter
+        // =============================================================================
+
+        MetricsFileExporter::MetricsFileExporter()
+            : m_interval(5000)
+            , m_running(false)
+        {
+        }
+
+        MetricsFileExporter::~MetricsFileExporter() {
+            Stop();
+        }
+
+        bool MetricsFileExporter::Start(const std::string& path, std::chrono::milliseconds interval, ContentProvider provider) {
+            Stop();
+
+            m_path = path;
+            m_interval = interval;
+            m_provider = std::move(provider);
+            m_running = true;
+
+            try {
+                m_thread = std::thread(&MetricsFileExporter::ExportLoop, this);
+            }
+            catch (const std::system_error&) {
+                m_running = false;
+                std::cerr << "创建指标导出线程失败" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        void MetricsFileExporter::Stop() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = false;
+            }
+            m_wakeup.notify_all();
+
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+        }
+
+        void MetricsFileExporter::ExportLoop() {
+            bool reportedFailure = false;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;) {
+                bool stopping = m_wakeup.wait_for(lock, m_interval, [this] { return !m_running; });
+                lock.unlock();
+
+                if (!WriteMetricsFile(m_path, m_provider())) {
+                    // 只提示一次，避免目录不可写时刷屏
+                    if (!reportedFailure) {
+                        std::cerr << "写入指标文件失败: " << m_path << std::endl;
+                        reportedFailure = true;
+                    }
+                }
+                else {
+                    reportedFailure = false;
+                }
+
+                if (stopping) {
+                    return;
+                }
+                lock.lock();
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+﻿#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 自身开销统计：对数-线性分桶的延迟直方图（HDR 风格，相对误差不超过 12.5%）与计数器，
+        // 导出为 Prometheus 文本格式（node_exporter textfile collector 可直接读取）
+        // 记录路径只有原子加法，可在扫描线程与批量应用的工作线程上并发调用
+        // =============================================================================
+
+        class LatencyHistogram {
+        public:
+            LatencyHistogram();
+
+            void Record(std::chrono::microseconds value);
+            void Record(uint64_t microseconds);
+
+            uint64_t GetCount() const;
+            uint64_t GetSum() const;
+            uint64_t GetMax() const;
+            // 分位数（0~1），返回所在桶的上界（微秒）；没有样本时返回 0
+            uint64_t GetQuantile(double quantile) const;
+
+        private:
+            // 16 个线性桶 + 每个 2 的幂 8 个子桶
+            static const size_t LINEAR_BUCKETS = 16;
+            static const size_t SUB_BUCKETS = 8;
+            static const size_t BUCKET_COUNT = LINEAR_BUCKETS + (64 - 4) * SUB_BUCKETS;
+
+            static size_t BucketIndex(uint64_t value);
+            static uint64_t BucketUpperBound(size_t index);
+
+            std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets;
+            std::atomic<uint64_t> m_count;
+            std::atomic<uint64_t> m_sum;
+            std::atomic<uint64_t> m_max;
+        };
+
+        // 直方图的分位数摘要（微秒），可复制，用于报告
+        struct LatencySummary {
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t p50 = 0;
+            uint64_t p99 = 0;
+            uint64_t p999 = 0;
+            uint64_t max = 0;
+        };
+
+        LatencySummary SummarizeLatency(const LatencyHistogram& histogram);
+
+        struct ManagerMetrics {
+            // 延迟（微秒）
+            LatencyHistogram snapshotTime;          // 枚举一次进程快照
+            LatencyHistogram processQueryTime;      // 单个进程打开句柄 + 查询亲和性
+            LatencyHistogram applyTime;             // 单个进程写入亲和性
+            LatencyHistogram detectionLatency;      // 发现进程（事件送达或快照完成）到排除完成
+            LatencyHistogram passTime;              // 保护线程一轮处理
+
+            // 计数器
+            std::atomic<uint64_t> passes{0};
+            std::atomic<uint64_t> processesScanned{0};
+            std::atomic<uint64_t> exclusionsApplied{0};
+            std::atomic<uint64_t> exclusionsDenied{0};
+            std::atomic<uint64_t> exclusionsFailed{0};   // 进程已退出或其他错误
+        };
+
+        // 导出时附加的、不由 ManagerMetrics 记录的值（例如事件队列的丢弃数）
+        struct MetricsExtras {
+            uint64_t droppedEvents = 0;
+            uint64_t protectedCoreCount = 0;
+            double scanIntervalSeconds = 0.0;   // 保护线程当前的全量扫描间隔
+        };
+
+        // 格式化为 Prometheus 文本；直方图以 summary 形式导出（分位数 + _sum + _count）
+        std::string FormatPrometheusMetrics(const ManagerMetrics& metrics, const MetricsExtras& extras);
+
+        // 先写临时文件再重命名，采集方不会读到写了一半的文件
+        bool WriteMetricsFile(const std::string& path, const std::string& content);
+
+        // 当前进程累计消耗的 CPU 时间（用户态 + 内核态，秒）
+        double GetSelfCpuSeconds();
+
+        // 定期把指标写入文件
+        class MetricsFileExporter {
+        public:
+            using ContentProvider = std::function<std::string()>;
+
+            MetricsFileExporter();
+            ~MetricsFileExporter();
+
+            MetricsFileExporter(const MetricsFileExporter&) = delete;
+            MetricsFileExporter& operator=(const MetricsFileExporter&) = delete;
+
+            bool Start(const std::string& path, std::chrono::milliseconds interval, ContentProvider provider);
+            // 停止前再写一次，文件中保留最终值
+            void Stop();
+
+        private:
+            void ExportLoop();
+
+            std::string m_path;
+            std::chrono::milliseconds m_interval;
+            ContentProvider m_provider;
+
+            std::thread m_thread;
+            std::mutex m_mutex;
+            std::condition_variable m_wakeup;
+            bool m_running;
+        };
+    }
+}
@@ -0,0 +1,190 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include "CpuSet.h"
+#include "CpuTopology.h"
+#include "ProcessEvents.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 进程后端抽象：CpuCoreManager 通过它访问进程表与亲和性，不直接调用平台 API
+        // =============================================================================
+
+        // 进程快照中的一项
+        struct ProcessEntry {
+            DWORD processId = 0;
+            DWORD parentProcessId = 0;
+            uint64_t startTime = 0;     // 创建时间，与 PID 组合唯一标识一个进程实例（未知时为 0）
+            std::string name;           // UTF-8 进程名
+            bool isSystem = false;      // 系统伪进程或内核线程，亲和性不可修改
+        };
+
+        // 进程内的一个线程
+        struct ThreadEntry {
+            DWORD threadId = 0;
+            uint64_t cpuTime = 0;       // 累计 CPU 时间（用户态 + 内核态，100ns 单位）
+            std::string name;           // 线程名（Linux comm），取不到时为空
+        };
+
+        // 处理器信息
+        struct ProcessorInfo {
+            DWORD dwNumberOfProcessors = 0;     // 所有处理器组的逻辑处理器总数
+            CpuSet activeProcessors;            // 在线的逻辑处理器
+        };
+
+        // 单个逻辑处理器的累计时间（单位由平台决定，只用于计算比例）
+        struct CpuTimes {
+            uint64_t busy = 0;      // 非空闲时间
+            uint64_t total = 0;     // 总时间，为 0 表示该 CPU 无数据
+        };
+
+        // 进程调度设置，未设置的项保持进程原值
+        struct ProcessScheduling {
+            enum class Policy {
+                Unchanged,
+                Normal,         // SCHED_OTHER
+                Batch,          // SCHED_BATCH；Windows 为低于正常优先级
+                Idle,           // SCHED_IDLE；Windows 为空闲优先级
+                Fifo,           // SCHED_FIFO；Windows 为实时优先级类
+                RoundRobin      // SCHED_RR；Windows 为实时优先级类
+            };
+
+            enum class IoClass {
+                Unchanged,
+                RealTime,
+                BestEffort,
+                Idle
+            };
+
+            DWORD priorityClass = 0;        // Windows 优先级类，0 表示未设置；Linux 换算为 nice
+            bool hasNice = false;
+            int nice = 0;                   // -20 ~ 19，优先于 priorityClass；Windows 换算为优先级类
+            Policy policy = Policy::Unchanged;
+            int realtimePriority = 0;       // Fifo / RoundRobin 的优先级 1 ~ 99（仅 Linux）
+            IoClass ioClass = IoClass::Unchanged;
+            int ioLevel = 4;                // RealTime / BestEffort 的级别 0 ~ 7，0 最高
+
+            bool IsEmpty() const {
+                return priorityClass == 0 && !hasNice && policy == Policy::Unchanged && ioClass == IoClass::Unchanged;
+            }
+        };
+
+        // 进程内存的 NUMA 策略，节点由进程绑定的核心所在的 NUMA 节点推导
+        struct ProcessMemoryPolicy {
+            enum class Mode {
+                None,
+                Preferred,      // 优先在这些节点上分配，内存不足时使用其他节点
+                Bind            // 只在这些节点上分配
+            };
+
+            Mode mode = Mode::None;
+            bool migrate = false;           // 同时把已分配的页面迁移到这些节点
+
+            bool IsEmpty() const { return mode == Mode::None; }
+        };
+
+        // 打开进程时请求的访问权限
+        enum class ProcessAccess {
+            Query,          // 仅查询亲和性
+            QueryAndSet     // 查询并修改亲和性/优先级
+        };
+
+        // 平台原生进程句柄（Windows HANDLE / Linux pidfd），析构时关闭
+        // 析构函数由各平台后端实现
+        struct NativeProcessHandle {
+            explicit NativeProcessHandle(intptr_t nativeValue) : value(nativeValue) {}
+            ~NativeProcessHandle();
+
+            NativeProcessHandle(const NativeProcessHandle&) = delete;
+            NativeProcessHandle& operator=(const NativeProcessHandle&) = delete;
+
+            intptr_t value;
+        };
+
+        // 进程句柄，可复制，所有副本共享同一个原生句柄
+        class ProcessHandle {
+        public:
+            ProcessHandle() = default;
+            ProcessHandle(DWORD processId, uint64_t startTime, intptr_t nativeValue)
+                : m_processId(processId)
+                , m_startTime(startTime)
+                , m_native(std::make_shared<NativeProcessHandle>(nativeValue))
+            {
+            }
+
+            // 原生句柄为 -1 时仍为有效句柄（Linux 不支持 pidfd 时按 PID 访问）
+            bool IsValid() const { return m_native != nullptr; }
+            DWORD GetProcessId() const { return m_processId; }
+            uint64_t GetStartTime() const { return m_startTime; }
+            intptr_t GetNative() const { return m_native ? m_native->value : -1; }
+
+        private:
+            DWORD m_processId = 0;
+            uint64_t m_startTime = 0;
+            std::shared_ptr<NativeProcessHandle> m_native;
+        };
+
+        // 平台进程后端接口
+        class IProcessBackend {
+        public:
+            virtual ~IProcessBackend() = default;
+
+            // 枚举当前所有进程
+            virtual bool EnumerateProcesses(std::vector<ProcessEntry>& processes) = 0;
+
+            // 查询单个进程的快照信息（用于事件驱动路径，避免全量枚举）
+            virtual bool QueryProcess(DWORD processId, ProcessEntry& entry) = 0;
+
+            // 打开进程，失败时返回无效句柄，错误码可通过 GetLastError 获取
+            virtual ProcessHandle Open(DWORD processId, ProcessAccess access) = 0;
+
+            // 当前进程的句柄
+            virtual ProcessHandle OpenSelf() = 0;
+
+            // processSet 为进程当前亲和性，systemSet 为该进程可使用的全部处理器
+            virtual bool QueryAffinity(const ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet) = 0;
+            virtual bool ApplyAffinity(const ProcessHandle& handle, const CpuSet& affinity) = 0;
+            virtual bool SetPriority(const ProcessHandle& handle, DWORD priorityClass) = 0;
+            // 应用调度策略、nice/优先级类与 I/O 优先级（Linux 逐线程设置）；
+            // 只写入与当前值不同的项，changed 表示是否实际修改
+            virtual bool ApplyScheduling(const ProcessHandle& handle, const ProcessScheduling& scheduling, bool& changed) = 0;
+            // 按内存策略把进程内存限定到 nodes（NUMA 节点编号的集合）；migrate 时迁移已有页面
+            // Linux 只能设置调用线程（及其之后创建的线程）的分配策略；其他进程只迁移已有页面，
+            // 没有 migrate 时返回失败（ENOTSUP）
+            virtual bool ApplyMemoryPolicy(const ProcessHandle& handle, const ProcessMemoryPolicy& policy, const CpuSet& nodes) = 0;
+            // 统计进程常驻内存在各 NUMA 节点上的大小（KB），下标为节点编号
+            virtual bool QueryMemoryNodes(DWORD processId, std::vector<uint64_t>& kilobytesPerNode) = 0;
+
+            // 枚举进程的全部线程及其累计 CPU 时间
+            virtual bool EnumerateThreads(DWORD processId, std::vector<ThreadEntry>& threads) = 0;
+            // 线程级亲和性（Linux 按 TID，Windows 按线程 ID）；Windows 下线程亲和性必须是进程亲和性的子集
+            virtual bool QueryThreadAffinity(DWORD threadId, CpuSet& affinity) = 0;
+            virtual bool ApplyThreadAffinity(DWORD threadId, const CpuSet& affinity) = 0;
+
+            virtual DWORD GetCurrentPid() = 0;
+            virtual ProcessorInfo GetProcessorInfo() = 0;
+            virtual CpuTopology GetCpuTopology() = 0;
+            // 读取各逻辑处理器的累计忙碌/总时间，下标为 CPU 编号
+            virtual bool QueryCpuTimes(std::vector<CpuTimes>& times) = 0;
+
+            // 创建进程事件源，平台不支持时返回 nullptr
+            virtual std::unique_ptr<IProcessEventSource> CreateEventSource() = 0;
+        };
+
+        // 查询处理器数量与活动处理器掩码
+        ProcessorInfo QueryProcessorInfo();
+
+        // 创建当前平台的后端（Windows: Toolhelp32，Linux: /proc + sched_setaffinity + pidfd）
+        std::unique_ptr<IProcessBackend> CreatePlatformBackend();
+
+        // 把 RLIMIT_NOFILE 软上限提升到硬上限（Linux 后端为每个已知进程持有一个 pidfd）
+        // 影响整个进程，只由独立运行的程序在入口调用；不调用时超出上限的进程退化为按 PID 访问
+        bool RaiseFileDescriptorLimit();
+    }
+}
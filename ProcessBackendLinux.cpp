@@ -0,0 +1,1026 @@
+﻿#include "pch.h"
+#include "ProcessBackend.h"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+#ifndef SCHED_RESET_ON_FORK
+#define SCHED_RESET_ON_FORK 0x40000000
+#endif
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#define MPOL_BIND 2
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // Linux 后端：/proc 枚举 + sched_getaffinity/sched_setaffinity + pidfd
+        //
+        // 每个已知进程持有一个 pidfd，稳态扫描只需要：
+        //   getdents64 读取 /proc 目录（少量系统调用）
+        //   一次 poll 检查所有 pidfd，找出已退出的进程
+        //   仅对新出现的 PID 执行 pidfd_open 并读取 /proc/<pid>/stat
+        // 修改前用 pidfd 确认目标进程仍然存活，避免修改复用了该 PID 的新进程；检查与写入之间
+        // 仍有极短的窗口（进程恰好退出且 PID 立即被复用），写入后再检查一次，把期间退出的进程报告为已退出
+        // 亲和性是线程属性：进程级的查询与修改遍历 /proc/<pid>/task 中的全部线程
+        // =============================================================================
+
+        NativeProcessHandle::~NativeProcessHandle() {
+            if (value >= 0) {
+                close(static_cast<int>(value));
+            }
+        }
+
+        namespace {
+
+            const unsigned int PF_KTHREAD_FLAG = 0x00200000;
+
+            struct LinuxDirent64 {
+                uint64_t d_ino;
+                int64_t d_off;
+                unsigned short d_reclen;
+                unsigned char d_type;
+                char d_name[1];
+            };
+
+            int PidfdOpen(DWORD processId) {
+                return static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(processId), 0));
+            }
+
+            // 通过 pidfd 判断进程是否仍存活（僵尸进程也视为存活，其 PID 尚未被回收）
+            bool IsPidfdAlive(int pidfd) {
+                if (pidfd < 0) {
+                    return true;
+                }
+                if (syscall(SYS_pidfd_send_signal, pidfd, 0, nullptr, 0) == 0) {
+                    return true;
+                }
+                return errno != ESRCH;
+            }
+
+            // 读取 /proc 下的小文件，返回读取的字节数，失败返回 -1
+            ssize_t ReadProcFile(int dirFd, const char* path, char* buffer, size_t bufferSize) {
+                int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return -1;
+                }
+                ssize_t length = read(fd, buffer, bufferSize - 1);
+                close(fd);
+                if (length >= 0) {
+                    buffer[length] = '\0';
+                }
+                return length;
+            }
+
+            // 解析 stat 内容：pid (comm) state 字段...，values[i] 对应第 i + 3 个字段
+            // 进程名可能包含空格和括号，以最后一个 ')' 为界
+            bool ParseStat(char* buffer, std::string& name, char& state, unsigned long long* values, int count) {
+                char* nameBegin = strchr(buffer, '(');
+                char* nameEnd = strrchr(buffer, ')');
+                if (nameBegin == nullptr || nameEnd == nullptr || nameEnd < nameBegin || nameEnd[1] == '\0') {
+                    return false;
+                }
+
+                char* fields = nameEnd + 2;
+                state = fields[0];
+
+                std::fill(values, values + count, 0ULL);
+                char* cursor = fields + 1;
+                for (int i = 1; i < count && *cursor != '\0'; i++) {
+                    values[i] = strtoull(cursor, &cursor, 10);
+                }
+
+                name.assign(nameBegin + 1, nameEnd);
+                return true;
+            }
+
+            // 节点编号集合转为 set_mempolicy / migrate_pages 使用的位图，位数为 bitCount 向上取整到整字
+            std::vector<unsigned long> ToNodeMask(const CpuSet& nodes, size_t bitCount) {
+                const size_t BITS = sizeof(unsigned long) * 8;
+                std::vector<unsigned long> mask((bitCount + BITS - 1) / BITS, 0);
+                for (size_t node = nodes.First(); node != CpuSet::npos; node = nodes.Next(node)) {
+                    mask[node / BITS] |= 1UL << (node % BITS);
+                }
+                return mask;
+            }
+
+            // 内核按 maxnode - 1 位读取节点位图
+            unsigned long NodeMaskBits(const std::vector<unsigned long>& mask) {
+                return static_cast<unsigned long>(mask.size() * sizeof(unsigned long) * 8 + 1);
+            }
+
+            // 读取 sysfs 中 "0-3,8" 格式的 CPU 列表
+            bool ReadSysfsCpuList(const std::string& path, CpuSet& cpus) {
+                char buffer[4096];
+                return ReadProcFile(AT_FDCWD, path.c_str(), buffer, sizeof(buffer)) > 0 &&
+                    CpuSet::Parse(buffer, cpus) && !cpus.Empty();
+            }
+
+            // sched_getaffinity/sched_setaffinity 使用的 CPU 位数：至少 CPU_SETSIZE，
+            // 超过 1024 个逻辑处理器的机器按实际数量动态分配
+            size_t AffinityCpuCount() {
+                long configured = sysconf(_SC_NPROCESSORS_CONF);
+                return configured > CPU_SETSIZE ? static_cast<size_t>(configured) : static_cast<size_t>(CPU_SETSIZE);
+            }
+
+            // 动态大小的 cpu_set_t
+            class DynamicCpuSet {
+            public:
+                explicit DynamicCpuSet(size_t cpuCount)
+                    : m_cpuCount(cpuCount)
+                    , m_size(CPU_ALLOC_SIZE(cpuCount))
+                    , m_set(CPU_ALLOC(cpuCount))
+                {
+                    if (m_set != nullptr) {
+                        CPU_ZERO_S(m_size, m_set);
+                    }
+                }
+
+                ~DynamicCpuSet() {
+                    if (m_set != nullptr) {
+                        CPU_FREE(m_set);
+                    }
+                }
+
+                DynamicCpuSet(const DynamicCpuSet&) = delete;
+                DynamicCpuSet& operator=(const DynamicCpuSet&) = delete;
+
+                bool IsValid() const { return m_set != nullptr; }
+                size_t Size() const { return m_size; }
+                cpu_set_t* Get() { return m_set; }
+
+                void Clear() {
+                    CPU_ZERO_S(m_size, m_set);
+                }
+
+                bool Equals(const DynamicCpuSet& other) const {
+                    return m_size == other.m_size && memcmp(m_set, other.m_set, m_size) == 0;
+                }
+
+                void Assign(const CpuSet& cpus) {
+                    for (size_t cpu = cpus.First(); cpu != CpuSet::npos && cpu < m_cpuCount; cpu = cpus.Next(cpu)) {
+                        CPU_SET_S(cpu, m_size, m_set);
+                    }
+                }
+
+                CpuSet ToCpuSet() const {
+                    CpuSet result;
+                    for (size_t cpu = 0; cpu < m_cpuCount; cpu++) {
+                        if (CPU_ISSET_S(cpu, m_size, m_set)) {
+                            result.Set(cpu);
+                        }
+                    }
+                    return result;
+                }
+
+            private:
+                size_t m_cpuCount;
+                size_t m_size;
+                cpu_set_t* m_set;
+            };
+
+            // 优先级类别到 nice 值的映射
+            int PriorityClassToNice(DWORD priorityClass) {
+                switch (priorityClass) {
+                case IDLE_PRIORITY_CLASS:         return 19;
+                case BELOW_NORMAL_PRIORITY_CLASS: return 10;
+                case ABOVE_NORMAL_PRIORITY_CLASS: return -5;
+                case HIGH_PRIORITY_CLASS:         return -10;
+                case REALTIME_PRIORITY_CLASS:     return -20;
+                default:                          return 0;
+                }
+            }
+
+            // glibc 没有 ioprio 的封装与常量，取自 linux/ioprio.h
+            const int IOPRIO_CLASS_SHIFT = 13;
+            const int IOPRIO_WHO_PROCESS = 1;
+
+            int ToLinuxPolicy(ProcessScheduling::Policy policy) {
+                switch (policy) {
+                case ProcessScheduling::Policy::Batch:      return SCHED_BATCH;
+                case ProcessScheduling::Policy::Idle:       return SCHED_IDLE;
+                case ProcessScheduling::Policy::Fifo:       return SCHED_FIFO;
+                case ProcessScheduling::Policy::RoundRobin: return SCHED_RR;
+                default:                                    return SCHED_OTHER;
+                }
+            }
+
+            int ToIoPriority(const ProcessScheduling& scheduling) {
+                switch (scheduling.ioClass) {
+                case ProcessScheduling::IoClass::RealTime:   return (1 << IOPRIO_CLASS_SHIFT) | scheduling.ioLevel;
+                case ProcessScheduling::IoClass::BestEffort: return (2 << IOPRIO_CLASS_SHIFT) | scheduling.ioLevel;
+                default:                                     return 3 << IOPRIO_CLASS_SHIFT;
+                }
+            }
+
+            // 调度策略、nice 与 I/O 优先级在 Linux 上都属于线程属性，逐个线程比较后写入
+            bool ApplyThreadScheduling(pid_t threadId, const ProcessScheduling& scheduling, bool& changed) {
+                if (scheduling.policy != ProcessScheduling::Policy::Unchanged) {
+                    int policy = ToLinuxPolicy(scheduling.policy);
+                    bool realtime = policy == SCHED_FIFO || policy == SCHED_RR;
+                    sched_param param;
+                    int current = sched_getscheduler(threadId);
+                    if (current < 0 || sched_getparam(threadId, &param) != 0) {
+                        return false;
+                    }
+                    int priority = realtime ? scheduling.realtimePriority : 0;
+                    if ((current & ~SCHED_RESET_ON_FORK) != policy || param.sched_priority != priority) {
+                        param.sched_priority = priority;
+                        if (sched_setscheduler(threadId, policy, &param) != 0) {
+                            return false;
+                        }
+                        changed = true;
+                    }
+                }
+
+                if (scheduling.hasNice || scheduling.priorityClass != 0) {
+                    int nice = scheduling.hasNice ? scheduling.nice : PriorityClassToNice(scheduling.priorityClass);
+                    // getpriority 可以合法地返回 -1，只能通过 errno 判断失败
+                    errno = 0;
+                    int current = getpriority(PRIO_PROCESS, static_cast<id_t>(threadId));
+                    if (errno != 0) {
+                        return false;
+                    }
+                    if (current != nice) {
+                        if (setpriority(PRIO_PROCESS, static_cast<id_t>(threadId), nice) != 0) {
+                            return false;
+                        }
+                        changed = true;
+                    }
+                }
+
+                if (scheduling.ioClass != ProcessScheduling::IoClass::Unchanged) {
+                    int priority = ToIoPriority(scheduling);
+                    long current = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, threadId);
+                    if (current < 0) {
+                        return false;
+                    }
+                    // 空闲类没有级别，只比较类别
+                    bool same = scheduling.ioClass == ProcessScheduling::IoClass::Idle
+                        ? (current >> IOPRIO_CLASS_SHIFT) == 3
+                        : current == priority;
+                    if (!same) {
+                        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, threadId, priority) != 0) {
+                            return false;
+                        }
+                        changed = true;
+                    }
+                }
+                return true;
+            }
+
+            class LinuxProcessBackend : public IProcessBackend {
+            public:
+                LinuxProcessBackend()
+                    : m_procFd(open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+                    , m_direntBuffer(256 * 1024)
+                    , m_generation(0)
+                    , m_affinityCpuCount(AffinityCpuCount())
+                    , m_processorInfo(QueryProcessorInfo())
+                    , m_ticksTo100ns(10000000 / static_cast<uint64_t>(sysconf(_SC_CLK_TCK) > 0 ? sysconf(_SC_CLK_TCK) : 100))
+                {
+                    int probeFd = PidfdOpen(static_cast<DWORD>(getpid()));
+                    m_pidfdSupported = probeFd >= 0;
+                    if (probeFd >= 0) {
+                        close(probeFd);
+                    }
+                }
+
+                ~LinuxProcessBackend() override {
+                    if (m_procFd >= 0) {
+                        close(m_procFd);
+                    }
+                }
+
+                bool EnumerateProcesses(std::vector<ProcessEntry>& processes) override {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    processes.clear();
+
+                    if (!ReadProcPids()) {
+                        return false;
+                    }
+
+                    DropExitedProcesses();
+
+                    m_generation++;
+                    processes.reserve(m_pids.size());
+
+                    for (DWORD processId : m_pids) {
+                        auto it = m_tracked.find(processId);
+                        if (it == m_tracked.end() || it->second.handle.GetNative() < 0) {
+                            TrackedProcess tracked;
+                            if (!TrackProcess(processId, tracked)) {
+                                continue;
+                            }
+                            it = m_tracked.insert_or_assign(processId, std::move(tracked)).first;
+                        }
+
+                        it->second.generation = m_generation;
+                        processes.push_back(it->second.entry);
+                    }
+
+                    // 清理 /proc 中已经消失的条目
+                    for (auto it = m_tracked.begin(); it != m_tracked.end();) {
+                        if (it->second.generation != m_generation) {
+                            it = m_tracked.erase(it);
+                        }
+                        else {
+                            ++it;
+                        }
+                    }
+
+                    return true;
+                }
+
+                bool QueryProcess(DWORD processId, ProcessEntry& entry) override {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    // exec 会改变进程名，已跟踪的进程也重新读取 stat；创建时间不同说明 PID 已被复用
+                    auto it = m_tracked.find(processId);
+                    if (it != m_tracked.end()) {
+                        ProcessEntry current;
+                        if (!ReadProcessStat(processId, current)) {
+                            m_tracked.erase(it);
+                            return false;
+                        }
+                        if (current.startTime == it->second.entry.startTime) {
+                            it->second.entry = current;
+                            entry = current;
+                            return true;
+                        }
+                    }
+
+                    TrackedProcess tracked;
+                    if (!TrackProcess(processId, tracked)) {
+                        m_tracked.erase(processId);
+                        return false;
+                    }
+                    tracked.generation = m_generation;
+                    entry = tracked.entry;
+                    m_tracked.insert_or_assign(processId, std::move(tracked));
+                    return true;
+                }
+
+                ProcessHandle Open(DWORD processId, ProcessAccess) override {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    // 已跟踪的进程在每次枚举时都经过 pidfd 校验，直接复用
+                    auto it = m_tracked.find(processId);
+                    if (it != m_tracked.end()) {
+                        return it->second.handle;
+                    }
+
+                    TrackedProcess tracked;
+                    if (!TrackProcess(processId, tracked)) {
+                        return ProcessHandle();
+                    }
+
+                    tracked.generation = m_generation;
+                    ProcessHandle handle = tracked.handle;
+                    m_tracked.insert_or_assign(processId, std::move(tracked));
+                    return handle;
+                }
+
+                ProcessHandle OpenSelf() override {
+                    return ProcessHandle(static_cast<DWORD>(getpid()), 0, -1);
+                }
+
+                // 返回全部线程亲和性的并集：只有部分线程排除了保留核心时，进程仍被视为使用保留核心
+                bool QueryAffinity(const ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet) override {
+                    DynamicCpuSet mainSet(m_affinityCpuCount);
+                    DynamicCpuSet threadSet(m_affinityCpuCount);
+                    if (!mainSet.IsValid() || !threadSet.IsValid()) {
+                        errno = ENOMEM;
+                        return false;
+                    }
+                    pid_t processId = static_cast<pid_t>(handle.GetProcessId());
+                    if (sched_getaffinity(processId, mainSet.Size(), mainSet.Get()) != 0) {
+                        return false;
+                    }
+                    processSet = mainSet.ToCpuSet();
+
+                    // 线程通常与主线程相同，只转换不同的掩码；枚举后退出的线程跳过
+                    std::vector<DWORD> threadIds;
+                    if (ListThreads(handle.GetProcessId(), threadIds)) {
+                        for (DWORD threadId : threadIds) {
+                            if (static_cast<pid_t>(threadId) == processId) {
+                                continue;
+                            }
+                            threadSet.Clear();
+                            if (sched_getaffinity(static_cast<pid_t>(threadId), threadSet.Size(), threadSet.Get()) == 0 &&
+                                !threadSet.Equals(mainSet)) {
+                                processSet |= threadSet.ToCpuSet();
+                            }
+                        }
+                    }
+
+                    systemSet = m_processorInfo.activeProcessors;
+                    return true;
+                }
+
+                // 先写主线程（其错误码即进程的错误码），再逐个写入其余线程；写入期间未修改的线程
+                // 可能创建继承旧亲和性的新线程，因此再枚举一次补上新出现的线程
+                bool ApplyAffinity(const ProcessHandle& handle, const CpuSet& affinity) override {
+                    DynamicCpuSet cpuSet(m_affinityCpuCount);
+                    if (!cpuSet.IsValid()) {
+                        errno = ENOMEM;
+                        return false;
+                    }
+                    cpuSet.Assign(affinity);
+
+                    int pidfd = static_cast<int>(handle.GetNative());
+                    if (!IsPidfdAlive(pidfd)) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    pid_t processId = static_cast<pid_t>(handle.GetProcessId());
+                    if (sched_setaffinity(processId, cpuSet.Size(), cpuSet.Get()) != 0) {
+                        return false;
+                    }
+
+                    std::vector<DWORD> applied(1, handle.GetProcessId());
+                    std::vector<DWORD> threadIds;
+                    int firstError = 0;
+                    for (int pass = 0; pass < 2 && ListThreads(handle.GetProcessId(), threadIds); pass++) {
+                        std::sort(threadIds.begin(), threadIds.end());
+                        bool found = false;
+                        for (DWORD threadId : threadIds) {
+                            if (std::binary_search(applied.begin(), applied.end(), threadId)) {
+                                continue;
+                            }
+                            found = true;
+                            // 线程在枚举后退出不算失败
+                            if (sched_setaffinity(static_cast<pid_t>(threadId), cpuSet.Size(), cpuSet.Get()) != 0 &&
+                                errno != ESRCH && firstError == 0) {
+                                firstError = errno;
+                            }
+                        }
+                        if (!found) {
+                            break;
+                        }
+                        std::vector<DWORD> merged;
+                        std::merge(applied.begin(), applied.end(), threadIds.begin(), threadIds.end(), std::back_inserter(merged));
+                        merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+                        applied.swap(merged);
+                    }
+
+                    // 写入期间退出的进程报告为已退出
+                    if (!IsPidfdAlive(pidfd)) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    if (firstError != 0) {
+                        errno = firstError;
+                        return false;
+                    }
+                    return true;
+                }
+
+                bool SetPriority(const ProcessHandle& handle, DWORD priorityClass) override {
+                    if (!IsPidfdAlive(static_cast<int>(handle.GetNative()))) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    if (setpriority(PRIO_PROCESS, static_cast<id_t>(handle.GetProcessId()), PriorityClassToNice(priorityClass)) != 0) {
+                        return false;
+                    }
+
+                    if (!IsPidfdAlive(static_cast<int>(handle.GetNative()))) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    return true;
+                }
+
+                // 之后创建的线程继承创建者的设置，因此只需处理当前已有的线程
+                bool ApplyScheduling(const ProcessHandle& handle, const ProcessScheduling& scheduling, bool& changed) override {
+                    changed = false;
+
+                    std::vector<DWORD> threadIds;
+                    if (!IsPidfdAlive(static_cast<int>(handle.GetNative()))) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    if (!ListThreads(handle.GetProcessId(), threadIds)) {
+                        return false;
+                    }
+
+                    int firstError = 0;
+                    for (DWORD threadId : threadIds) {
+                        // 线程在枚举后退出不算失败
+                        if (!ApplyThreadScheduling(static_cast<pid_t>(threadId), scheduling, changed) &&
+                            errno != ESRCH && firstError == 0) {
+                            firstError = errno;
+                        }
+                    }
+
+                    if (!IsPidfdAlive(static_cast<int>(handle.GetNative()))) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    if (firstError != 0) {
+                        errno = firstError;
+                        return false;
+                    }
+                    return true;
+                }
+
+                // 当前进程：set_mempolicy 只设置调用线程及其之后创建的线程的分配策略，其他已有线程保持原策略
+                // 其他进程：内核不提供修改分配策略的接口，只能迁移已有页面；没有 migrate 时什么都不会发生，返回 ENOTSUP
+                bool ApplyMemoryPolicy(const ProcessHandle& handle, const ProcessMemoryPolicy& policy, const CpuSet& nodes) override {
+                    if (policy.IsEmpty()) {
+                        return true;
+                    }
+                    if (nodes.Empty()) {
+                        errno = EINVAL;
+                        return false;
+                    }
+
+                    pid_t processId = static_cast<pid_t>(handle.GetProcessId());
+                    if (processId == getpid()) {
+                        // MPOL_PREFERRED 只接受一个节点，取编号最小的
+                        CpuSet target = policy.mode == ProcessMemoryPolicy::Mode::Bind ? nodes : CpuSet::Single(nodes.First());
+                        std::vector<unsigned long> mask = ToNodeMask(target, target.Last() + 1);
+                        int mode = policy.mode == ProcessMemoryPolicy::Mode::Bind ? MPOL_BIND : MPOL_PREFERRED;
+                        if (syscall(SYS_set_mempolicy, mode, mask.data(), NodeMaskBits(mask)) != 0) {
+                            return false;
+                        }
+                    }
+                    else if (!policy.migrate) {
+                        errno = ENOTSUP;
+                        return false;
+                    }
+
+                    if (policy.migrate) {
+                        CpuSet sourceNodes;
+                        if (ReadSysfsCpuList("/sys/devices/system/node/online", sourceNodes)) {
+                            sourceNodes.AndNot(nodes);
+                        }
+                        if (!sourceNodes.Empty()) {
+                            size_t bitCount = std::max(sourceNodes.Last(), nodes.Last()) + 1;
+                            std::vector<unsigned long> oldMask = ToNodeMask(sourceNodes, bitCount);
+                            std::vector<unsigned long> newMask = ToNodeMask(nodes, bitCount);
+                            // 返回值为无法迁移的页数（被锁定或与其他进程共享的页），不视为失败
+                            if (syscall(SYS_migrate_pages, processId, NodeMaskBits(oldMask), oldMask.data(), newMask.data()) < 0) {
+                                return false;
+                            }
+                        }
+                    }
+
+                    if (!IsPidfdAlive(static_cast<int>(handle.GetNative()))) {
+                        errno = ESRCH;
+                        return false;
+                    }
+                    return true;
+                }
+
+                // /proc/<pid>/numa_maps 每行一个映射区，N<节点>=<页数> 与 kernelpagesize_kB=<页大小>
+                bool QueryMemoryNodes(DWORD processId, std::vector<uint64_t>& kilobytesPerNode) override {
+                    kilobytesPerNode.clear();
+
+                    char path[48];
+                    snprintf(path, sizeof(path), "%u/numa_maps", processId);
+                    int fd = openat(m_procFd, path, O_RDONLY | O_CLOEXEC);
+                    if (fd < 0) {
+                        return false;
+                    }
+                    std::string content;
+                    char buffer[16384];
+                    ssize_t length = 0;
+                    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                        content.append(buffer, static_cast<size_t>(length));
+                    }
+                    close(fd);
+                    if (length < 0) {
+                        return false;
+                    }
+
+                    std::vector<std::pair<size_t, uint64_t>> linePages;
+                    size_t lineBegin = 0;
+                    while (lineBegin < content.size()) {
+                        size_t lineEnd = content.find('\n', lineBegin);
+                        if (lineEnd == std::string::npos) {
+                            lineEnd = content.size();
+                        }
+
+                        linePages.clear();
+                        uint64_t pageKilobytes = 4;
+                        size_t tokenBegin = lineBegin;
+                        while (tokenBegin < lineEnd) {
+                            size_t tokenEnd = content.find(' ', tokenBegin);
+                            if (tokenEnd == std::string::npos || tokenEnd > lineEnd) {
+                                tokenEnd = lineEnd;
+                            }
+                            const char* token = content.c_str() + tokenBegin;
+                            char* end = nullptr;
+                            if (token[0] == 'N' && token[1] >= '0' && token[1] <= '9') {
+                                unsigned long node = strtoul(token + 1, &end, 10);
+                                if (*end == '=') {
+                                    linePages.emplace_back(node, strtoull(end + 1, nullptr, 10));
+                                }
+                            }
+                            else if (strncmp(token, "kernelpagesize_kB=", 18) == 0) {
+                                pageKilobytes = strtoull(token + 18, nullptr, 10);
+                            }
+                            tokenBegin = tokenEnd + 1;
+                        }
+
+                        for (const auto& pages : linePages) {
+                            if (pages.first >= kilobytesPerNode.size()) {
+                                kilobytesPerNode.resize(pages.first + 1, 0);
+                            }
+                            kilobytesPerNode[pages.first] += pages.second * pageKilobytes;
+                        }
+                        lineBegin = lineEnd + 1;
+                    }
+                    return true;
+                }
+
+                // 读取 /proc/<pid>/task 下每个线程的 stat：utime(14)、stime(15)
+                bool EnumerateThreads(DWORD processId, std::vector<ThreadEntry>& threads) override {
+                    threads.clear();
+
+                    std::vector<DWORD> threadIds;
+                    if (!ListThreads(processId, threadIds)) {
+                        return false;
+                    }
+
+                    char path[48];
+                    char buffer[1024];
+                    unsigned long long values[13];
+                    for (DWORD threadId : threadIds) {
+                        snprintf(path, sizeof(path), "%u/task/%u/stat", processId, threadId);
+                        if (ReadProcFile(m_procFd, path, buffer, sizeof(buffer)) <= 0) {
+                            continue;   // 线程已退出
+                        }
+
+                        ThreadEntry entry;
+                        char state = 0;
+                        if (!ParseStat(buffer, entry.name, state, values, 13)) {
+                            continue;
+                        }
+                        entry.threadId = threadId;
+                        entry.cpuTime = (values[11] + values[12]) * m_ticksTo100ns;
+                        threads.push_back(std::move(entry));
+                    }
+                    return !threads.empty();
+                }
+
+                bool QueryThreadAffinity(DWORD threadId, CpuSet& affinity) override {
+                    DynamicCpuSet cpuSet(m_affinityCpuCount);
+                    if (!cpuSet.IsValid()) {
+                        errno = ENOMEM;
+                        return false;
+                    }
+                    if (sched_getaffinity(static_cast<pid_t>(threadId), cpuSet.Size(), cpuSet.Get()) != 0) {
+                        return false;
+                    }
+
+                    affinity = cpuSet.ToCpuSet();
+                    return true;
+                }
+
+                // sched_setaffinity 作用于单个 TID；线程 ID 复用窗口极短，这里不做 pidfd 校验
+                bool ApplyThreadAffinity(DWORD threadId, const CpuSet& affinity) override {
+                    DynamicCpuSet cpuSet(m_affinityCpuCount);
+                    if (!cpuSet.IsValid()) {
+                        errno = ENOMEM;
+                        return false;
+                    }
+                    cpuSet.Assign(affinity);
+
+                    return sched_setaffinity(static_cast<pid_t>(threadId), cpuSet.Size(), cpuSet.Get()) == 0;
+                }
+
+                DWORD GetCurrentPid() override {
+                    return static_cast<DWORD>(getpid());
+                }
+
+                ProcessorInfo GetProcessorInfo() override {
+                    return m_processorInfo;
+                }
+
+                CpuTopology GetCpuTopology() override {
+                    return QueryCpuTopology();
+                }
+
+                // /proc/stat 的 cpuN 行：user nice system idle iowait irq softirq steal ...
+                // idle 与 iowait 计为空闲；guest 时间已包含在 user/nice 中，不重复累加
+                bool QueryCpuTimes(std::vector<CpuTimes>& times) override {
+                    // cpu 行位于文件开头，只读取足够容纳这些行的长度
+                    std::vector<char> buffer((m_affinityCpuCount + 1) * 128 + 4096);
+                    ssize_t length = ReadProcFile(m_procFd, "stat", buffer.data(), buffer.size());
+                    if (length <= 0) {
+                        return false;
+                    }
+
+                    times.clear();
+                    const char* line = buffer.data();
+                    const char* end = buffer.data() + length;
+                    while (line < end && strncmp(line, "cpu", 3) == 0) {
+                        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+                        if (lineEnd == nullptr) {
+                            break;
+                        }
+
+                        if (line[3] >= '0' && line[3] <= '9') {
+                            char* cursor = nullptr;
+                            unsigned long cpu = strtoul(line + 3, &cursor, 10);
+                            unsigned long long values[8] = {};
+                            for (int i = 0; i < 8 && cursor < lineEnd; i++) {
+                                values[i] = strtoull(cursor, &cursor, 10);
+                            }
+
+                            if (cpu >= times.size()) {
+                                times.resize(cpu + 1);
+                            }
+                            uint64_t idle = values[3] + values[4];
+                            uint64_t total = 0;
+                            for (unsigned long long value : values) {
+                                total += value;
+                            }
+                            times[cpu].total = total;
+                            times[cpu].busy = total - idle;
+                        }
+                        line = lineEnd + 1;
+                    }
+                    return !times.empty();
+                }
+
+                std::unique_ptr<IProcessEventSource> CreateEventSource() override {
+                    return CreatePlatformEventSource();
+                }
+
+            private:
+                struct TrackedProcess {
+                    ProcessEntry entry;
+                    ProcessHandle handle;
+                    uint64_t generation = 0;
+                };
+
+                // 通过 getdents64 读取 /proc 下所有数字目录
+                bool ReadProcPids() {
+                    m_pids.clear();
+                    if (m_procFd < 0 || lseek(m_procFd, 0, SEEK_SET) < 0) {
+                        return false;
+                    }
+
+                    return ReadNumericEntries(m_procFd, m_pids, m_direntBuffer.data(), m_direntBuffer.size());
+                }
+
+                // 读取 /proc/<pid>/task 中的线程 ID，进程已退出时返回 false
+                bool ListThreads(DWORD processId, std::vector<DWORD>& threadIds) {
+                    threadIds.clear();
+                    char path[48];
+                    snprintf(path, sizeof(path), "%u/task", processId);
+                    int taskFd = openat(m_procFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                    if (taskFd < 0) {
+                        return false;
+                    }
+                    bool listed = ReadNumericEntries(taskFd, threadIds);
+                    close(taskFd);
+                    return listed;
+                }
+
+                // 读取目录中全部数字名称的条目（/proc 与 /proc/<pid>/task）
+                static bool ReadNumericEntries(int dirFd, std::vector<DWORD>& ids) {
+                    alignas(LinuxDirent64) char direntBuffer[16 * 1024];
+                    return ReadNumericEntries(dirFd, ids, direntBuffer, sizeof(direntBuffer));
+                }
+
+                static bool ReadNumericEntries(int dirFd, std::vector<DWORD>& ids, char* direntBuffer, size_t bufferSize) {
+                    for (;;) {
+                        long bytes = syscall(SYS_getdents64, dirFd, direntBuffer, bufferSize);
+                        if (bytes < 0) {
+                            return false;
+                        }
+                        if (bytes == 0) {
+                            break;
+                        }
+
+                        for (long offset = 0; offset < bytes;) {
+                            const LinuxDirent64* dirent = reinterpret_cast<const LinuxDirent64*>(direntBuffer + offset);
+                            offset += dirent->d_reclen;
+
+                            const char* name = dirent->d_name;
+                            if (*name < '0' || *name > '9') {
+                                continue;
+                            }
+
+                            DWORD id = 0;
+                            for (; *name >= '0' && *name <= '9'; name++) {
+                                id = id * 10 + static_cast<DWORD>(*name - '0');
+                            }
+                            if (*name == '\0') {
+                                ids.push_back(id);
+                            }
+                        }
+                    }
+                    return true;
+                }
+
+                // 一次 poll 检查全部 pidfd，可读表示进程已退出
+                void DropExitedProcesses() {
+                    m_pollFds.clear();
+                    m_pollPids.clear();
+                    for (const auto& pair : m_tracked) {
+                        int pidfd = static_cast<int>(pair.second.handle.GetNative());
+                        if (pidfd >= 0) {
+                            m_pollFds.push_back({ pidfd, POLLIN, 0 });
+                            m_pollPids.push_back(pair.first);
+                        }
+                    }
+
+                    if (m_pollFds.empty() || poll(m_pollFds.data(), m_pollFds.size(), 0) <= 0) {
+                        return;
+                    }
+
+                    for (size_t i = 0; i < m_pollFds.size(); i++) {
+                        if (m_pollFds[i].revents != 0) {
+                            m_tracked.erase(m_pollPids[i]);
+                        }
+                    }
+                }
+
+                // 为新 PID 打开 pidfd 并读取 /proc/<pid>/stat；僵尸进程与已退出进程返回 false
+                // 先打开 pidfd 再读 stat，保证两者指向同一个进程实例
+                bool TrackProcess(DWORD processId, TrackedProcess& tracked) {
+                    int pidfd = -1;
+                    if (m_pidfdSupported) {
+                        pidfd = PidfdOpen(processId);
+                        if (pidfd < 0 && errno == ESRCH) {
+                            return false;
+                        }
+                    }
+
+                    if (!ReadProcessStat(processId, tracked.entry)) {
+                        if (pidfd >= 0) {
+                            close(pidfd);
+                        }
+                        return false;
+                    }
+
+                    tracked.handle = ProcessHandle(processId, tracked.entry.startTime, pidfd);
+                    return true;
+                }
+
+                // 格式: pid (comm) state ppid ... flags(9) ... starttime(22)
+                bool ReadProcessStat(DWORD processId, ProcessEntry& entry) {
+                    char path[32];
+                    char buffer[1024];
+                    snprintf(path, sizeof(path), "%u/stat", processId);
+                    if (ReadProcFile(m_procFd, path, buffer, sizeof(buffer)) <= 0) {
+                        return false;
+                    }
+
+                    // values[i] 对应 stat 第 i + 3 个字段
+                    unsigned long long values[20];
+                    char state = 0;
+                    if (!ParseStat(buffer, entry.name, state, values, 20) || state == 'Z' || state == 'X') {
+                        return false;
+                    }
+
+                    entry.processId = processId;
+                    entry.parentProcessId = static_cast<DWORD>(values[1]);
+                    entry.startTime = values[19];
+                    entry.isSystem = (values[6] & PF_KTHREAD_FLAG) != 0 || processId == 2;
+                    return true;
+                }
+
+                std::mutex m_mutex;
+                int m_procFd;
+                bool m_pidfdSupported;
+                std::vector<char> m_direntBuffer;
+                std::vector<DWORD> m_pids;
+                std::vector<pollfd> m_pollFds;
+                std::vector<DWORD> m_pollPids;
+                std::unordered_map<DWORD, TrackedProcess> m_tracked;
+                uint64_t m_generation;
+                size_t m_affinityCpuCount;
+                ProcessorInfo m_processorInfo;
+                uint64_t m_ticksTo100ns;    // stat 中时钟节拍到 100ns 的换算系数
+            };
+        }
+
+        ProcessorInfo QueryProcessorInfo() {
+            ProcessorInfo info;
+            long configured = sysconf(_SC_NPROCESSORS_CONF);
+            info.dwNumberOfProcessors = configured > 0 ? static_cast<DWORD>(configured) : 1;
+
+            char buffer[4096];
+            if (ReadProcFile(AT_FDCWD, "/sys/devices/system/cpu/online", buffer, sizeof(buffer)) <= 0 ||
+                !CpuSet::Parse(buffer, info.activeProcessors)) {
+                info.activeProcessors.Clear();
+            }
+            if (info.activeProcessors.Empty()) {
+                info.activeProcessors = CpuSet::Range(0, info.dwNumberOfProcessors);
+            }
+            return info;
+        }
+
+        CpuTopology QueryCpuTopology() {
+            CpuTopology topology;
+            topology.onlineProcessors = QueryProcessorInfo().activeProcessors;
+            const CpuSet& online = topology.onlineProcessors;
+
+            for (size_t cpu = online.First(); cpu != CpuSet::npos; cpu = online.Next(cpu)) {
+                std::string cpuPath = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+
+                // 兄弟线程列表是对称的，已归入某个物理核心的 CPU 不再读取
+                if (CpuTopology::FindDomain(topology.physicalCores, cpu) < 0) {
+                    CpuSet siblings;
+                    if (!ReadSysfsCpuList(cpuPath + "/topology/thread_siblings_list", siblings)) {
+                        siblings = CpuSet::Single(cpu);
+                    }
+                    siblings &= online;
+                    siblings.Set(cpu);
+                    topology.physicalCores.push_back(siblings);
+                }
+
+                if (CpuTopology::FindDomain(topology.l3Domains, cpu) < 0) {
+                    CpuSet l3;
+                    char buffer[32];
+                    for (int index = 0; ; index++) {
+                        std::string cachePath = cpuPath + "/cache/index" + std::to_string(index);
+                        if (ReadProcFile(AT_FDCWD, (cachePath + "/level").c_str(), buffer, sizeof(buffer)) <= 0) {
+                            break;
+                        }
+                        if (atoi(buffer) == 3 && ReadSysfsCpuList(cachePath + "/shared_cpu_list", l3)) {
+                            break;
+                        }
+                        l3.Clear();
+                    }
+
+                    // 没有 L3 信息（部分 ARM 平台）时按物理封装划分
+                    if (l3.Empty() && !ReadSysfsCpuList(cpuPath + "/topology/core_siblings_list", l3)) {
+                        l3 = online;
+                    }
+                    l3 &= online;
+                    l3.Set(cpu);
+                    topology.l3Domains.push_back(l3);
+                }
+            }
+
+            CpuSet nodes;
+            if (ReadSysfsCpuList("/sys/devices/system/node/online", nodes)) {
+                for (size_t node = nodes.First(); node != CpuSet::npos; node = nodes.Next(node)) {
+                    CpuSet cpus;
+                    if (ReadSysfsCpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", cpus)) {
+                        cpus &= online;
+                        if (!cpus.Empty()) {
+                            topology.numaNodes.push_back(cpus);
+                            topology.numaNodeIds.push_back(static_cast<DWORD>(node));
+                        }
+                    }
+                }
+            }
+            if (topology.numaNodes.empty()) {
+                topology.numaNodes.push_back(online);
+                topology.numaNodeIds.push_back(0);
+            }
+
+            return topology;
+        }
+
+        std::unique_ptr<IProcessBackend> CreatePlatformBackend() {
+            return std::make_unique<LinuxProcessBackend>();
+        }
+
+        bool RaiseFileDescriptorLimit() {
+            struct rlimit limit;
+            if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+                return false;
+            }
+            if (limit.rlim_cur >= limit.rlim_max) {
+                return true;
+            }
+            limit.rlim_cur = limit.rlim_max;
+            return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+        }
+    }
+}
+
+#endif
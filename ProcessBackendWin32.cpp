@@ -0,0 +1,724 @@
+﻿#include "pch.h"
+#include "ProcessBackend.h"
+#include "CpuCoreManager.h"
+
+#ifdef _WIN32
+
+#include <psapi.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#pragma comment(lib, "psapi.lib")
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // Windows 后端：Toolhelp32 快照 + OpenProcess/SetProcessAffinityMask
+        //
+        // 处理器组：全局 CPU 编号 = 组起始编号 + 组内序号，各组按顺序连续编号。
+        // 单组进程在本组内修改时使用 SetProcessAffinityMask；
+        // 跨组的亲和性通过 SetProcessDefaultCpuSetMasks（Windows 11 / Server 2022 起）设置。
+        // =============================================================================
+
+        NativeProcessHandle::~NativeProcessHandle() {
+            HANDLE hProcess = reinterpret_cast<HANDLE>(value);
+            if (hProcess != NULL && hProcess != GetCurrentProcess()) {
+                CloseHandle(hProcess);
+            }
+        }
+
+        namespace {
+
+            uint64_t GetProcessStartTime(HANDLE hProcess) {
+                FILETIME creationTime, exitTime, kernelTime, userTime;
+                if (!GetProcessTimes(hProcess, &creationTime, &exitTime, &kernelTime, &userTime)) {
+                    return 0;
+                }
+                return (static_cast<uint64_t>(creationTime.dwHighDateTime) << 32) | creationTime.dwLowDateTime;
+            }
+
+            // 一个处理器组
+            struct ProcessorGroup {
+                DWORD firstCpu;         // 组内 0 号处理器的全局编号
+                KAFFINITY activeMask;   // 组内在线处理器
+            };
+
+            std::vector<ProcessorGroup> QueryProcessorGroups() {
+                std::vector<ProcessorGroup> groups;
+
+                DWORD length = 0;
+                GetLogicalProcessorInformationEx(RelationGroup, nullptr, &length);
+                std::vector<BYTE> buffer(length);
+                if (length != 0 && GetLogicalProcessorInformationEx(RelationGroup,
+                    reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+                    const GROUP_RELATIONSHIP& relation =
+                        reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data())->Group;
+
+                    DWORD firstCpu = 0;
+                    for (WORD group = 0; group < relation.ActiveGroupCount; group++) {
+                        groups.push_back({ firstCpu, relation.GroupInfo[group].ActiveProcessorMask });
+                        firstCpu += relation.GroupInfo[group].MaximumProcessorCount;
+                    }
+                }
+
+                if (groups.empty()) {
+                    SYSTEM_INFO sysInfo;
+                    ::GetSystemInfo(&sysInfo);
+                    groups.push_back({ 0, sysInfo.dwActiveProcessorMask });
+                }
+                return groups;
+            }
+
+            // SystemProcessorPerformanceInformation 的每处理器记录（KernelTime 包含 IdleTime）
+            struct ProcessorPerformanceInformation {
+                LARGE_INTEGER IdleTime;
+                LARGE_INTEGER KernelTime;
+                LARGE_INTEGER UserTime;
+                LARGE_INTEGER DpcTime;
+                LARGE_INTEGER InterruptTime;
+                ULONG InterruptCount;
+            };
+
+            const ULONG SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION_CLASS = 8;
+
+            typedef LONG (WINAPI *NtQuerySystemInformationExFunc)(ULONG, PVOID, ULONG, PVOID, ULONG, PULONG);
+
+            // 进程 I/O 优先级（ProcessIoPriority）：0 很低、1 低、2 正常、3 高（需要 SeIncreaseBasePriorityPrivilege）
+            const ULONG PROCESS_IO_PRIORITY_INFORMATION_CLASS = 33;
+
+            typedef LONG (WINAPI *NtQueryInformationProcessFunc)(HANDLE, ULONG, PVOID, ULONG, PULONG);
+            typedef LONG (WINAPI *NtSetInformationProcessFunc)(HANDLE, ULONG, PVOID, ULONG);
+            typedef ULONG (WINAPI *RtlNtStatusToDosErrorFunc)(LONG);
+
+            // nice 值到优先级类别的映射，与 Linux 后端的 PriorityClassToNice 对应
+            DWORD NiceToPriorityClass(int nice) {
+                if (nice >= 15) return IDLE_PRIORITY_CLASS;
+                if (nice >= 5) return BELOW_NORMAL_PRIORITY_CLASS;
+                if (nice > -5) return NORMAL_PRIORITY_CLASS;
+                if (nice > -10) return ABOVE_NORMAL_PRIORITY_CLASS;
+                if (nice > -20) return HIGH_PRIORITY_CLASS;
+                return REALTIME_PRIORITY_CLASS;
+            }
+
+            // Windows 没有进程级调度策略，按最接近的优先级类别处理；实时策略的优先级数值无对应项
+            DWORD ResolvePriorityClass(const ProcessScheduling& scheduling) {
+                switch (scheduling.policy) {
+                case ProcessScheduling::Policy::Fifo:
+                case ProcessScheduling::Policy::RoundRobin:
+                    return REALTIME_PRIORITY_CLASS;
+                case ProcessScheduling::Policy::Batch:
+                    return BELOW_NORMAL_PRIORITY_CLASS;
+                case ProcessScheduling::Policy::Idle:
+                    return IDLE_PRIORITY_CLASS;
+                default:
+                    break;
+                }
+                if (scheduling.priorityClass != 0) {
+                    return scheduling.priorityClass;
+                }
+                return scheduling.hasNice ? NiceToPriorityClass(scheduling.nice) : 0;
+            }
+
+            ULONG ToIoPriority(const ProcessScheduling& scheduling) {
+                switch (scheduling.ioClass) {
+                case ProcessScheduling::IoClass::RealTime:   return 3;
+                case ProcessScheduling::IoClass::BestEffort: return scheduling.ioLevel >= 6 ? 1 : 2;
+                default:                                     return 0;
+                }
+            }
+
+            typedef BOOL (WINAPI *SetProcessDefaultCpuSetMasksFunc)(HANDLE, GROUP_AFFINITY*, USHORT);
+            typedef BOOL (WINAPI *GetProcessDefaultCpuSetMasksFunc)(HANDLE, GROUP_AFFINITY*, USHORT, USHORT*);
+            typedef BOOL (WINAPI *SetThreadSelectedCpuSetMasksFunc)(HANDLE, GROUP_AFFINITY*, USHORT);
+
+            uint64_t FileTimeToUInt64(const FILETIME& time) {
+                return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+            }
+
+            // 线程句柄的 RAII 包装
+            class ScopedThreadHandle {
+            public:
+                ScopedThreadHandle(DWORD threadId, DWORD desiredAccess)
+                    : m_handle(::OpenThread(desiredAccess, FALSE, threadId))
+                {
+                }
+
+                ~ScopedThreadHandle() {
+                    if (m_handle != NULL) {
+                        CloseHandle(m_handle);
+                    }
+                }
+
+                ScopedThreadHandle(const ScopedThreadHandle&) = delete;
+                ScopedThreadHandle& operator=(const ScopedThreadHandle&) = delete;
+
+                HANDLE Get() const { return m_handle; }
+
+            private:
+                HANDLE m_handle;
+            };
+
+            class Win32ProcessBackend : public IProcessBackend {
+            public:
+                Win32ProcessBackend()
+                    : m_groups(QueryProcessorGroups())
+                    , m_setDefaultCpuSetMasks(nullptr)
+                    , m_getDefaultCpuSetMasks(nullptr)
+                    , m_setThreadSelectedCpuSetMasks(nullptr)
+                    , m_querySystemInformationEx(nullptr)
+                    , m_queryInformationProcess(nullptr)
+                    , m_setInformationProcess(nullptr)
+                    , m_ntStatusToDosError(nullptr)
+                    , m_nameGeneration(0)
+                {
+                    // 旧系统没有 CPU 集合掩码 API，此时跨组亲和性不可用
+                    HMODULE kernel32 = GetModuleHandleW(L"kernel32.dll");
+                    if (kernel32 != NULL) {
+                        m_setDefaultCpuSetMasks = reinterpret_cast<SetProcessDefaultCpuSetMasksFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(kernel32, "SetProcessDefaultCpuSetMasks")));
+                        m_getDefaultCpuSetMasks = reinterpret_cast<GetProcessDefaultCpuSetMasksFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(kernel32, "GetProcessDefaultCpuSetMasks")));
+                        m_setThreadSelectedCpuSetMasks = reinterpret_cast<SetThreadSelectedCpuSetMasksFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(kernel32, "SetThreadSelectedCpuSetMasks")));
+                    }
+
+                    HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+                    if (ntdll != NULL) {
+                        m_querySystemInformationEx = reinterpret_cast<NtQuerySystemInformationExFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(ntdll, "NtQuerySystemInformationEx")));
+                        m_queryInformationProcess = reinterpret_cast<NtQueryInformationProcessFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(ntdll, "NtQueryInformationProcess")));
+                        m_setInformationProcess = reinterpret_cast<NtSetInformationProcessFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(ntdll, "NtSetInformationProcess")));
+                        m_ntStatusToDosError = reinterpret_cast<RtlNtStatusToDosErrorFunc>(
+                            reinterpret_cast<void*>(GetProcAddress(ntdll, "RtlNtStatusToDosError")));
+                    }
+                }
+
+                bool EnumerateProcesses(std::vector<ProcessEntry>& processes) override {
+                    std::lock_guard<std::mutex> lock(m_nameCacheMutex);
+                    processes.clear();
+                    m_nameGeneration++;
+
+                    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+                    if (hSnapshot == INVALID_HANDLE_VALUE) {
+                        return false;
+                    }
+
+                    PROCESSENTRY32W pe32;
+                    pe32.dwSize = sizeof(PROCESSENTRY32W);
+
+                    if (!Process32FirstW(hSnapshot, &pe32)) {
+                        CloseHandle(hSnapshot);
+                        return false;
+                    }
+
+                    do {
+                        ProcessEntry entry;
+                        entry.processId = pe32.th32ProcessID;
+                        entry.parentProcessId = pe32.th32ParentProcessID;
+                        entry.name = ConvertProcessName(pe32.th32ProcessID, pe32.szExeFile);
+                        entry.isSystem = pe32.th32ProcessID == 0 || pe32.th32ProcessID == 4;
+                        processes.push_back(std::move(entry));
+                    } while (Process32NextW(hSnapshot, &pe32));
+
+                    CloseHandle(hSnapshot);
+
+                    for (auto it = m_nameCache.begin(); it != m_nameCache.end();) {
+                        if (it->second.generation != m_nameGeneration) {
+                            it = m_nameCache.erase(it);
+                        }
+                        else {
+                            ++it;
+                        }
+                    }
+                    return true;
+                }
+
+                bool QueryProcess(DWORD processId, ProcessEntry& entry) override {
+                    HANDLE hProcess = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+                    if (hProcess == NULL) {
+                        return false;
+                    }
+
+                    wchar_t imagePath[MAX_PATH];
+                    DWORD length = ARRAYSIZE(imagePath);
+                    BOOL nameResolved = QueryFullProcessImageNameW(hProcess, 0, imagePath, &length);
+                    entry.processId = processId;
+                    entry.parentProcessId = 0;
+                    entry.startTime = GetProcessStartTime(hProcess);
+                    entry.isSystem = processId == 0 || processId == 4;
+                    CloseHandle(hProcess);
+
+                    if (!nameResolved) {
+                        return false;
+                    }
+
+                    // 与 Toolhelp32 的 szExeFile 保持一致，只保留文件名
+                    const wchar_t* fileName = wcsrchr(imagePath, L'\\');
+                    entry.name = Utils::WideStringToString(fileName != nullptr ? fileName + 1 : imagePath);
+                    return true;
+                }
+
+                ProcessHandle Open(DWORD processId, ProcessAccess access) override {
+                    DWORD desiredAccess = access == ProcessAccess::QueryAndSet
+                        ? PROCESS_SET_INFORMATION | PROCESS_QUERY_INFORMATION
+                        : PROCESS_QUERY_INFORMATION;
+
+                    HANDLE hProcess = ::OpenProcess(desiredAccess, FALSE, processId);
+                    if (hProcess == NULL) {
+                        return ProcessHandle();
+                    }
+
+                    return ProcessHandle(processId, GetProcessStartTime(hProcess), reinterpret_cast<intptr_t>(hProcess));
+                }
+
+                ProcessHandle OpenSelf() override {
+                    return ProcessHandle(::GetCurrentProcessId(), 0, reinterpret_cast<intptr_t>(GetCurrentProcess()));
+                }
+
+                bool QueryAffinity(const ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet) override {
+                    HANDLE hProcess = reinterpret_cast<HANDLE>(handle.GetNative());
+                    USHORT groupIds[64];
+                    USHORT groupCount = ARRAYSIZE(groupIds);
+                    if (!GetProcessGroupAffinity(hProcess, &groupCount, groupIds) || groupCount == 0) {
+                        return false;
+                    }
+
+                    if (groupCount == 1) {
+                        DWORD_PTR processMask = 0;
+                        DWORD_PTR systemMask = 0;
+                        if (!GetProcessAffinityMask(hProcess, &processMask, &systemMask)) {
+                            return false;
+                        }
+                        processSet = GroupMaskToCpuSet(groupIds[0], processMask);
+                        systemSet = GroupMaskToCpuSet(groupIds[0], systemMask);
+                        return true;
+                    }
+
+                    // 跨组进程：系统集合为所在各组的在线处理器，进程集合优先取默认 CPU 集合掩码
+                    systemSet.Clear();
+                    for (USHORT i = 0; i < groupCount; i++) {
+                        if (groupIds[i] < m_groups.size()) {
+                            systemSet |= GroupMaskToCpuSet(groupIds[i], m_groups[groupIds[i]].activeMask);
+                        }
+                    }
+
+                    processSet = systemSet;
+                    GROUP_AFFINITY masks[64];
+                    USHORT maskCount = 0;
+                    if (m_getDefaultCpuSetMasks != nullptr &&
+                        m_getDefaultCpuSetMasks(hProcess, masks, ARRAYSIZE(masks), &maskCount) && maskCount > 0) {
+                        processSet.Clear();
+                        for (USHORT i = 0; i < maskCount; i++) {
+                            processSet |= GroupMaskToCpuSet(masks[i].Group, masks[i].Mask);
+                        }
+                    }
+                    return true;
+                }
+
+                bool ApplyAffinity(const ProcessHandle& handle, const CpuSet& affinity) override {
+                    HANDLE hProcess = reinterpret_cast<HANDLE>(handle.GetNative());
+
+                    std::vector<GROUP_AFFINITY> masks = ToGroupAffinities(affinity);
+                    if (masks.empty()) {
+                        SetLastError(ERROR_INVALID_PARAMETER);
+                        return false;
+                    }
+
+                    USHORT groupIds[64];
+                    USHORT groupCount = ARRAYSIZE(groupIds);
+                    if (masks.size() == 1 && GetProcessGroupAffinity(hProcess, &groupCount, groupIds) &&
+                        groupCount == 1 && groupIds[0] == masks[0].Group) {
+                        return SetProcessAffinityMask(hProcess, static_cast<DWORD_PTR>(masks[0].Mask)) != FALSE;
+                    }
+
+                    if (m_setDefaultCpuSetMasks == nullptr) {
+                        SetLastError(ERROR_NOT_SUPPORTED);
+                        return false;
+                    }
+                    return m_setDefaultCpuSetMasks(hProcess, masks.data(), static_cast<USHORT>(masks.size())) != FALSE;
+                }
+
+                bool SetPriority(const ProcessHandle& handle, DWORD priorityClass) override {
+                    return SetPriorityClass(reinterpret_cast<HANDLE>(handle.GetNative()), priorityClass) != FALSE;
+                }
+
+                bool ApplyScheduling(const ProcessHandle& handle, const ProcessScheduling& scheduling, bool& changed) override {
+                    changed = false;
+                    HANDLE hProcess = reinterpret_cast<HANDLE>(handle.GetNative());
+
+                    DWORD priorityClass = ResolvePriorityClass(scheduling);
+                    if (priorityClass != 0) {
+                        DWORD current = GetPriorityClass(hProcess);
+                        if (current == 0) {
+                            return false;
+                        }
+                        if (current != priorityClass) {
+                            if (!SetPriorityClass(hProcess, priorityClass)) {
+                                return false;
+                            }
+                            // 没有 SeIncreaseBasePriorityPrivilege 时实时优先级会被静默降为高优先级
+                            if (GetPriorityClass(hProcess) != priorityClass) {
+                                SetLastError(ERROR_ACCESS_DENIED);
+                                return false;
+                            }
+                            changed = true;
+                        }
+                    }
+
+                    if (scheduling.ioClass != ProcessScheduling::IoClass::Unchanged) {
+                        if (m_queryInformationProcess == nullptr || m_setInformationProcess == nullptr) {
+                            SetLastError(ERROR_NOT_SUPPORTED);
+                            return false;
+                        }
+
+                        ULONG priority = ToIoPriority(scheduling);
+                        ULONG current = 0;
+                        LONG status = m_queryInformationProcess(hProcess, PROCESS_IO_PRIORITY_INFORMATION_CLASS,
+                            &current, sizeof(current), nullptr);
+                        if (status >= 0 && current != priority) {
+                            status = m_setInformationProcess(hProcess, PROCESS_IO_PRIORITY_INFORMATION_CLASS,
+                                &priority, sizeof(priority));
+                            changed = changed || status >= 0;
+                        }
+                        if (status < 0) {
+                            SetLastError(m_ntStatusToDosError != nullptr ? m_ntStatusToDosError(status) : ERROR_ACCESS_DENIED);
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                // Windows 没有修改其他进程分配策略或迁移页面的接口；线程绑定核心后内存管理器默认在
+                // 理想处理器所在的节点分配，但这只是默认行为而不是已应用的策略，Bind、Preferred 与迁移
+                // 都返回 ERROR_NOT_SUPPORTED，调用方不会把它们报告为成功
+                bool ApplyMemoryPolicy(const ProcessHandle&, const ProcessMemoryPolicy& policy, const CpuSet& nodes) override {
+                    if (policy.IsEmpty()) {
+                        return true;
+                    }
+                    if (nodes.Empty()) {
+                        SetLastError(ERROR_INVALID_PARAMETER);
+                        return false;
+                    }
+                    SetLastError(ERROR_NOT_SUPPORTED);
+                    return false;
+                }
+
+                // QueryWorkingSet 列出常驻页，QueryWorkingSetEx 给出每页所在的节点
+                bool QueryMemoryNodes(DWORD processId, std::vector<uint64_t>& kilobytesPerNode) override {
+                    kilobytesPerNode.clear();
+                    NativeProcessHandle process(reinterpret_cast<intptr_t>(
+                        OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId)));
+                    HANDLE hProcess = reinterpret_cast<HANDLE>(process.value);
+                    if (hProcess == NULL) {
+                        return false;
+                    }
+
+                    std::vector<ULONG_PTR> buffer(4096);
+                    while (!QueryWorkingSet(hProcess, buffer.data(), static_cast<DWORD>(buffer.size() * sizeof(ULONG_PTR)))) {
+                        if (GetLastError() != ERROR_BAD_LENGTH) {
+                            return false;
+                        }
+                        // 查询期间工作集仍可能增长，多预留一些
+                        ULONG_PTR entries = reinterpret_cast<PSAPI_WORKING_SET_INFORMATION*>(buffer.data())->NumberOfEntries;
+                        buffer.resize(entries + entries / 8 + 64);
+                    }
+
+                    const PSAPI_WORKING_SET_INFORMATION* workingSet =
+                        reinterpret_cast<const PSAPI_WORKING_SET_INFORMATION*>(buffer.data());
+                    SYSTEM_INFO systemInfo;
+                    GetSystemInfo(&systemInfo);
+                    const ULONG_PTR CHUNK_SIZE = 16384;
+                    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+
+                    for (ULONG_PTR first = 0; first < workingSet->NumberOfEntries; first += CHUNK_SIZE) {
+                        ULONG_PTR count = std::min(CHUNK_SIZE, workingSet->NumberOfEntries - first);
+                        pages.resize(count);
+                        for (ULONG_PTR i = 0; i < count; i++) {
+                            pages[i].VirtualAddress = reinterpret_cast<PVOID>(
+                                workingSet->WorkingSetInfo[first + i].VirtualPage * systemInfo.dwPageSize);
+                        }
+                        if (!QueryWorkingSetEx(hProcess, pages.data(), static_cast<DWORD>(count * sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))) {
+                            return false;
+                        }
+
+                        for (const PSAPI_WORKING_SET_EX_INFORMATION& page : pages) {
+                            if (!page.VirtualAttributes.Valid) {
+                                continue;
+                            }
+                            size_t node = static_cast<size_t>(page.VirtualAttributes.Node);
+                            if (node >= kilobytesPerNode.size()) {
+                                kilobytesPerNode.resize(node + 1, 0);
+                            }
+                            kilobytesPerNode[node] += systemInfo.dwPageSize / 1024;
+                        }
+                    }
+                    return true;
+                }
+
+                // Toolhelp32 线程快照覆盖全系统，按所属进程过滤后逐个读取 GetThreadTimes
+                bool EnumerateThreads(DWORD processId, std::vector<ThreadEntry>& threads) override {
+                    threads.clear();
+
+                    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+                    if (hSnapshot == INVALID_HANDLE_VALUE) {
+                        return false;
+                    }
+
+                    THREADENTRY32 te32;
+                    te32.dwSize = sizeof(THREADENTRY32);
+                    if (Thread32First(hSnapshot, &te32)) {
+                        do {
+                            if (te32.th32OwnerProcessID != processId) {
+                                continue;
+                            }
+
+                            ThreadEntry entry;
+                            entry.threadId = te32.th32ThreadID;
+
+                            ScopedThreadHandle thread(te32.th32ThreadID, THREAD_QUERY_LIMITED_INFORMATION);
+                            FILETIME creationTime, exitTime, kernelTime, userTime;
+                            if (thread.Get() != NULL &&
+                                GetThreadTimes(thread.Get(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+                                entry.cpuTime = FileTimeToUInt64(kernelTime) + FileTimeToUInt64(userTime);
+                            }
+                            threads.push_back(std::move(entry));
+                        } while (Thread32Next(hSnapshot, &te32));
+                    }
+
+                    CloseHandle(hSnapshot);
+                    return !threads.empty();
+                }
+
+                bool QueryThreadAffinity(DWORD threadId, CpuSet& affinity) override {
+                    ScopedThreadHandle thread(threadId, THREAD_QUERY_LIMITED_INFORMATION);
+                    GROUP_AFFINITY groupAffinity;
+                    if (thread.Get() == NULL || !GetThreadGroupAffinity(thread.Get(), &groupAffinity)) {
+                        return false;
+                    }
+
+                    affinity = GroupMaskToCpuSet(groupAffinity.Group, groupAffinity.Mask);
+                    return true;
+                }
+
+                // 线程同一时刻只属于一个处理器组：单组时使用 SetThreadGroupAffinity，
+                // 跨组时使用 SetThreadSelectedCpuSetMasks（Windows 11 / Server 2022 起）
+                bool ApplyThreadAffinity(DWORD threadId, const CpuSet& affinity) override {
+                    std::vector<GROUP_AFFINITY> masks = ToGroupAffinities(affinity);
+                    if (masks.empty()) {
+                        SetLastError(ERROR_INVALID_PARAMETER);
+                        return false;
+                    }
+
+                    ScopedThreadHandle thread(threadId, THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION);
+                    if (thread.Get() == NULL) {
+                        return false;
+                    }
+
+                    if (masks.size() == 1) {
+                        return SetThreadGroupAffinity(thread.Get(), &masks[0], nullptr) != FALSE;
+                    }
+
+                    if (m_setThreadSelectedCpuSetMasks == nullptr) {
+                        SetLastError(ERROR_NOT_SUPPORTED);
+                        return false;
+                    }
+                    return m_setThreadSelectedCpuSetMasks(thread.Get(), masks.data(), static_cast<USHORT>(masks.size())) != FALSE;
+                }
+
+                DWORD GetCurrentPid() override {
+                    return ::GetCurrentProcessId();
+                }
+
+                ProcessorInfo GetProcessorInfo() override {
+                    return QueryProcessorInfo();
+                }
+
+                CpuTopology GetCpuTopology() override {
+                    return QueryCpuTopology();
+                }
+
+                // 按处理器组查询每处理器性能计数；GetSystemTimes 只有整机汇总，无法区分核心
+                bool QueryCpuTimes(std::vector<CpuTimes>& times) override {
+                    if (m_querySystemInformationEx == nullptr) {
+                        SetLastError(ERROR_NOT_SUPPORTED);
+                        return false;
+                    }
+
+                    times.clear();
+                    std::vector<ProcessorPerformanceInformation> records(64);
+                    for (size_t group = 0; group < m_groups.size(); group++) {
+                        USHORT groupNumber = static_cast<USHORT>(group);
+                        ULONG returned = 0;
+                        if (m_querySystemInformationEx(SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION_CLASS,
+                            &groupNumber, sizeof(groupNumber), records.data(),
+                            static_cast<ULONG>(records.size() * sizeof(ProcessorPerformanceInformation)), &returned) < 0) {
+                            return false;
+                        }
+
+                        size_t count = returned / sizeof(ProcessorPerformanceInformation);
+                        size_t firstCpu = m_groups[group].firstCpu;
+                        if (times.size() < firstCpu + count) {
+                            times.resize(firstCpu + count);
+                        }
+                        for (size_t i = 0; i < count; i++) {
+                            uint64_t idle = static_cast<uint64_t>(records[i].IdleTime.QuadPart);
+                            uint64_t total = static_cast<uint64_t>(records[i].KernelTime.QuadPart + records[i].UserTime.QuadPart);
+                            times[firstCpu + i].total = total;
+                            times[firstCpu + i].busy = total >= idle ? total - idle : 0;
+                        }
+                    }
+                    return !times.empty();
+                }
+
+                std::unique_ptr<IProcessEventSource> CreateEventSource() override {
+                    return CreatePlatformEventSource();
+                }
+
+            private:
+                // 上一轮快照中的进程名转换结果
+                struct CachedName {
+                    std::wstring wideName;
+                    std::string name;
+                    uint64_t generation = 0;
+                };
+
+                // 同一 PID 的 szExeFile 未变化时复用上次的 UTF-8 结果，稳态扫描不再逐个调用 WideCharToMultiByte
+                const std::string& ConvertProcessName(DWORD processId, const wchar_t* exeFile) {
+                    CachedName& cached = m_nameCache[processId];
+                    if (cached.generation == 0 || cached.wideName != exeFile) {
+                        cached.wideName = exeFile;
+                        cached.name = Utils::WideStringToString(exeFile);
+                    }
+                    cached.generation = m_nameGeneration;
+                    return cached.name;
+                }
+
+                // 按处理器组拆分 CpuSet，忽略不在线的处理器
+                std::vector<GROUP_AFFINITY> ToGroupAffinities(const CpuSet& affinity) const {
+                    std::vector<GROUP_AFFINITY> masks;
+                    for (size_t group = 0; group < m_groups.size(); group++) {
+                        KAFFINITY mask = static_cast<KAFFINITY>(affinity.ExtractMask(m_groups[group].firstCpu)) & m_groups[group].activeMask;
+                        if (mask != 0) {
+                            GROUP_AFFINITY groupAffinity;
+                            ZeroMemory(&groupAffinity, sizeof(groupAffinity));
+                            groupAffinity.Mask = mask;
+                            groupAffinity.Group = static_cast<WORD>(group);
+                            masks.push_back(groupAffinity);
+                        }
+                    }
+                    return masks;
+                }
+
+                CpuSet GroupMaskToCpuSet(USHORT group, KAFFINITY mask) const {
+                    if (group >= m_groups.size()) {
+                        return CpuSet();
+                    }
+                    return CpuSet::FromMask(static_cast<uint64_t>(mask), m_groups[group].firstCpu);
+                }
+
+                std::vector<ProcessorGroup> m_groups;
+                SetProcessDefaultCpuSetMasksFunc m_setDefaultCpuSetMasks;
+                GetProcessDefaultCpuSetMasksFunc m_getDefaultCpuSetMasks;
+                SetThreadSelectedCpuSetMasksFunc m_setThreadSelectedCpuSetMasks;
+                NtQuerySystemInformationExFunc m_querySystemInformationEx;
+                NtQueryInformationProcessFunc m_queryInformationProcess;
+                NtSetInformationProcessFunc m_setInformationProcess;
+                RtlNtStatusToDosErrorFunc m_ntStatusToDosError;
+
+                std::mutex m_nameCacheMutex;
+                std::unordered_map<DWORD, CachedName> m_nameCache;
+                uint64_t m_nameGeneration;
+            };
+        }
+
+        ProcessorInfo QueryProcessorInfo() {
+            ProcessorInfo info;
+            for (const ProcessorGroup& group : QueryProcessorGroups()) {
+                info.activeProcessors |= CpuSet::FromMask(static_cast<uint64_t>(group.activeMask), group.firstCpu);
+            }
+            info.dwNumberOfProcessors = static_cast<DWORD>(info.activeProcessors.Count());
+            return info;
+        }
+
+        CpuTopology QueryCpuTopology() {
+            CpuTopology topology;
+            std::vector<ProcessorGroup> groups = QueryProcessorGroups();
+            for (const ProcessorGroup& group : groups) {
+                topology.onlineProcessors |= CpuSet::FromMask(static_cast<uint64_t>(group.activeMask), group.firstCpu);
+            }
+
+            auto toCpuSet = [&groups](const GROUP_AFFINITY* masks, WORD count) {
+                CpuSet cpus;
+                for (WORD i = 0; i < count; i++) {
+                    if (masks[i].Group < groups.size()) {
+                        cpus |= CpuSet::FromMask(static_cast<uint64_t>(masks[i].Mask), groups[masks[i].Group].firstCpu);
+                    }
+                }
+                return cpus;
+            };
+
+            DWORD length = 0;
+            GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+            std::vector<BYTE> buffer(length);
+            if (length != 0 && GetLogicalProcessorInformationEx(RelationAll,
+                reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+                for (DWORD offset = 0; offset < length;) {
+                    const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info =
+                        reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+
+                    // 旧系统的 Cache/NumaNode 只有一个 GroupMask（GroupCount 为 0）
+                    switch (info->Relationship) {
+                    case RelationProcessorCore:
+                        topology.physicalCores.push_back(toCpuSet(info->Processor.GroupMask, info->Processor.GroupCount));
+                        break;
+                    case RelationCache:
+                        if (info->Cache.Level == 3) {
+                            topology.l3Domains.push_back(toCpuSet(info->Cache.GroupMasks,
+                                info->Cache.GroupCount != 0 ? info->Cache.GroupCount : 1));
+                        }
+                        break;
+                    case RelationNumaNode:
+                        topology.numaNodes.push_back(toCpuSet(info->NumaNode.GroupMasks,
+                            info->NumaNode.GroupCount != 0 ? info->NumaNode.GroupCount : 1));
+                        topology.numaNodeIds.push_back(info->NumaNode.NodeNumber);
+                        break;
+                    default:
+                        break;
+                    }
+                    offset += info->Size;
+                }
+            }
+
+            if (topology.physicalCores.empty()) {
+                for (size_t cpu = topology.onlineProcessors.First(); cpu != CpuSet::npos; cpu = topology.onlineProcessors.Next(cpu)) {
+                    topology.physicalCores.push_back(CpuSet::Single(cpu));
+                }
+            }
+            if (topology.l3Domains.empty()) {
+                topology.l3Domains.push_back(topology.onlineProcessors);
+            }
+            if (topology.numaNodes.empty()) {
+                topology.numaNodes.push_back(topology.onlineProcessors);
+                topology.numaNodeIds.push_back(0);
+            }
+            return topology;
+        }
+
+        std::unique_ptr<IProcessBackend> CreatePlatformBackend() {
+            return std::make_unique<Win32ProcessBackend>();
+        }
+
+        // 进程句柄数不受类似的软上限限制
+        bool RaiseFileDescriptorLimit() {
+            return true;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 进程事件源：进程创建后毫秒级通知，供保护线程立即处理新进程
+        // Windows: ETW Microsoft-Windows-Kernel-Process 实时会话
+        // Linux:   netlink 进程连接器（CN_IDX_PROC）
+        // =============================================================================
+
+        struct ProcessEvent {
+            enum class Type {
+                Created,    // 新进程
+                Exec,       // 进程替换了映像（Linux exec）
+                Exited,     // 进程退出
+                Overflow    // 事件丢失，需要立即全量扫描
+            };
+
+            Type type = Type::Created;
+            DWORD processId = 0;
+            DWORD parentProcessId = 0;
+        };
+
+        // 事件回调在事件源自己的线程上执行，应尽快返回
+        using ProcessEventCallback = std::function<void(const ProcessEvent& event)>;
+
+        class IProcessEventSource {
+        public:
+            virtual ~IProcessEventSource() = default;
+
+            // 启动事件线程，权限不足或平台不支持时返回 false
+            virtual bool Start(ProcessEventCallback callback) = 0;
+            virtual void Stop() = 0;
+        };
+
+        // 创建当前平台的进程事件源
+        std::unique_ptr<IProcessEventSource> CreatePlatformEventSource();
+    }
+}
@@ -0,0 +1,206 @@
+﻿#include "pch.h"
+#include "ProcessEvents.h"
+
+#ifndef _WIN32
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <thread>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+
+            // =============================================================================
+            // netlink 进程连接器：订阅 fork/exec/exit 事件（需要 root 或 CAP_NET_ADMIN）
+            // =============================================================================
+
+            class NetlinkProcessEventSource : public IProcessEventSource {
+            public:
+                NetlinkProcessEventSource()
+                    : m_socket(-1)
+                    , m_wakeFd(-1)
+                {
+                }
+
+                ~NetlinkProcessEventSource() override {
+                    Stop();
+                }
+
+                bool Start(ProcessEventCallback callback) override {
+                    Stop();
+
+                    m_socket = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+                    if (m_socket < 0) {
+                        return false;
+                    }
+
+                    sockaddr_nl address;
+                    memset(&address, 0, sizeof(address));
+                    address.nl_family = AF_NETLINK;
+                    address.nl_groups = CN_IDX_PROC;
+
+                    // 增大接收缓冲区，降低进程风暴时的丢包概率
+                    int receiveBuffer = 4 * 1024 * 1024;
+                    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+
+                    if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+                        !SendMulticastOp(PROC_CN_MCAST_LISTEN)) {
+                        CloseSockets();
+                        return false;
+                    }
+
+                    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                    if (m_wakeFd < 0) {
+                        CloseSockets();
+                        return false;
+                    }
+
+                    m_callback = std::move(callback);
+                    m_thread = std::thread(&NetlinkProcessEventSource::ReceiveLoop, this);
+                    return true;
+                }
+
+                void Stop() override {
+                    if (m_thread.joinable()) {
+                        uint64_t value = 1;
+                        ssize_t written = write(m_wakeFd, &value, sizeof(value));
+                        (void)written;
+                        m_thread.join();
+                        SendMulticastOp(PROC_CN_MCAST_IGNORE);
+                    }
+                    CloseSockets();
+                }
+
+            private:
+                bool SendMulticastOp(proc_cn_mcast_op op) {
+                    if (m_socket < 0) {
+                        return false;
+                    }
+
+                    alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))];
+                    memset(buffer, 0, sizeof(buffer));
+
+                    nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+                    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+                    header->nlmsg_type = NLMSG_DONE;
+                    header->nlmsg_pid = static_cast<__u32>(getpid());
+
+                    cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+                    message->id.idx = CN_IDX_PROC;
+                    message->id.val = CN_VAL_PROC;
+                    message->len = sizeof(proc_cn_mcast_op);
+                    memcpy(message->data, &op, sizeof(op));
+
+                    return send(m_socket, header, header->nlmsg_len, 0) >= 0;
+                }
+
+                void ReceiveLoop() {
+                    alignas(nlmsghdr) char buffer[8192];
+                    pollfd fds[2] = {
+                        { m_socket, POLLIN, 0 },
+                        { m_wakeFd, POLLIN, 0 }
+                    };
+
+                    for (;;) {
+                        if (poll(fds, 2, -1) < 0) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            break;
+                        }
+                        if (fds[1].revents != 0) {
+                            break;
+                        }
+
+                        ssize_t length = recv(m_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+                        if (length < 0) {
+                            if (errno == ENOBUFS) {
+                                // 接收队列溢出，已丢失的事件只能靠全量扫描补偿
+                                ProcessEvent event;
+                                event.type = ProcessEvent::Type::Overflow;
+                                m_callback(event);
+                            }
+                            continue;
+                        }
+
+                        for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+                             NLMSG_OK(header, static_cast<unsigned int>(length));
+                             header = NLMSG_NEXT(header, length)) {
+                            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+                                continue;
+                            }
+
+                            const cn_msg* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+                            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+                                continue;
+                            }
+
+                            Dispatch(*reinterpret_cast<const proc_event*>(message->data));
+                        }
+                    }
+                }
+
+                // 只关心线程组首线程（即进程本身），线程创建/退出事件忽略
+                void Dispatch(const proc_event& source) {
+                    ProcessEvent event;
+
+                    switch (source.what) {
+                    case proc_event::PROC_EVENT_FORK:
+                        if (source.event_data.fork.child_pid != source.event_data.fork.child_tgid) {
+                            return;
+                        }
+                        event.type = ProcessEvent::Type::Created;
+                        event.processId = static_cast<DWORD>(source.event_data.fork.child_tgid);
+                        event.parentProcessId = static_cast<DWORD>(source.event_data.fork.parent_tgid);
+                        break;
+                    case proc_event::PROC_EVENT_EXEC:
+                        event.type = ProcessEvent::Type::Exec;
+                        event.processId = static_cast<DWORD>(source.event_data.exec.process_tgid);
+                        break;
+                    case proc_event::PROC_EVENT_EXIT:
+                        if (source.event_data.exit.process_pid != source.event_data.exit.process_tgid) {
+                            return;
+                        }
+                        event.type = ProcessEvent::Type::Exited;
+                        event.processId = static_cast<DWORD>(source.event_data.exit.process_tgid);
+                        break;
+                    default:
+                        return;
+                    }
+
+                    m_callback(event);
+                }
+
+                void CloseSockets() {
+                    if (m_socket >= 0) {
+                        close(m_socket);
+                        m_socket = -1;
+                    }
+                    if (m_wakeFd >= 0) {
+                        close(m_wakeFd);
+                        m_wakeFd = -1;
+                    }
+                }
+
+                int m_socket;
+                int m_wakeFd;
+                std::thread m_thread;
+                ProcessEventCallback m_callback;
+            };
+        }
+
+        std::unique_ptr<IProcessEventSource> CreatePlatformEventSource() {
+            return std::make_unique<NetlinkProcessEventSource>();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,169 @@
+﻿#include "pch.h"
+#include "ProcessEvents.h"
+
+#ifdef _WIN32
+
+#include <evntrace.h>
+#include <evntcons.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#pragma comment(lib, "advapi32.lib")
+
+#ifndef EVENT_TRACE_USE_MS_FLUSH_TIMER
+#define EVENT_TRACE_USE_MS_FLUSH_TIMER 0x00000010
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+
+            // =============================================================================
+            // ETW 实时会话：订阅 Microsoft-Windows-Kernel-Process 的进程启动/退出事件
+            // 需要管理员权限；刷新间隔设为毫秒级，保证事件在进程启动后很快送达
+            // =============================================================================
+
+            // {22FB2CD6-0E7B-422B-A0C7-2FAD1FD0E716}
+            const GUID KernelProcessProviderGuid =
+                { 0x22fb2cd6, 0x0e7b, 0x422b, { 0xa0, 0xc7, 0x2f, 0xad, 0x1f, 0xd0, 0xe7, 0x16 } };
+
+            const wchar_t SESSION_NAME[] = L"TSysWatch-ProcessEvents";
+            const ULONGLONG WINEVENT_KEYWORD_PROCESS = 0x10;
+            const USHORT EVENT_ID_PROCESS_START = 1;
+            const USHORT EVENT_ID_PROCESS_STOP = 2;
+            const ULONG FLUSH_INTERVAL_MS = 10;
+
+            class EtwProcessEventSource : public IProcessEventSource {
+            public:
+                EtwProcessEventSource()
+                    : m_session(0)
+                    , m_trace(INVALID_PROCESSTRACE_HANDLE)
+                    , m_properties(sizeof(EVENT_TRACE_PROPERTIES) + sizeof(SESSION_NAME))
+                {
+                }
+
+                ~EtwProcessEventSource() override {
+                    Stop();
+                }
+
+                bool Start(ProcessEventCallback callback) override {
+                    Stop();
+
+                    // 上次异常退出可能遗留同名会话
+                    ControlTraceW(0, SESSION_NAME, ResetProperties(), EVENT_TRACE_CONTROL_STOP);
+
+                    EVENT_TRACE_PROPERTIES* properties = ResetProperties();
+                    properties->LogFileMode = EVENT_TRACE_REAL_TIME_MODE | EVENT_TRACE_USE_MS_FLUSH_TIMER;
+                    properties->FlushTimer = FLUSH_INTERVAL_MS;
+
+                    if (StartTraceW(&m_session, SESSION_NAME, properties) != ERROR_SUCCESS) {
+                        m_session = 0;
+                        return false;
+                    }
+
+                    if (EnableTraceEx2(m_session, &KernelProcessProviderGuid, EVENT_CONTROL_CODE_ENABLE_PROVIDER,
+                        TRACE_LEVEL_INFORMATION, WINEVENT_KEYWORD_PROCESS, 0, 0, nullptr) != ERROR_SUCCESS) {
+                        StopSession();
+                        return false;
+                    }
+
+                    m_callback = std::move(callback);
+
+                    EVENT_TRACE_LOGFILEW logFile;
+                    ZeroMemory(&logFile, sizeof(logFile));
+                    logFile.LoggerName = const_cast<LPWSTR>(SESSION_NAME);
+                    logFile.ProcessTraceMode = PROCESS_TRACE_MODE_REAL_TIME | PROCESS_TRACE_MODE_EVENT_RECORD;
+                    logFile.EventRecordCallback = &EtwProcessEventSource::OnEventRecord;
+                    logFile.Context = this;
+
+                    m_trace = OpenTraceW(&logFile);
+                    if (m_trace == INVALID_PROCESSTRACE_HANDLE) {
+                        StopSession();
+                        return false;
+                    }
+
+                    // ProcessTrace 阻塞直到 CloseTrace
+                    m_thread = std::thread([this]() {
+                        ProcessTrace(&m_trace, 1, nullptr, nullptr);
+                    });
+                    return true;
+                }
+
+                void Stop() override {
+                    if (m_trace != INVALID_PROCESSTRACE_HANDLE) {
+                        CloseTrace(m_trace);
+                    }
+                    StopSession();
+                    if (m_thread.joinable()) {
+                        m_thread.join();
+                    }
+                    m_trace = INVALID_PROCESSTRACE_HANDLE;
+                }
+
+            private:
+                EVENT_TRACE_PROPERTIES* ResetProperties() {
+                    std::fill(m_properties.begin(), m_properties.end(), static_cast<char>(0));
+
+                    EVENT_TRACE_PROPERTIES* properties = reinterpret_cast<EVENT_TRACE_PROPERTIES*>(m_properties.data());
+                    properties->Wnode.BufferSize = static_cast<ULONG>(m_properties.size());
+                    properties->Wnode.Flags = WNODE_FLAG_TRACED_GUID;
+                    properties->Wnode.ClientContext = 1;    // QPC 时间戳
+                    properties->LoggerNameOffset = sizeof(EVENT_TRACE_PROPERTIES);
+                    return properties;
+                }
+
+                void StopSession() {
+                    if (m_session != 0) {
+                        ControlTraceW(m_session, nullptr, ResetProperties(), EVENT_TRACE_CONTROL_STOP);
+                        m_session = 0;
+                    }
+                }
+
+                // ProcessStart/ProcessStop 负载前两个字段均为 ProcessID(UInt32)、CreateTime(FILETIME)，
+                // ProcessStart 随后是 ParentProcessID(UInt32)
+                static void WINAPI OnEventRecord(PEVENT_RECORD record) {
+                    EtwProcessEventSource* self = static_cast<EtwProcessEventSource*>(record->UserContext);
+                    if (self == nullptr || !IsEqualGUID(record->EventHeader.ProviderId, KernelProcessProviderGuid) ||
+                        record->UserDataLength < sizeof(DWORD)) {
+                        return;
+                    }
+
+                    const unsigned char* data = static_cast<const unsigned char*>(record->UserData);
+                    ProcessEvent event;
+                    memcpy(&event.processId, data, sizeof(DWORD));
+
+                    switch (record->EventHeader.EventDescriptor.Id) {
+                    case EVENT_ID_PROCESS_START:
+                        event.type = ProcessEvent::Type::Created;
+                        if (record->UserDataLength >= 16) {
+                            memcpy(&event.parentProcessId, data + 12, sizeof(DWORD));
+                        }
+                        break;
+                    case EVENT_ID_PROCESS_STOP:
+                        event.type = ProcessEvent::Type::Exited;
+                        break;
+                    default:
+                        return;
+                    }
+
+                    self->m_callback(event);
+                }
+
+                TRACEHANDLE m_session;
+                TRACEHANDLE m_trace;
+                std::vector<char> m_properties;
+                std::thread m_thread;
+                ProcessEventCallback m_callback;
+            };
+        }
+
+        std::unique_ptr<IProcessEventSource> CreatePlatformEventSource() {
+            return std::make_unique<EtwProcessEventSource>();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,112 @@
+﻿#include "pch.h"
+#include "ProcessHandleCache.h"
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            // 权限不足的记录在多少轮扫描后重试（创建时间未知时用于限制 PID 复用造成的误判）
+            const uint64_t DENIED_RETRY_GENERATIONS = 12;
+        }
+
+        ProcessHandleCache::ProcessHandleCache(IProcessBackend& backend)
+            : m_backend(backend)
+            , m_generation(0)
+        {
+        }
+
+        ProcessHandle ProcessHandleCache::Acquire(const ProcessEntry& process, DWORD* openError) {
+            uint64_t generation = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (FindLocked(process, openError, generation)) {
+                    return m_handles[process.processId].handle;
+                }
+            }
+
+            // 打开进程是最慢的一步，放在锁外，批量应用时多个线程可同时打开不同进程
+            CachedHandle cached;
+            cached.handle = m_backend.Open(process.processId, ProcessAccess::QueryAndSet);
+            cached.openError = cached.handle.IsValid() ? 0 : GetLastError();
+            cached.startTime = process.startTime;
+            cached.openedGeneration = generation;
+            cached.seenGeneration = generation;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // 其他线程可能已经为同一进程放入了句柄，以先放入的为准
+            if (FindLocked(process, openError, generation)) {
+                return m_handles[process.processId].handle;
+            }
+
+            if (openError != nullptr) {
+                *openError = cached.openError;
+            }
+            ProcessHandle handle = cached.handle;
+            m_handles.insert_or_assign(process.processId, std::move(cached));
+            return handle;
+        }
+
+        bool ProcessHandleCache::FindLocked(const ProcessEntry& process, DWORD* openError, uint64_t& generation) {
+            generation = m_generation;
+
+            auto it = m_handles.find(process.processId);
+            if (it == m_handles.end()) {
+                return false;
+            }
+
+            bool sameProcess = process.startTime == 0 || it->second.startTime == process.startTime;
+            bool deniedExpired = !it->second.handle.IsValid() &&
+                m_generation - it->second.openedGeneration >= DENIED_RETRY_GENERATIONS;
+
+            if (sameProcess && !deniedExpired) {
+                if (openError != nullptr) {
+                    *openError = it->second.openError;
+                }
+                return true;
+            }
+
+            m_handles.erase(it);
+            return false;
+        }
+
+        void ProcessHandleCache::Prune(const std::vector<ProcessEntry>& processes) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_generation++;
+
+            if (m_handles.empty()) {
+                return;
+            }
+
+            for (const ProcessEntry& process : processes) {
+                auto it = m_handles.find(process.processId);
+                if (it == m_handles.end()) {
+                    continue;
+                }
+
+                // 创建时间不一致说明 PID 已被复用，不标记即被淘汰
+                if (process.startTime == 0 || it->second.startTime == 0 || it->second.startTime == process.startTime) {
+                    it->second.seenGeneration = m_generation;
+                }
+            }
+
+            for (auto it = m_handles.begin(); it != m_handles.end();) {
+                if (it->second.seenGeneration != m_generation) {
+                    it = m_handles.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        void ProcessHandleCache::Clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_handles.clear();
+        }
+
+        size_t ProcessHandleCache::Size() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_handles.size();
+        }
+    }
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include "ProcessBackend.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 进程句柄缓存：跨扫描复用 QueryAndSet 句柄，避免每轮 OpenProcess/CloseHandle
+        //
+        // 缓存键为 PID + 创建时间。Windows 下持有句柄期间该 PID 不会被复用，
+        // Linux 下由后端的 pidfd 校验保证快照中的 startTime 准确，
+        // 因此只要进程仍出现在最新快照中且创建时间一致，缓存的句柄就指向同一进程。
+        // 打开失败（权限不足）的进程同样缓存，直到其退出前不再重复尝试。
+        // =============================================================================
+
+        class ProcessHandleCache {
+        public:
+            explicit ProcessHandleCache(IProcessBackend& backend);
+
+            // 获取进程句柄，缓存命中时不调用平台 API；权限不足时返回无效句柄，openError 为打开失败时的错误码
+            // 可在多个线程上并发调用，打开进程时不持有缓存锁
+            ProcessHandle Acquire(const ProcessEntry& process, DWORD* openError = nullptr);
+
+            // 根据最新快照淘汰已退出进程的句柄
+            void Prune(const std::vector<ProcessEntry>& processes);
+
+            void Clear();
+            size_t Size();
+
+        private:
+            // 查找仍然有效的缓存条目，过期条目被移除；调用方已持有 m_mutex
+            bool FindLocked(const ProcessEntry& process, DWORD* openError, uint64_t& generation);
+
+            struct CachedHandle {
+                ProcessHandle handle;            // 打开失败时为无效句柄
+                DWORD openError = 0;             // 打开失败时的错误码
+                uint64_t startTime = 0;          // 快照中的创建时间（未知时为 0）
+                uint64_t openedGeneration = 0;   // 打开时的扫描轮次
+                uint64_t seenGeneration = 0;     // 最近一次出现在快照中的轮次
+            };
+
+            IProcessBackend& m_backend;
+            std::mutex m_mutex;
+            std::unordered_map<DWORD, CachedHandle> m_handles;
+            uint64_t m_generation;
+        };
+    }
+}
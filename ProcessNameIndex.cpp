@@ -0,0 +1,87 @@
+﻿#include "pch.h"
+#include "ProcessNameIndex.h"
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            // 驻留池超过该大小且大部分名称已无人引用时清理一次
+            const size_t NAME_POOL_COMPACT_THRESHOLD = 1024;
+        }
+
+        void ProcessNameIndex::Update(const std::vector<ProcessEntry>& processes) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_generation++;
+
+            for (const ProcessEntry& process : processes) {
+                SetLocked(process);
+            }
+
+            for (auto it = m_entries.begin(); it != m_entries.end();) {
+                if (it->second.generation != m_generation) {
+                    it = m_entries.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+
+            // 只被驻留池自身引用的名称可以释放（调用方仍持有的名称不受影响）
+            if (m_names.size() > NAME_POOL_COMPACT_THRESHOLD && m_names.size() > 2 * m_entries.size()) {
+                for (auto it = m_names.begin(); it != m_names.end();) {
+                    if (it->second.use_count() == 1) {
+                        it = m_names.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+            }
+
+            m_updated = std::chrono::steady_clock::now();
+            m_hasUpdated = true;
+        }
+
+        void ProcessNameIndex::Insert(const ProcessEntry& process) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            SetLocked(process);
+        }
+
+        ProcessName ProcessNameIndex::Find(DWORD processId) const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(processId);
+            return it != m_entries.end() ? it->second.name : ProcessName();
+        }
+
+        std::chrono::steady_clock::duration ProcessNameIndex::Age() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_hasUpdated) {
+                return std::chrono::steady_clock::duration::max();
+            }
+            return std::chrono::steady_clock::now() - m_updated;
+        }
+
+        void ProcessNameIndex::Clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.clear();
+            m_names.clear();
+            m_hasUpdated = false;
+        }
+
+        const ProcessName& ProcessNameIndex::Intern(const std::string& name) {
+            auto it = m_names.find(name);
+            if (it == m_names.end()) {
+                it = m_names.emplace(name, std::make_shared<const std::string>(name)).first;
+            }
+            return it->second;
+        }
+
+        void ProcessNameIndex::SetLocked(const ProcessEntry& process) {
+            Entry& entry = m_entries[process.processId];
+            if (!entry.name || *entry.name != process.name) {
+                entry.name = Intern(process.name);
+            }
+            entry.generation = m_generation;
+        }
+    }
+}
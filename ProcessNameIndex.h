@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include "ProcessBackend.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // PID -> 进程名索引：每轮扫描用快照刷新一次，查询为 O(1) 且不分配内存
+        //
+        // 进程名驻留（intern）：同名进程共享同一个字符串，刷新时名称未变的条目不做任何分配。
+        // 查询返回共享指针，调用方持有期间字符串始终有效，不受之后的刷新影响。
+        // =============================================================================
+
+        using ProcessName = std::shared_ptr<const std::string>;
+
+        class ProcessNameIndex {
+        public:
+            // 用最新快照刷新索引，快照中不存在的 PID 被移除
+            void Update(const std::vector<ProcessEntry>& processes);
+
+            // 登记单个进程（事件路径或按需查询得到的新进程）
+            void Insert(const ProcessEntry& process);
+
+            // 未找到时返回空指针
+            ProcessName Find(DWORD processId) const;
+
+            // 距上次 Update 的时间，从未刷新时返回 duration::max()
+            std::chrono::steady_clock::duration Age() const;
+
+            void Clear();
+
+        private:
+            struct Entry {
+                ProcessName name;
+                uint64_t generation = 0;
+            };
+
+            // 调用方已持有 m_mutex
+            const ProcessName& Intern(const std::string& name);
+            void SetLocked(const ProcessEntry& process);
+
+            mutable std::mutex m_mutex;
+            std::unordered_map<DWORD, Entry> m_entries;
+            std::unordered_map<std::string, ProcessName> m_names;
+            uint64_t m_generation = 0;
+            std::chrono::steady_clock::time_point m_updated;
+            bool m_hasUpdated = false;
+        };
+    }
+}
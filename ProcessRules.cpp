@@ -0,0 +1,733 @@
+﻿#include "pch.h"
+#include "ProcessRules.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+
+#ifdef _WIN32
+            const char* const BUILTIN_CRITICAL_PROCESSES[] = {
+                "System", "Registry", "csrss.exe", "winlogon.exe",
+                "services.exe", "lsass.exe", "wininit.exe", "smss.exe"
+            };
+#else
+            const char* const BUILTIN_CRITICAL_PROCESSES[] = {
+                "init", "systemd", "kthreadd", "systemd-journal", "systemd-udevd"
+            };
+#endif
+
+            // 只转换 ASCII 字母，与 ToLowerAscii 一致，且不受区域设置影响
+            inline char LowerChar(char c) {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+
+            // 去掉 .exe 后缀后的长度
+            size_t NormalizedLength(const char* name, size_t length) {
+                if (length > 4 && name[length - 4] == '.' && LowerChar(name[length - 3]) == 'e' &&
+                    LowerChar(name[length - 2]) == 'x' && LowerChar(name[length - 1]) == 'e') {
+                    return length - 4;
+                }
+                return length;
+            }
+
+            // FNV-1a，按小写字符计算
+            uint64_t HashName(const char* name, size_t length) {
+                uint64_t hash = 14695981039346656037ull;
+                for (size_t i = 0; i < length; i++) {
+                    hash ^= static_cast<unsigned char>(LowerChar(name[i]));
+                    hash *= 1099511628211ull;
+                }
+                return hash;
+            }
+
+            bool EqualsLower(const std::string& normalized, const char* name, size_t length) {
+                if (normalized.size() != length) {
+                    return false;
+                }
+                for (size_t i = 0; i < length; i++) {
+                    if (normalized[i] != LowerChar(name[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // 通配符匹配：* 匹配任意长度，? 匹配单个字符
+            bool WildcardMatch(const std::string& pattern, const char* name, size_t length) {
+                size_t p = 0;
+                size_t n = 0;
+                size_t starPattern = std::string::npos;
+                size_t starName = 0;
+                while (n < length) {
+                    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == LowerChar(name[n]))) {
+                        p++;
+                        n++;
+                    }
+                    else if (p < pattern.size() && pattern[p] == '*') {
+                        starPattern = p++;
+                        starName = n;
+                    }
+                    else if (starPattern != std::string::npos) {
+                        p = starPattern + 1;
+                        n = ++starName;
+                    }
+                    else {
+                        return false;
+                    }
+                }
+                while (p < pattern.size() && pattern[p] == '*') {
+                    p++;
+                }
+                return p == pattern.size();
+            }
+
+            bool ParseCount(const std::string& text, DWORD& value) {
+                char* end = nullptr;
+                unsigned long parsed = strtoul(text.c_str(), &end, 10);
+                if (text.empty() || *end != '\0' || parsed == 0) {
+                    return false;
+                }
+                value = static_cast<DWORD>(parsed);
+                return true;
+            }
+
+            // 逗号分隔的列表，去掉空白与空项
+            std::vector<std::string> SplitList(const std::string& text) {
+                std::vector<std::string> items;
+                size_t begin = 0;
+                while (begin <= text.size()) {
+                    size_t end = text.find(',', begin);
+                    if (end == std::string::npos) {
+                        end = text.size();
+                    }
+                    std::string item = TrimIniText(text.substr(begin, end - begin));
+                    if (!item.empty()) {
+                        items.push_back(std::move(item));
+                    }
+                    begin = end + 1;
+                }
+                return items;
+            }
+
+            bool ParseInt(const std::string& text, int minimum, int maximum, int& value) {
+                char* end = nullptr;
+                long parsed = strtol(text.c_str(), &end, 10);
+                if (text.empty() || *end != '\0' || parsed < minimum || parsed > maximum) {
+                    return false;
+                }
+                value = static_cast<int>(parsed);
+                return true;
+            }
+
+            struct PriorityClassName {
+                const char* name;
+                DWORD priorityClass;
+            };
+
+            const PriorityClassName PRIORITY_CLASS_NAMES[] = {
+                { "idle", IDLE_PRIORITY_CLASS },
+                { "below_normal", BELOW_NORMAL_PRIORITY_CLASS },
+                { "normal", NORMAL_PRIORITY_CLASS },
+                { "above_normal", ABOVE_NORMAL_PRIORITY_CLASS },
+                { "high", HIGH_PRIORITY_CLASS },
+                { "realtime", REALTIME_PRIORITY_CLASS }
+            };
+
+            // 解析一项 "名称:值[:值]"
+            bool ParseSchedulingItem(const std::vector<std::string>& parts, ProcessScheduling& scheduling) {
+                const std::string& name = parts[0];
+                if (name == "priority" && parts.size() == 2) {
+                    for (const PriorityClassName& entry : PRIORITY_CLASS_NAMES) {
+                        if (parts[1] == entry.name) {
+                            scheduling.priorityClass = entry.priorityClass;
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+                if (name == "nice" && parts.size() == 2) {
+                    scheduling.hasNice = ParseInt(parts[1], -20, 19, scheduling.nice);
+                    return scheduling.hasNice;
+                }
+                if (name == "policy" && parts.size() >= 2) {
+                    const std::string& policy = parts[1];
+                    if (policy == "fifo" || policy == "rr") {
+                        scheduling.policy = policy == "fifo" ? ProcessScheduling::Policy::Fifo : ProcessScheduling::Policy::RoundRobin;
+                        return parts.size() == 3 && ParseInt(parts[2], 1, 99, scheduling.realtimePriority);
+                    }
+                    if (parts.size() != 2) {
+                        return false;
+                    }
+                    if (policy == "normal" || policy == "other") {
+                        scheduling.policy = ProcessScheduling::Policy::Normal;
+                    }
+                    else if (policy == "batch") {
+                        scheduling.policy = ProcessScheduling::Policy::Batch;
+                    }
+                    else if (policy == "idle") {
+                        scheduling.policy = ProcessScheduling::Policy::Idle;
+                    }
+                    else {
+                        return false;
+                    }
+                    return true;
+                }
+                if (name == "io" && parts.size() >= 2) {
+                    const std::string& ioClass = parts[1];
+                    if (ioClass == "idle") {
+                        scheduling.ioClass = ProcessScheduling::IoClass::Idle;
+                        return parts.size() == 2;
+                    }
+                    if (ioClass == "rt" || ioClass == "be") {
+                        scheduling.ioClass = ioClass == "rt" ? ProcessScheduling::IoClass::RealTime : ProcessScheduling::IoClass::BestEffort;
+                        scheduling.ioLevel = 4;
+                        return parts.size() == 2 || (parts.size() == 3 && ParseInt(parts[2], 0, 7, scheduling.ioLevel));
+                    }
+                    return false;
+                }
+                return false;
+            }
+        }
+
+        std::string NormalizeProcessName(const std::string& name) {
+            std::string normalized = ToLowerAscii(name);
+            normalized.resize(NormalizedLength(normalized.data(), normalized.size()));
+            return normalized;
+        }
+
+        bool ProcessNameEquals(const std::string& normalizedName, const std::string& processName) {
+            return EqualsLower(normalizedName, processName.data(), NormalizedLength(processName.data(), processName.size()));
+        }
+
+        bool ParseProcessScheduling(const std::string& text, ProcessScheduling& scheduling) {
+            ProcessScheduling parsed;
+            size_t begin = 0;
+            while (begin <= text.size()) {
+                size_t end = text.find(',', begin);
+                if (end == std::string::npos) {
+                    end = text.size();
+                }
+                std::string item = ToLowerAscii(TrimIniText(text.substr(begin, end - begin)));
+                begin = end + 1;
+                if (item.empty()) {
+                    continue;
+                }
+
+                std::vector<std::string> parts;
+                size_t partBegin = 0;
+                for (;;) {
+                    size_t colon = item.find(':', partBegin);
+                    parts.push_back(TrimIniText(item.substr(partBegin, colon == std::string::npos ? std::string::npos : colon - partBegin)));
+                    if (colon == std::string::npos) {
+                        break;
+                    }
+                    partBegin = colon + 1;
+                }
+                if (!ParseSchedulingItem(parts, parsed)) {
+                    return false;
+                }
+            }
+
+            if (parsed.IsEmpty()) {
+                return false;
+            }
+            scheduling = parsed;
+            return true;
+        }
+
+        std::string FormatProcessScheduling(const ProcessScheduling& scheduling) {
+            std::vector<std::string> items;
+            for (const PriorityClassName& entry : PRIORITY_CLASS_NAMES) {
+                if (scheduling.priorityClass == entry.priorityClass) {
+                    items.push_back(std::string("priority:") + entry.name);
+                }
+            }
+            if (scheduling.hasNice) {
+                items.push_back("nice:" + std::to_string(scheduling.nice));
+            }
+            switch (scheduling.policy) {
+            case ProcessScheduling::Policy::Normal:     items.push_back("policy:normal"); break;
+            case ProcessScheduling::Policy::Batch:      items.push_back("policy:batch"); break;
+            case ProcessScheduling::Policy::Idle:       items.push_back("policy:idle"); break;
+            case ProcessScheduling::Policy::Fifo:       items.push_back("policy:fifo:" + std::to_string(scheduling.realtimePriority)); break;
+            case ProcessScheduling::Policy::RoundRobin: items.push_back("policy:rr:" + std::to_string(scheduling.realtimePriority)); break;
+            case ProcessScheduling::Policy::Unchanged:  break;
+            }
+            switch (scheduling.ioClass) {
+            case ProcessScheduling::IoClass::RealTime:   items.push_back("io:rt:" + std::to_string(scheduling.ioLevel)); break;
+            case ProcessScheduling::IoClass::BestEffort: items.push_back("io:be:" + std::to_string(scheduling.ioLevel)); break;
+            case ProcessScheduling::IoClass::Idle:       items.push_back("io:idle"); break;
+            case ProcessScheduling::IoClass::Unchanged:  break;
+            }
+
+            std::string text;
+            for (const std::string& item : items) {
+                if (!text.empty()) {
+                    text += ", ";
+                }
+                text += item;
+            }
+            return text;
+        }
+
+        bool ParseProcessMemoryPolicy(const std::string& text, ProcessMemoryPolicy& policy) {
+            ProcessMemoryPolicy parsed;
+            size_t begin = 0;
+            while (begin <= text.size()) {
+                size_t end = text.find(',', begin);
+                if (end == std::string::npos) {
+                    end = text.size();
+                }
+                std::string item = ToLowerAscii(TrimIniText(text.substr(begin, end - begin)));
+                begin = end + 1;
+
+                if (item == "bind" || item == "preferred") {
+                    if (!parsed.IsEmpty()) {
+                        return false;
+                    }
+                    parsed.mode = item == "bind" ? ProcessMemoryPolicy::Mode::Bind : ProcessMemoryPolicy::Mode::Preferred;
+                }
+                else if (item == "migrate") {
+                    parsed.migrate = true;
+                }
+                else if (!item.empty()) {
+                    return false;
+                }
+            }
+
+            if (parsed.IsEmpty()) {
+                return false;
+            }
+            policy = parsed;
+            return true;
+        }
+
+        std::string FormatProcessMemoryPolicy(const ProcessMemoryPolicy& policy) {
+            std::string text;
+            switch (policy.mode) {
+            case ProcessMemoryPolicy::Mode::Bind:       text = "bind"; break;
+            case ProcessMemoryPolicy::Mode::Preferred:  text = "preferred"; break;
+            case ProcessMemoryPolicy::Mode::None:       break;
+            }
+            if (policy.migrate) {
+                text += text.empty() ? "migrate" : ", migrate";
+            }
+            return text;
+        }
+
+        // =============================================================================
+        // 规则构建
+        // =============================================================================
+
+        ProcessRuleSet::ProcessRuleSet() {
+            for (const char* name : BUILTIN_CRITICAL_PROCESSES) {
+                AddCritical(name);
+            }
+            Compile();
+        }
+
+        bool ProcessRuleSet::Load(const std::string& iniPath) {
+            std::vector<IniEntry> entries;
+            if (!ReadIniFile(iniPath, entries)) {
+                return false;
+            }
+
+            Load(entries);
+            return true;
+        }
+
+        void ProcessRuleSet::Load(const std::vector<IniEntry>& entries) {
+            ProcessRuleSet loaded;
+            for (const IniEntry& entry : entries) {
+                bool valid = true;
+                DWORD count = 0;
+                CpuSet cores;
+                ProcessScheduling scheduling;
+                ProcessMemoryPolicy memoryPolicy;
+
+                if (entry.section == "processname") {
+                    valid = ParseCount(entry.value, count);
+                    if (valid) {
+                        loaded.AddNameCoreCount(entry.key, count);
+                    }
+                }
+                else if (entry.section == "pid") {
+                    DWORD processId = 0;
+                    valid = ParseCount(entry.key, processId) && ParseCount(entry.value, count);
+                    if (valid) {
+                        loaded.AddPidCoreCount(processId, count);
+                    }
+                }
+                else if (entry.section == "processcorebinding") {
+                    valid = CpuSet::Parse(entry.value, cores) && !cores.Empty();
+                    if (valid) {
+                        loaded.AddNameBinding(entry.key, cores);
+                    }
+                }
+                else if (entry.section == "pidcorebinding") {
+                    DWORD processId = 0;
+                    valid = ParseCount(entry.key, processId) && CpuSet::Parse(entry.value, cores) && !cores.Empty();
+                    if (valid) {
+                        loaded.AddPidBinding(processId, cores);
+                    }
+                }
+                else if (entry.section == "processscheduling") {
+                    valid = ParseProcessScheduling(entry.value, scheduling);
+                    if (valid) {
+                        loaded.AddNameScheduling(entry.key, scheduling);
+                    }
+                }
+                else if (entry.section == "pidscheduling") {
+                    DWORD processId = 0;
+                    valid = ParseCount(entry.key, processId) && ParseProcessScheduling(entry.value, scheduling);
+                    if (valid) {
+                        loaded.AddPidScheduling(processId, scheduling);
+                    }
+                }
+                else if (entry.section == "processmemorypolicy") {
+                    valid = ParseProcessMemoryPolicy(entry.value, memoryPolicy);
+                    if (valid) {
+                        loaded.AddNameMemoryPolicy(entry.key, memoryPolicy);
+                    }
+                }
+                else if (entry.section == "pidmemorypolicy") {
+                    DWORD processId = 0;
+                    valid = ParseCount(entry.key, processId) && ParseProcessMemoryPolicy(entry.value, memoryPolicy);
+                    if (valid) {
+                        loaded.AddPidMemoryPolicy(processId, memoryPolicy);
+                    }
+                }
+                else if (entry.section == "critical" && ToLowerAscii(entry.key) == "processes") {
+                    for (const std::string& name : SplitList(entry.value)) {
+                        loaded.AddCritical(name);
+                    }
+                }
+                else if (entry.section == "processtree" && ToLowerAscii(entry.key) == "processes") {
+                    for (const std::string& name : SplitList(entry.value)) {
+                        loaded.AddNameTree(name);
+                    }
+                }
+                else if (entry.section == "processtree" && ToLowerAscii(entry.key) == "pids") {
+                    for (const std::string& item : SplitList(entry.value)) {
+                        DWORD processId = 0;
+                        if (ParseCount(item, processId)) {
+                            loaded.AddPidTree(processId);
+                        }
+                        else {
+                            valid = false;
+                        }
+                    }
+                }
+
+                if (!valid) {
+                    std::cerr << "忽略格式错误的进程规则（第 " << entry.line << " 行）: "
+                        << entry.key << "=" << entry.value << std::endl;
+                }
+            }
+
+            loaded.Compile();
+            *this = std::move(loaded);
+        }
+
+        ProcessRuleSet::NameRule& ProcessRuleSet::GetNameRule(const std::string& pattern) {
+            std::string normalized = NormalizeProcessName(TrimIniText(pattern));
+            auto it = m_patternIndex.find(normalized);
+            if (it != m_patternIndex.end()) {
+                return m_nameRules[it->second];
+            }
+
+            m_patternIndex.emplace(normalized, static_cast<uint32_t>(m_nameRules.size()));
+            m_nameRules.emplace_back();
+            m_nameRules.back().pattern = std::move(normalized);
+            return m_nameRules.back();
+        }
+
+        void ProcessRuleSet::AddNameCoreCount(const std::string& pattern, DWORD coreCount) {
+            NameRule& rule = GetNameRule(pattern);
+            rule.flags |= HasCoreCount;
+            rule.coreCount = coreCount;
+        }
+
+        void ProcessRuleSet::AddNameBinding(const std::string& pattern, const CpuSet& cores) {
+            NameRule& rule = GetNameRule(pattern);
+            rule.flags |= HasBinding;
+            rule.cores = cores;
+        }
+
+        void ProcessRuleSet::AddPidCoreCount(DWORD processId, DWORD coreCount) {
+            PidRule& rule = m_pidRules[processId];
+            rule.flags |= HasCoreCount;
+            rule.coreCount = coreCount;
+        }
+
+        void ProcessRuleSet::AddPidBinding(DWORD processId, const CpuSet& cores) {
+            PidRule& rule = m_pidRules[processId];
+            rule.flags |= HasBinding;
+            rule.cores = cores;
+        }
+
+        void ProcessRuleSet::AddCritical(const std::string& pattern) {
+            GetNameRule(pattern).flags |= IsCriticalName;
+        }
+
+        void ProcessRuleSet::AddNameScheduling(const std::string& pattern, const ProcessScheduling& scheduling) {
+            NameRule& rule = GetNameRule(pattern);
+            rule.flags |= HasScheduling;
+            rule.scheduling = scheduling;
+        }
+
+        void ProcessRuleSet::AddPidScheduling(DWORD processId, const ProcessScheduling& scheduling) {
+            PidRule& rule = m_pidRules[processId];
+            rule.flags |= HasScheduling;
+            rule.scheduling = scheduling;
+        }
+
+        void ProcessRuleSet::AddNameMemoryPolicy(const std::string& pattern, const ProcessMemoryPolicy& policy) {
+            NameRule& rule = GetNameRule(pattern);
+            rule.flags |= HasMemoryPolicy;
+            rule.memoryPolicy = policy;
+        }
+
+        void ProcessRuleSet::AddPidMemoryPolicy(DWORD processId, const ProcessMemoryPolicy& policy) {
+            PidRule& rule = m_pidRules[processId];
+            rule.flags |= HasMemoryPolicy;
+            rule.memoryPolicy = policy;
+        }
+
+        void ProcessRuleSet::AddNameTree(const std::string& pattern) {
+            GetNameRule(pattern).flags |= HasTree;
+        }
+
+        void ProcessRuleSet::AddPidTree(DWORD processId) {
+            m_pidRules[processId].flags |= HasTree;
+        }
+
+        void ProcessRuleSet::Compile() {
+            m_exactHashes.assign(m_nameRules.size(), 0);
+            m_prefixTrie.assign(1, TrieNode());
+            m_wildcards.clear();
+
+            m_hasScheduling = false;
+            m_hasMemoryPolicy = false;
+            m_hasTree = false;
+            for (const NameRule& rule : m_nameRules) {
+                m_hasScheduling = m_hasScheduling || (rule.flags & HasScheduling) != 0;
+                m_hasMemoryPolicy = m_hasMemoryPolicy || (rule.flags & HasMemoryPolicy) != 0;
+                m_hasTree = m_hasTree || (rule.flags & HasTree) != 0;
+            }
+            for (const auto& pid : m_pidRules) {
+                m_hasScheduling = m_hasScheduling || (pid.second.flags & HasScheduling) != 0;
+                m_hasMemoryPolicy = m_hasMemoryPolicy || (pid.second.flags & HasMemoryPolicy) != 0;
+                m_hasTree = m_hasTree || (pid.second.flags & HasTree) != 0;
+            }
+
+            size_t bucketCount = 16;
+            while (bucketCount < m_nameRules.size() * 2) {
+                bucketCount <<= 1;
+            }
+            m_exactBuckets.assign(bucketCount, -1);
+
+            for (uint32_t i = 0; i < m_nameRules.size(); i++) {
+                const std::string& pattern = m_nameRules[i].pattern;
+                size_t wildcard = pattern.find_first_of("*?");
+
+                if (wildcard == std::string::npos) {
+                    uint64_t hash = HashName(pattern.data(), pattern.size());
+                    m_exactHashes[i] = hash;
+                    size_t slot = static_cast<size_t>(hash) & (bucketCount - 1);
+                    while (m_exactBuckets[slot] != -1) {
+                        slot = (slot + 1) & (bucketCount - 1);
+                    }
+                    m_exactBuckets[slot] = static_cast<int32_t>(i);
+                }
+                else if (wildcard == pattern.size() - 1 && pattern.back() == '*') {
+                    InsertPrefix(pattern.substr(0, wildcard), i);
+                }
+                else {
+                    m_wildcards.push_back(i);
+                }
+            }
+        }
+
+        void ProcessRuleSet::InsertPrefix(const std::string& prefix, uint32_t rule) {
+            uint32_t node = 0;
+            for (char c : prefix) {
+                std::vector<std::pair<char, uint32_t>>& children = m_prefixTrie[node].children;
+                auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(c, 0u),
+                    [](const std::pair<char, uint32_t>& a, const std::pair<char, uint32_t>& b) { return a.first < b.first; });
+                if (it != children.end() && it->first == c) {
+                    node = it->second;
+                    continue;
+                }
+
+                uint32_t child = static_cast<uint32_t>(m_prefixTrie.size());
+                children.insert(it, std::make_pair(c, child));
+                m_prefixTrie.emplace_back();
+                node = child;
+            }
+            m_prefixTrie[node].rule = static_cast<int32_t>(rule);
+        }
+
+        // =============================================================================
+        // 规则查询
+        // =============================================================================
+
+        const ProcessRuleSet::NameRule* ProcessRuleSet::FindNameRule(const char* name, size_t length, uint8_t flag) const {
+            if (m_nameRules.empty()) {
+                return nullptr;
+            }
+
+            // 精确匹配
+            uint64_t hash = HashName(name, length);
+            size_t mask = m_exactBuckets.size() - 1;
+            for (size_t slot = static_cast<size_t>(hash) & mask; m_exactBuckets[slot] != -1; slot = (slot + 1) & mask) {
+                const NameRule& rule = m_nameRules[m_exactBuckets[slot]];
+                if (m_exactHashes[m_exactBuckets[slot]] == hash && (rule.flags & flag) && EqualsLower(rule.pattern, name, length)) {
+                    return &rule;
+                }
+            }
+
+            // 最长前缀：沿前缀树向下，记录最后一个带有 flag 的节点
+            const NameRule* best = nullptr;
+            uint32_t node = 0;
+            for (size_t i = 0;; i++) {
+                int32_t ruleIndex = m_prefixTrie[node].rule;
+                if (ruleIndex >= 0 && (m_nameRules[ruleIndex].flags & flag)) {
+                    best = &m_nameRules[ruleIndex];
+                }
+                if (i == length) {
+                    break;
+                }
+
+                const std::vector<std::pair<char, uint32_t>>& children = m_prefixTrie[node].children;
+                char c = LowerChar(name[i]);
+                auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(c, 0u),
+                    [](const std::pair<char, uint32_t>& a, const std::pair<char, uint32_t>& b) { return a.first < b.first; });
+                if (it == children.end() || it->first != c) {
+                    break;
+                }
+                node = it->second;
+            }
+            if (best) {
+                return best;
+            }
+
+            for (uint32_t index : m_wildcards) {
+                const NameRule& rule = m_nameRules[index];
+                if ((rule.flags & flag) && WildcardMatch(rule.pattern, name, length)) {
+                    return &rule;
+                }
+            }
+            return nullptr;
+        }
+
+        bool ProcessRuleSet::IsCritical(const std::string& processName) const {
+            size_t length = NormalizedLength(processName.data(), processName.size());
+            return FindNameRule(processName.data(), length, IsCriticalName) != nullptr;
+        }
+
+        ProcessRuleMatch ProcessRuleSet::Resolve(DWORD processId, const std::string& processName) const {
+            ProcessRuleMatch match;
+
+            auto pid = m_pidRules.find(processId);
+            if (pid != m_pidRules.end()) {
+                if (pid->second.flags & HasBinding) {
+                    match.kind = ProcessRuleKind::PidBinding;
+                    match.cores = &pid->second.cores;
+                    return match;
+                }
+                // 只有调度或内存策略规则的 PID 继续按进程名匹配亲和性规则
+                if (pid->second.flags & HasCoreCount) {
+                    match.kind = ProcessRuleKind::PidCoreCount;
+                    match.coreCount = pid->second.coreCount;
+                    return match;
+                }
+            }
+
+            size_t length = NormalizedLength(processName.data(), processName.size());
+            if (const NameRule* rule = FindNameRule(processName.data(), length, HasBinding)) {
+                match.kind = ProcessRuleKind::NameBinding;
+                match.cores = &rule->cores;
+            }
+            else if (const NameRule* rule = FindNameRule(processName.data(), length, HasCoreCount)) {
+                match.kind = ProcessRuleKind::NameCoreCount;
+                match.coreCount = rule->coreCount;
+            }
+            return match;
+        }
+
+        const ProcessScheduling* ProcessRuleSet::ResolveScheduling(DWORD processId, const std::string& processName) const {
+            if (!m_hasScheduling) {
+                return nullptr;
+            }
+
+            auto pid = m_pidRules.find(processId);
+            if (pid != m_pidRules.end() && (pid->second.flags & HasScheduling)) {
+                return &pid->second.scheduling;
+            }
+
+            size_t length = NormalizedLength(processName.data(), processName.size());
+            const NameRule* rule = FindNameRule(processName.data(), length, HasScheduling);
+            return rule ? &rule->scheduling : nullptr;
+        }
+
+        bool ProcessRuleSet::HasSchedulingRules() const {
+            return m_hasScheduling;
+        }
+
+        const ProcessMemoryPolicy* ProcessRuleSet::ResolveMemoryPolicy(DWORD processId, const std::string& processName) const {
+            if (!m_hasMemoryPolicy) {
+                return nullptr;
+            }
+
+            auto pid = m_pidRules.find(processId);
+            if (pid != m_pidRules.end() && (pid->second.flags & HasMemoryPolicy)) {
+                return &pid->second.memoryPolicy;
+            }
+
+            size_t length = NormalizedLength(processName.data(), processName.size());
+            const NameRule* rule = FindNameRule(processName.data(), length, HasMemoryPolicy);
+            return rule ? &rule->memoryPolicy : nullptr;
+        }
+
+        bool ProcessRuleSet::IsTreeRoot(DWORD processId, const std::string& processName) const {
+            if (!m_hasTree) {
+                return false;
+            }
+
+            auto pid = m_pidRules.find(processId);
+            if (pid != m_pidRules.end() && (pid->second.flags & HasTree)) {
+                return true;
+            }
+
+            size_t length = NormalizedLength(processName.data(), processName.size());
+            return FindNameRule(processName.data(), length, HasTree) != nullptr;
+        }
+
+        bool ProcessRuleSet::HasTreeRules() const {
+            return m_hasTree;
+        }
+
+        size_t ProcessRuleSet::GetRuleCount() const {
+            // 同一模式或 PID 在多个节中出现时分别计数
+            auto countFlags = [](uint8_t flags) {
+                return static_cast<size_t>((flags & HasCoreCount) != 0) + ((flags & HasBinding) != 0) +
+                    ((flags & IsCriticalName) != 0) + ((flags & HasScheduling) != 0) + ((flags & HasMemoryPolicy) != 0) +
+                    ((flags & HasTree) != 0);
+            };
+
+            size_t count = 0;
+            for (const auto& pid : m_pidRules) {
+                count += countFlags(pid.second.flags);
+            }
+            for (const NameRule& rule : m_nameRules) {
+                count += countFlags(rule.flags);
+            }
+            return count;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+﻿#pragma once
+
+#include "CpuSet.h"
+#include "IniFile.h"
+#include "ProcessBackend.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 进程规则：加载 [ProcessName] / [PID] / [ProcessCoreBinding] / [PidCoreBinding] / [Critical]
+        // 以及调度规则 [ProcessScheduling] / [PidScheduling]、内存策略 [ProcessMemoryPolicy] / [PidMemoryPolicy]、
+        // 继承范围 [ProcessTree]，编译为哈希表（精确名）+ 前缀树（name*）+ 通配符列表（含 * ? 的其他模式）
+        //
+        // 优先级：PID 核心绑定 > PID 核心数 > 进程名核心绑定 > 进程名核心数；调度规则与内存策略 PID 优先于进程名，
+        // 与亲和性规则相互独立。同一类进程名规则中精确匹配优先，其次最长前缀，最后按文件顺序匹配通配符。
+        // 进程名不区分大小写并忽略 .exe 后缀，查询过程不分配内存。
+        // [ProcessTree] 中的进程（processes=名称列表，pids=PID 列表）的规则同时适用于其全部后代，
+        // 后代自身的同类规则优先（见 ProcessTree.h 的 ResolveProcessRules）。
+        // =============================================================================
+
+        enum class ProcessRuleKind {
+            None,
+            PidBinding,         // [PidCoreBinding]
+            PidCoreCount,       // [PID]
+            NameBinding,        // [ProcessCoreBinding]
+            NameCoreCount       // [ProcessName]
+        };
+
+        struct ProcessRuleMatch {
+            ProcessRuleKind kind = ProcessRuleKind::None;
+            DWORD coreCount = 0;            // 核心数规则
+            const CpuSet* cores = nullptr;  // 核心绑定规则，规则集存活期间有效
+        };
+
+        // 去掉 .exe 后缀并转为小写，Windows 与 Linux 的进程名可按同一规则比较
+        std::string NormalizeProcessName(const std::string& name);
+        // 比较已规范化的名称与原始进程名，不分配内存
+        bool ProcessNameEquals(const std::string& normalizedName, const std::string& processName);
+
+        // 解析调度规则的值，逗号分隔，例如：
+        //   priority:high                      优先级类别 idle / below_normal / normal / above_normal / high / realtime
+        //   nice:10, io:idle                   nice 值 -20 ~ 19；I/O 优先级 rt[:级别] / be[:级别] / idle，级别 0 ~ 7
+        //   policy:fifo:80, io:rt:0            调度策略 normal / batch / idle / fifo:优先级 / rr:优先级
+        bool ParseProcessScheduling(const std::string& text, ProcessScheduling& scheduling);
+        // 格式化为与配置文件相同的写法
+        std::string FormatProcessScheduling(const ProcessScheduling& scheduling);
+
+        // 解析内存策略：bind / preferred，可附加 migrate，例如 "bind, migrate"
+        // 节点不在规则中指定，由进程绑定的核心所在的 NUMA 节点决定
+        bool ParseProcessMemoryPolicy(const std::string& text, ProcessMemoryPolicy& policy);
+        std::string FormatProcessMemoryPolicy(const ProcessMemoryPolicy& policy);
+
+        class ProcessRuleSet {
+        public:
+            // 内置系统关键进程列表
+            ProcessRuleSet();
+
+            // 读取 INI 文件并重新编译，文件无法打开时返回 false 且规则保持不变
+            bool Load(const std::string& iniPath);
+            // 由已读取的 INI 内容重新编译，忽略无关的节
+            void Load(const std::vector<IniEntry>& entries);
+
+            void AddNameCoreCount(const std::string& pattern, DWORD coreCount);
+            void AddNameBinding(const std::string& pattern, const CpuSet& cores);
+            void AddPidCoreCount(DWORD processId, DWORD coreCount);
+            void AddPidBinding(DWORD processId, const CpuSet& cores);
+            void AddCritical(const std::string& pattern);
+            void AddNameScheduling(const std::string& pattern, const ProcessScheduling& scheduling);
+            void AddPidScheduling(DWORD processId, const ProcessScheduling& scheduling);
+            void AddNameMemoryPolicy(const std::string& pattern, const ProcessMemoryPolicy& policy);
+            void AddPidMemoryPolicy(DWORD processId, const ProcessMemoryPolicy& policy);
+            // 规则同时适用于该进程的全部后代
+            void AddNameTree(const std::string& pattern);
+            void AddPidTree(DWORD processId);
+
+            // 规则修改后需重新编译索引；Load 会自动编译
+            void Compile();
+
+            bool IsCritical(const std::string& processName) const;
+            ProcessRuleMatch Resolve(DWORD processId, const std::string& processName) const;
+            // 没有调度规则时返回 nullptr，返回值在规则集存活期间有效
+            const ProcessScheduling* ResolveScheduling(DWORD processId, const std::string& processName) const;
+            bool HasSchedulingRules() const;
+            // 没有内存策略规则时返回 nullptr，返回值在规则集存活期间有效
+            const ProcessMemoryPolicy* ResolveMemoryPolicy(DWORD processId, const std::string& processName) const;
+            // 进程是否在 [ProcessTree] 中
+            bool IsTreeRoot(DWORD processId, const std::string& processName) const;
+            bool HasTreeRules() const;
+
+            size_t GetRuleCount() const;
+
+        private:
+            enum NameFlags : uint8_t {
+                HasCoreCount = 1,
+                HasBinding = 2,
+                IsCriticalName = 4,
+                HasScheduling = 8,
+                HasMemoryPolicy = 16,
+                HasTree = 32
+            };
+
+            struct NameRule {
+                std::string pattern;        // 已规范化
+                uint8_t flags = 0;
+                DWORD coreCount = 0;
+                CpuSet cores;
+                ProcessScheduling scheduling;
+                ProcessMemoryPolicy memoryPolicy;
+            };
+
+            struct PidRule {
+                uint8_t flags = 0;
+                DWORD coreCount = 0;
+                CpuSet cores;
+                ProcessScheduling scheduling;
+                ProcessMemoryPolicy memoryPolicy;
+            };
+
+            struct TrieNode {
+                std::vector<std::pair<char, uint32_t>> children;   // 按字符排序
+                int32_t rule = -1;
+            };
+
+            NameRule& GetNameRule(const std::string& pattern);
+            // 按精确 > 最长前缀 > 通配符的顺序返回第一个带有 flag 的规则
+            const NameRule* FindNameRule(const char* name, size_t length, uint8_t flag) const;
+            void InsertPrefix(const std::string& prefix, uint32_t rule);
+
+            std::vector<NameRule> m_nameRules;
+            std::unordered_map<std::string, uint32_t> m_patternIndex;   // 仅在构建时使用
+            std::unordered_map<DWORD, PidRule> m_pidRules;
+            bool m_hasScheduling = false;
+            bool m_hasMemoryPolicy = false;
+            bool m_hasTree = false;
+
+            // 编译后的索引
+            std::vector<int32_t> m_exactBuckets;    // 开放寻址，元素为 m_nameRules 下标
+            std::vector<uint64_t> m_exactHashes;    // 与 m_nameRules 对应
+            std::vector<TrieNode> m_prefixTrie;
+            std::vector<uint32_t> m_wildcards;
+        };
+    }
+}
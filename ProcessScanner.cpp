@@ -0,0 +1,97 @@
+﻿#include "pch.h"
+#include "ProcessScanner.h"
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        IncrementalProcessScanner::IncrementalProcessScanner(std::chrono::milliseconds revalidatePeriod)
+            : m_round(0)
+            , m_newCount(0)
+            , m_revalidatePeriod(revalidatePeriod.count() <= 0 ? std::chrono::milliseconds(1) : revalidatePeriod)
+        {
+        }
+
+        void IncrementalProcessScanner::Update(const std::vector<ProcessEntry>& processes,
+                                               std::vector<const ProcessEntry*>& changed,
+                                               std::vector<DWORD>* exited) {
+            changed.clear();
+            if (exited != nullptr) {
+                exited->clear();
+            }
+
+            m_round++;
+            m_newCount = 0;
+            auto now = std::chrono::steady_clock::now();
+
+            for (const ProcessEntry& process : processes) {
+                auto it = m_known.find(process.processId);
+                if (it == m_known.end()) {
+                    KnownProcess known;
+                    known.startTime = process.startTime;
+                    known.seenRound = m_round;
+                    ResetChecked(process.processId, known, now);
+                    m_known.emplace(process.processId, known);
+                    changed.push_back(&process);
+                    m_newCount++;
+                    continue;
+                }
+
+                // 创建时间为 0 表示未知（Windows 快照不含创建时间），此时依赖句柄缓存持有句柄阻止 PID 复用
+                KnownProcess& known = it->second;
+                if (process.startTime != 0 && known.startTime != 0 && known.startTime != process.startTime) {
+                    // PID 被复用：旧实例视为退出，新实例视为新建
+                    if (exited != nullptr) {
+                        exited->push_back(process.processId);
+                    }
+                    known.startTime = process.startTime;
+                    known.checked = now;
+                    changed.push_back(&process);
+                    m_newCount++;
+                }
+                else if (now - known.checked >= m_revalidatePeriod) {
+                    known.checked = now;
+                    changed.push_back(&process);
+                }
+                known.seenRound = m_round;
+            }
+
+            // 本轮未出现的进程已退出
+            if (m_known.size() > processes.size()) {
+                for (auto it = m_known.begin(); it != m_known.end();) {
+                    if (it->second.seenRound != m_round) {
+                        if (exited != nullptr) {
+                            exited->push_back(it->first);
+                        }
+                        it = m_known.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        void IncrementalProcessScanner::MarkProcessed(const ProcessEntry& process) {
+            auto it = m_known.find(process.processId);
+            if (it == m_known.end()) {
+                it = m_known.emplace(process.processId, KnownProcess()).first;
+                ResetChecked(process.processId, it->second, std::chrono::steady_clock::now());
+            }
+            it->second.startTime = process.startTime;
+            it->second.seenRound = m_round;
+        }
+
+        void IncrementalProcessScanner::Reset() {
+            m_known.clear();
+            m_round = 0;
+            m_newCount = 0;
+        }
+
+        void IncrementalProcessScanner::ResetChecked(DWORD processId, KnownProcess& known,
+                                                     std::chrono::steady_clock::time_point now) const {
+            // Windows PID 为 4 的倍数，先打散再映射到周期内的偏移
+            uint32_t slot = (static_cast<uint32_t>(processId) * 2654435761u) >> 16;
+            known.checked = now - m_revalidatePeriod * slot / 65536;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include "ProcessBackend.h"
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 增量进程扫描：与上一轮快照比较，只返回需要处理的进程
+        //
+        // 新出现的 PID、创建时间变化（PID 被复用）的进程每轮都会返回；
+        // 已知进程距上次检查超过 revalidatePeriod 时复检一次，用于发现进程自行重置亲和性的情况，
+        // 复检延迟不超过 revalidatePeriod 加一个扫描间隔，与扫描间隔的退避无关。
+        // 首次复检时间按 PID 打散到整个周期内，扫描间隔小于周期时稳态下每轮的平台调用次数
+        // 与进程变化量加 进程数×间隔/周期 成正比，而不是与进程总数成正比。
+        // =============================================================================
+
+        class IncrementalProcessScanner {
+        public:
+            explicit IncrementalProcessScanner(std::chrono::milliseconds revalidatePeriod = std::chrono::milliseconds(5000));
+
+            // 比较新快照；changed 为需要处理的进程（指向 processes 内的元素），
+            // exited 为自上一轮以来退出或被复用的 PID（可为 nullptr）
+            void Update(const std::vector<ProcessEntry>& processes,
+                        std::vector<const ProcessEntry*>& changed,
+                        std::vector<DWORD>* exited = nullptr);
+
+            // 将进程标记为已处理（例如事件驱动路径已处理过），下一轮不再作为新进程返回
+            void MarkProcessed(const ProcessEntry& process);
+
+            // 清空历史，下一轮返回全部进程
+            void Reset();
+
+            size_t Size() const { return m_known.size(); }
+            // 上一轮 Update 中新出现或 PID 被复用的进程数（不含轮到复检的进程）
+            size_t GetNewCount() const { return m_newCount; }
+
+        private:
+            struct KnownProcess {
+                uint64_t startTime = 0;
+                uint64_t seenRound = 0;
+                std::chrono::steady_clock::time_point checked;  // 上次检查时间
+            };
+
+            // 新进程的上次检查时间按 PID 提前 0 ~ 一个周期，使已知进程的复检分摊到各轮
+            void ResetChecked(DWORD processId, KnownProcess& known, std::chrono::steady_clock::time_point now) const;
+
+            std::unordered_map<DWORD, KnownProcess> m_known;
+            uint64_t m_round;
+            size_t m_newCount;
+            std::chrono::steady_clock::duration m_revalidatePeriod;
+        };
+    }
+}
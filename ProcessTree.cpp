@@ -0,0 +1,195 @@
+﻿#include "pch.h"
+#include "ProcessTree.h"
+#include <algorithm>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            // 父进程链的最大深度，防止异常数据形成环
+            const size_t MAX_ANCESTOR_DEPTH = 64;
+        }
+
+        void ProcessTree::Update(const std::vector<ProcessEntry>& processes) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_generation++;
+
+            for (const ProcessEntry& process : processes) {
+                SetLocked(process);
+            }
+
+            for (auto it = m_nodes.begin(); it != m_nodes.end();) {
+                if (it->second.generation != m_generation) {
+                    UnlinkLocked(it->second.process.parentProcessId, it->first);
+                    it = m_nodes.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        void ProcessTree::Insert(const ProcessEntry& process) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            SetLocked(process);
+        }
+
+        bool ProcessTree::Find(DWORD processId, ProcessEntry& process) const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_nodes.find(processId);
+            if (it == m_nodes.end()) {
+                return false;
+            }
+            process = it->second.process;
+            return true;
+        }
+
+        bool ProcessTree::VisitAncestors(const ProcessEntry& process,
+            const std::function<bool(const ProcessEntry& ancestor)>& visitor) const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const ProcessEntry* child = &process;
+            for (size_t depth = 0; depth < MAX_ANCESTOR_DEPTH; depth++) {
+                if (child->parentProcessId == child->processId) {
+                    return false;
+                }
+                auto it = m_nodes.find(child->parentProcessId);
+                if (it == m_nodes.end() || !IsParentOf(it->second.process, *child)) {
+                    return false;
+                }
+                if (visitor(it->second.process)) {
+                    return true;
+                }
+                child = &it->second.process;
+            }
+            return false;
+        }
+
+        std::vector<DWORD> ProcessTree::GetDescendants(DWORD processId) const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<DWORD> descendants;
+            auto root = m_nodes.find(processId);
+            if (root == m_nodes.end()) {
+                return descendants;
+            }
+
+            std::vector<const ProcessEntry*> queue{ &root->second.process };
+            for (size_t next = 0; next < queue.size(); next++) {
+                const ProcessEntry& parent = *queue[next];
+                auto children = m_children.find(parent.processId);
+                if (children == m_children.end()) {
+                    continue;
+                }
+                for (DWORD childId : children->second) {
+                    auto child = m_nodes.find(childId);
+                    // 跳过自身为父进程的条目（Windows 的 System Idle Process）
+                    if (child == m_nodes.end() || childId == parent.processId || !IsParentOf(parent, child->second.process)) {
+                        continue;
+                    }
+                    descendants.push_back(childId);
+                    queue.push_back(&child->second.process);
+                }
+            }
+            return descendants;
+        }
+
+        size_t ProcessTree::Size() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_nodes.size();
+        }
+
+        void ProcessTree::Clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_nodes.clear();
+            m_children.clear();
+        }
+
+        void ProcessTree::SetLocked(const ProcessEntry& process) {
+            auto inserted = m_nodes.emplace(process.processId, Node());
+            Node& node = inserted.first->second;
+            if (inserted.second) {
+                LinkLocked(process.parentProcessId, process.processId);
+            }
+            // Windows 的单进程查询不提供父进程，保留快照中的父进程（同一实例时）
+            else if (process.parentProcessId == 0 && node.process.startTime == process.startTime) {
+                DWORD parentProcessId = node.process.parentProcessId;
+                node.process = process;
+                node.process.parentProcessId = parentProcessId;
+                node.generation = m_generation;
+                return;
+            }
+            else if (node.process.parentProcessId != process.parentProcessId) {
+                UnlinkLocked(node.process.parentProcessId, process.processId);
+                LinkLocked(process.parentProcessId, process.processId);
+            }
+
+            if (node.process.startTime != process.startTime || node.process.name != process.name ||
+                node.process.parentProcessId != process.parentProcessId) {
+                node.process = process;
+            }
+            node.generation = m_generation;
+        }
+
+        void ProcessTree::LinkLocked(DWORD parentId, DWORD childId) {
+            m_children[parentId].push_back(childId);
+        }
+
+        void ProcessTree::UnlinkLocked(DWORD parentId, DWORD childId) {
+            auto it = m_children.find(parentId);
+            if (it == m_children.end()) {
+                return;
+            }
+
+            std::vector<DWORD>& children = it->second;
+            auto child = std::find(children.begin(), children.end(), childId);
+            if (child != children.end()) {
+                *child = children.back();
+                children.pop_back();
+            }
+            if (children.empty()) {
+                m_children.erase(it);
+            }
+        }
+
+        bool ProcessTree::IsParentOf(const ProcessEntry& parent, const ProcessEntry& child) {
+            // 创建时间未知时只能信任 PID
+            return parent.startTime == 0 || child.startTime == 0 || parent.startTime <= child.startTime;
+        }
+
+        ResolvedProcessRules ResolveProcessRules(const ProcessRuleSet& rules, const ProcessTree& tree, const ProcessEntry& process) {
+            ResolvedProcessRules resolved;
+            resolved.match = rules.Resolve(process.processId, process.name);
+            resolved.scheduling = rules.ResolveScheduling(process.processId, process.name);
+            resolved.memoryPolicy = rules.ResolveMemoryPolicy(process.processId, process.name);
+            if (!rules.HasTreeRules()) {
+                return resolved;
+            }
+            resolved.treeRule = resolved.match.kind != ProcessRuleKind::None && rules.IsTreeRoot(process.processId, process.name);
+            if (resolved.match.kind != ProcessRuleKind::None && resolved.scheduling != nullptr && resolved.memoryPolicy != nullptr) {
+                return resolved;
+            }
+
+            // 每类规则分别取最近的带有该类规则的 [ProcessTree] 祖先
+            tree.VisitAncestors(process, [&rules, &resolved](const ProcessEntry& ancestor) {
+                if (!rules.IsTreeRoot(ancestor.processId, ancestor.name)) {
+                    return false;
+                }
+                if (resolved.match.kind == ProcessRuleKind::None) {
+                    resolved.match = rules.Resolve(ancestor.processId, ancestor.name);
+                    if (resolved.match.kind != ProcessRuleKind::None) {
+                        resolved.inheritedFrom = ancestor.processId;
+                        resolved.treeRule = true;
+                    }
+                }
+                if (resolved.scheduling == nullptr) {
+                    resolved.scheduling = rules.ResolveScheduling(ancestor.processId, ancestor.name);
+                }
+                if (resolved.memoryPolicy == nullptr) {
+                    resolved.memoryPolicy = rules.ResolveMemoryPolicy(ancestor.processId, ancestor.name);
+                }
+                return resolved.match.kind != ProcessRuleKind::None && resolved.scheduling != nullptr &&
+                    resolved.memoryPolicy != nullptr;
+            });
+            return resolved;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include "ProcessBackend.h"
+#include "ProcessRules.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 进程树：PID -> 父进程与子进程列表，每轮扫描用快照刷新，事件路径逐个登记新进程
+        //
+        // 父进程的创建时间晚于子进程说明父 PID 已被复用，这条父子关系视为不存在。
+        // 已退出的进程保留到下一次刷新，期间其后代仍能沿原来的父进程链找到祖先。
+        // =============================================================================
+
+        class ProcessTree {
+        public:
+            // 用最新快照刷新，快照中不存在的 PID 被移除
+            void Update(const std::vector<ProcessEntry>& processes);
+            // 登记单个进程，PID 已存在时替换（父进程可能已变化）
+            void Insert(const ProcessEntry& process);
+
+            bool Find(DWORD processId, ProcessEntry& process) const;
+            // 从父进程开始逐级访问祖先，visitor 返回 true 时停止并返回 true
+            // visitor 在内部锁下调用，不能再访问本对象
+            bool VisitAncestors(const ProcessEntry& process, const std::function<bool(const ProcessEntry& ancestor)>& visitor) const;
+            // 全部后代 PID（广度优先，不含自身）
+            std::vector<DWORD> GetDescendants(DWORD processId) const;
+
+            size_t Size() const;
+            void Clear();
+
+        private:
+            struct Node {
+                ProcessEntry process;
+                uint64_t generation = 0;
+            };
+
+            // 调用方已持有 m_mutex
+            void SetLocked(const ProcessEntry& process);
+            void LinkLocked(DWORD parentId, DWORD childId);
+            void UnlinkLocked(DWORD parentId, DWORD childId);
+            // child 的父进程是否仍是 parent 这个进程实例
+            static bool IsParentOf(const ProcessEntry& parent, const ProcessEntry& child);
+
+            mutable std::mutex m_mutex;
+            std::unordered_map<DWORD, Node> m_nodes;
+            std::unordered_map<DWORD, std::vector<DWORD>> m_children;   // 父 PID -> 子 PID，父进程可以不在 m_nodes 中
+            uint64_t m_generation = 0;
+        };
+
+        // 进程实际适用的规则：进程自身的规则优先，没有时使用最近的 [ProcessTree] 祖先的同类规则
+        struct ResolvedProcessRules {
+            ProcessRuleMatch match;
+            const ProcessScheduling* scheduling = nullptr;      // 返回值在规则集存活期间有效
+            const ProcessMemoryPolicy* memoryPolicy = nullptr;
+            DWORD inheritedFrom = 0;    // 亲和性规则继承自的祖先 PID，0 表示来自进程自身或没有亲和性规则
+            bool treeRule = false;      // 亲和性规则属于 [ProcessTree] 进程（自身或祖先），保护线程会持续应用
+
+            bool IsEmpty() const {
+                return match.kind == ProcessRuleKind::None && scheduling == nullptr && memoryPolicy == nullptr;
+            }
+        };
+
+        ResolvedProcessRules ResolveProcessRules(const ProcessRuleSet& rules, const ProcessTree& tree, const ProcessEntry& process);
+    }
+}
@@ -0,0 +1,197 @@
+﻿#include "pch.h"
+#include "ReservationController.h"
+#include <algorithm>
+
+#ifndef _WIN32
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+#ifndef _WIN32
+            // PSI 文件的 "some ... total=<微秒>" 行
+            bool ReadPressureTotal(const std::string& path, uint64_t& total) {
+                std::ifstream file(path);
+                std::string line;
+                while (std::getline(file, line)) {
+                    if (line.compare(0, 5, "some ") != 0) {
+                        continue;
+                    }
+                    size_t position = line.find("total=");
+                    if (position == std::string::npos) {
+                        return false;
+                    }
+                    total = strtoull(line.c_str() + position + 6, nullptr, 10);
+                    return true;
+                }
+                return false;
+            }
+
+            // /proc/<pid>/task/<tid>/schedstat 的第二个字段为线程在运行队列中等待的累计纳秒数
+            bool ReadProcessWaitTime(DWORD processId, uint64_t& total) {
+                std::string taskPath = "/proc/" + std::to_string(processId) + "/task";
+                std::error_code error;
+                std::filesystem::directory_iterator it(taskPath, error);
+                if (error) {
+                    return false;
+                }
+
+                uint64_t waitNanoseconds = 0;
+                for (std::filesystem::directory_iterator end; !error && it != end; it.increment(error)) {
+                    std::ifstream file(it->path().string() + "/schedstat");
+                    uint64_t runTime = 0;
+                    uint64_t waitTime = 0;
+                    if (file >> runTime >> waitTime) {
+                        waitNanoseconds += waitTime;
+                    }
+                }
+                total = waitNanoseconds / 1000;
+                return true;
+            }
+#endif
+
+            // 累计等待时间（微秒）
+            bool ReadStallTime(DWORD processId, const std::string& cgroupPath, uint64_t& total) {
+#ifdef _WIN32
+                (void)processId;
+                (void)cgroupPath;
+                (void)total;
+                return false;
+#else
+                if (!cgroupPath.empty()) {
+                    return ReadPressureTotal(cgroupPath + "/cpu.pressure", total);
+                }
+                return ReadProcessWaitTime(processId, total);
+#endif
+            }
+        }
+
+        // =============================================================================
+        // 调整决策
+        // =============================================================================
+
+        ReservationController::ReservationController(const ReservationControllerOptions& options)
+            : m_options(options)
+            , m_overloadedSamples(0)
+            , m_idleSamples(0)
+        {
+            m_options.minCores = std::max<DWORD>(m_options.minCores, 1);
+            m_options.maxCores = std::max(m_options.maxCores, m_options.minCores);
+        }
+
+        ReservationAdjustment ReservationController::Evaluate(const ReservationPressure& sample, size_t reservedCores,
+            std::chrono::steady_clock::time_point now) {
+            bool hasUtilization = sample.utilization >= 0;
+            bool hasPressure = sample.pressure >= 0;
+            if (hasUtilization || hasPressure) {
+                bool overloaded = (hasUtilization && sample.utilization >= m_options.growUtilization) ||
+                    (hasPressure && sample.pressure >= m_options.growPressure);
+                bool idle = (!hasUtilization || sample.utilization <= m_options.shrinkUtilization) &&
+                    (!hasPressure || sample.pressure <= m_options.shrinkPressure);
+                m_overloadedSamples = overloaded ? m_overloadedSamples + 1 : 0;
+                m_idleSamples = idle ? m_idleSamples + 1 : 0;
+            }
+
+            if (now < m_cooldownUntil) {
+                return ReservationAdjustment::None;
+            }
+
+            ReservationAdjustment adjustment = ReservationAdjustment::None;
+            if (reservedCores < m_options.minCores ||
+                (m_overloadedSamples >= m_options.growAfter && reservedCores < m_options.maxCores)) {
+                adjustment = ReservationAdjustment::Grow;
+            }
+            else if (reservedCores > m_options.maxCores ||
+                (m_idleSamples >= m_options.shrinkAfter && reservedCores > m_options.minCores)) {
+                adjustment = ReservationAdjustment::Shrink;
+            }
+
+            if (adjustment != ReservationAdjustment::None) {
+                // 调整后负载分布改变，之前的计数不再有效
+                m_overloadedSamples = 0;
+                m_idleSamples = 0;
+                m_cooldownUntil = now + m_options.cooldown;
+            }
+            return adjustment;
+        }
+
+        void ReservationController::Reset() {
+            m_overloadedSamples = 0;
+            m_idleSamples = 0;
+            m_cooldownUntil = std::chrono::steady_clock::time_point();
+        }
+
+        // =============================================================================
+        // 负载信号采集
+        // =============================================================================
+
+        ReservationPressureSampler::ReservationPressureSampler(IProcessBackend& backend)
+            : m_backend(backend)
+            , m_lastStall(0)
+            , m_hasStall(false)
+        {
+        }
+
+        ReservationPressure ReservationPressureSampler::Sample(DWORD processId, const CpuSet& reservedSet,
+            const std::string& cgroupPath) {
+            ReservationPressure result;
+            auto now = std::chrono::steady_clock::now();
+
+            std::vector<CpuTimes> times;
+            if (m_backend.QueryCpuTimes(times)) {
+                double sum = 0.0;
+                size_t count = 0;
+                for (size_t cpu = reservedSet.First(); cpu != CpuSet::npos; cpu = reservedSet.Next(cpu)) {
+                    if (cpu >= times.size() || cpu >= m_lastTimes.size() || times[cpu].total <= m_lastTimes[cpu].total) {
+                        continue;
+                    }
+                    uint64_t total = times[cpu].total - m_lastTimes[cpu].total;
+                    uint64_t busy = times[cpu].busy >= m_lastTimes[cpu].busy ? times[cpu].busy - m_lastTimes[cpu].busy : 0;
+                    sum += std::min(100.0, 100.0 * static_cast<double>(busy) / static_cast<double>(total));
+                    count++;
+                }
+                if (count > 0) {
+                    result.utilization = sum / static_cast<double>(count);
+                }
+                m_lastTimes.swap(times);
+            }
+
+            uint64_t stall = 0;
+            std::string source = cgroupPath.empty() ? std::to_string(processId) : cgroupPath;
+            if (ReadStallTime(processId, cgroupPath, stall)) {
+                // 线程退出会使累计值变小，此时只重新建立基准
+                if (m_hasStall && source == m_lastSource && stall >= m_lastStall) {
+                    double elapsed = std::chrono::duration<double, std::micro>(now - m_lastTime).count();
+                    if (elapsed > 0) {
+                        result.pressure = 100.0 * static_cast<double>(stall - m_lastStall) / elapsed;
+                        // 多个线程的等待时间会叠加，按保留核心数归一化；PSI 本身已是比例
+                        if (cgroupPath.empty() && !reservedSet.Empty()) {
+                            result.pressure /= static_cast<double>(reservedSet.Count());
+                        }
+                    }
+                }
+                m_lastStall = stall;
+                m_lastSource = std::move(source);
+                m_hasStall = true;
+            }
+            else {
+                m_hasStall = false;
+            }
+
+            m_lastTime = now;
+            return result;
+        }
+
+        void ReservationPressureSampler::Reset() {
+            m_lastTimes.clear();
+            m_lastStall = 0;
+            m_lastSource.clear();
+            m_hasStall = false;
+        }
+    }
+}
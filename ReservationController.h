@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include "CpuSet.h"
+#include "ProcessBackend.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 保留核心闭环调整：按被保护进程的实际负载在范围内逐个物理核心扩大或缩小保留
+        //   使用率：保留核心在采样周期内的平均忙碌比例
+        //   压力：被保护进程可运行但等待 CPU 的时间比例
+        //     Linux cgroup 方式读取保留组的 cpu.pressure（PSI some），亲和性方式读取进程各线程的 schedstat
+        //     Windows 没有对应的计数，只使用使用率
+        // 滞回：扩大与缩小使用不同阈值，需要连续多个周期满足，调整后有冷却时间
+        // =============================================================================
+
+        struct ReservationControllerOptions {
+            DWORD processId = 0;                            // 被保护的进程，0 表示当前进程
+            DWORD minCores = 1;                             // 保留的物理核心数范围
+            DWORD maxCores = 4;
+            std::chrono::milliseconds interval{1000};       // 采样周期
+            double growUtilization = 85.0;                  // 使用率或压力（百分比）超过阈值时计为过载
+            double growPressure = 10.0;
+            double shrinkUtilization = 40.0;                // 使用率与压力都低于阈值时计为空闲
+            double shrinkPressure = 1.0;
+            DWORD growAfter = 3;                            // 连续过载多少个周期后扩大
+            DWORD shrinkAfter = 60;                         // 连续空闲多少个周期后缩小，比扩大更保守
+            std::chrono::milliseconds cooldown{10000};      // 调整后至少等待多久才能再次调整
+        };
+
+        // 一个采样周期的负载信号，无数据时为 -1
+        struct ReservationPressure {
+            double utilization = -1.0;
+            double pressure = -1.0;
+        };
+
+        enum class ReservationAdjustment {
+            None,
+            Grow,
+            Shrink
+        };
+
+        // 根据负载信号决定是否调整，不访问系统
+        class ReservationController {
+        public:
+            explicit ReservationController(const ReservationControllerOptions& options);
+
+            // reservedCores 为当前保留的物理核心数；超出范围时立即调整回范围内（同样受冷却时间限制）
+            ReservationAdjustment Evaluate(const ReservationPressure& sample, size_t reservedCores,
+                std::chrono::steady_clock::time_point now);
+            void Reset();
+
+        private:
+            ReservationControllerOptions m_options;
+            DWORD m_overloadedSamples;
+            DWORD m_idleSamples;
+            std::chrono::steady_clock::time_point m_cooldownUntil;
+        };
+
+        // 采集负载信号：每次调用与上一次比较累计值，首次调用只建立基准
+        class ReservationPressureSampler {
+        public:
+            explicit ReservationPressureSampler(IProcessBackend& backend);
+
+            // cgroupPath 非空时读取该 cgroup 的 cpu.pressure，否则读取进程各线程的等待时间
+            ReservationPressure Sample(DWORD processId, const CpuSet& reservedSet, const std::string& cgroupPath);
+            void Reset();
+
+        private:
+            IProcessBackend& m_backend;
+            std::vector<CpuTimes> m_lastTimes;
+            std::chrono::steady_clock::time_point m_lastTime;
+            uint64_t m_lastStall;           // 累计等待时间（微秒）
+            std::string m_lastSource;       // 上一次读取等待时间的来源，变化时重新建立基准
+            bool m_hasStall;
+        };
+    }
+}
@@ -0,0 +1,161 @@
+﻿#include "pch.h"
+#include "SharedProcessTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include "CpuCoreManager.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        void CpuSetToMask(const CpuSet& cpus, uint64_t* mask) {
+            for (size_t index = 0; index < CPUCORE_MASK_WORDS; index++) {
+                mask[index] = cpus.Word(index);
+            }
+        }
+
+        CpuSet MaskToCpuSet(const uint64_t* mask) {
+            CpuSet cpus;
+            for (size_t index = 0; index < CPUCORE_MASK_WORDS; index++) {
+                if (mask[index] != 0) {
+                    cpus |= CpuSet::FromMask(mask[index], index * 64);
+                }
+            }
+            return cpus;
+        }
+
+        SharedProcessTable::SharedProcessTable()
+            : m_table(nullptr)
+            , m_size(0)
+#ifdef _WIN32
+            , m_mapping(NULL)
+#endif
+        {
+        }
+
+        SharedProcessTable::~SharedProcessTable() {
+            Close();
+        }
+
+        bool SharedProcessTable::Open(const std::string& name, uint32_t capacity) {
+            Close();
+            if (capacity == 0) {
+                return false;
+            }
+
+            size_t size = offsetof(CpuCoreProcessTable, records) + static_cast<size_t>(capacity) * sizeof(CpuCoreProcessRecord);
+            void* memory = nullptr;
+
+#ifdef _WIN32
+            std::wstring mappingName = name.empty() ? std::wstring() : Utils::StringToWideString("Local\\" + name);
+            m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size),
+                mappingName.empty() ? nullptr : mappingName.c_str());
+            if (m_mapping == NULL) {
+                std::cerr << "创建共享进程表失败，错误码: " << GetLastError() << std::endl;
+                return false;
+            }
+            memory = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+            if (memory == nullptr) {
+                std::cerr << "映射共享进程表失败，错误码: " << GetLastError() << std::endl;
+                CloseHandle(m_mapping);
+                m_mapping = NULL;
+                return false;
+            }
+#else
+            if (name.empty()) {
+                memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            }
+            else {
+                std::string shmName = "/" + name;
+                int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+                if (fd < 0) {
+                    std::cerr << "创建共享进程表失败: " << strerror(errno) << std::endl;
+                    return false;
+                }
+                if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+                    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                }
+                else {
+                    memory = MAP_FAILED;
+                }
+                close(fd);
+                if (memory == MAP_FAILED) {
+                    shm_unlink(shmName.c_str());
+                }
+            }
+            if (memory == MAP_FAILED) {
+                std::cerr << "映射共享进程表失败: " << strerror(errno) << std::endl;
+                return false;
+            }
+#endif
+
+            // 记录在每次刷新时写入，这里只填写表头（复用已存在的命名共享内存时其中可能有旧数据）
+            m_table = static_cast<CpuCoreProcessTable*>(memory);
+            m_size = size;
+            m_name = name;
+            m_table->magic = CPUCORE_TABLE_MAGIC;
+            m_table->version = CPUCORE_API_VERSION;
+            m_table->recordSize = sizeof(CpuCoreProcessRecord);
+            m_table->capacity = capacity;
+            m_table->sequence = 0;
+            m_table->count = 0;
+            m_table->totalProcesses = 0;
+            m_table->updateTime = 0;
+            return true;
+        }
+
+        void SharedProcessTable::Close() {
+            if (m_table == nullptr) {
+                return;
+            }
+
+#ifdef _WIN32
+            UnmapViewOfFile(m_table);
+            CloseHandle(m_mapping);
+            m_mapping = NULL;
+#else
+            munmap(m_table, m_size);
+            if (!m_name.empty()) {
+                shm_unlink(("/" + m_name).c_str());
+            }
+#endif
+            m_table = nullptr;
+            m_size = 0;
+            m_name.clear();
+        }
+
+        bool SharedProcessTable::IsOpen() const {
+            return m_table != nullptr;
+        }
+
+        const CpuCoreProcessTable* SharedProcessTable::GetTable() const {
+            return m_table;
+        }
+
+        CpuCoreProcessRecord* SharedProcessTable::BeginUpdate() {
+            m_table->sequence = m_table->sequence + 1;
+            // 读者看到奇数序号之前不能看到任何记录的修改
+            std::atomic_thread_fence(std::memory_order_release);
+            return m_table->records;
+        }
+
+        void SharedProcessTable::EndUpdate(uint32_t count, uint32_t totalProcesses) {
+            m_table->count = count;
+            m_table->totalProcesses = totalProcesses;
+            m_table->updateTime = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+            std::atomic_thread_fence(std::memory_order_release);
+            m_table->sequence = m_table->sequence + 1;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include "CpuCoreApi.h"
+#include "CpuPlatform.h"
+#include "CpuSet.h"
+#include <string>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 共享进程表：固定布局（CpuCoreApi.h 中的 CpuCoreProcessTable）的进程快照映射到共享内存，
+        // 托管端直接读取映射内存，不复制、不分配对象。单写者，读者通过序号锁校验一致性
+        // =============================================================================
+
+        // CpuSet 与定长掩码互相转换，编号超出 CPUCORE_MASK_WORDS * 64 的 CPU 被忽略
+        void CpuSetToMask(const CpuSet& cpus, uint64_t* mask);
+        CpuSet MaskToCpuSet(const uint64_t* mask);
+
+        class SharedProcessTable {
+        public:
+            SharedProcessTable();
+            ~SharedProcessTable();
+
+            SharedProcessTable(const SharedProcessTable&) = delete;
+            SharedProcessTable& operator=(const SharedProcessTable&) = delete;
+
+            // name 为空时只在本进程内映射，否则创建命名共享内存；已打开时先关闭
+            bool Open(const std::string& name, uint32_t capacity);
+            // 解除映射，命名共享内存同时删除名称（已映射的读者不受影响）
+            void Close();
+            bool IsOpen() const;
+            const CpuCoreProcessTable* GetTable() const;
+
+            // 写入一次快照：BeginUpdate 使序号变为奇数并返回记录数组（capacity 项），
+            // 写完后 EndUpdate 发布记录数并使序号变为偶数
+            CpuCoreProcessRecord* BeginUpdate();
+            void EndUpdate(uint32_t count, uint32_t totalProcesses);
+
+        private:
+            CpuCoreProcessTable* m_table;
+            size_t m_size;
+            std::string m_name;
+#ifdef _WIN32
+            HANDLE m_mapping;
+#endif
+        };
+    }
+}
@@ -0,0 +1,553 @@
+﻿#include "pch.h"
+#include "SimulatedBackend.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const DWORD MAX_SIMULATED_CORES = 1024;
+            const DWORD SELF_PROCESS_ID = 1;
+            const DWORD FIRST_PROCESS_ID = 100;
+            const DWORD MAX_PROCESS_ID = 4194304;   // Linux pid_max 上限
+
+            // 常见进程名，含少量系统关键进程，使关键进程判断的开销也计入扫描
+            const char* const PROCESS_NAMES[] = {
+                "chrome.exe", "firefox", "python3", "java", "node", "nginx", "postgres", "sshd",
+                "bash", "svchost.exe", "explorer.exe", "dotnet", "TSysWatch.exe", "code", "systemd",
+                "csrss.exe", "dwm.exe", "MsMpEng.exe", "redis-server", "containerd"
+            };
+
+            // 无权限时的错误码与真实后端一致，ClassifyAffinityError 可正确归类
+            void SetSimulatedError(bool denied) {
+#ifdef _WIN32
+                SetLastError(denied ? ERROR_ACCESS_DENIED : ERROR_INVALID_PARAMETER);
+#else
+                errno = denied ? EPERM : ESRCH;
+#endif
+            }
+
+            const char* TraceTypeName(ProcessEvent::Type type) {
+                switch (type) {
+                case ProcessEvent::Type::Created:
+                    return "create";
+                case ProcessEvent::Type::Exec:
+                    return "exec";
+                case ProcessEvent::Type::Exited:
+                    return "exit";
+                case ProcessEvent::Type::Overflow:
+                    break;
+                }
+                return "overflow";
+            }
+
+            bool ParseTraceType(const std::string& text, ProcessEvent::Type& type) {
+                if (text == "create") {
+                    type = ProcessEvent::Type::Created;
+                }
+                else if (text == "exec") {
+                    type = ProcessEvent::Type::Exec;
+                }
+                else if (text == "exit") {
+                    type = ProcessEvent::Type::Exited;
+                }
+                else if (text == "overflow") {
+                    type = ProcessEvent::Type::Overflow;
+                }
+                else {
+                    return false;
+                }
+                return true;
+            }
+        }
+
+        // =============================================================================
+        // 轨迹文件
+        // =============================================================================
+
+        bool LoadProcessTrace(const std::string& path, std::vector<ProcessTraceRecord>& records) {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            records.clear();
+            std::string line;
+            while (std::getline(file, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+
+                std::istringstream fields(line);
+                double milliseconds = 0;
+                std::string type;
+                ProcessTraceRecord record;
+                if (!(fields >> milliseconds >> type >> record.processId >> record.parentProcessId) ||
+                    !ParseTraceType(type, record.type)) {
+                    continue;
+                }
+                std::getline(fields >> std::ws, record.name);
+                record.offset = std::chrono::microseconds(static_cast<int64_t>(milliseconds * 1000.0));
+                records.push_back(std::move(record));
+            }
+
+            // 录制时多个事件线程的记录可能交错，按时间排序后回放
+            std::stable_sort(records.begin(), records.end(), [](const ProcessTraceRecord& a, const ProcessTraceRecord& b) {
+                return a.offset < b.offset;
+            });
+            return true;
+        }
+
+        bool SaveProcessTrace(const std::string& path, const std::vector<ProcessTraceRecord>& records) {
+            std::ofstream file(path, std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            file << "# <毫秒偏移> <create|exec|exit> <PID> <父 PID> [进程名]\n";
+            for (const ProcessTraceRecord& record : records) {
+                file << record.offset.count() / 1000.0 << " " << TraceTypeName(record.type) << " "
+                    << record.processId << " " << record.parentProcessId;
+                if (!record.name.empty()) {
+                    file << " " << record.name;
+                }
+                file << "\n";
+            }
+            return file.good();
+        }
+
+        // =============================================================================
+        // 事件源：事件在调用 Churn / Apply 的线程上同步送达
+        // =============================================================================
+
+        class SimulatedProcessBackend::EventSource : public IProcessEventSource {
+        public:
+            explicit EventSource(SimulatedProcessBackend& backend)
+                : m_backend(backend)
+            {
+            }
+
+            ~EventSource() override {
+                Stop();
+            }
+
+            bool Start(ProcessEventCallback callback) override {
+                m_backend.SetCallback(std::move(callback));
+                return true;
+            }
+
+            void Stop() override {
+                m_backend.SetCallback(nullptr);
+            }
+
+        private:
+            SimulatedProcessBackend& m_backend;
+        };
+
+        // =============================================================================
+        // SimulatedProcessBackend
+        // =============================================================================
+
+        SimulatedProcessBackend::SimulatedProcessBackend(const SimulatedSystemOptions& options)
+            : m_options(options)
+            , m_random(options.seed)
+            , m_nextPid(FIRST_PROCESS_ID)
+            , m_nextStartTime(1)
+            , m_queryProcessCount(0)
+        {
+            m_options.coreCount = std::min(std::max<DWORD>(m_options.coreCount, 1), MAX_SIMULATED_CORES);
+            m_systemSet = CpuSet::Range(0, m_options.coreCount);
+            m_cpuTimes.resize(m_options.coreCount);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_processes.reserve(m_options.processCount);
+            AddLocked(SELF_PROCESS_ID, 0, "cpucore_benchmark");
+            while (m_processes.size() < m_options.processCount) {
+                AddLocked(AllocatePidLocked(), SELF_PROCESS_ID, std::string());
+            }
+        }
+
+        void SimulatedProcessBackend::AddLocked(DWORD processId, DWORD parentProcessId, const std::string& name) {
+            std::uniform_real_distribution<double> ratio(0.0, 1.0);
+
+            SimulatedProcess process;
+            process.entry.processId = processId;
+            process.entry.parentProcessId = parentProcessId;
+            process.entry.startTime = m_nextStartTime++;
+            process.affinity = m_systemSet;
+
+            if (!name.empty()) {
+                process.entry.name = name;
+            }
+            else if (processId != SELF_PROCESS_ID && ratio(m_random) < m_options.kernelThreadRatio) {
+                process.entry.name = "kworker/" + std::to_string(processId % m_options.coreCount);
+                process.entry.isSystem = true;
+            }
+            else {
+                std::uniform_int_distribution<size_t> pick(0, sizeof(PROCESS_NAMES) / sizeof(PROCESS_NAMES[0]) - 1);
+                process.entry.name = PROCESS_NAMES[pick(m_random)];
+            }
+            process.denied = processId != SELF_PROCESS_ID && !process.entry.isSystem &&
+                ratio(m_random) < m_options.deniedRatio;
+
+            auto it = m_index.find(processId);
+            if (it != m_index.end()) {
+                m_processes[it->second] = std::move(process);
+                return;
+            }
+            m_index.emplace(processId, m_processes.size());
+            m_processes.push_back(std::move(process));
+        }
+
+        bool SimulatedProcessBackend::RemoveLocked(DWORD processId) {
+            auto it = m_index.find(processId);
+            if (it == m_index.end()) {
+                return false;
+            }
+
+            // 与末尾元素交换后删除，保持 O(1)
+            size_t position = it->second;
+            m_index.erase(it);
+            if (position != m_processes.size() - 1) {
+                m_processes[position] = std::move(m_processes.back());
+                m_index[m_processes[position].entry.processId] = position;
+            }
+            m_processes.pop_back();
+            return true;
+        }
+
+        DWORD SimulatedProcessBackend::AllocatePidLocked() {
+            // 与 Linux 相同，PID 递增分配，到达上限后回绕并跳过仍在使用的 PID
+            for (;;) {
+                DWORD processId = m_nextPid++;
+                if (m_nextPid >= MAX_PROCESS_ID) {
+                    m_nextPid = FIRST_PROCESS_ID;
+                }
+                if (m_index.find(processId) == m_index.end()) {
+                    return processId;
+                }
+            }
+        }
+
+        SimulatedProcessBackend::SimulatedProcess* SimulatedProcessBackend::FindLocked(const ProcessHandle& handle) {
+            auto it = m_index.find(handle.GetProcessId());
+            if (it == m_index.end()) {
+                return nullptr;
+            }
+
+            // 句柄指向的进程已退出、PID 已被复用
+            SimulatedProcess& process = m_processes[it->second];
+            if (handle.GetStartTime() != 0 && process.entry.startTime != handle.GetStartTime()) {
+                return nullptr;
+            }
+            return &process;
+        }
+
+        void SimulatedProcessBackend::Churn(size_t exits, size_t creates, bool notify) {
+            std::vector<ProcessEvent> events;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (size_t i = 0; i < exits && m_processes.size() > 1; i++) {
+                    // 当前进程不退出
+                    std::uniform_int_distribution<size_t> pick(0, m_processes.size() - 1);
+                    DWORD processId = m_processes[pick(m_random)].entry.processId;
+                    if (processId == SELF_PROCESS_ID) {
+                        continue;
+                    }
+
+                    RemoveLocked(processId);
+                    if (notify) {
+                        ProcessEvent event;
+                        event.type = ProcessEvent::Type::Exited;
+                        event.processId = processId;
+                        events.push_back(event);
+                    }
+                }
+
+                for (size_t i = 0; i < creates; i++) {
+                    DWORD processId = AllocatePidLocked();
+                    AddLocked(processId, SELF_PROCESS_ID, std::string());
+                    if (notify) {
+                        ProcessEvent event;
+                        event.type = ProcessEvent::Type::Created;
+                        event.processId = processId;
+                        event.parentProcessId = SELF_PROCESS_ID;
+                        events.push_back(event);
+                    }
+                }
+            }
+
+            Notify(events);
+        }
+
+        void SimulatedProcessBackend::Apply(const ProcessTraceRecord& record, bool notify) {
+            ProcessEvent event;
+            event.type = record.type;
+            event.processId = record.processId;
+            event.parentProcessId = record.parentProcessId;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                switch (record.type) {
+                case ProcessEvent::Type::Created:
+                    AddLocked(record.processId, record.parentProcessId, record.name);
+                    break;
+                case ProcessEvent::Type::Exec: {
+                    // exec 只替换映像，亲和性与创建时间保持不变
+                    auto it = m_index.find(record.processId);
+                    if (it == m_index.end()) {
+                        AddLocked(record.processId, record.parentProcessId, record.name);
+                    }
+                    else if (!record.name.empty()) {
+                        m_processes[it->second].entry.name = record.name;
+                    }
+                    break;
+                }
+                case ProcessEvent::Type::Exited:
+                    if (record.processId == SELF_PROCESS_ID || !RemoveLocked(record.processId)) {
+                        return;
+                    }
+                    break;
+                case ProcessEvent::Type::Overflow:
+                    break;
+                }
+            }
+
+            if (notify) {
+                Notify(std::vector<ProcessEvent>(1, event));
+            }
+        }
+
+        void SimulatedProcessBackend::RequestResync() {
+            ProcessEvent event;
+            event.type = ProcessEvent::Type::Overflow;
+            Notify(std::vector<ProcessEvent>(1, event));
+        }
+
+        void SimulatedProcessBackend::ResetAffinities() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (SimulatedProcess& process : m_processes) {
+                process.affinity = m_systemSet;
+            }
+        }
+
+        size_t SimulatedProcessBackend::GetProcessCount() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_processes.size();
+        }
+
+        uint64_t SimulatedProcessBackend::GetQueryProcessCount() const {
+            return m_queryProcessCount.load(std::memory_order_acquire);
+        }
+
+        void SimulatedProcessBackend::Notify(const std::vector<ProcessEvent>& events) {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            if (!m_callback) {
+                return;
+            }
+            for (const ProcessEvent& event : events) {
+                m_callback(event);
+            }
+        }
+
+        void SimulatedProcessBackend::SetCallback(ProcessEventCallback callback) {
+            std::lock_guard<std::mutex> lock(m_callbackMutex);
+            m_callback = std::move(callback);
+        }
+
+        bool SimulatedProcessBackend::EnumerateProcesses(std::vector<ProcessEntry>& processes) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            processes.clear();
+            processes.reserve(m_processes.size());
+            for (const SimulatedProcess& process : m_processes) {
+                processes.push_back(process.entry);
+            }
+            return true;
+        }
+
+        bool SimulatedProcessBackend::QueryProcess(DWORD processId, ProcessEntry& entry) {
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_index.find(processId);
+                if (it != m_index.end()) {
+                    entry = m_processes[it->second].entry;
+                    found = true;
+                }
+            }
+
+            m_queryProcessCount.fetch_add(1, std::memory_order_release);
+            if (!found) {
+                SetSimulatedError(false);
+            }
+            return found;
+        }
+
+        ProcessHandle SimulatedProcessBackend::Open(DWORD processId, ProcessAccess access) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(processId);
+            if (it == m_index.end()) {
+                SetSimulatedError(false);
+                return ProcessHandle();
+            }
+
+            // 与 Windows 相同，无权修改的进程在请求修改权限时打开失败
+            const SimulatedProcess& process = m_processes[it->second];
+            if (process.denied && access == ProcessAccess::QueryAndSet) {
+                SetSimulatedError(true);
+                return ProcessHandle();
+            }
+
+            // -1 在两个平台上都不会被 NativeProcessHandle 关闭（Linux 无效描述符 / Windows 当前进程伪句柄）
+            return ProcessHandle(processId, process.entry.startTime, -1);
+        }
+
+        ProcessHandle SimulatedProcessBackend::OpenSelf() {
+            return Open(SELF_PROCESS_ID, ProcessAccess::QueryAndSet);
+        }
+
+        bool SimulatedProcessBackend::QueryAffinity(const ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            SimulatedProcess* process = FindLocked(handle);
+            if (process == nullptr) {
+                SetSimulatedError(false);
+                return false;
+            }
+
+            processSet = process->affinity;
+            systemSet = m_systemSet;
+            return true;
+        }
+
+        bool SimulatedProcessBackend::ApplyAffinity(const ProcessHandle& handle, const CpuSet& affinity) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            SimulatedProcess* process = FindLocked(handle);
+            if (process == nullptr) {
+                SetSimulatedError(false);
+                return false;
+            }
+            if (process->denied || process->entry.isSystem) {
+                SetSimulatedError(true);
+                return false;
+            }
+
+            process->affinity = affinity & m_systemSet;
+            return true;
+        }
+
+        bool SimulatedProcessBackend::SetPriority(const ProcessHandle& handle, DWORD) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (FindLocked(handle) == nullptr) {
+                SetSimulatedError(false);
+                return false;
+            }
+            return true;
+        }
+
+        bool SimulatedProcessBackend::ApplyScheduling(const ProcessHandle& handle, const ProcessScheduling&, bool& changed) {
+            // 模拟进程不记录调度设置，视为已是目标值
+            std::lock_guard<std::mutex> lock(m_mutex);
+            changed = false;
+            if (FindLocked(handle) == nullptr) {
+                SetSimulatedError(false);
+                return false;
+            }
+            return true;
+        }
+
+        bool SimulatedProcessBackend::ApplyMemoryPolicy(const ProcessHandle& handle, const ProcessMemoryPolicy&, const CpuSet&) {
+            // 模拟进程没有内存，视为已在目标节点
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (FindLocked(handle) == nullptr) {
+                SetSimulatedError(false);
+                return false;
+            }
+            return true;
+        }
+
+        bool SimulatedProcessBackend::QueryMemoryNodes(DWORD, std::vector<uint64_t>& kilobytesPerNode) {
+            kilobytesPerNode.clear();
+            return true;
+        }
+
+        bool SimulatedProcessBackend::EnumerateThreads(DWORD processId, std::vector<ThreadEntry>& threads) {
+            // 每个进程只有一个主线程，线程 ID 与 PID 相同
+            std::lock_guard<std::mutex> lock(m_mutex);
+            threads.clear();
+            auto it = m_index.find(processId);
+            if (it == m_index.end()) {
+                SetSimulatedError(false);
+                return false;
+            }
+
+            ThreadEntry thread;
+            thread.threadId = processId;
+            thread.name = m_processes[it->second].entry.name;
+            threads.push_back(thread);
+            return true;
+        }
+
+        bool SimulatedProcessBackend::QueryThreadAffinity(DWORD threadId, CpuSet& affinity) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(threadId);
+            if (it == m_index.end()) {
+                SetSimulatedError(false);
+                return false;
+            }
+            affinity = m_processes[it->second].affinity;
+            return true;
+        }
+
+        bool SimulatedProcessBackend::ApplyThreadAffinity(DWORD threadId, const CpuSet& affinity) {
+            return ApplyAffinity(ProcessHandle(threadId, 0, -1), affinity);
+        }
+
+        DWORD SimulatedProcessBackend::GetCurrentPid() {
+            return SELF_PROCESS_ID;
+        }
+
+        ProcessorInfo SimulatedProcessBackend::GetProcessorInfo() {
+            ProcessorInfo info;
+            info.dwNumberOfProcessors = m_options.coreCount;
+            info.activeProcessors = m_systemSet;
+            return info;
+        }
+
+        CpuTopology SimulatedProcessBackend::GetCpuTopology() {
+            // 每个物理核心 2 个 SMT 线程，每 16 个逻辑处理器共享 L3，每 256 个为一个 NUMA 节点
+            const DWORD L3_SIZE = 16;
+            const DWORD NODE_SIZE = 256;
+
+            CpuTopology topology;
+            topology.onlineProcessors = m_systemSet;
+            for (DWORD cpu = 0; cpu < m_options.coreCount; cpu += 2) {
+                topology.physicalCores.push_back(CpuSet::Range(cpu, std::min<DWORD>(2, m_options.coreCount - cpu)));
+            }
+            for (DWORD cpu = 0; cpu < m_options.coreCount; cpu += L3_SIZE) {
+                topology.l3Domains.push_back(CpuSet::Range(cpu, std::min(L3_SIZE, m_options.coreCount - cpu)));
+            }
+            for (DWORD cpu = 0; cpu < m_options.coreCount; cpu += NODE_SIZE) {
+                topology.numaNodes.push_back(CpuSet::Range(cpu, std::min(NODE_SIZE, m_options.coreCount - cpu)));
+                topology.numaNodeIds.push_back(cpu / NODE_SIZE);
+            }
+            return topology;
+        }
+
+        bool SimulatedProcessBackend::QueryCpuTimes(std::vector<CpuTimes>& times) {
+            // 固定的负载分布：每次查询各核心前进 1000 个单位，忙碌比例按编号在 0%~96% 之间分布
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t cpu = 0; cpu < m_cpuTimes.size(); cpu++) {
+                m_cpuTimes[cpu].total += 1000;
+                m_cpuTimes[cpu].busy += (cpu * 37 % 25) * 40;
+            }
+            times = m_cpuTimes;
+            return true;
+        }
+
+        std::unique_ptr<IProcessEventSource> SimulatedProcessBackend::CreateEventSource() {
+            return std::make_unique<EventSource>(*this);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+﻿#pragma once
+
+#include "ProcessBackend.h"
+#include "ProcessEvents.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 模拟进程后端：内存中的进程表，供基准测试在不触碰真实系统的前提下驱动 CpuCoreManager
+        // 进程数、核心数（最多 1024）、权限不足比例可配置，随机数种子固定时结果可复现；
+        // 进程变动可随机生成，也可回放由真实事件源录制的轨迹
+        // =============================================================================
+
+        struct SimulatedSystemOptions {
+            size_t processCount = 1000;     // 初始进程数（含当前进程）
+            DWORD coreCount = 64;           // 逻辑处理器数，1~1024
+            double deniedRatio = 0.05;      // 无权修改亲和性的进程比例
+            double kernelThreadRatio = 0.1; // 内核线程比例（亲和性不可修改，扫描时跳过）
+            uint32_t seed = 1;
+        };
+
+        // 进程变动轨迹中的一条记录
+        struct ProcessTraceRecord {
+            std::chrono::microseconds offset{0};    // 距轨迹开始的时间
+            ProcessEvent::Type type = ProcessEvent::Type::Created;
+            DWORD processId = 0;
+            DWORD parentProcessId = 0;
+            std::string name;                       // 未知时为空
+        };
+
+        // 轨迹文件每行一条记录：<毫秒偏移> <create|exec|exit> <PID> <父 PID> [进程名]，# 开头为注释
+        bool LoadProcessTrace(const std::string& path, std::vector<ProcessTraceRecord>& records);
+        bool SaveProcessTrace(const std::string& path, const std::vector<ProcessTraceRecord>& records);
+
+        class SimulatedProcessBackend : public IProcessBackend {
+        public:
+            explicit SimulatedProcessBackend(const SimulatedSystemOptions& options);
+
+            // 随机退出 exits 个进程并创建 creates 个新进程；notify 为 true 时经事件源报告
+            void Churn(size_t exits, size_t creates, bool notify);
+            // 应用一条轨迹记录：创建时 PID 已存在则视为 PID 复用，退出不存在的 PID 时忽略
+            void Apply(const ProcessTraceRecord& record, bool notify);
+            // 经事件源报告事件丢失，保护线程随即全量扫描
+            void RequestResync();
+            // 所有进程的亲和性恢复为全部处理器
+            void ResetAffinities();
+
+            size_t GetProcessCount();
+            // QueryProcess 的累计调用次数，基准测试据此判断事件路径是否已处理完一批进程
+            uint64_t GetQueryProcessCount() const;
+
+            bool EnumerateProcesses(std::vector<ProcessEntry>& processes) override;
+            bool QueryProcess(DWORD processId, ProcessEntry& entry) override;
+            ProcessHandle Open(DWORD processId, ProcessAccess access) override;
+            ProcessHandle OpenSelf() override;
+            bool QueryAffinity(const ProcessHandle& handle, CpuSet& processSet, CpuSet& systemSet) override;
+            bool ApplyAffinity(const ProcessHandle& handle, const CpuSet& affinity) override;
+            bool SetPriority(const ProcessHandle& handle, DWORD priorityClass) override;
+            bool ApplyScheduling(const ProcessHandle& handle, const ProcessScheduling& scheduling, bool& changed) override;
+            bool ApplyMemoryPolicy(const ProcessHandle& handle, const ProcessMemoryPolicy& policy, const CpuSet& nodes) override;
+            bool QueryMemoryNodes(DWORD processId, std::vector<uint64_t>& kilobytesPerNode) override;
+            bool EnumerateThreads(DWORD processId, std::vector<ThreadEntry>& threads) override;
+            bool QueryThreadAffinity(DWORD threadId, CpuSet& affinity) override;
+            bool ApplyThreadAffinity(DWORD threadId, const CpuSet& affinity) override;
+            DWORD GetCurrentPid() override;
+            ProcessorInfo GetProcessorInfo() override;
+            CpuTopology GetCpuTopology() override;
+            bool QueryCpuTimes(std::vector<CpuTimes>& times) override;
+            std::unique_ptr<IProcessEventSource> CreateEventSource() override;
+
+        private:
+            class EventSource;
+
+            struct SimulatedProcess {
+                ProcessEntry entry;
+                CpuSet affinity;
+                bool denied = false;    // 可查询但不可修改
+            };
+
+            // 以下调用方已持有 m_mutex
+            void AddLocked(DWORD processId, DWORD parentProcessId, const std::string& name);
+            bool RemoveLocked(DWORD processId);
+            DWORD AllocatePidLocked();
+            SimulatedProcess* FindLocked(const ProcessHandle& handle);
+
+            void Notify(const std::vector<ProcessEvent>& events);
+            void SetCallback(ProcessEventCallback callback);
+
+            SimulatedSystemOptions m_options;
+            CpuSet m_systemSet;
+
+            std::mutex m_mutex;
+            std::vector<SimulatedProcess> m_processes;
+            std::unordered_map<DWORD, size_t> m_index;      // PID -> m_processes 下标
+            std::mt19937 m_random;
+            DWORD m_nextPid;
+            uint64_t m_nextStartTime;
+            std::vector<CpuTimes> m_cpuTimes;
+
+            std::atomic<uint64_t> m_queryProcessCount;
+
+            std::mutex m_callbackMutex;
+            ProcessEventCallback m_callback;
+        };
+    }
+}
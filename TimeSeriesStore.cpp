@@ -0,0 +1,967 @@
+﻿#include "pch.h"
+#include "TimeSeriesStore.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <system_error>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        namespace {
+            const uint32_t SEGMENT_MAGIC = 0x42445354u;     // "TSDB"
+            const uint32_t SEGMENT_VERSION = 1;
+            const size_t CHUNK_SIZE = 4096;
+            const char* const REGISTRY_FILE = "series.idx";
+            const char* const SEGMENT_PREFIX = "segment-";
+            const char* const SEGMENT_SUFFIX = ".tsd";
+            const char* const WRITER_LOCK_FILE = "writer.lock";
+
+            // 段头占第一个块的位置，之后是 chunkCount 个块
+            struct SegmentHeader {
+                uint32_t magic;                 // 最后写入，读取方据此判断段已初始化
+                uint32_t version;
+                uint32_t chunkSize;
+                uint32_t chunkCount;
+                volatile uint32_t usedChunks;
+                uint32_t reserved;
+                volatile int64_t minTime;       // 段内所有点的时间范围，用于查询时跳过整段
+                volatile int64_t maxTime;
+            };
+
+            // 块头之后是压缩数据；第一个点的时间与值在块头中，之后每个点写入数据区
+            struct ChunkHeader {
+                uint32_t seriesId;
+                volatile uint32_t count;        // 数据写完后才增加，读取方只解码 count 个点
+                uint32_t bitCount;
+                uint32_t reserved;
+                int64_t firstTime;
+                volatile int64_t lastTime;
+                uint64_t firstValue;
+            };
+
+            const uint32_t CHUNK_DATA_BITS = static_cast<uint32_t>((CHUNK_SIZE - sizeof(ChunkHeader)) * 8);
+            // 一个点编码后的最大位数：时间 4 + 64，值 2 + 5 + 6 + 64
+            const uint32_t MAX_POINT_BITS = 145;
+
+            SegmentHeader* GetSegmentHeader(uint8_t* base) {
+                return reinterpret_cast<SegmentHeader*>(base);
+            }
+
+            ChunkHeader* GetChunk(uint8_t* base, uint32_t index) {
+                return reinterpret_cast<ChunkHeader*>(base + CHUNK_SIZE * (static_cast<size_t>(index) + 1));
+            }
+
+            uint8_t* GetChunkData(ChunkHeader* chunk) {
+                return reinterpret_cast<uint8_t*>(chunk + 1);
+            }
+
+            // value 不能为 0
+            unsigned LeadingZeros(uint64_t value) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+                unsigned long index;
+                _BitScanReverse64(&index, value);
+                return 63 - static_cast<unsigned>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+                return static_cast<unsigned>(__builtin_clzll(value));
+#else
+                unsigned count = 0;
+                for (uint64_t bit = 1ull << 63; (value & bit) == 0; bit >>= 1) {
+                    count++;
+                }
+                return count;
+#endif
+            }
+
+            // value 不能为 0
+            unsigned TrailingZeros(uint64_t value) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+                unsigned long index;
+                _BitScanForward64(&index, value);
+                return static_cast<unsigned>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+                return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+                unsigned count = 0;
+                for (; (value & 1) == 0; value >>= 1) {
+                    count++;
+                }
+                return count;
+#endif
+            }
+
+            // 按高位在前写入 value 的低 count 位，数据区初始为 0
+            void WriteBits(uint8_t* data, uint32_t& position, uint64_t value, unsigned count) {
+                while (count > 0) {
+                    unsigned offset = position & 7;
+                    unsigned take = std::min(count, 8u - offset);
+                    uint8_t bits = static_cast<uint8_t>((value >> (count - take)) & ((1u << take) - 1));
+                    data[position >> 3] |= static_cast<uint8_t>(bits << (8 - offset - take));
+                    position += take;
+                    count -= take;
+                }
+            }
+
+            class BitReader {
+            public:
+                BitReader(const uint8_t* data, uint32_t limit)
+                    : m_data(data)
+                    , m_position(0)
+                    , m_limit(limit)
+                {
+                }
+
+                bool Read(unsigned count, uint64_t& value) {
+                    if (count > m_limit - m_position) {
+                        return false;
+                    }
+                    value = 0;
+                    while (count > 0) {
+                        unsigned offset = m_position & 7;
+                        unsigned take = std::min(count, 8u - offset);
+                        uint8_t byte = m_data[m_position >> 3];
+                        value = (value << take) | ((byte >> (8 - offset - take)) & ((1u << take) - 1));
+                        m_position += take;
+                        count -= take;
+                    }
+                    return true;
+                }
+
+                bool ReadBit(bool& bit) {
+                    uint64_t value = 0;
+                    if (!Read(1, value)) {
+                        return false;
+                    }
+                    bit = value != 0;
+                    return true;
+                }
+
+            private:
+                const uint8_t* m_data;
+                uint32_t m_position;
+                uint32_t m_limit;
+            };
+
+            // 时间戳二阶差分：0 → "0"；小范围按前缀 10 / 110 / 1110 加偏移量；其余 1111 加 64 位
+            const unsigned TIME_WIDTHS[] = { 7, 9, 12, 64 };
+            const int64_t TIME_BIASES[] = { 63, 255, 2047, 0 };
+
+            void EncodeTime(uint8_t* data, uint32_t& position, int64_t deltaOfDelta) {
+                if (deltaOfDelta == 0) {
+                    WriteBits(data, position, 0, 1);
+                    return;
+                }
+                for (size_t kind = 0; kind < 3; kind++) {
+                    if (deltaOfDelta >= -TIME_BIASES[kind] && deltaOfDelta <= TIME_BIASES[kind] + 1) {
+                        // 前缀为 kind + 1 个 1 加一个 0
+                        WriteBits(data, position, ((1u << (kind + 1)) - 1) << 1, static_cast<unsigned>(kind + 2));
+                        WriteBits(data, position, static_cast<uint64_t>(deltaOfDelta + TIME_BIASES[kind]), TIME_WIDTHS[kind]);
+                        return;
+                    }
+                }
+                WriteBits(data, position, 0xF, 4);
+                WriteBits(data, position, static_cast<uint64_t>(deltaOfDelta), 64);
+            }
+
+            bool DecodeTime(BitReader& reader, int64_t& deltaOfDelta) {
+                bool bit = false;
+                if (!reader.ReadBit(bit)) {
+                    return false;
+                }
+                if (!bit) {
+                    deltaOfDelta = 0;
+                    return true;
+                }
+
+                size_t kind = 0;
+                for (; kind < 3; kind++) {
+                    if (!reader.ReadBit(bit)) {
+                        return false;
+                    }
+                    if (!bit) {
+                        break;
+                    }
+                }
+
+                uint64_t value = 0;
+                if (!reader.Read(TIME_WIDTHS[kind], value)) {
+                    return false;
+                }
+                deltaOfDelta = static_cast<int64_t>(value) - TIME_BIASES[kind];
+                return true;
+            }
+
+            // 值与前一个值的异或：0 → "0"；有效位落在上一个窗口内 → "10" 加窗口内的位；
+            // 否则 "11" 加 5 位前导零数、6 位有效位数减一与有效位
+            void EncodeValue(uint8_t* data, uint32_t& position, uint64_t delta, uint8_t& leading, uint8_t& trailing) {
+                if (delta == 0) {
+                    WriteBits(data, position, 0, 1);
+                    return;
+                }
+
+                unsigned leadingZeros = std::min(LeadingZeros(delta), 31u);
+                unsigned trailingZeros = TrailingZeros(delta);
+                if (leading != 0xFF && leadingZeros >= leading && trailingZeros >= trailing) {
+                    WriteBits(data, position, 0x2, 2);
+                    WriteBits(data, position, delta >> trailing, 64u - leading - trailing);
+                    return;
+                }
+
+                unsigned meaningful = 64 - leadingZeros - trailingZeros;
+                WriteBits(data, position, 0x3, 2);
+                WriteBits(data, position, leadingZeros, 5);
+                WriteBits(data, position, meaningful - 1, 6);
+                WriteBits(data, position, delta >> trailingZeros, meaningful);
+                leading = static_cast<uint8_t>(leadingZeros);
+                trailing = static_cast<uint8_t>(trailingZeros);
+            }
+
+            bool DecodeValue(BitReader& reader, uint64_t& value, uint8_t& leading, uint8_t& trailing) {
+                bool bit = false;
+                if (!reader.ReadBit(bit)) {
+                    return false;
+                }
+                if (!bit) {
+                    return true;
+                }
+                if (!reader.ReadBit(bit)) {
+                    return false;
+                }
+
+                if (bit) {
+                    uint64_t leadingZeros = 0;
+                    uint64_t meaningful = 0;
+                    if (!reader.Read(5, leadingZeros) || !reader.Read(6, meaningful)) {
+                        return false;
+                    }
+                    meaningful++;
+                    if (leadingZeros + meaningful > 64) {
+                        return false;
+                    }
+                    leading = static_cast<uint8_t>(leadingZeros);
+                    trailing = static_cast<uint8_t>(64 - leadingZeros - meaningful);
+                }
+                else if (leading == 0xFF) {
+                    return false;
+                }
+
+                uint64_t bits = 0;
+                if (!reader.Read(64u - leading - trailing, bits)) {
+                    return false;
+                }
+                value ^= bits << trailing;
+                return true;
+            }
+
+            TimeSeriesPoint MakePoint(int64_t time, uint64_t raw, TimeSeriesType type) {
+                TimeSeriesPoint point;
+                point.time = time;
+                point.raw = raw;
+                if (type == TimeSeriesType::Double) {
+                    memcpy(&point.value, &raw, sizeof(raw));
+                }
+                else {
+                    point.value = static_cast<double>(raw);
+                }
+                return point;
+            }
+
+            void DecodeChunk(ChunkHeader* chunk, uint32_t count, TimeSeriesType type, int64_t from, int64_t to,
+                std::vector<TimeSeriesPoint>& points) {
+                BitReader reader(GetChunkData(chunk), CHUNK_DATA_BITS);
+                int64_t time = chunk->firstTime;
+                int64_t delta = 0;
+                uint64_t value = chunk->firstValue;
+                uint8_t leading = 0xFF;
+                uint8_t trailing = 0;
+
+                for (uint32_t i = 0; i < count; i++) {
+                    if (i > 0) {
+                        int64_t deltaOfDelta = 0;
+                        if (!DecodeTime(reader, deltaOfDelta) || !DecodeValue(reader, value, leading, trailing)) {
+                            return;
+                        }
+                        delta += deltaOfDelta;
+                        time += delta;
+                    }
+                    if (time >= to) {
+                        return;
+                    }
+                    if (time >= from) {
+                        points.push_back(MakePoint(time, value, type));
+                    }
+                }
+            }
+
+            void UpdateSegmentTime(SegmentHeader* header, int64_t time) {
+                if (time < header->minTime) {
+                    header->minTime = time;
+                }
+                if (time > header->maxTime) {
+                    header->maxTime = time;
+                }
+            }
+
+            std::string SegmentFileName(uint64_t sequence) {
+                std::string number = std::to_string(sequence);
+                return SEGMENT_PREFIX + std::string(number.size() < 8 ? 8 - number.size() : 0, '0') + number + SEGMENT_SUFFIX;
+            }
+
+            bool ParseSegmentFileName(const std::string& name, uint64_t& sequence) {
+                size_t prefixLength = strlen(SEGMENT_PREFIX);
+                size_t suffixLength = strlen(SEGMENT_SUFFIX);
+                if (name.size() <= prefixLength + suffixLength || name.compare(0, prefixLength, SEGMENT_PREFIX) != 0 ||
+                    name.compare(name.size() - suffixLength, suffixLength, SEGMENT_SUFFIX) != 0) {
+                    return false;
+                }
+
+                std::string number = name.substr(prefixLength, name.size() - prefixLength - suffixLength);
+                char* end = nullptr;
+                sequence = strtoull(number.c_str(), &end, 10);
+                return *end == '\0' && sequence != 0;
+            }
+
+            int64_t FloorDivide(int64_t value, int64_t divisor) {
+                int64_t quotient = value / divisor;
+                return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+            }
+
+            // 同一目录只允许一个写入方：两个写入方会分配相同的序列 ID 并争抢同一个段序号。
+            // 锁随进程退出自动释放，崩溃后不会残留
+            bool AcquireWriterLock(const std::filesystem::path& path, intptr_t& lock) {
+#ifdef _WIN32
+                // 不共享打开，其他写入方打开时得到 ERROR_SHARING_VIOLATION
+                HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                    FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) {
+                    return false;
+                }
+                lock = reinterpret_cast<intptr_t>(file);
+#else
+                int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+                if (fd < 0) {
+                    return false;
+                }
+                if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+                    close(fd);
+                    return false;
+                }
+                lock = fd;
+#endif
+                return true;
+            }
+
+            void ReleaseWriterLock(intptr_t& lock) {
+                if (lock == -1) {
+                    return;
+                }
+#ifdef _WIN32
+                CloseHandle(reinterpret_cast<HANDLE>(lock));
+#else
+                close(static_cast<int>(lock));
+#endif
+                lock = -1;
+            }
+        }
+
+        // =============================================================================
+        // 段文件映射
+        // =============================================================================
+
+        struct TimeSeriesStore::Segment {
+            uint64_t sequence = 0;
+            std::filesystem::path path;
+            uint8_t* base = nullptr;
+            size_t size = 0;
+#ifdef _WIN32
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = NULL;
+#endif
+
+            ~Segment() {
+                Unmap();
+            }
+
+            // create 时新建 fileSize 大小的文件并以读写方式映射，否则以只读方式映射已有文件
+            bool Map(const std::filesystem::path& filePath, size_t fileSize, bool create) {
+#ifdef _WIN32
+                // 允许删除：写入方清理过期段时读取方可能仍在映射
+                file = CreateFileW(filePath.c_str(), create ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, create ? CREATE_NEW : OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) {
+                    return false;
+                }
+                if (!create) {
+                    LARGE_INTEGER length;
+                    if (!GetFileSizeEx(file, &length)) {
+                        Unmap();
+                        return false;
+                    }
+                    fileSize = static_cast<size_t>(length.QuadPart);
+                }
+                if (fileSize < CHUNK_SIZE) {
+                    Unmap();
+                    return false;
+                }
+
+                uint64_t mappingSize = fileSize;
+                mapping = CreateFileMappingW(file, nullptr, create ? PAGE_READWRITE : PAGE_READONLY,
+                    static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize), nullptr);
+                if (mapping == NULL) {
+                    Unmap();
+                    return false;
+                }
+                base = static_cast<uint8_t*>(MapViewOfFile(mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, fileSize));
+                if (base == nullptr) {
+                    Unmap();
+                    return false;
+                }
+#else
+                int fd = create ? open(filePath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644)
+                    : open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return false;
+                }
+                if (create) {
+                    if (ftruncate(fd, static_cast<off_t>(fileSize)) != 0) {
+                        close(fd);
+                        return false;
+                    }
+                }
+                else {
+                    struct stat status;
+                    if (fstat(fd, &status) != 0) {
+                        close(fd);
+                        return false;
+                    }
+                    fileSize = static_cast<size_t>(status.st_size);
+                }
+                if (fileSize < CHUNK_SIZE) {
+                    close(fd);
+                    return false;
+                }
+
+                void* memory = mmap(nullptr, fileSize, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+                close(fd);
+                if (memory == MAP_FAILED) {
+                    return false;
+                }
+                base = static_cast<uint8_t*>(memory);
+#endif
+                size = fileSize;
+                path = filePath;
+                return true;
+            }
+
+            void Unmap() {
+#ifdef _WIN32
+                if (base != nullptr) {
+                    UnmapViewOfFile(base);
+                }
+                if (mapping != NULL) {
+                    CloseHandle(mapping);
+                    mapping = NULL;
+                }
+                if (file != INVALID_HANDLE_VALUE) {
+                    CloseHandle(file);
+                    file = INVALID_HANDLE_VALUE;
+                }
+#else
+                if (base != nullptr) {
+                    munmap(base, size);
+                }
+#endif
+                base = nullptr;
+                size = 0;
+            }
+
+            void Flush() {
+                if (base == nullptr) {
+                    return;
+                }
+#ifdef _WIN32
+                FlushViewOfFile(base, size);
+#else
+                msync(base, size, MS_ASYNC);
+#endif
+            }
+
+            // 段头完整且与文件大小一致（写入方可能还在初始化）
+            bool IsValid() const {
+                const SegmentHeader* header = GetSegmentHeader(base);
+                return header->magic == SEGMENT_MAGIC && header->version == SEGMENT_VERSION &&
+                    header->chunkSize == CHUNK_SIZE && size >= CHUNK_SIZE * (static_cast<size_t>(header->chunkCount) + 1);
+            }
+        };
+
+        // =============================================================================
+        // 打开与关闭
+        // =============================================================================
+
+        TimeSeriesStore::TimeSeriesStore()
+            : m_open(false)
+            , m_readOnly(true)
+            , m_activeSegment(nullptr)
+            , m_nextSequence(1)
+            , m_nextSeriesId(1)
+            , m_registrySize(0)
+            , m_writerLock(-1)
+        {
+        }
+
+        TimeSeriesStore::~TimeSeriesStore() {
+            Close();
+        }
+
+        bool TimeSeriesStore::Open(const std::string& directory, bool readOnly, const TimeSeriesStoreOptions& options) {
+            Close();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::error_code error;
+            if (!readOnly) {
+                std::filesystem::create_directories(directory, error);
+            }
+            if (!std::filesystem::is_directory(directory, error)) {
+                std::cerr << "历史数据目录不可用: " << directory << std::endl;
+                return false;
+            }
+
+            m_directory = directory;
+            m_options = options;
+            m_options.chunksPerSegment = std::max<uint32_t>(m_options.chunksPerSegment, 1);
+            m_readOnly = readOnly;
+            // 先取得写入锁再读取序列表与段，之后只有本实例修改它们
+            if (!readOnly && !AcquireWriterLock(std::filesystem::path(directory) / WRITER_LOCK_FILE, m_writerLock)) {
+                std::cerr << "历史数据目录已有其他写入方: " << directory << std::endl;
+                return false;
+            }
+            LoadRegistryLocked();
+            LoadSegmentsLocked();
+
+            if (!readOnly) {
+                m_registry.open(std::filesystem::path(directory) / REGISTRY_FILE, std::ios::app | std::ios::binary);
+                if (!m_registry) {
+                    std::cerr << "无法写入历史数据序列表: " << directory << std::endl;
+                    m_segments.clear();
+                    m_series.clear();
+                    ReleaseWriterLock(m_writerLock);
+                    return false;
+                }
+            }
+
+            m_open = true;
+            return true;
+        }
+
+        void TimeSeriesStore::Close() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_activeSegment != nullptr) {
+                m_activeSegment->Flush();
+            }
+            m_activeSegment = nullptr;
+            m_segments.clear();
+            m_series.clear();
+            if (m_registry.is_open()) {
+                m_registry.close();
+            }
+            ReleaseWriterLock(m_writerLock);
+            m_open = false;
+            m_nextSequence = 1;
+            m_nextSeriesId = 1;
+            m_registrySize = 0;
+        }
+
+        bool TimeSeriesStore::IsOpen() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_open;
+        }
+
+        void TimeSeriesStore::LoadSegmentsLocked() {
+            std::error_code error;
+            std::vector<uint64_t> present;
+            for (std::filesystem::directory_iterator it(m_directory, error), end; !error && it != end; it.increment(error)) {
+                uint64_t sequence = 0;
+                if (!ParseSegmentFileName(it->path().filename().string(), sequence)) {
+                    continue;
+                }
+                present.push_back(sequence);
+                m_nextSequence = std::max(m_nextSequence, sequence + 1);
+                if (m_segments.count(sequence) != 0) {
+                    continue;
+                }
+
+                // 尚未初始化完成的段留到下一次刷新
+                auto segment = std::make_unique<Segment>();
+                segment->sequence = sequence;
+                if (segment->Map(it->path(), 0, false) && segment->IsValid()) {
+                    m_segments.emplace(sequence, std::move(segment));
+                }
+            }
+
+            // 已被写入方删除的段
+            for (auto it = m_segments.begin(); it != m_segments.end();) {
+                if (it->second.get() != m_activeSegment &&
+                    std::find(present.begin(), present.end(), it->first) == present.end()) {
+                    it = m_segments.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        void TimeSeriesStore::LoadRegistryLocked() {
+            std::ifstream file(std::filesystem::path(m_directory) / REGISTRY_FILE, std::ios::binary);
+            if (!file) {
+                return;
+            }
+            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            // 每行 "<编号> <d|u> <序列名>"；写入方可能正在写最后一行，只解析完整的行
+            size_t begin = 0;
+            for (size_t end = content.find('\n'); end != std::string::npos; begin = end + 1, end = content.find('\n', begin)) {
+                std::istringstream line(content.substr(begin, end - begin));
+                uint32_t id = 0;
+                char type = 0;
+                std::string key;
+                if (!(line >> id >> type) || id == 0 || (type != 'd' && type != 'u')) {
+                    continue;
+                }
+                std::getline(line >> std::ws, key);
+                if (key.empty() || m_series.count(key) != 0) {
+                    continue;
+                }
+
+                Series series;
+                series.id = id;
+                series.type = type == 'd' ? TimeSeriesType::Double : TimeSeriesType::UInt64;
+                m_series.emplace(std::move(key), series);
+                m_nextSeriesId = std::max(m_nextSeriesId, id + 1);
+            }
+            m_registrySize = content.size();
+        }
+
+        void TimeSeriesStore::RefreshLocked() {
+            std::error_code error;
+            uintmax_t registrySize = std::filesystem::file_size(std::filesystem::path(m_directory) / REGISTRY_FILE, error);
+            if (!error && registrySize != m_registrySize) {
+                LoadRegistryLocked();
+            }
+            LoadSegmentsLocked();
+        }
+
+        // =============================================================================
+        // 写入
+        // =============================================================================
+
+        bool TimeSeriesStore::Append(const std::string& key, int64_t time, double value) {
+            uint64_t raw = 0;
+            memcpy(&raw, &value, sizeof(raw));
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return AppendLocked(key, time, raw, TimeSeriesType::Double);
+        }
+
+        bool TimeSeriesStore::AppendRaw(const std::string& key, int64_t time, uint64_t value) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return AppendLocked(key, time, value, TimeSeriesType::UInt64);
+        }
+
+        void TimeSeriesStore::Flush() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_activeSegment != nullptr) {
+                m_activeSegment->Flush();
+            }
+        }
+
+        bool TimeSeriesStore::AppendLocked(const std::string& key, int64_t time, uint64_t value, TimeSeriesType type) {
+            if (!m_open || m_readOnly) {
+                return false;
+            }
+            Series* series = GetSeriesLocked(key, type);
+            if (series == nullptr || (series->hasPoint && time < series->lastTime)) {
+                return false;
+            }
+
+            if (series->segment == nullptr || series->bitCount + MAX_POINT_BITS > CHUNK_DATA_BITS) {
+                return StartChunkLocked(*series, time, value);
+            }
+
+            ChunkHeader* chunk = GetChunk(series->segment->base, series->chunk);
+            int64_t delta = time - series->lastTime;
+            EncodeTime(GetChunkData(chunk), series->bitCount, delta - series->lastDelta);
+            EncodeValue(GetChunkData(chunk), series->bitCount, value ^ series->lastValue,
+                series->leadingZeros, series->trailingZeros);
+            series->lastTime = time;
+            series->lastDelta = delta;
+            series->lastValue = value;
+
+            chunk->bitCount = series->bitCount;
+            chunk->lastTime = time;
+            UpdateSegmentTime(GetSegmentHeader(series->segment->base), time);
+            std::atomic_thread_fence(std::memory_order_release);
+            chunk->count = chunk->count + 1;
+            return true;
+        }
+
+        TimeSeriesStore::Series* TimeSeriesStore::GetSeriesLocked(const std::string& key, TimeSeriesType type) {
+            // 序列表按行存储，名称中的换行替换掉
+            std::string name = key;
+            std::replace(name.begin(), name.end(), '\n', '_');
+            std::replace(name.begin(), name.end(), '\r', '_');
+
+            auto it = m_series.find(name);
+            if (it != m_series.end()) {
+                return it->second.type == type ? &it->second : nullptr;
+            }
+            if (name.empty() || name.front() == ' ') {
+                return nullptr;
+            }
+
+            // 先写入序列表再写数据，读取方读到的块总能找到所属序列
+            Series series;
+            series.id = m_nextSeriesId;
+            series.type = type;
+            m_registry << series.id << ' ' << (type == TimeSeriesType::Double ? 'd' : 'u') << ' ' << name << '\n';
+            m_registry.flush();
+            if (!m_registry) {
+                m_registry.clear();
+                return nullptr;
+            }
+
+            m_nextSeriesId++;
+            return &m_series.emplace(std::move(name), series).first->second;
+        }
+
+        bool TimeSeriesStore::StartChunkLocked(Series& series, int64_t time, uint64_t value) {
+            if (m_activeSegment == nullptr ||
+                GetSegmentHeader(m_activeSegment->base)->usedChunks >= m_options.chunksPerSegment) {
+                if (!RotateSegmentLocked()) {
+                    return false;
+                }
+            }
+
+            SegmentHeader* header = GetSegmentHeader(m_activeSegment->base);
+            uint32_t index = header->usedChunks;
+            ChunkHeader* chunk = GetChunk(m_activeSegment->base, index);
+            chunk->seriesId = series.id;
+            chunk->bitCount = 0;
+            chunk->firstTime = time;
+            chunk->lastTime = time;
+            chunk->firstValue = value;
+            chunk->count = 1;
+            UpdateSegmentTime(header, time);
+            std::atomic_thread_fence(std::memory_order_release);
+            header->usedChunks = index + 1;
+
+            series.segment = m_activeSegment;
+            series.chunk = index;
+            series.bitCount = 0;
+            series.lastTime = time;
+            series.lastDelta = 0;
+            series.lastValue = value;
+            series.leadingZeros = 0xFF;
+            series.trailingZeros = 0;
+            series.hasPoint = true;
+            return true;
+        }
+
+        bool TimeSeriesStore::RotateSegmentLocked() {
+            RemoveExpiredLocked(Now());
+
+            auto segment = std::make_unique<Segment>();
+            segment->sequence = m_nextSequence++;
+            std::filesystem::path path = std::filesystem::path(m_directory) / SegmentFileName(segment->sequence);
+            size_t size = CHUNK_SIZE * (static_cast<size_t>(m_options.chunksPerSegment) + 1);
+            if (!segment->Map(path, size, true)) {
+                std::error_code error;
+                std::filesystem::remove(path, error);
+                std::cerr << "创建历史数据段失败: " << path.string() << std::endl;
+                return false;
+            }
+
+            SegmentHeader* header = GetSegmentHeader(segment->base);
+            header->version = SEGMENT_VERSION;
+            header->chunkSize = static_cast<uint32_t>(CHUNK_SIZE);
+            header->chunkCount = m_options.chunksPerSegment;
+            header->usedChunks = 0;
+            header->minTime = std::numeric_limits<int64_t>::max();
+            header->maxTime = std::numeric_limits<int64_t>::min();
+            std::atomic_thread_fence(std::memory_order_release);
+            header->magic = SEGMENT_MAGIC;
+
+            // 每个段只由一次写入追加，之前段中的块不再续写
+            for (auto& entry : m_series) {
+                entry.second.segment = nullptr;
+            }
+            if (m_activeSegment != nullptr) {
+                m_activeSegment->Flush();
+            }
+            m_activeSegment = segment.get();
+            m_segments.emplace(m_activeSegment->sequence, std::move(segment));
+            return true;
+        }
+
+        void TimeSeriesStore::RemoveExpiredLocked(int64_t now) {
+            int64_t cutoff = now - std::chrono::duration_cast<std::chrono::milliseconds>(m_options.retention).count();
+            for (auto it = m_segments.begin(); it != m_segments.end();) {
+                if (it->second.get() == m_activeSegment || GetSegmentHeader(it->second->base)->maxTime >= cutoff) {
+                    ++it;
+                    continue;
+                }
+
+                std::filesystem::path path = it->second->path;
+                it = m_segments.erase(it);
+                std::error_code error;
+                std::filesystem::remove(path, error);
+            }
+        }
+
+        // =============================================================================
+        // 查询
+        // =============================================================================
+
+        bool TimeSeriesStore::Query(const std::string& key, int64_t from, int64_t to, std::vector<TimeSeriesPoint>& points) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            points.clear();
+            if (!m_open) {
+                return false;
+            }
+            if (m_readOnly) {
+                RefreshLocked();
+            }
+
+            auto series = m_series.find(key);
+            if (series == m_series.end() || from >= to) {
+                return true;
+            }
+
+            for (const auto& entry : m_segments) {
+                uint8_t* base = entry.second->base;
+                SegmentHeader* header = GetSegmentHeader(base);
+                uint32_t used = std::min<uint32_t>(static_cast<uint32_t>(header->usedChunks), header->chunkCount);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (used == 0 || header->maxTime < from || header->minTime >= to) {
+                    continue;
+                }
+
+                for (uint32_t index = 0; index < used; index++) {
+                    ChunkHeader* chunk = GetChunk(base, index);
+                    if (chunk->seriesId != series->second.id) {
+                        continue;
+                    }
+                    uint32_t count = chunk->count;
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (count == 0 || chunk->firstTime >= to || chunk->lastTime < from) {
+                        continue;
+                    }
+                    DecodeChunk(chunk, count, series->second.type, from, to, points);
+                }
+            }
+
+            // 块按写入顺序排列；写入方重启后时间可能与之前的段交错
+            auto earlier = [](const TimeSeriesPoint& a, const TimeSeriesPoint& b) { return a.time < b.time; };
+            if (!std::is_sorted(points.begin(), points.end(), earlier)) {
+                std::stable_sort(points.begin(), points.end(), earlier);
+            }
+            return true;
+        }
+
+        bool TimeSeriesStore::Query(const std::string& key, int64_t from, int64_t to, int64_t step,
+            TimeSeriesAggregation aggregation, std::vector<TimeSeriesPoint>& points) {
+            std::vector<TimeSeriesPoint> samples;
+            if (!Query(key, from, to, samples)) {
+                points.clear();
+                return false;
+            }
+            DownsampleTimeSeries(samples, from, step, aggregation, points);
+            return true;
+        }
+
+        std::vector<std::string> TimeSeriesStore::ListSeries(const std::string& prefix) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<std::string> keys;
+            if (!m_open) {
+                return keys;
+            }
+            if (m_readOnly) {
+                RefreshLocked();
+            }
+
+            for (const auto& entry : m_series) {
+                if (entry.first.compare(0, prefix.size(), prefix) == 0) {
+                    keys.push_back(entry.first);
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            return keys;
+        }
+
+        int64_t TimeSeriesStore::Now() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        void DownsampleTimeSeries(const std::vector<TimeSeriesPoint>& points, int64_t from, int64_t step,
+            TimeSeriesAggregation aggregation, std::vector<TimeSeriesPoint>& result) {
+            result.clear();
+            if (step <= 0) {
+                result = points;
+                return;
+            }
+
+            // 平均值没有对应的原始值，raw 为 0；最小 / 最大 / 最后一个保留所选点的原始值
+            size_t index = 0;
+            while (index < points.size()) {
+                TimeSeriesPoint bucket;
+                bucket.time = from + FloorDivide(points[index].time - from, step) * step;
+                double sum = 0.0;
+                size_t count = 0;
+                for (; index < points.size() && points[index].time < bucket.time + step; index++) {
+                    const TimeSeriesPoint& point = points[index];
+                    bool select = count == 0;
+                    switch (aggregation) {
+                    case TimeSeriesAggregation::Average:
+                        sum += point.value;
+                        break;
+                    case TimeSeriesAggregation::Min:
+                        select = select || point.value < bucket.value;
+                        break;
+                    case TimeSeriesAggregation::Max:
+                        select = select || point.value > bucket.value;
+                        break;
+                    case TimeSeriesAggregation::Last:
+                        select = true;
+                        break;
+                    }
+                    if (select && aggregation != TimeSeriesAggregation::Average) {
+                        bucket.value = point.value;
+                        bucket.raw = point.raw;
+                    }
+                    count++;
+                }
+                if (aggregation == TimeSeriesAggregation::Average) {
+                    bucket.value = sum / static_cast<double>(count);
+                }
+                result.push_back(bucket);
+            }
+        }
+    }
+}
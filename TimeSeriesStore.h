@@ -0,0 +1,133 @@
+﻿#pragma once
+
+#include "CpuPlatform.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SamsunIoCardC {
+    namespace CpuManager {
+
+        // =============================================================================
+        // 紧凑时序存储：每核心使用率、进程亲和性变化与扫描指标的长期历史
+        //
+        // 目录中是固定大小的段文件（segment-<序号>.tsd），整体映射到内存，按 4 KiB 分块；
+        // 每块只属于一个序列，块内时间戳按二阶差分、值按与前一个值的异或压缩（Gorilla 编码），
+        // 每秒一个点的规整序列每点约 1~2 字节。序列名与编号记录在 series.idx 中。
+        //
+        // 单写者：写入方在自己的段中追加，块内先写数据再发布点数；读取方（可在其他进程中只读打开）
+        // 查询时重新扫描目录，读到的点总是完整的。段写满后创建新段，超过保留时间的段整体删除。
+        // =============================================================================
+
+        enum class TimeSeriesType : uint8_t {
+            Double,         // 值按 IEEE 754 双精度解释
+            UInt64          // 值为 64 位无符号整数（例如亲和性掩码）
+        };
+
+        enum class TimeSeriesAggregation {
+            Average,
+            Min,
+            Max,
+            Last
+        };
+
+        struct TimeSeriesPoint {
+            int64_t time = 0;       // Unix 毫秒
+            double value = 0.0;     // UInt64 序列为 raw 转换的数值（超过 2^53 时不精确）
+            uint64_t raw = 0;       // 原始 64 位值，Double 序列为位模式
+        };
+
+        struct TimeSeriesStoreOptions {
+            uint32_t chunksPerSegment = 1023;               // 每段的块数，加上段头共 4 MiB
+            std::chrono::hours retention{24 * 21};          // 最新数据早于该时间的段在创建新段时删除
+        };
+
+        class TimeSeriesStore {
+        public:
+            TimeSeriesStore();
+            ~TimeSeriesStore();
+
+            TimeSeriesStore(const TimeSeriesStore&) = delete;
+            TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+            // 打开（写入时创建）目录；写入方每次打开都从新段开始，不修改已有段
+            // 同一目录同时只能有一个写入方（writer.lock 独占锁），已被其他写入方打开时返回 false
+            bool Open(const std::string& directory, bool readOnly,
+                const TimeSeriesStoreOptions& options = TimeSeriesStoreOptions());
+            void Close();
+            bool IsOpen() const;
+
+            // 追加一个点，time 不能早于该序列的上一个点；序列不存在时以对应类型创建
+            bool Append(const std::string& key, int64_t time, double value);
+            bool AppendRaw(const std::string& key, int64_t time, uint64_t value);
+            // 把当前段写回磁盘（映射内存由系统异步写回，通常不需要调用）
+            void Flush();
+
+            // 查询 [from, to) 内的原始点，按时间排序；序列不存在时返回 true 且结果为空
+            bool Query(const std::string& key, int64_t from, int64_t to, std::vector<TimeSeriesPoint>& points);
+            // 按 step（毫秒）降采样，见 DownsampleTimeSeries
+            bool Query(const std::string& key, int64_t from, int64_t to, int64_t step,
+                TimeSeriesAggregation aggregation, std::vector<TimeSeriesPoint>& points);
+            // 以 prefix 开头的序列名，按名称排序
+            std::vector<std::string> ListSeries(const std::string& prefix = std::string());
+
+            // 当前时间（Unix 毫秒）
+            static int64_t Now();
+
+        private:
+            struct Segment;
+
+            struct Series {
+                uint32_t id = 0;
+                TimeSeriesType type = TimeSeriesType::Double;
+                // 写入状态：当前块与压缩器状态，块只在写入方的本次打开期间追加
+                Segment* segment = nullptr;
+                uint32_t chunk = 0;
+                uint32_t bitCount = 0;
+                int64_t lastTime = 0;
+                int64_t lastDelta = 0;
+                uint64_t lastValue = 0;
+                uint8_t leadingZeros = 0xFF;    // 上一个非零异或值的有效位窗口，0xFF 表示没有
+                uint8_t trailingZeros = 0;
+                bool hasPoint = false;
+            };
+
+            bool AppendLocked(const std::string& key, int64_t time, uint64_t value, TimeSeriesType type);
+            Series* GetSeriesLocked(const std::string& key, TimeSeriesType type);
+            // 为序列分配新块并写入第一个点，当前段已满时换段
+            bool StartChunkLocked(Series& series, int64_t time, uint64_t value);
+            bool RotateSegmentLocked();
+            void RemoveExpiredLocked(int64_t now);
+            // 只读方式：映射新出现的段、丢弃已删除的段并重新读取序列表
+            void RefreshLocked();
+            void LoadSegmentsLocked();
+            void LoadRegistryLocked();
+
+            mutable std::mutex m_mutex;
+            std::string m_directory;
+            TimeSeriesStoreOptions m_options;
+            bool m_open;
+            bool m_readOnly;
+
+            std::map<uint64_t, std::unique_ptr<Segment>> m_segments;    // 按序号排序
+            Segment* m_activeSegment;
+            uint64_t m_nextSequence;
+
+            std::unordered_map<std::string, Series> m_series;
+            uint32_t m_nextSeriesId;
+            std::ofstream m_registry;
+            uint64_t m_registrySize;
+            intptr_t m_writerLock;      // 写入方独占锁（Linux 文件描述符 / Windows 文件句柄），-1 表示未持有
+        };
+
+        // 按 from + k * step 对齐分桶聚合，点的时间为桶的起点，空桶不输出
+        void DownsampleTimeSeries(const std::vector<TimeSeriesPoint>& points, int64_t from, int64_t step,
+            TimeSeriesAggregation aggregation, std::vector<TimeSeriesPoint>& result);
+    }
+}